@@ -0,0 +1,107 @@
+// Tests that each of the strategies $lookup picks from returns the same results, and that explain
+// reports the strategy in use.
+(function() {
+    "use strict";
+
+    var local = db.lookup_strategies_local;
+    var foreign = db.lookup_strategies_foreign;
+    local.drop();
+    foreign.drop();
+
+    var localValues = [0, 1, 1.0, NumberLong(2), "3", null, [1, 2], {x: 1}, /^3/, NaN];
+    for (var i = 0; i < 40; i++) {
+        assert.writeOK(local.insert({_id: i, a: localValues[i % localValues.length]}));
+    }
+    assert.writeOK(local.insert({_id: 40}));
+
+    for (var i = 0; i < 30; i++) {
+        assert.writeOK(foreign.insert({_id: i, b: i % 4}));
+    }
+    assert.writeOK(foreign.insert({_id: 30, b: "3"}));
+    assert.writeOK(foreign.insert({_id: 31, b: [1, 2, 1]}));
+    assert.writeOK(foreign.insert({_id: 32, b: [[1, 2]]}));
+    assert.writeOK(foreign.insert({_id: 33, b: null}));
+    assert.writeOK(foreign.insert({_id: 34}));
+    assert.writeOK(foreign.insert({_id: 35, b: {x: 1}}));
+    assert.writeOK(foreign.insert({_id: 36, b: /^3/}));
+    assert.writeOK(foreign.insert({_id: 37, b: NaN}));
+
+    function setParameters(params) {
+        params.setParameter = 1;
+        assert.commandWorked(db.adminCommand(params));
+    }
+
+    function byId(a, b) {
+        return a._id - b._id;
+    }
+
+    function run(pipeline) {
+        var results = local.aggregate(pipeline).toArray();
+        results.forEach(function(doc) {
+            if (Array.isArray(doc.same)) {
+                doc.same.sort(byId);
+            }
+        });
+        return results.sort(function(a, b) {
+            return byId(a, b) || byId(a.same || {}, b.same || {});
+        });
+    }
+
+    var lookup = {
+        $lookup: {localField: "a", foreignField: "b", from: foreign.getName(), as: "same"}
+    };
+    var pipelines = [
+        [lookup],
+        [lookup, {$unwind: "$same"}],
+        [lookup, {$unwind: {path: "$same", preserveNullAndEmptyArrays: true}}]
+    ];
+
+    function strategyInUse() {
+        var explain = local.aggregate([lookup], {explain: true});
+        return explain.stages[1].$lookup.strategy;
+    }
+
+    var original = db.adminCommand({
+        getParameter: 1,
+        internalLookupBatchSize: 1,
+        internalLookupHashJoinMaxMemoryBytes: 1,
+        internalLookupHashJoinMaxForeignDocs: 1,
+        internalLookupBatchMaxMemoryBytes: 1
+    });
+    assert.commandWorked(original);
+
+    // Without an index on the foreign field, the small foreign collection is read up front.
+    assert.eq("hashJoin", strategyInUse());
+    var expected = pipelines.map(run);
+
+    // The foreign collection doesn't fit in memory any more, so it gets probed in batches.
+    setParameters({internalLookupHashJoinMaxMemoryBytes: 0, internalLookupBatchSize: 3});
+    assert.eq("batchedProbe", strategyInUse());
+    assert.eq(expected, pipelines.map(run));
+
+    // With an index, probing is preferred once the foreign collection has more than a few
+    // documents, even if it would fit in memory.
+    setParameters({
+        internalLookupHashJoinMaxMemoryBytes: original.internalLookupHashJoinMaxMemoryBytes,
+        internalLookupHashJoinMaxForeignDocs: 10
+    });
+    assert.commandWorked(foreign.createIndex({b: 1}));
+    assert.eq("batchedProbe", strategyInUse());
+    assert.eq(expected, pipelines.map(run));
+
+    // Batches whose matches don't fit in memory are streamed from a query per input document.
+    setParameters({internalLookupBatchMaxMemoryBytes: 0});
+    assert.eq(expected, pipelines.map(run));
+    setParameters({internalLookupBatchMaxMemoryBytes: original.internalLookupBatchMaxMemoryBytes});
+
+    // Batches of one document are looked up with a query each.
+    setParameters({internalLookupBatchSize: 1});
+    assert.eq("perDocument", strategyInUse());
+    assert.eq(expected, pipelines.map(run));
+
+    setParameters({
+        internalLookupBatchSize: original.internalLookupBatchSize,
+        internalLookupHashJoinMaxForeignDocs: original.internalLookupHashJoinMaxForeignDocs
+    });
+    assert.eq("hashJoin", strategyInUse());
+}());
@@ -0,0 +1,52 @@
+// Tests collections whose records are stored compressed, created with the compressed user flag.
+(function() {
+    "use strict";
+
+    var compressedFlag = 4;
+    var padding = new Array(1000).join("x");
+
+    function fill(coll) {
+        coll.drop();
+        for (var i = 0; i < 500; i++) {
+            assert.writeOK(coll.insert({_id: i, a: i % 10, padding: padding}));
+        }
+        assert.commandWorked(coll.ensureIndex({a: 1}));
+    }
+
+    var plain = db.compressed_records_plain;
+    var coll = db.compressed_records;
+    coll.drop();
+    assert.commandWorked(db.createCollection(coll.getName(), {flags: 1 | compressedFlag}));
+    fill(plain);
+    fill(coll);
+
+    var stats = coll.stats();
+    assert.eq(1 | compressedFlag, stats.userFlags);
+    assert(stats.compression, tojson(stats));
+    assert.lt(stats.size, plain.stats().size / 4, tojson(stats));
+
+    assert.eq(500, coll.find().itcount());
+    assert.eq(50, coll.find({a: 3}).itcount());
+    assert.eq(padding, coll.findOne({_id: 7}).padding);
+
+    // Updates which stay in place and updates which move the record, as it no longer compresses.
+    assert.writeOK(coll.update({_id: 1}, {$set: {b: 1}}));
+    assert.eq(1, coll.findOne({_id: 1}).b);
+    var random = "";
+    for (var i = 0; i < 2000; i++) {
+        random += String.fromCharCode(33 + Math.floor(Math.random() * 90));
+    }
+    assert.writeOK(coll.update({_id: 2}, {$set: {a: 100, padding: random}}));
+    assert.eq(random, coll.findOne({_id: 2}).padding);
+    assert.eq(1, coll.find({a: 100}).itcount());
+
+    assert.writeOK(coll.remove({a: 5}));
+    assert.eq(450, coll.find().itcount());
+
+    assert.commandWorked(db.runCommand({compact: coll.getName()}));
+    assert.eq(450, coll.find().itcount());
+    assert.eq(padding, coll.findOne({_id: 7}).padding);
+
+    var validate = coll.validate(true);
+    assert(validate.valid, tojson(validate));
+}());
@@ -0,0 +1,39 @@
+// Tests that the inMemory storage engine serves reads and writes without writing data files and
+// starts out empty after a restart.
+(function() {
+    "use strict";
+
+    var conn = MongoRunner.runMongod({storageEngine: "inMemory", inMemorySizeGB: 1});
+    assert.neq(null, conn, "mongod failed to start with the inMemory storage engine");
+    var dbpath = conn.dbpath;
+
+    var coll = conn.getDB("test").in_memory_engine;
+    assert.commandWorked(coll.createIndex({a: 1}));
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 1000; i++) {
+        bulk.insert({_id: i, a: i % 10});
+    }
+    assert.writeOK(bulk.execute());
+
+    assert.eq(100, coll.find({a: 3}).hint({a: 1}).itcount());
+    assert.writeOK(coll.update({a: 3}, {$set: {b: 1}}, {multi: true}));
+    assert.eq(100, coll.find({b: 1}).itcount());
+    assert.commandWorked(conn.getDB("admin").runCommand({fsync: 1}));
+
+    var status = conn.getDB("admin").runCommand({serverStatus: 1});
+    assert.commandWorked(status);
+    assert.eq("inMemory", status.storageEngine.name);
+    assert(status.wiredTiger.sessionCache, tojson(status.wiredTiger));
+
+    listFiles(dbpath).forEach(function(file) {
+        assert(!/\.wt$/.test(file.baseName), "unexpected data file " + file.name);
+        assert.neq("journal", file.baseName);
+    });
+
+    MongoRunner.stopMongod(conn);
+    conn = MongoRunner.runMongod(
+        {restart: true, dbpath: dbpath, port: conn.port, storageEngine: "inMemory"});
+    assert.neq(null, conn, "mongod failed to restart with the inMemory storage engine");
+    assert.eq(0, conn.getDB("test").in_memory_engine.count());
+    MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,39 @@
+// Tests that inserts and updates fail with ExceededMemoryLimit once the inMemory storage engine
+// is full, and that the server keeps serving requests.
+(function() {
+    "use strict";
+
+    var conn = MongoRunner.runMongod(
+        {storageEngine: "inMemory", wiredTigerEngineConfigString: "cache_size=50M"});
+    assert.neq(null, conn, "mongod failed to start with the inMemory storage engine");
+
+    var coll = conn.getDB("test").in_memory_engine_cache_full;
+    var bigString = new Array(1024 * 1024).join("x");
+
+    // Insert documents until the cache is full.
+    var res;
+    for (var i = 0; i < 1000; i++) {
+        res = coll.insert({_id: i, s: bigString});
+        if (res.hasWriteError()) {
+            break;
+        }
+    }
+    assert.eq(ErrorCodes.ExceededMemoryLimit, res.getWriteError().code, tojson(res));
+    assert.gt(i, 0, "no document fit in the cache");
+
+    // Growing a document which fit before fails the same way, well before it reaches the maximum
+    // document size.
+    for (var j = 0; j < 10; j++) {
+        res = coll.update({_id: 0}, {$push: {a: bigString}});
+        if (res.hasWriteError()) {
+            break;
+        }
+    }
+    assert.eq(ErrorCodes.ExceededMemoryLimit, res.getWriteError().code, tojson(res));
+
+    // The server is still up, and the documents which fit are readable.
+    assert.commandWorked(conn.getDB("admin").runCommand({serverStatus: 1}));
+    assert.eq(i, coll.find({}, {_id: 1}).itcount());
+
+    MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,67 @@
+/**
+ * Tests that unique indexes keep a Bloom filter when indexBloomFilterSizeBytes is set, that _id
+ * lookups of missing documents are answered by it, and that it is filled again from the index
+ * after a restart.
+ *
+ * This test requires persistence to rebuild the filter from the index after the restart.
+ * @tags: [requires_persistence]
+ */
+(function() {
+    'use strict';
+
+    var dbpath = MongoRunner.dataPath + 'index_bloom_filter';
+    resetDbpath(dbpath);
+
+    var mongodArgs = {
+        dbpath: dbpath,
+        noCleanData: true,
+        setParameter: 'indexBloomFilterSizeBytes=65536'
+    };
+
+    var conn = MongoRunner.runMongod(mongodArgs);
+    assert.neq(null, conn, 'mongod was unable to start up');
+
+    var coll = conn.getDB('test').index_bloom_filter;
+    for (var i = 0; i < 100; i++) {
+        assert.writeOK(coll.insert({_id: i, a: i, b: i % 10}));
+    }
+    assert.commandWorked(coll.createIndex({a: 1}, {unique: true}));
+    assert.commandWorked(coll.createIndex({b: 1}));
+
+    function filterStats(indexName) {
+        // Indexes of storage engines without their own statistics only show up with a filter.
+        var details = coll.stats().indexDetails[indexName];
+        return details ? details.bloomFilter : undefined;
+    }
+
+    function checkLookups() {
+        for (var i = 0; i < 100; i++) {
+            assert.eq(i, coll.findOne({_id: i}).a);
+        }
+
+        var before = filterStats('_id_');
+        for (var i = 100; i < 200; i++) {
+            assert.eq(null, coll.findOne({_id: i}));
+        }
+        var after = filterStats('_id_');
+        assert.eq(before.lookups + 100, after.lookups, tojson(after));
+        // Only about 1% of them should have had to go to the storage engine.
+        assert.gt(after.negatives - before.negatives, 90, tojson(after));
+    }
+
+    assert.eq(100, filterStats('_id_').keysAdded);
+    assert.eq(100, filterStats('a_1').keysAdded);
+    assert.eq(undefined, filterStats('b_1'), 'only unique indexes have a filter');
+    checkLookups();
+
+    // The filter is not persisted, but filled from the index when it is opened again.
+    MongoRunner.stopMongod(conn);
+    conn = MongoRunner.runMongod(mongodArgs);
+    assert.neq(null, conn, 'mongod was unable to restart');
+    coll = conn.getDB('test').index_bloom_filter;
+
+    assert.eq(100, filterStats('_id_').keysAdded);
+    checkLookups();
+
+    MongoRunner.stopMongod(conn);
+})();
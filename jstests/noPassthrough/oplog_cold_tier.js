@@ -0,0 +1,55 @@
+// Tests that oplog entries truncated from a WiredTiger oplog are sealed into the cold tier and stay
+// readable through the oplog, both forward and backward.
+(function() {
+    "use strict";
+
+    if (jsTest.options().storageEngine && jsTest.options().storageEngine !== "wiredTiger") {
+        jsTestLog("Skipping test because storageEngine is not wiredTiger");
+        return;
+    }
+
+    var replTest = new ReplSetTest({
+        nodes: 1,
+        oplogSize: 1,
+        nodeOptions: {setParameter: {wiredTigerOplogColdTierSizeMB: 64}}
+    });
+    replTest.startSet();
+    replTest.initiate();
+
+    var primary = replTest.getPrimary();
+    var oplog = primary.getDB("local").oplog.rs;
+    var coll = primary.getDB("test").oplog_cold_tier;
+
+    var firstTs = oplog.find().sort({$natural: 1}).limit(1).next().ts;
+
+    // Write several times the size of the oplog so that its oldest stones get truncated.
+    var padding = new Array(10 * 1024).join("x");
+    for (var i = 0; i < 500; i++) {
+        assert.writeOK(coll.insert({_id: i, padding: padding}));
+    }
+
+    var coldTier;
+    assert.soon(function() {
+        coldTier = oplog.stats().coldTier;
+        return coldTier && coldTier.records > 0;
+    }, "no oplog entries were sealed into the cold tier");
+    assert.gt(coldTier.dataSize, coldTier.storageSize, tojson(coldTier));
+
+    // The oldest entry is still found, and forward and reverse scans see the same entries.
+    assert.eq(firstTs, oplog.find().sort({$natural: 1}).limit(1).next().ts);
+    assert.eq(1, oplog.find({ts: firstTs}).itcount());
+    var forward = oplog.find({}, {ts: 1}).sort({$natural: 1}).toArray();
+    var reverse = oplog.find({}, {ts: 1}).sort({$natural: -1}).toArray();
+    assert.eq(forward.length, reverse.length);
+    assert.eq(forward, reverse.reverse());
+    assert.gt(forward.length, oplog.count());
+
+    // Every insert is still in the oplog, in order.
+    var inserts = oplog.find({op: "i", ns: coll.getFullName()}).toArray();
+    assert.eq(500, inserts.length);
+    inserts.forEach(function(entry, i) {
+        assert.eq(i, entry.o._id);
+    });
+
+    replTest.stopSet();
+}());
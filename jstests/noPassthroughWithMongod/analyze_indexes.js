@@ -0,0 +1,76 @@
+// Tests that analyzeIndexes computes index statistics, and that the planner picks a plan from them
+// without a trial run once one plan is estimated to be clearly cheaper than the others.
+(function() {
+    "use strict";
+
+    var coll = db.analyze_indexes;
+    coll.drop();
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 2000; i++) {
+        bulk.insert({a: i, b: i % 2});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.createIndex({a: 1}));
+    assert.commandWorked(coll.createIndex({b: 1}));
+
+    var query = {a: {$gte: 10, $lte: 12}, b: 1};
+
+    function costBasedPlanSelections() {
+        return db.serverStatus().metrics.queryExecutor.costBasedPlanSelections;
+    }
+
+    // Without statistics both plans are run.
+    var explain = coll.find(query).explain();
+    assert.eq(1, explain.queryPlanner.rejectedPlans.length, tojson(explain));
+
+    var res = assert.commandWorked(db.runCommand({analyzeIndexes: coll.getName()}));
+    assert.eq(2000, res.indexes.a_1.numKeys, tojson(res));
+    assert.eq(2000, res.indexes.a_1.distinctValues, tojson(res));
+    assert.eq(2, res.indexes.b_1.distinctValues, tojson(res));
+    assert(res.indexes.hasOwnProperty("_id_"), tojson(res));
+
+    // The scan over 'a' is estimated to examine a few keys, the one over 'b' half of them.
+    var selectionsBefore = costBasedPlanSelections();
+    explain = coll.find(query).explain();
+    assert.eq(0, explain.queryPlanner.rejectedPlans.length, tojson(explain));
+    assert.eq("a_1", explain.queryPlanner.winningPlan.inputStage.indexName, tojson(explain));
+    assert.eq([11], coll.find(query).toArray().map(function(doc) {
+        return doc.a;
+    }));
+    assert.gt(costBasedPlanSelections(), selectionsBefore);
+
+    // Queries with a limit are still ranked by running them.
+    explain = coll.find(query).limit(1).explain();
+    assert.eq(1, explain.queryPlanner.rejectedPlans.length, tojson(explain));
+
+    // Cost based selection can be turned off.
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryCostBasedPlanSelection: false}));
+    explain = coll.find(query).explain();
+    assert.eq(1, explain.queryPlanner.rejectedPlans.length, tojson(explain));
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryCostBasedPlanSelection: true}));
+
+    // Plans are ranked by running them again once the statistics go stale.
+    bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 2000; i < 6000; i++) {
+        bulk.insert({a: i, b: i % 2});
+    }
+    assert.writeOK(bulk.execute());
+    explain = coll.find(query).explain();
+    assert.eq(1, explain.queryPlanner.rejectedPlans.length, tojson(explain));
+
+    // A single index can be analyzed, with a smaller sample.
+    res = assert.commandWorked(
+        db.runCommand({analyzeIndexes: coll.getName(), index: "b_1", sampleSize: 100}));
+    assert.eq(100, res.indexes.b_1.sampleSize, tojson(res));
+    assert(!res.indexes.hasOwnProperty("a_1"), tojson(res));
+
+    assert.commandFailedWithCode(db.runCommand({analyzeIndexes: coll.getName(), index: "c_1"}),
+                                 ErrorCodes.IndexNotFound);
+    assert.commandFailedWithCode(db.runCommand({analyzeIndexes: coll.getName(), sampleSize: 0}),
+                                 ErrorCodes.BadValue);
+    assert.commandFailedWithCode(db.runCommand({analyzeIndexes: "analyze_indexes_missing"}),
+                                 ErrorCodes.NamespaceNotFound);
+}());
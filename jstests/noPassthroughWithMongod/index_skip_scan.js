@@ -0,0 +1,65 @@
+// Tests that a compound index whose leading field has few distinct values answers predicates over
+// its other fields by skipping from one leading value to the next.
+(function() {
+    "use strict";
+
+    var coll = db.index_skip_scan;
+    coll.drop();
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 2000; i++) {
+        bulk.insert({_id: i, a: i % 4, b: i});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.createIndex({a: 1, b: 1}));
+
+    var query = {b: {$gte: 1000, $lte: 1003}};
+
+    function winningIndexScan(explain) {
+        var stage = explain.queryPlanner.winningPlan;
+        while (stage && stage.stage !== "IXSCAN") {
+            stage = stage.inputStage;
+        }
+        return stage;
+    }
+
+    // Without statistics the cardinality of 'a' is unknown, so the query scans the collection.
+    var explain = coll.find(query).explain();
+    assert.eq(null, winningIndexScan(explain), tojson(explain));
+
+    assert.commandWorked(db.runCommand({analyzeIndexes: coll.getName()}));
+
+    explain = coll.find(query).explain("executionStats");
+    var ixscan = winningIndexScan(explain);
+    assert.neq(null, ixscan, tojson(explain));
+    assert.eq(
+        {a: ["[MinKey, MaxKey]"], b: ["[1000.0, 1003.0]"]}, ixscan.indexBounds, tojson(ixscan));
+    assert.eq(4, explain.executionStats.nReturned, tojson(explain));
+    assert.lt(explain.executionStats.totalKeysExamined, 20, tojson(explain));
+
+    function ids(cursor) {
+        return cursor.toArray().map(function(doc) {
+            return doc._id;
+        }).sort();
+    }
+    assert.eq(ids(coll.find(query).hint({$natural: 1})), ids(coll.find(query)));
+
+    // Constraining the leading field doesn't need a skip scan.
+    explain = coll.find({a: 2, b: {$gte: 1000, $lte: 1003}}).explain();
+    assert.eq({a: ["[2.0, 2.0]"], b: ["[1000.0, 1003.0]"]},
+              winningIndexScan(explain).indexBounds,
+              tojson(explain));
+
+    // Skip scans are limited to leading fields with few enough distinct values.
+    var original = assert.commandWorked(
+        db.adminCommand({getParameter: 1, internalQueryPlannerSkipScanMaxLeadingValues: 1}));
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryPlannerSkipScanMaxLeadingValues: 2}));
+    explain = coll.find(query).explain();
+    assert.eq(null, winningIndexScan(explain), tojson(explain));
+    assert.commandWorked(db.adminCommand({
+        setParameter: 1,
+        internalQueryPlannerSkipScanMaxLeadingValues:
+            original.internalQueryPlannerSkipScanMaxLeadingValues
+    }));
+}());
@@ -0,0 +1,77 @@
+// Tests that collection scans split into partitions read in parallel return the same documents as
+// serial scans, in natural order when asked to, for both find and aggregate.
+(function() {
+    "use strict";
+
+    var coll = db.parallel_query_collection_scan;
+    coll.drop();
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 20000; i++) {
+        bulk.insert({_id: i, a: i % 7, b: i});
+    }
+    assert.writeOK(bulk.execute());
+
+    function setParameters(params) {
+        params.setParameter = 1;
+        assert.commandWorked(db.adminCommand(params));
+    }
+
+    function byId(a, b) {
+        return a._id - b._id;
+    }
+
+    var filter = {a: {$in: [1, 5]}};
+    var pipeline = [{$match: filter}, {$group: {_id: "$a", total: {$sum: "$b"}, n: {$sum: 1}}}];
+
+    function run() {
+        return {
+            find: coll.find(filter).toArray().sort(byId),
+            natural: coll.find(filter).sort({$natural: 1}).toArray(),
+            aggregate: coll.aggregate(pipeline).toArray().sort(byId)
+        };
+    }
+
+    var original = db.adminCommand({
+        getParameter: 1,
+        internalQueryParallelCollectionScanMaxDegree: 1,
+        internalQueryParallelCollectionScanMinRecords: 1
+    });
+    assert.commandWorked(original);
+
+    var expected = run();
+    assert.eq(5714, expected.find.length);
+    assert.eq(expected.find, expected.natural);
+
+    setParameters({
+        internalQueryParallelCollectionScanMaxDegree: 4,
+        internalQueryParallelCollectionScanMinRecords: 0
+    });
+
+    // Only storage engines with document level locking read the partitions in parallel.
+    if (db.serverStatus().storageEngine.name === "wiredTiger") {
+        var explain = coll.find(filter).sort({$natural: 1}).explain("executionStats");
+        var scan = explain.executionStats.executionStages;
+        assert.eq("PARALLEL_COLLSCAN", scan.stage, tojson(explain));
+        assert(scan.ordered, tojson(scan));
+        assert.eq(4, scan.maxParallelism, tojson(scan));
+        assert.gt(scan.partitions, 1, tojson(scan));
+        assert.eq(20000, scan.docsExamined, tojson(scan));
+        assert.eq(20000, explain.executionStats.totalDocsExamined, tojson(explain));
+    }
+
+    var actual = run();
+    assert.eq(expected.find, actual.find);
+    assert.eq(expected.natural, actual.natural);
+    assert.eq(expected.aggregate, actual.aggregate);
+
+    // Getting more batches saves and restores the scan in between.
+    assert.eq(expected.find, coll.find(filter).batchSize(100).toArray().sort(byId));
+
+    setParameters({
+        internalQueryParallelCollectionScanMaxDegree:
+            original.internalQueryParallelCollectionScanMaxDegree,
+        internalQueryParallelCollectionScanMinRecords:
+            original.internalQueryParallelCollectionScanMinRecords
+    });
+}());
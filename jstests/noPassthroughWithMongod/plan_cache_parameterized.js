@@ -0,0 +1,65 @@
+// Tests that queries of a cached shape get their solution from the parameterized solution of the
+// cache entry when their values allow it, and that they return the same results as without it.
+(function() {
+    "use strict";
+
+    var coll = db.plan_cache_parameterized;
+    coll.drop();
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 1000; i++) {
+        bulk.insert({a: i, b: i % 2, c: "v" + (i % 10)});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.createIndex({a: 1}));
+    assert.commandWorked(coll.createIndex({b: 1}));
+
+    function planCacheMetrics() {
+        return db.serverStatus().metrics.queryExecutor.planCache;
+    }
+
+    function listPlans(query) {
+        return assert.commandWorked(
+            coll.runCommand("planCacheListPlans", {query: query, sort: {_id: 1}}));
+    }
+
+    function assertSameResults(query) {
+        var expected = coll.find(query).hint({$natural: 1}).sort({_id: 1}).toArray();
+        assert.eq(expected, coll.find(query).sort({_id: 1}).toArray(), tojson(query));
+    }
+
+    // The first query is planned by running both candidate plans, and the second rebuilds the
+    // cached solution from its index assignments.
+    assertSameResults({a: {$gte: 10, $lte: 20}, b: 1, c: "v1"});
+    assertSameResults({a: {$gte: 30, $lte: 40}, b: 0, c: "v2"});
+
+    var plans = listPlans({a: {$gte: 10, $lte: 20}, b: 1, c: "v1"});
+    assert(plans.parameterized, tojson(plans));
+    assert.eq(1, plans.usage.rebuilt, tojson(plans));
+
+    // The next queries substitute their values, including values of another numeric type.
+    var before = planCacheMetrics();
+    assertSameResults({a: {$gte: 100, $lte: 110}, b: 1, c: "v3"});
+    assertSameResults({a: {$gte: 500.5, $lte: NumberLong(505)}, b: 0, c: "v5"});
+    assertSameResults({a: {$gte: 10, $lte: 11}, b: 1, c: "v0"});
+    var after = planCacheMetrics();
+    assert.eq(before.instantiated + 3, after.instantiated, tojson(after));
+    assert.eq(before.rebuilt, after.rebuilt, tojson(after));
+
+    plans = listPlans({a: {$gte: 10, $lte: 20}, b: 1, c: "v1"});
+    assert.eq(3, plans.usage.instantiated, tojson(plans));
+    assert.gte(plans.usage.hits, 4, tojson(plans));
+
+    // Values ordered differently from those the solution was planned for fall back to rebuilding.
+    assertSameResults({a: {$gte: 20, $lte: 10}, b: 1, c: "v1"});
+    assert.eq(after.rebuilt + 1, planCacheMetrics().rebuilt);
+
+    // Disabling parameterized solutions rebuilds every cached solution.
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryCacheParameterizedPlans: false}));
+    before = planCacheMetrics();
+    assertSameResults({a: {$gte: 100, $lte: 110}, b: 1, c: "v3"});
+    assert.eq(before.instantiated, planCacheMetrics().instantiated);
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryCacheParameterizedPlans: true}));
+}());
@@ -0,0 +1,86 @@
+// Tests that a cached plan whose executions examine many more keys and documents per result than
+// when it was cached is flagged as degraded, and that its alternatives get evaluated again in the
+// background, flipping the cached plan to the one which is now better.
+(function() {
+    "use strict";
+
+    var coll = db.plan_cache_reevaluation;
+    coll.drop();
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 1000; i++) {
+        bulk.insert({a: i, b: i});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.createIndex({a: 1}));
+    assert.commandWorked(coll.createIndex({b: 1}));
+
+    function setParameters(params) {
+        params.setParameter = 1;
+        assert.commandWorked(db.adminCommand(params));
+    }
+
+    function planCacheMetrics() {
+        return db.serverStatus().metrics.queryExecutor.planCache;
+    }
+
+    function query(aMax, bMax) {
+        return {a: {$gte: 0, $lte: aMax}, b: {$gte: 0, $lte: bMax}};
+    }
+
+    function cachedEntry() {
+        return assert.commandWorked(coll.runCommand("planCacheListPlans", {query: query(5, 999)}));
+    }
+
+    function cachedIndex() {
+        return cachedEntry().plans[0].reason.stats.inputStage.keyPattern;
+    }
+
+    var original = db.adminCommand({
+        getParameter: 1,
+        internalQueryCacheEvictionRatio: 1,
+        internalQueryCacheReevaluationWindow: 1
+    });
+    assert.commandWorked(original);
+
+    // Keep the works of the trial period from evicting the entry, so that only the feedback of
+    // completed executions replaces the cached plan.
+    setParameters({
+        internalQueryCacheEvictionRatio: 1000000,
+        internalQueryCacheReevaluationWindow: 5
+    });
+
+    // The index on 'a' wins for selective values of 'a', and its executions set the baseline.
+    for (var i = 0; i < 6; i++) {
+        assert.eq(6, coll.find(query(5, 999)).itcount());
+    }
+    assert.eq({a: 1}, cachedIndex());
+    var usage = cachedEntry().usage;
+    assert.eq(5, usage.executions, tojson(usage));
+    assert(!usage.degraded, tojson(usage));
+
+    // The same shape with selective values of 'b' makes the cached plan examine the whole index.
+    var before = planCacheMetrics();
+    for (var i = 0; i < 5; i++) {
+        assert.eq(6, coll.find(query(999, 5)).itcount());
+    }
+
+    assert.soon(function() {
+        return bsonWoCompare({b: 1}, cachedIndex()) === 0;
+    }, "cached plan did not flip to the index on 'b'");
+
+    usage = cachedEntry().usage;
+    assert.eq(1, usage.reevaluations, tojson(usage));
+    assert.eq(1, usage.flips, tojson(usage));
+    assert(!usage.degraded, tojson(usage));
+
+    var after = planCacheMetrics();
+    assert.eq(before.degraded + 1, after.degraded, tojson(after));
+    assert.eq(before.reevaluations + 1, after.reevaluations, tojson(after));
+    assert.eq(before.flips + 1, after.flips, tojson(after));
+
+    setParameters({
+        internalQueryCacheEvictionRatio: original.internalQueryCacheEvictionRatio,
+        internalQueryCacheReevaluationWindow: original.internalQueryCacheReevaluationWindow
+    });
+}());
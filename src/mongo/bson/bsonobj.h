@@ -177,6 +177,14 @@ public:
         return _ownedBuffer.get() != 0;
     }
 
+    /**
+     * Returns the buffer this object lives in. The object must be owned.
+     */
+    const SharedBuffer& sharedBuffer() const {
+        invariant(isOwned());
+        return _ownedBuffer;
+    }
+
     /** assure the data buffer is under the control of this BSONObj and not a remote buffer
         @see isOwned()
     */
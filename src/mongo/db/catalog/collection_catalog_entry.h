@@ -77,6 +77,21 @@ public:
 
     virtual bool isIndexReady(OperationContext* txn, StringData indexName) const = 0;
 
+    /**
+     * Returns the statistics last stored for the index with setIndexStatistics(), or an empty
+     * object if there are none.
+     */
+    virtual BSONObj getIndexStatistics(OperationContext* txn, StringData indexName) const {
+        return BSONObj();
+    }
+
+    /**
+     * Stores the statistics of an index. Engines which can't persist them ignore them.
+     */
+    virtual void setIndexStatistics(OperationContext* txn,
+                                    StringData indexName,
+                                    const BSONObj& statistics) {}
+
     virtual Status removeIndex(OperationContext* txn, StringData indexName) = 0;
 
     virtual Status prepareForIndexBuild(OperationContext* txn, const IndexDescriptor* spec) = 0;
@@ -35,13 +35,19 @@
 #include "mongo/db/catalog/collection_info_cache.h"
 
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_catalog_entry.h"
+#include "mongo/db/client.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/fts/fts_spec.h"
+#include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index_legacy.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/planner_ixselect.h"
 #include "mongo/db/service_context.h"
+#include "mongo/db/storage/recovery_unit.h"
 #include "mongo/util/clock_source.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/log.h"
@@ -205,6 +211,113 @@ void CollectionInfoCache::rebuildIndexData(OperationContext* txn) {
     _keysComputed = false;
     computeIndexKeys(txn);
     updatePlanCacheIndexEntries(txn);
+    loadIndexStatistics(txn);
+}
+
+void CollectionInfoCache::loadIndexStatistics(OperationContext* txn) {
+    _indexStatistics = StringMap<std::shared_ptr<const IndexStatistics>>();
+
+    const bool includeUnfinishedIndexes = false;
+    IndexCatalog::IndexIterator ii =
+        _collection->getIndexCatalog()->getIndexIterator(txn, includeUnfinishedIndexes);
+    while (ii.more()) {
+        const IndexDescriptor* desc = ii.next();
+        BSONObj obj = _collection->getCatalogEntry()->getIndexStatistics(txn, desc->indexName());
+        if (obj.isEmpty())
+            continue;
+
+        auto statistics = IndexStatistics::parse(obj);
+        if (!statistics.isOK()) {
+            warning() << "ignoring statistics of index " << desc->indexName() << " on "
+                      << _collection->ns() << ": " << statistics.getStatus();
+            continue;
+        }
+        _indexStatistics[desc->indexName()] =
+            std::make_shared<const IndexStatistics>(std::move(statistics.getValue()));
+    }
+}
+
+std::shared_ptr<const IndexStatistics> CollectionInfoCache::getIndexStatistics(
+    StringData indexName) const {
+    auto it = _indexStatistics.find(indexName);
+    return it == _indexStatistics.end() ? nullptr : it->second;
+}
+
+StatusWith<std::shared_ptr<const IndexStatistics>> CollectionInfoCache::sampleIndex(
+    OperationContext* txn, const IndexDescriptor* desc, int sampleSize) const {
+    // Requires at least a shared collection lock.
+    invariant(txn->lockState()->isCollectionLockedForMode(_collection->ns().ns(), MODE_IS));
+
+    if (sampleSize <= 0) {
+        return {ErrorCodes::BadValue, "the sample size has to be positive"};
+    }
+
+    const IndexAccessMethod* iam = _collection->getIndexCatalog()->getIndex(desc);
+    const long long numRecords = _collection->numRecords(txn);
+    long long numKeys = 0;
+    std::vector<BSONObj> sample;
+    sample.reserve(std::min<long long>(sampleSize, numRecords));
+
+    // Without multikey, sparse or partial indexes there is exactly one key per document, so the
+    // number of keys is known without reading them all.
+    const bool oneKeyPerRecord =
+        !desc->isMultikey(txn) && !desc->isSparse() && !desc->isPartial();
+    auto randomCursor = (oneKeyPerRecord && numRecords > sampleSize)
+        ? iam->newRandomCursor(txn)
+        : std::unique_ptr<SortedDataInterface::Cursor>();
+
+    if (randomCursor) {
+        numKeys = numRecords;
+        while (static_cast<int>(sample.size()) < sampleSize) {
+            auto entry = randomCursor->next();
+            if (!entry)
+                break;
+            sample.push_back(entry->key.getOwned());
+        }
+    } else {
+        // Reservoir sampling over a full scan, which also counts the keys.
+        BSONObjBuilder startKey;
+        for (auto&& field : desc->keyPattern()) {
+            if (field.isNumber() && field.numberInt() < 0) {
+                startKey.appendMaxKey("");
+            } else {
+                startKey.appendMinKey("");
+            }
+        }
+
+        PseudoRandom& prng = txn->getClient()->getPrng();
+        auto cursor = iam->newCursor(txn);
+        for (auto entry = cursor->seek(startKey.obj(), true); entry; entry = cursor->next()) {
+            numKeys++;
+            if (static_cast<int>(sample.size()) < sampleSize) {
+                sample.push_back(entry->key.getOwned());
+                continue;
+            }
+            const long long slot = prng.nextInt64(numKeys);
+            if (slot < sampleSize) {
+                sample[slot] = entry->key.getOwned();
+            }
+        }
+    }
+
+    return {std::make_shared<const IndexStatistics>(
+        IndexStatistics::build(std::move(sample), numKeys, numRecords))};
+}
+
+void CollectionInfoCache::setIndexStatistics(OperationContext* txn,
+                                             const IndexDescriptor* desc,
+                                             std::shared_ptr<const IndexStatistics> statistics) {
+    // Requires exclusive collection lock.
+    invariant(txn->lockState()->isCollectionLockedForMode(_collection->ns().ns(), MODE_X));
+
+    _collection->getCatalogEntry()->setIndexStatistics(
+        txn, desc->indexName(), statistics->toBSON());
+
+    const std::string indexName = desc->indexName();
+    txn->recoveryUnit()->onCommit([this, indexName, statistics]() {
+        _indexStatistics[indexName] = statistics;
+        clearQueryCache();
+    });
 }
 
 CollectionIndexUsageMap CollectionInfoCache::getIndexUsageStats() const {
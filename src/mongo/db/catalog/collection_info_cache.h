@@ -30,6 +30,9 @@
 
 #pragma once
 
+#include <memory>
+
+#include "mongo/base/status_with.h"
 #include "mongo/db/collection_index_usage_tracker.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
@@ -39,6 +42,7 @@ namespace mongo {
 
 class Collection;
 class IndexDescriptor;
+class IndexStatistics;
 class OperationContext;
 
 /**
@@ -73,6 +77,34 @@ public:
      */
     CollectionIndexUsageMap getIndexUsageStats() const;
 
+    /**
+     * Returns the statistics of the index named 'indexName' from the last time it was analyzed,
+     * or nullptr if it never was.
+     *
+     * Requires at least a shared collection lock.
+     */
+    std::shared_ptr<const IndexStatistics> getIndexStatistics(StringData indexName) const;
+
+    /**
+     * Computes the statistics of an index from a sample of about 'sampleSize' of its keys.
+     * Indexes no larger than the sample are read completely.
+     *
+     * Requires at least a shared collection lock.
+     */
+    StatusWith<std::shared_ptr<const IndexStatistics>> sampleIndex(OperationContext* txn,
+                                                                   const IndexDescriptor* desc,
+                                                                   int sampleSize) const;
+
+    /**
+     * Stores 'statistics' with the index in the catalog. Once the enclosing WriteUnitOfWork
+     * commits, the planner starts using them and the plan cache is cleared.
+     *
+     * Must be called under exclusive collection lock.
+     */
+    void setIndexStatistics(OperationContext* txn,
+                            const IndexDescriptor* desc,
+                            std::shared_ptr<const IndexStatistics> statistics);
+
     /**
      * Builds internal cache state based on the current state of the Collection's IndexCatalog
      */
@@ -122,8 +154,12 @@ private:
     // Tracks index usage statistics for this collection.
     CollectionIndexUsageTracker _indexUsageTracker;
 
+    // Statistics of the analyzed indexes, by index name.
+    StringMap<std::shared_ptr<const IndexStatistics>> _indexStatistics;
+
     void computeIndexKeys(OperationContext* txn);
     void updatePlanCacheIndexEntries(OperationContext* txn);
+    void loadIndexStatistics(OperationContext* txn);
 
     /**
      * Rebuilds cached information that is dependent on index composition. Must be called
@@ -89,6 +89,7 @@ struct CollectionOptions {
     enum UserFlags {
         Flag_UsePowerOf2Sizes = 1 << 0,
         Flag_NoPadding = 1 << 1,
+        Flag_Compressed = 1 << 2,  // MMAPv1 only, set at creation. Ignored if capped.
     };
     int flags;  // a bitvector of UserFlags
     bool flagsSet;
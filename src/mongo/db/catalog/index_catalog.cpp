@@ -145,6 +145,7 @@ IndexCatalogEntry* IndexCatalog::_setupInMemoryStructures(OperationContext* txn,
 
     entry->init(txn,
                 _collection->_dbce->getIndex(txn, _collection->getCatalogEntry(), entry.get()));
+    entry->accessMethod()->initBloomFilter(txn);
 
     IndexCatalogEntry* save = entry.get();
     _entries.add(entry.release());
@@ -34,6 +34,9 @@
 
 #include "mongo/db/catalog/index_create.h"
 
+#include <algorithm>
+#include <deque>
+#include <utility>
 
 #include "mongo/base/error_codes.h"
 #include "mongo/client/dbclientinterface.h"
@@ -48,7 +51,10 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
@@ -59,6 +65,195 @@ using std::unique_ptr;
 using std::string;
 using std::endl;
 
+// With 1 the keys are generated on the thread scanning the collection.
+MONGO_EXPORT_SERVER_PARAMETER(indexBuildKeyGenerationThreads, int, 1);
+
+namespace {
+
+const int kMaxKeyGenerationThreads = 64;
+
+// Documents are handed to the key generation threads in batches of up to this many documents or
+// bytes, whichever is reached first.
+const size_t kMaxBatchDocs = 1000;
+const size_t kMaxBatchBytes = 4 * 1024 * 1024;
+
+// Batches which should fit into the memory for buffered documents per key generation thread, so
+// that each has another batch queued while it works on one.
+const size_t kMinBufferedBatchesPerThread = 2;
+
+}  // namespace
+
+/**
+ * Generates the keys of a foreground build on a set of worker threads while the build's thread
+ * scans the collection. Worker i adds keys to the i-th BulkBuilder of every index, so that the
+ * builders need no synchronization; each sorts its partition of the keys on the worker's thread
+ * and doneInserting() merges the partitions. The scan hands documents over in batches through a
+ * queue. The documents of the batches which are queued, being worked on or being filled are
+ * limited to 'maxBufferedBytes', so the scan waits whenever the workers fall behind.
+ */
+class MultiIndexBlock::ParallelKeyGenerator {
+    MONGO_DISALLOW_COPYING(ParallelKeyGenerator);
+
+public:
+    ParallelKeyGenerator(MultiIndexBlock* indexer, size_t numWorkers, size_t maxBufferedBytes)
+        : _indexer(indexer),
+          _maxBufferedBytes(maxBufferedBytes),
+          _maxBatchBytes(std::max<size_t>(
+              1,
+              std::min(kMaxBatchBytes,
+                       maxBufferedBytes / (kMinBufferedBatchesPerThread * numWorkers)))) {
+        for (size_t i = 0; i < numWorkers; i++) {
+            _workers.emplace_back([this, i] { _workerThread(i); });
+        }
+    }
+
+    ~ParallelKeyGenerator() {
+        {
+            // Stop without processing queued batches if finish() wasn't reached.
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _done = true;
+            _clearQueue_inlock();
+        }
+        _workAvailable.notify_all();
+        _joinWorkers();
+    }
+
+    /**
+     * Queues 'doc' for key generation. Returns the first error of any worker instead, after
+     * which nothing more should be added.
+     */
+    Status add(const BSONObj& doc, const RecordId& loc) {
+        Status status = _reserve(doc.objsize());
+        if (!status.isOK())
+            return status;
+
+        _pending.docs.emplace_back(doc.getOwned(), loc);
+        _pending.bytes += doc.objsize();
+        if (_pending.docs.size() < kMaxBatchDocs && _pending.bytes < _maxBatchBytes)
+            return Status::OK();
+        return _flush();
+    }
+
+    /**
+     * Waits until all keys have been generated and returns the first error of any worker.
+     */
+    Status finish() {
+        Status status = _pending.docs.empty() ? Status::OK() : _flush();
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _done = true;
+        }
+        _workAvailable.notify_all();
+        _joinWorkers();
+
+        if (!status.isOK())
+            return status;
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _status;
+    }
+
+private:
+    struct Batch {
+        std::vector<std::pair<BSONObj, RecordId>> docs;
+        size_t bytes = 0;
+    };
+
+    // Waits until another 'bytes' of documents fit into the buffer. Once the workers are done
+    // with everything handed to them, the document is admitted even if it doesn't fit, since
+    // nothing else would free up space.
+    Status _reserve(size_t bytes) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _spaceAvailable.wait(lk, [&] {
+            return _bufferedBytes + bytes <= _maxBufferedBytes ||
+                _bufferedBytes == _pending.bytes || !_status.isOK();
+        });
+        if (!_status.isOK())
+            return _status;
+        _bufferedBytes += bytes;
+        return Status::OK();
+    }
+
+    Status _flush() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (!_status.isOK())
+            return _status;
+
+        _queue.push_back(std::move(_pending));
+        _pending = Batch();
+        _workAvailable.notify_one();
+        return Status::OK();
+    }
+
+    void _clearQueue_inlock() {
+        for (auto&& batch : _queue) {
+            _bufferedBytes -= batch.bytes;
+        }
+        _queue.clear();
+        _spaceAvailable.notify_all();
+    }
+
+    void _workerThread(size_t partition) {
+        while (true) {
+            Batch batch;
+            {
+                stdx::unique_lock<stdx::mutex> lk(_mutex);
+                _workAvailable.wait(lk, [this] { return _done || !_queue.empty(); });
+                if (_queue.empty())
+                    return;
+                batch = std::move(_queue.front());
+                _queue.pop_front();
+            }
+
+            Status status = Status::OK();
+            try {
+                for (auto&& doc : batch.docs) {
+                    status = _indexer->_insert(nullptr, doc.first, doc.second, partition);
+                    if (!status.isOK())
+                        break;
+                }
+            } catch (const DBException& e) {
+                status = e.toStatus();
+            }
+
+            // The documents stay buffered until their keys are in the builders.
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _bufferedBytes -= batch.bytes;
+            _spaceAvailable.notify_all();
+            if (!status.isOK()) {
+                if (_status.isOK())
+                    _status = status;
+                _clearQueue_inlock();
+            }
+        }
+    }
+
+    void _joinWorkers() {
+        for (auto&& worker : _workers) {
+            if (worker.joinable())
+                worker.join();
+        }
+    }
+
+    MultiIndexBlock* const _indexer;
+    std::vector<stdx::thread> _workers;
+
+    const size_t _maxBufferedBytes;
+    const size_t _maxBatchBytes;
+
+    // The batch being filled by the scanning thread.
+    Batch _pending;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _workAvailable;
+    stdx::condition_variable _spaceAvailable;
+    std::deque<Batch> _queue;
+
+    // Bytes of the documents in the pending, queued and in progress batches.
+    size_t _bufferedBytes = 0;
+    bool _done = false;
+    Status _status = Status::OK();
+};
+
 /**
  * On rollback sets MultiIndexBlock::_needToCleanup to true.
  */
@@ -188,7 +383,7 @@ Status MultiIndexBlock::init(const std::vector<BSONObj>& indexSpecs) {
         if (!_buildInBackground) {
             // Bulk build process requires foreground building as it assumes nothing is changing
             // under it.
-            index.bulk = index.real->initiateBulk();
+            index.bulks.push_back(index.real->initiateBulk());
         }
 
         const IndexDescriptor* descriptor = index.block->getEntry()->descriptor();
@@ -198,7 +393,7 @@ Status MultiIndexBlock::init(const std::vector<BSONObj>& indexSpecs) {
             repl::getGlobalReplicationCoordinator()->shouldIgnoreUniqueIndex(descriptor);
 
         log() << "build index on: " << ns << " properties: " << descriptor->toString();
-        if (index.bulk)
+        if (!index.bulks.empty())
             log() << "\t building index using bulk method";
 
         index.filterExpression = index.block->getEntry()->getFilterExpression();
@@ -227,6 +422,28 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(std::set<RecordId>* dupsO
 
     unsigned long long n = 0;
 
+    // Generating keys in parallel requires bulk builds, which are foreground only. The builders
+    // are still empty, so they can be replaced by one per worker sharing the memory budget. The
+    // documents buffered for the workers take a quarter of that budget off each index.
+    std::unique_ptr<ParallelKeyGenerator> keyGenerator;
+    const size_t numKeyGenerationThreads =
+        std::min(std::max(1, indexBuildKeyGenerationThreads.load()), kMaxKeyGenerationThreads);
+    if (!_buildInBackground && numKeyGenerationThreads > 1) {
+        const size_t maxBufferedBytes = IndexAccessMethod::kDefaultBulkMaxMemoryUsageBytes / 4;
+        const size_t maxSortBytes =
+            IndexAccessMethod::kDefaultBulkMaxMemoryUsageBytes - maxBufferedBytes;
+        for (auto&& index : _indexes) {
+            index.bulks.clear();
+            for (size_t i = 0; i < numKeyGenerationThreads; i++) {
+                index.bulks.push_back(
+                    index.real->initiateBulk(maxSortBytes / numKeyGenerationThreads));
+            }
+        }
+        keyGenerator.reset(
+            new ParallelKeyGenerator(this, numKeyGenerationThreads, maxBufferedBytes));
+        log() << "\t generating keys on " << numKeyGenerationThreads << " threads";
+    }
+
     unique_ptr<PlanExecutor> exec(InternalPlanner::collectionScan(
         _txn, _collection->ns().ns(), _collection, PlanExecutor::YIELD_MANUAL));
     if (_buildInBackground) {
@@ -258,7 +475,8 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(std::set<RecordId>* dupsO
             progress->setTotalWhileRunning(_collection->numRecords(_txn));
 
             WriteUnitOfWork wunit(_txn);
-            Status ret = insert(objToIndex.value(), loc);
+            Status ret = keyGenerator ? keyGenerator->add(objToIndex.value(), loc)
+                                      : insert(objToIndex.value(), loc);
             if (ret.isOK()) {
                 wunit.commit();
             } else if (dupsOut && ret.code() == ErrorCodes::DuplicateKey) {
@@ -294,6 +512,16 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(std::set<RecordId>* dupsO
 
     progress->finished();
 
+    if (keyGenerator) {
+        {
+            stdx::lock_guard<Client> lk(*_txn->getClient());
+            CurOp::get(_txn)->setMessage_inlock("Index Build: generating keys");
+        }
+        Status status = keyGenerator->finish();
+        if (!status.isOK())
+            return status;
+    }
+
     Status ret = doneInserting(dupsOut);
     if (!ret.isOK())
         return ret;
@@ -305,6 +533,13 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(std::set<RecordId>* dupsO
 }
 
 Status MultiIndexBlock::insert(const BSONObj& doc, const RecordId& loc) {
+    return _insert(_txn, doc, loc, 0);
+}
+
+Status MultiIndexBlock::_insert(OperationContext* txn,
+                                const BSONObj& doc,
+                                const RecordId& loc,
+                                size_t partition) {
     for (size_t i = 0; i < _indexes.size(); i++) {
         if (_indexes[i].filterExpression && !_indexes[i].filterExpression->matchesBSON(doc)) {
             continue;
@@ -312,10 +547,12 @@ Status MultiIndexBlock::insert(const BSONObj& doc, const RecordId& loc) {
 
         int64_t unused;
         Status idxStatus(ErrorCodes::InternalError, "");
-        if (_indexes[i].bulk) {
-            idxStatus = _indexes[i].bulk->insert(_txn, doc, loc, _indexes[i].options, &unused);
+        if (!_indexes[i].bulks.empty()) {
+            idxStatus = _indexes[i].bulks[partition]->insert(
+                txn, doc, loc, _indexes[i].options, &unused);
         } else {
-            idxStatus = _indexes[i].real->insert(_txn, doc, loc, _indexes[i].options, &unused);
+            invariant(txn);
+            idxStatus = _indexes[i].real->insert(txn, doc, loc, _indexes[i].options, &unused);
         }
 
         if (!idxStatus.isOK())
@@ -326,12 +563,12 @@ Status MultiIndexBlock::insert(const BSONObj& doc, const RecordId& loc) {
 
 Status MultiIndexBlock::doneInserting(std::set<RecordId>* dupsOut) {
     for (size_t i = 0; i < _indexes.size(); i++) {
-        if (_indexes[i].bulk == NULL)
+        if (_indexes[i].bulks.empty())
             continue;
         LOG(1) << "\t bulk commit starting for index: "
                << _indexes[i].block->getEntry()->descriptor()->indexName();
         Status status = _indexes[i].real->commitBulk(_txn,
-                                                     std::move(_indexes[i].bulk),
+                                                     std::move(_indexes[i].bulks),
                                                      _allowInterruption,
                                                      _indexes[i].options.dupsAllowed,
                                                      dupsOut);
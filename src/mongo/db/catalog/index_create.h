@@ -30,6 +30,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <set>
 #include <string>
@@ -47,6 +48,9 @@ class BSONObj;
 class Collection;
 class OperationContext;
 
+// Number of threads generating the keys of a foreground insertAllDocumentsInCollection().
+extern std::atomic<int> indexBuildKeyGenerationThreads;  // NOLINT
+
 /**
  * Builds one or more indexes.
  *
@@ -190,6 +194,7 @@ public:
 private:
     class SetNeedToCleanupOnRollback;
     class CleanupIndexesVectorOnRollback;
+    class ParallelKeyGenerator;
 
     struct IndexToBuild {
 #if defined(_MSC_VER) && _MSC_VER < 1900  // MVSC++ <= 2013 can't generate default move operations
@@ -197,7 +202,7 @@ private:
         IndexToBuild(IndexToBuild&& other)
             : block(std::move(other.block)),
               real(std::move(other.real)),
-              bulk(std::move(other.bulk)),
+              bulks(std::move(other.bulks)),
               options(std::move(other.options)),
               filterExpression(std::move(other.filterExpression)) {}
 
@@ -205,7 +210,7 @@ private:
             block = std::move(other.block);
             real = std::move(other.real);
             filterExpression = std::move(other.filterExpression);
-            bulk = std::move(other.bulk);
+            bulks = std::move(other.bulks);
             options = std::move(other.options);
             return *this;
         }
@@ -215,11 +220,22 @@ private:
 
         IndexAccessMethod* real = NULL;           // owned elsewhere
         const MatchExpression* filterExpression;  // might be NULL, owned elsewhere
-        std::unique_ptr<IndexAccessMethod::BulkBuilder> bulk;
+        // Empty for background builds. Otherwise one BulkBuilder per partition of the documents,
+        // see ParallelKeyGenerator.
+        std::vector<std::unique_ptr<IndexAccessMethod::BulkBuilder>> bulks;
 
         InsertDeleteOptions options;
     };
 
+    /**
+     * Inserts 'doc' into every index, using the BulkBuilders of 'partition' for bulk builds.
+     * 'txn' may only be null for bulk builds.
+     */
+    Status _insert(OperationContext* txn,
+                   const BSONObj& doc,
+                   const RecordId& loc,
+                   size_t partition);
+
     std::vector<IndexToBuild> _indexes;
 
     std::unique_ptr<BackgroundOperation> _backgroundOperation;
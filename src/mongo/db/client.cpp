@@ -91,6 +91,21 @@ void Client::destroy() {
     currentClient.reset(nullptr);
 }
 
+ServiceContext::UniqueClient Client::releaseCurrent() {
+    invariant(currentClient.get());
+    invariant(currentClient.get()->get());
+    return std::move(*currentClient.get());
+}
+
+void Client::setCurrent(ServiceContext::UniqueClient client) {
+    invariant(client);
+    invariant(currentClient.getMake()->get() == nullptr);
+
+    setThreadName(client->desc());
+    client->_threadId = stdx::this_thread::get_id();
+    *currentClient.get() = std::move(client);
+}
+
 namespace {
 int64_t generateSeed(const std::string& desc) {
     size_t seed = 0;
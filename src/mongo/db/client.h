@@ -90,6 +90,22 @@ public:
      */
     static void destroy();
 
+    /**
+     * Detaches the Client object stored in TLS for the current thread and returns it to the
+     * caller. The current thread must have a Client.
+     *
+     * Used by service executors which multiplex many connections over a pool of worker threads,
+     * so that a connection's Client can be carried from one worker to the next between requests.
+     */
+    static ServiceContext::UniqueClient releaseCurrent();
+
+    /**
+     * Attaches 'client' to the current thread, which must not already have a Client. The thread
+     * name is set to the description of the client and the client records the current thread as
+     * its owner.
+     */
+    static void setCurrent(ServiceContext::UniqueClient client);
+
     std::string clientAddress(bool includePort = false) const;
     const std::string& desc() const {
         return _desc;
@@ -165,8 +181,9 @@ private:
     // Description for the client (e.g. conn8)
     const std::string _desc;
 
-    // OS id of the thread, which owns this client
-    const stdx::thread::id _threadId;
+    // OS id of the thread, which owns this client. Changes when the client is moved to another
+    // thread through setCurrent().
+    stdx::thread::id _threadId;
 
     // > 0 for things "conn", 0 otherwise
     const ConnectionId _connectionId;
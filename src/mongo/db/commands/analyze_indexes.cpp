@@ -0,0 +1,228 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kCommand
+
+#include "mongo/platform/basic.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_info_cache.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/index_statistics.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+struct AnalyzedIndex {
+    std::string name;
+    BSONObj keyPattern;
+    std::shared_ptr<const IndexStatistics> statistics;
+};
+
+bool canAnalyze(const IndexDescriptor* desc) {
+    const std::string& accessMethod = desc->getAccessMethodName();
+    return accessMethod == IndexNames::BTREE || accessMethod == IndexNames::HASHED;
+}
+
+/**
+ * Computes the statistics the planner uses to estimate the cost of index scans, from a sample of
+ * the keys of each index of a collection, and stores them with the index in the catalog.
+ *
+ * Statistics are local to a node and are not replicated.
+ */
+class AnalyzeIndexesCmd : public Command {
+public:
+    AnalyzeIndexesCmd() : Command("analyzeIndexes") {}
+
+    bool isWriteCommandForConfigServer() const override {
+        return false;
+    }
+
+    bool slaveOk() const override {
+        return true;
+    }
+
+    void help(std::stringstream& help) const override {
+        help << "computes statistics about the keys of indexes, used to estimate the cost of "
+                "query plans\n"
+                "{ analyzeIndexes : <collection>, [index : <name>], [sampleSize : <n>] }\n"
+                " analyzes all btree and hashed indexes of the collection unless one is named";
+    }
+
+    void addRequiredPrivileges(const std::string& dbname,
+                               const BSONObj& cmdObj,
+                               std::vector<Privilege>* out) override {
+        ActionSet actions;
+        actions.addAction(ActionType::planCacheWrite);
+        out->push_back(
+            Privilege(ResourcePattern::forExactNamespace(NamespaceString(parseNs(dbname, cmdObj))),
+                      actions));
+    }
+
+    bool run(OperationContext* txn,
+             const std::string& dbname,
+             BSONObj& cmdObj,
+             int,
+             std::string& errmsg,
+             BSONObjBuilder& result) override {
+        const NamespaceString nss(parseNsCollectionRequired(dbname, cmdObj));
+
+        int sampleSize = internalQueryIndexStatisticsSampleSize.load();
+        if (cmdObj.hasField("sampleSize")) {
+            if (!cmdObj["sampleSize"].isNumber() || cmdObj["sampleSize"].numberInt() <= 0) {
+                return appendCommandStatus(
+                    result, {ErrorCodes::BadValue, "sampleSize has to be a positive number"});
+            }
+            sampleSize = cmdObj["sampleSize"].numberInt();
+        }
+
+        std::string indexName;
+        if (cmdObj.hasField("index")) {
+            if (cmdObj["index"].type() != String) {
+                return appendCommandStatus(
+                    result, {ErrorCodes::BadValue, "index has to be the name of an index"});
+            }
+            indexName = cmdObj["index"].String();
+        }
+
+        // Sampling may read entire indexes, so it only takes a shared lock. The exclusive lock is
+        // taken afterwards, just to store the results.
+        std::vector<AnalyzedIndex> analyzed;
+        {
+            AutoGetCollectionForRead ctx(txn, nss);
+            Collection* collection = ctx.getCollection();
+            if (!collection) {
+                return appendCommandStatus(
+                    result,
+                    {ErrorCodes::NamespaceNotFound, str::stream() << "ns not found: " << nss.ns()});
+            }
+
+            std::vector<const IndexDescriptor*> indexes;
+            if (!indexName.empty()) {
+                const IndexDescriptor* desc =
+                    collection->getIndexCatalog()->findIndexByName(txn, indexName);
+                if (!desc) {
+                    return appendCommandStatus(result,
+                                               {ErrorCodes::IndexNotFound,
+                                                str::stream() << "index not found: " << indexName});
+                }
+                if (!canAnalyze(desc)) {
+                    return appendCommandStatus(result,
+                                               {ErrorCodes::BadValue,
+                                                str::stream() << "can't analyze " << indexName
+                                                              << ", only btree and hashed indexes "
+                                                                 "have statistics"});
+                }
+                indexes.push_back(desc);
+            } else {
+                IndexCatalog::IndexIterator ii =
+                    collection->getIndexCatalog()->getIndexIterator(txn, false);
+                while (ii.more()) {
+                    const IndexDescriptor* desc = ii.next();
+                    if (canAnalyze(desc)) {
+                        indexes.push_back(desc);
+                    }
+                }
+            }
+
+            for (auto&& desc : indexes) {
+                auto statistics = collection->infoCache()->sampleIndex(txn, desc, sampleSize);
+                if (!statistics.isOK()) {
+                    return appendCommandStatus(result, statistics.getStatus());
+                }
+                analyzed.push_back(
+                    {desc->indexName(), desc->keyPattern().getOwned(), statistics.getValue()});
+            }
+        }
+
+        ScopedTransaction transaction(txn, MODE_IX);
+        AutoGetDb autoDb(txn, nss.db(), MODE_IX);
+        Lock::CollectionLock collLock(txn->lockState(), nss.ns(), MODE_X);
+
+        Collection* collection = autoDb.getDb() ? autoDb.getDb()->getCollection(nss) : nullptr;
+        if (!collection) {
+            return appendCommandStatus(
+                result,
+                {ErrorCodes::NamespaceNotFound, str::stream() << "ns not found: " << nss.ns()});
+        }
+
+        BSONObjBuilder indexesBuilder(result.subobjStart("indexes"));
+        for (auto&& index : analyzed) {
+            // Skip indexes which were dropped or replaced while they were sampled.
+            const IndexDescriptor* desc =
+                collection->getIndexCatalog()->findIndexByName(txn, index.name);
+            if (!desc || desc->keyPattern() != index.keyPattern) {
+                continue;
+            }
+
+            MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
+                WriteUnitOfWork wunit(txn);
+                collection->infoCache()->setIndexStatistics(txn, desc, index.statistics);
+                wunit.commit();
+            }
+            MONGO_WRITE_CONFLICT_RETRY_LOOP_END(txn, "analyzeIndexes", nss.ns());
+
+            const IndexStatistics& statistics = *index.statistics;
+            BSONObjBuilder indexBuilder(indexesBuilder.subobjStart(index.name));
+            indexBuilder.append("numKeys", statistics.numKeys());
+            indexBuilder.append("sampleSize", statistics.sampleSize());
+            indexBuilder.append("distinctKeys", statistics.distinctKeys());
+            indexBuilder.append("distinctValues", statistics.distinctLeadingValues());
+            indexBuilder.append("buckets", static_cast<int>(statistics.buckets().size()));
+            indexBuilder.doneFast();
+
+            LOG(1) << "analyzed index " << index.name << " on " << nss.ns() << ": "
+                   << statistics.toBSON();
+        }
+        indexesBuilder.doneFast();
+        return true;
+    }
+} analyzeIndexesCmd;
+
+}  // namespace
+}  // namespace mongo
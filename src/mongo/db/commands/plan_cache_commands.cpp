@@ -436,6 +436,14 @@ Status PlanCacheListPlans::list(OperationContext* txn,
     }
     plansBuilder.doneFast();
 
+    // Whether queries of the shape get their solution by substituting their values into the
+    // cached one, how often they did, and how the executions of the plan went, including whether
+    // it degraded and how often the winning plan of the shape changed.
+    bob->append("parameterized", static_cast<bool>(entry->planTemplate));
+    BSONObjBuilder usageBob(bob->subobjStart("usage"));
+    entry->usage->appendStats(&usageBob);
+    usageBob.doneFast();
+
     return Status::OK();
 }
 
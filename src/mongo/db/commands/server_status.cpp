@@ -44,6 +44,7 @@
 #include "mongo/db/commands/server_status_internal.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/platform/process_id.h"
@@ -284,6 +285,11 @@ public:
     BSONObj generateSection(OperationContext* txn, const BSONElement& configElement) const {
         BSONObjBuilder b;
         networkCounter.append(b);
+        if (serverGlobalParams.serviceExecutor != "synchronous") {
+            BSONObjBuilder executor(b.subobjStart("serviceExecutor"));
+            executor.append("mode", serverGlobalParams.serviceExecutor);
+            serviceExecutorCounter.append(executor);
+        }
         return b.obj();
     }
 
@@ -247,6 +247,7 @@ void CondVarLockGrantNotification::notify(ResourceId resId, LockResult result) {
 
 namespace {
 TicketHolder* ticketHolders[LockModesCount] = {};
+FairTicketHolder* fairTicketHolders[LockModesCount] = {};
 }  // namespace
 
 
@@ -261,6 +262,14 @@ void Locker::setGlobalThrottling(class TicketHolder* reading, class TicketHolder
     ticketHolders[MODE_IX] = writing;
 }
 
+/* static */
+void Locker::setGlobalAdmissionControl(class FairTicketHolder* reading,
+                                       class FairTicketHolder* writing) {
+    fairTicketHolders[MODE_S] = reading;
+    fairTicketHolders[MODE_IS] = reading;
+    fairTicketHolders[MODE_IX] = writing;
+}
+
 template <bool IsForMMAPV1>
 LockerImpl<IsForMMAPV1>::LockerImpl()
     : _id(idCounter.addAndFetch(1)), _wuowNestingLevel(0), _batchWriter(false) {}
@@ -303,8 +312,12 @@ LockResult LockerImpl<IsForMMAPV1>::lockGlobalBegin(LockMode mode) {
     dassert(isLocked() == (_modeForTicket != MODE_NONE));
     if (_modeForTicket == MODE_NONE) {
         const bool reader = isSharedLockMode(mode);
+        auto fairHolder = fairTicketHolders[mode];
         auto holder = ticketHolders[mode];
-        if (holder) {
+        if (fairHolder) {
+            _clientState.store(reader ? kQueuedReader : kQueuedWriter);
+            _fairTicket = fairHolder->waitForTicket(_admissionTenant);
+        } else if (holder) {
             _clientState.store(reader ? kQueuedReader : kQueuedWriter);
             holder->waitForTicket();
         }
@@ -787,9 +800,12 @@ bool LockerImpl<IsForMMAPV1>::_unlockImpl(LockRequestsMap::Iterator* it) {
     if (globalLockManager.unlock(it->objAddr())) {
         if (it->key() == resourceIdGlobal) {
             invariant(_modeForTicket != MODE_NONE);
+            auto fairHolder = fairTicketHolders[_modeForTicket];
             auto holder = ticketHolders[_modeForTicket];
             _modeForTicket = MODE_NONE;
-            if (holder) {
+            if (_fairTicket.isValid()) {
+                fairHolder->release(&_fairTicket);
+            } else if (holder) {
                 holder->release();
             }
             _clientState.store(kInactive);
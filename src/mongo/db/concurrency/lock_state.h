@@ -29,10 +29,12 @@
 #pragma once
 
 #include <queue>
+#include <string>
 
 #include "mongo/db/concurrency/fast_map_noalloc.h"
 #include "mongo/db/concurrency/locker.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/fair_ticket_holder.h"
 #include "mongo/util/concurrency/spin_lock.h"
 
 namespace mongo {
@@ -95,6 +97,10 @@ public:
 
     virtual ClientState getClientState() const;
 
+    virtual void setAdmissionTenant(StringData tenant) {
+        _admissionTenant = tenant.toString();
+    }
+
     virtual LockerId getId() const {
         return _id;
     }
@@ -219,6 +225,10 @@ private:
     // Mode for which the Locker acquired a ticket, or MODE_NONE if no ticket was acquired.
     LockMode _modeForTicket = MODE_NONE;
 
+    // Tenant to queue under, and the ticket granted to it, when admission control is enabled.
+    std::string _admissionTenant;
+    FairTicketHolder::Ticket _fairTicket;
+
     // Indicates whether the client is active reader/writer or is queued.
     AtomicWord<ClientState> _clientState{kInactive};
 
@@ -57,6 +57,20 @@ public:
      */
     static void setGlobalThrottling(class TicketHolder* reading, class TicketHolder* writing);
 
+    /**
+     * Like setGlobalThrottling, but shares the tickets fairly between the tenants named through
+     * setAdmissionTenant. Takes precedence over setGlobalThrottling for the same modes.
+     */
+    static void setGlobalAdmissionControl(class FairTicketHolder* reading,
+                                          class FairTicketHolder* writing);
+
+    /**
+     * Names the tenant (e.g. database) on whose behalf this locker acquires the global lock. Only
+     * used to pick the queue when admission control is enabled, and must be set before the global
+     * lock is acquired in order to take effect.
+     */
+    virtual void setAdmissionTenant(StringData tenant) = 0;
+
     /**
      * State for reporting the number of active and queued reader and writer clients.
      */
@@ -49,6 +49,8 @@ public:
         invariant(false);
     }
 
+    virtual void setAdmissionTenant(StringData tenant) {}
+
     virtual LockResult lockGlobal(LockMode mode, unsigned timeoutMs) {
         invariant(false);
     }
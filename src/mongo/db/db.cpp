@@ -73,6 +73,7 @@
 #include "mongo/db/op_observer.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/plan_cache_reevaluator.h"
 #include "mongo/db/range_deleter_service.h"
 #include "mongo/db/repair_database.h"
 #include "mongo/db/repl/oplog.h"
@@ -635,6 +636,8 @@ static void _initAndListen(int listenPort) {
 
     startClientCursorMonitor();
 
+    startPlanCacheReevaluator();
+
     startAuditLogFlusher();
 
     PeriodicTask::startRunningPeriodicTasks();
@@ -47,6 +47,8 @@
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -59,13 +61,15 @@ CachedPlanStage::CachedPlanStage(OperationContext* txn,
                                  CanonicalQuery* cq,
                                  const QueryPlannerParams& params,
                                  size_t decisionWorks,
+                                 std::shared_ptr<PlanCacheEntryUsage> usage,
                                  PlanStage* root)
     : PlanStage(kStageType, txn),
       _collection(collection),
       _ws(ws),
       _canonicalQuery(cq),
       _plannerParams(params),
-      _decisionWorks(decisionWorks) {
+      _decisionWorks(decisionWorks),
+      _usage(std::move(usage)) {
     invariant(_collection);
     _children.emplace_back(root);
 }
@@ -75,6 +79,8 @@ Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     // execution work that happens here, so this is needed for the time accounting to
     // make sense.
     ScopedTimer timer(&_commonStats.executionTimeMillis);
+    const unsigned long long startMicros = curTimeMicros64();
+    ON_BLOCK_EXIT([this, startMicros] { _executionMicros += curTimeMicros64() - startMicros; });
 
     // If we work this many times during the trial period, then we will replan the
     // query from scratch.
@@ -196,6 +202,8 @@ Status CachedPlanStage::tryYield(PlanYieldPolicy* yieldPolicy) {
 }
 
 Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy, bool shouldCache) {
+    _replanned = true;
+
     // We're going to start over with a new plan. Clear out info from our old plan.
     _results.clear();
     _ws->clear();
@@ -285,6 +293,7 @@ PlanStage::StageState CachedPlanStage::work(WorkingSetID* out) {
     ScopedTimer timer(&_commonStats.executionTimeMillis);
 
     if (isEOF()) {
+        recordExecution();
         return PlanStage::IS_EOF;
     }
 
@@ -297,7 +306,9 @@ PlanStage::StageState CachedPlanStage::work(WorkingSetID* out) {
     }
 
     // Nothing left in trial period buffer.
+    const unsigned long long startMicros = curTimeMicros64();
     StageState childStatus = child()->work(out);
+    _executionMicros += curTimeMicros64() - startMicros;
 
     if (PlanStage::ADVANCED == childStatus) {
         _commonStats.advanced++;
@@ -305,6 +316,8 @@ PlanStage::StageState CachedPlanStage::work(WorkingSetID* out) {
         _commonStats.needYield++;
     } else if (PlanStage::NEED_TIME == childStatus) {
         _commonStats.needTime++;
+    } else if (PlanStage::IS_EOF == childStatus) {
+        recordExecution();
     }
 
     return childStatus;
@@ -353,4 +366,32 @@ void CachedPlanStage::updatePlanCache() {
     }
 }
 
+void CachedPlanStage::recordExecution() {
+    if (!_usage || _executionRecorded || _replanned) {
+        return;
+    }
+    _executionRecorded = true;
+
+    PlanSummaryStats summary;
+    Explain::getSummaryStats(child().get(), &summary);
+    if (!_usage->recordExecution(summary.totalKeysExamined,
+                                 summary.totalDocsExamined,
+                                 _commonStats.advanced,
+                                 _executionMicros)) {
+        return;
+    }
+
+    planCacheDegradedEntries.increment();
+    LOG(1) << "Cached plan degraded, examining " << summary.totalKeysExamined << " keys and "
+           << summary.totalDocsExamined << " documents for " << _commonStats.advanced
+           << " results. query: " << _canonicalQuery->toStringShort()
+           << " planSummary: " << Explain::getPlanSummary(child().get());
+
+    if (internalQueryCacheBackgroundReevaluation &&
+        !PlanCacheReevaluationQueue::get().push(*_canonicalQuery, _usage)) {
+        LOG(1) << "Not re-evaluating the plans of degraded cache entry, too many queued: "
+               << _canonicalQuery->toStringShort();
+    }
+}
+
 }  // namespace mongo
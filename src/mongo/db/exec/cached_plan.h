@@ -42,6 +42,7 @@
 
 namespace mongo {
 
+class PlanCacheEntryUsage;
 class PlanYieldPolicy;
 
 /**
@@ -59,6 +60,7 @@ public:
                     CanonicalQuery* cq,
                     const QueryPlannerParams& params,
                     size_t decisionWorks,
+                    std::shared_ptr<PlanCacheEntryUsage> usage,
                     PlanStage* root);
 
     bool isEOF() final;
@@ -96,6 +98,12 @@ private:
      */
     void updatePlanCache();
 
+    /**
+     * Records the completed execution of the cached plan in the usage of its cache entry, and
+     * queues the query for the alternative plans to be evaluated again if the plan degraded.
+     */
+    void recordExecution();
+
     /**
      * Uses the QueryPlanner and the MultiPlanStage to re-generate candidate plans for this
      * query and select a new winner.
@@ -129,6 +137,15 @@ private:
     // cached.
     size_t _decisionWorks;
 
+    // Usage of the cache entry the plan comes from. May be null.
+    std::shared_ptr<PlanCacheEntryUsage> _usage;
+
+    // Time spent running the plan, and whether the execution has been recorded in '_usage'. An
+    // execution which replanned isn't recorded, as it didn't run the cached plan.
+    long long _executionMicros = 0;
+    bool _executionRecorded = false;
+    bool _replanned = false;
+
     // If we fall back to re-planning the query, and there is just one resulting query solution,
     // that solution is owned here.
     std::unique_ptr<QuerySolution> _replannedQs;
@@ -38,6 +38,7 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/fail_point_service.h"
@@ -66,6 +67,10 @@ CollectionScan::CollectionScan(OperationContext* txn,
       _wsidForFetch(_workingSet->allocate()) {
     // Explain reports the direction of the collection scan.
     _specificStats.direction = params.direction;
+
+    if (_filter && internalQueryCompileMatchExpressions.load()) {
+        _compiledFilter = CompiledMatchExpression::compile(_filter);
+    }
 }
 
 PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
@@ -170,12 +175,99 @@ PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
     return returnIfMatches(member, id, out);
 }
 
+PlanStage::StageState CollectionScan::workBatch(size_t maxResults,
+                                                std::vector<WorkingSetID>* results,
+                                                WorkingSetID* out) {
+    // Creating and positioning the cursor, tailing and maxScan are left to work().
+    if (!canReadNextInline()) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        const StageState state = work(&id);
+        if (PlanStage::ADVANCED == state) {
+            results->push_back(id);
+        } else {
+            *out = id;
+        }
+        return state;
+    }
+
+    // Adds the amount of time taken by the whole batch to executionTimeMillis.
+    ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+    size_t numResults = 0;
+    size_t numNeedTime = 0;
+    WorkingSetMember* lastReturned = nullptr;
+    while (numResults < maxResults && canReadNextInline()) {
+        ++_commonStats.works;
+
+        boost::optional<Record> record;
+        try {
+            if (auto fetcher = _cursor->fetcherForNext()) {
+                WorkingSetMember* member = _workingSet->get(_wsidForFetch);
+                member->setFetcher(fetcher.release());
+                *out = _wsidForFetch;
+                _commonStats.needYield++;
+                return PlanStage::NEED_YIELD;
+            }
+
+            // The cursor may reuse the memory of the record it returned last, which is still
+            // part of this batch.
+            if (lastReturned) {
+                lastReturned->makeObjOwnedIfNeeded();
+                lastReturned = nullptr;
+            }
+
+            record = _cursor->next();
+        } catch (const WriteConflictException& wce) {
+            *out = WorkingSet::INVALID_ID;
+            return PlanStage::NEED_YIELD;
+        }
+
+        if (!record) {
+            // Same as in work().
+            if (_params.tailable && !_lastSeenId.isNull()) {
+                _cursor.reset();
+            } else {
+                _commonStats.isEOF = true;
+            }
+            return PlanStage::IS_EOF;
+        }
+
+        _lastSeenId = record->id;
+
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->loc = record->id;
+        member->obj = {getOpCtx()->recoveryUnit()->getSnapshotId(), record->data.releaseToBson()};
+        _workingSet->transitionToLocAndObj(id);
+
+        ++_specificStats.docsTested;
+        if (Filter::passes(member, _filter, _compiledFilter.get())) {
+            results->push_back(id);
+            lastReturned = member;
+            ++numResults;
+            ++_commonStats.advanced;
+        } else {
+            _workingSet->free(id);
+            ++_commonStats.needTime;
+            if (++numNeedTime >= maxResults)
+                return PlanStage::NEED_TIME;
+        }
+    }
+
+    return numResults ? PlanStage::ADVANCED : PlanStage::NEED_TIME;
+}
+
+bool CollectionScan::canReadNextInline() const {
+    return _cursor && !_isDead && !_commonStats.isEOF && 0 == _params.maxScan &&
+        !(_lastSeenId.isNull() && !_params.start.isNull());
+}
+
 PlanStage::StageState CollectionScan::returnIfMatches(WorkingSetMember* member,
                                                       WorkingSetID memberID,
                                                       WorkingSetID* out) {
     ++_specificStats.docsTested;
 
-    if (Filter::passes(member, _filter)) {
+    if (Filter::passes(member, _filter, _compiledFilter.get())) {
         *out = memberID;
         ++_commonStats.advanced;
         return PlanStage::ADVANCED;
@@ -32,6 +32,7 @@
 
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
 
@@ -55,6 +56,9 @@ public:
                    const MatchExpression* filter);
 
     StageState work(WorkingSetID* out) final;
+    StageState workBatch(size_t maxResults,
+                         std::vector<WorkingSetID>* results,
+                         WorkingSetID* out) final;
     bool isEOF() final;
 
     void doInvalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) final;
@@ -80,12 +84,21 @@ private:
      */
     StageState returnIfMatches(WorkingSetMember* member, WorkingSetID memberID, WorkingSetID* out);
 
+    /**
+     * Returns true if the next call to work() would simply read the next record from an open
+     * cursor, which workBatch() does inline.
+     */
+    bool canReadNextInline() const;
+
     // WorkingSet is not owned by us.
     WorkingSet* _workingSet;
 
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // The compiled form of '_filter', if it could be compiled.
+    std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
     std::unique_ptr<SeekableRecordCursor> _cursor;
 
     CollectionScanParams _params;
@@ -35,6 +35,7 @@
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/fail_point_service.h"
@@ -60,6 +61,10 @@ FetchStage::FetchStage(OperationContext* txn,
       _filter(filter),
       _idRetrying(WorkingSet::INVALID_ID) {
     _children.emplace_back(child);
+
+    if (_filter && internalQueryCompileMatchExpressions.load()) {
+        _compiledFilter = CompiledMatchExpression::compile(_filter);
+    }
 }
 
 FetchStage::~FetchStage() {}
@@ -71,6 +76,11 @@ bool FetchStage::isEOF() {
         return false;
     }
 
+    if (!_pending.empty() || _hasPendingState) {
+        // A batch from our child has not been fully processed.
+        return false;
+    }
+
     return child()->isEOF();
 }
 
@@ -84,15 +94,33 @@ PlanStage::StageState FetchStage::work(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
-    // Either retry the last WSM we worked on or get a new one from our child.
+    // Either retry the last WSM we worked on, continue with what is left of a batch from
+    // workBatch(), or get a new one from our child.
     WorkingSetID id;
     StageState status;
-    if (_idRetrying == WorkingSet::INVALID_ID) {
-        status = child()->work(&id);
-    } else {
+    if (_idRetrying != WorkingSet::INVALID_ID) {
         status = ADVANCED;
         id = _idRetrying;
         _idRetrying = WorkingSet::INVALID_ID;
+    } else {
+        // Collect a window of results, so that their documents are read while the earlier ones
+        // are processed.
+        const int readAheadWindow = internalQueryFetchReadAheadWindow.load();
+        if (readAheadWindow > 1 && _pending.empty() && !_hasPendingState) {
+            fillPending(readAheadWindow);
+        }
+
+        if (!_pending.empty()) {
+            status = ADVANCED;
+            id = _pending.front();
+            _pending.pop_front();
+        } else if (_hasPendingState) {
+            status = _pendingState;
+            id = _pendingStateId;
+            _hasPendingState = false;
+        } else {
+            status = child()->work(&id);
+        }
     }
 
     if (PlanStage::ADVANCED == status) {
@@ -161,7 +189,158 @@ PlanStage::StageState FetchStage::work(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState FetchStage::workBatch(size_t maxResults,
+                                            std::vector<WorkingSetID>* results,
+                                            WorkingSetID* out) {
+    // Adds the amount of time taken by the batch to executionTimeMillis.
+    ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+    if (isEOF()) {
+        ++_commonStats.works;
+        return PlanStage::IS_EOF;
+    }
+
+    // A member which had to be paged in comes before the rest of its batch.
+    if (WorkingSet::INVALID_ID != _idRetrying) {
+        _pending.push_front(_idRetrying);
+        _idRetrying = WorkingSet::INVALID_ID;
+    }
+
+    if (_pending.empty() && !_hasPendingState) {
+        fillPending(maxResults);
+    }
+
+    size_t numResults = 0;
+    WorkingSetMember* lastFetched = nullptr;
+    while (!_pending.empty() && numResults < maxResults) {
+        ++_commonStats.works;
+        const WorkingSetID id = _pending.front();
+        _pending.pop_front();
+        WorkingSetMember* member = _ws->get(id);
+
+        bool fetched = false;
+        if (member->hasObj()) {
+            ++_specificStats.alreadyHasObj;
+        } else {
+            verify(WorkingSetMember::LOC_AND_IDX == member->getState());
+            verify(member->hasLoc());
+
+            try {
+                if (!_cursor)
+                    _cursor = _collection->getCursor(getOpCtx());
+
+                if (auto fetcher = _cursor->fetcherForId(member->loc)) {
+                    _idRetrying = id;
+                    member->setFetcher(fetcher.release());
+                    *out = id;
+                    _commonStats.needYield++;
+                    return NEED_YIELD;
+                }
+
+                // Seeking may reuse the memory of the document fetched last, which is still part
+                // of this batch.
+                if (lastFetched) {
+                    lastFetched->makeObjOwnedIfNeeded();
+                    lastFetched = nullptr;
+                }
+
+                if (!WorkingSetCommon::fetch(getOpCtx(), _ws, id, _cursor)) {
+                    _ws->free(id);
+                    _commonStats.needTime++;
+                    continue;
+                }
+                fetched = true;
+            } catch (const WriteConflictException& wce) {
+                member->makeObjOwnedIfNeeded();
+                _idRetrying = id;
+                *out = WorkingSet::INVALID_ID;
+                _commonStats.needYield++;
+                return NEED_YIELD;
+            }
+        }
+
+        ++_specificStats.docsExamined;
+        if (Filter::passes(member, _filter, _compiledFilter.get())) {
+            results->push_back(id);
+            ++numResults;
+            ++_commonStats.advanced;
+            if (fetched)
+                lastFetched = member;
+        } else {
+            _ws->free(id);
+            ++_commonStats.needTime;
+        }
+    }
+
+    if (!_pending.empty() || !_hasPendingState) {
+        return numResults ? PlanStage::ADVANCED : PlanStage::NEED_TIME;
+    }
+
+    // The whole batch has been processed, so pass on the state our child ended it with.
+    ++_commonStats.works;
+    _hasPendingState = false;
+    const StageState status = _pendingState;
+    *out = _pendingStateId;
+    if (PlanStage::FAILURE == status || PlanStage::DEAD == status) {
+        if (WorkingSet::INVALID_ID == *out) {
+            mongoutils::str::stream ss;
+            ss << "fetch stage failed to read in results from child";
+            Status status(ErrorCodes::InternalError, ss);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+        }
+    } else if (PlanStage::NEED_TIME == status) {
+        ++_commonStats.needTime;
+    } else if (PlanStage::NEED_YIELD == status) {
+        ++_commonStats.needYield;
+    }
+    return status;
+}
+
+void FetchStage::fillPending(size_t maxResults) {
+    _childBatch.clear();
+    WorkingSetID childOut = WorkingSet::INVALID_ID;
+    const StageState childState = child()->workBatch(maxResults, &_childBatch, &childOut);
+    _pending.insert(_pending.end(), _childBatch.begin(), _childBatch.end());
+    if (PlanStage::ADVANCED != childState) {
+        _hasPendingState = true;
+        _pendingState = childState;
+        _pendingStateId = childOut;
+    }
+
+    if (internalQueryFetchReadAheadWindow.load() > 1) {
+        prefetchPending();
+    }
+}
+
+void FetchStage::prefetchPending() {
+    std::vector<RecordId> ids;
+    for (auto id : _pending) {
+        WorkingSetMember* member = _ws->get(id);
+        if (!member->hasObj() && member->hasLoc()) {
+            ids.push_back(member->loc);
+        }
+    }
+    if (ids.size() < 2) {
+        // The document is about to be fetched anyway.
+        return;
+    }
+
+    try {
+        if (!_cursor)
+            _cursor = _collection->getCursor(getOpCtx());
+        _specificStats.docsPrefetched += _cursor->prefetch(ids);
+    } catch (const WriteConflictException& wce) {
+        // Reading ahead is only an optimization, the documents are fetched regardless.
+    }
+}
+
 void FetchStage::doSaveState() {
+    // Members of an unfinished batch may point into storage engine memory which is not stable
+    // across a yield.
+    for (auto id : _pending) {
+        _ws->get(id)->makeObjOwnedIfNeeded();
+    }
+
     if (_cursor)
         _cursor->saveUnpositioned();
 }
@@ -191,6 +370,14 @@ void FetchStage::doInvalidate(OperationContext* txn, const RecordId& dl, Invalid
             WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
         }
     }
+
+    // The same goes for the members of an unfinished batch.
+    for (auto id : _pending) {
+        WorkingSetMember* member = _ws->get(id);
+        if (member->hasLoc() && (member->loc == dl)) {
+            WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+        }
+    }
 }
 
 PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
@@ -212,7 +399,7 @@ PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
     // predicate.
     ++_specificStats.docsExamined;
 
-    if (Filter::passes(member, _filter)) {
+    if (Filter::passes(member, _filter, _compiledFilter.get())) {
         *out = memberID;
 
         ++_commonStats.advanced;
@@ -28,10 +28,13 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
+#include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
 
@@ -59,6 +62,9 @@ public:
 
     bool isEOF() final;
     StageState work(WorkingSetID* out) final;
+    StageState workBatch(size_t maxResults,
+                         std::vector<WorkingSetID>* results,
+                         WorkingSetID* out) final;
 
     void doSaveState() final;
     void doRestoreState() final;
@@ -83,6 +89,17 @@ private:
      */
     StageState returnIfMatches(WorkingSetMember* member, WorkingSetID memberID, WorkingSetID* out);
 
+    /**
+     * Asks the child for a batch of up to 'maxResults' results, which are queued in '_pending',
+     * and has the storage engine read ahead the documents they point to if enabled.
+     */
+    void fillPending(size_t maxResults);
+
+    /**
+     * Starts reading the documents of the members in '_pending' which still need to be fetched.
+     */
+    void prefetchPending();
+
     // Collection which is used by this stage. Used to resolve record ids retrieved by child
     // stages. The lifetime of the collection must supersede that of the stage.
     const Collection* _collection;
@@ -95,9 +112,25 @@ private:
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // The compiled form of '_filter', if it could be compiled.
+    std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
     // If not Null, we use this rather than asking our child what to do next.
     WorkingSetID _idRetrying;
 
+    // Results of the child's last batch which have not been fetched yet, because fetching an
+    // earlier one required a yield. Processed before asking the child for more.
+    std::deque<WorkingSetID> _pending;
+
+    // The state the child's last batch ended with, if not ADVANCED. It is returned once
+    // '_pending' has been drained.
+    bool _hasPendingState = false;
+    StageState _pendingState = ADVANCED;
+    WorkingSetID _pendingStateId = WorkingSet::INVALID_ID;
+
+    // Reused to receive the child's batches.
+    std::vector<WorkingSetID> _childBatch;
+
     // Stats
     FetchStats _specificStats;
 };
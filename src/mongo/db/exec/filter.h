@@ -29,6 +29,7 @@
 #pragma once
 
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/matcher/matchable.h"
 
@@ -157,6 +158,19 @@ public:
         return filter->matches(&doc, NULL);
     }
 
+    /**
+     * Same as above, but uses 'compiled', the compiled form of 'filter', if it is not NULL and
+     * 'wsm' has a document.
+     */
+    static bool passes(WorkingSetMember* wsm,
+                       const MatchExpression* filter,
+                       const CompiledMatchExpression* compiled) {
+        if (NULL != compiled && wsm->hasObj()) {
+            return compiled->matchesBSON(wsm->obj.value());
+        }
+        return passes(wsm, filter);
+    }
+
     static bool passes(const BSONObj& keyData,
                        const BSONObj& keyPattern,
                        const MatchExpression* filter) {
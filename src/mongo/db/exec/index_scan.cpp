@@ -228,6 +228,13 @@ PlanStage::StageState IndexScan::work(WorkingSetID* out) {
     return PlanStage::ADVANCED;
 }
 
+PlanStage::StageState IndexScan::workBatch(size_t maxResults,
+                                           std::vector<WorkingSetID>* results,
+                                           WorkingSetID* out) {
+    // Returned keys are always owned, so advancing the cursor does not affect earlier results.
+    return workRepeatedly(this, maxResults, results, out);
+}
+
 bool IndexScan::isEOF() {
     return _commonStats.isEOF;
 }
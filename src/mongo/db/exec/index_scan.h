@@ -96,6 +96,9 @@ public:
               const MatchExpression* filter);
 
     StageState work(WorkingSetID* out) final;
+    StageState workBatch(size_t maxResults,
+                         std::vector<WorkingSetID>* results,
+                         WorkingSetID* out) final;
     bool isEOF() final;
     void doSaveState() final;
     void doRestoreState() final;
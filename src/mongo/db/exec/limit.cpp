@@ -95,6 +95,48 @@ PlanStage::StageState LimitStage::work(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState LimitStage::workBatch(size_t maxResults,
+                                            std::vector<WorkingSetID>* results,
+                                            WorkingSetID* out) {
+    // Adds the amount of time taken by the batch to executionTimeMillis.
+    ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+    if (0 == _numToReturn) {
+        ++_commonStats.works;
+        return PlanStage::IS_EOF;
+    }
+
+    // Never ask the child for more than we are going to return.
+    const size_t numBefore = results->size();
+    StageState status = child()->workBatch(
+        std::min(maxResults, static_cast<size_t>(_numToReturn)), results, out);
+    const size_t numReturned = results->size() - numBefore;
+
+    _numToReturn -= numReturned;
+    _commonStats.advanced += numReturned;
+    _commonStats.works += numReturned;
+
+    if (PlanStage::ADVANCED == status) {
+        return status;
+    }
+
+    ++_commonStats.works;
+    if (PlanStage::FAILURE == status || PlanStage::DEAD == status) {
+        if (WorkingSet::INVALID_ID == *out) {
+            mongoutils::str::stream ss;
+            ss << "limit stage failed to read in results from child";
+            Status status(ErrorCodes::InternalError, ss);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+        }
+    } else if (PlanStage::NEED_TIME == status) {
+        ++_commonStats.needTime;
+    } else if (PlanStage::NEED_YIELD == status) {
+        ++_commonStats.needYield;
+    }
+
+    return status;
+}
+
 unique_ptr<PlanStageStats> LimitStage::getStats() {
     _commonStats.isEOF = isEOF();
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_LIMIT);
@@ -0,0 +1,461 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/parallel_collection_scan.h"
+
+#include <algorithm>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+
+using std::unique_ptr;
+using std::vector;
+using stdx::make_unique;
+
+namespace {
+
+// How many bytes of documents a scan buffers at most, split evenly between the partitions which
+// are read at the same time.
+const size_t kMaxBufferedBytes = 16 * 1024 * 1024;
+
+// How many records a worker reads before handing the matching documents to the query.
+const size_t kRecordsPerBatch = 128;
+
+/**
+ * The workers of all parallel collection scans. There is one thread per core at most, and idle
+ * threads go away after a while.
+ */
+ThreadPool* workerPool() {
+    static ThreadPool* const pool = [] {
+        ThreadPool::Options options;
+        options.poolName = "ParallelCollectionScan";
+        options.threadNamePrefix = "parallelCollScan-";
+        options.minThreads = 0;
+        options.maxThreads = std::max(2u, ProcessInfo().getNumCores());
+        // Intentionally leaked, as the workers may still run at shutdown.
+        ThreadPool* pool = new ThreadPool(options);
+        pool->startup();
+        return pool;
+    }();
+    return pool;
+}
+
+}  // namespace
+
+// static
+const char* ParallelCollectionScan::kStageType = "PARALLEL_COLLSCAN";
+
+ParallelCollectionScan::ParallelCollectionScan(OperationContext* txn,
+                                               const Collection* collection,
+                                               int maxParallelism,
+                                               bool ordered,
+                                               WorkingSet* workingSet,
+                                               const MatchExpression* filter)
+    : PlanStage(kStageType, txn),
+      _collection(collection),
+      _workingSet(workingSet),
+      _filter(filter),
+      _maxParallelism(std::max(1, maxParallelism)),
+      _ordered(ordered),
+      _partitionBufferBytes(kMaxBufferedBytes / _maxParallelism) {
+    _specificStats.maxParallelism = _maxParallelism;
+    _specificStats.ordered = _ordered;
+
+    if (_filter && internalQueryCompileMatchExpressions.load()) {
+        _compiledFilter = CompiledMatchExpression::compile(_filter);
+    }
+}
+
+ParallelCollectionScan::~ParallelCollectionScan() {
+    // The workers refer to the stage, so they have to be done before it goes away.
+    _stopReads();
+}
+
+PlanStage::StageState ParallelCollectionScan::work(WorkingSetID* out) {
+    ++_commonStats.works;
+
+    // Adds the amount of time taken by work() to executionTimeMillis.
+    ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+    if (!_started) {
+        _start();
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
+    vector<Result> results;
+    {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _specificStats.docsTested = _docsTested;
+
+        if (_error.isOK()) {
+            _popResults_inlock(1, &results);
+            _scheduleReads_inlock();
+        }
+
+        if (!_error.isOK()) {
+            *out = WorkingSetCommon::allocateStatusMember(_workingSet, _error);
+            return PlanStage::FAILURE;
+        }
+
+        if (results.empty()) {
+            if (_firstUnfinished == _partitions.size()) {
+                _commonStats.isEOF = true;
+                return PlanStage::IS_EOF;
+            }
+
+            // Some partition which may be read isn't exhausted, so a worker is reading it and
+            // notifies once it has documents or is done.
+            ++_specificStats.waits;
+            _partitionsChanged.wait(lk);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+    }
+
+    ++_commonStats.advanced;
+    return _returnResult(results.front(), out);
+}
+
+PlanStage::StageState ParallelCollectionScan::workBatch(size_t maxResults,
+                                                        std::vector<WorkingSetID>* results,
+                                                        WorkingSetID* out) {
+    vector<Result> popped;
+    if (_started) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_error.isOK()) {
+            _popResults_inlock(maxResults, &popped);
+            _scheduleReads_inlock();
+        }
+    }
+
+    // Starting, waiting for the workers, failing and EOF are left to work().
+    if (popped.empty()) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        const StageState state = work(&id);
+        if (PlanStage::ADVANCED == state) {
+            results->push_back(id);
+        } else {
+            *out = id;
+        }
+        return state;
+    }
+
+    // Adds the amount of time taken by the whole batch to executionTimeMillis.
+    ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+    for (auto&& result : popped) {
+        ++_commonStats.works;
+        ++_commonStats.advanced;
+        WorkingSetID id;
+        _returnResult(result, &id);
+        results->push_back(id);
+    }
+    return PlanStage::ADVANCED;
+}
+
+bool ParallelCollectionScan::isEOF() {
+    return _commonStats.isEOF;
+}
+
+void ParallelCollectionScan::doInvalidate(OperationContext* txn,
+                                          const RecordId& dl,
+                                          InvalidationType type) {
+    // Storage engines with document level locking don't invalidate anything, but the partitions
+    // follow the contract of RecordCursor::invalidate() regardless.
+    if (INVALIDATION_DELETION != type) {
+        return;
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    invariant(0 == _numReading);
+    for (auto&& partition : _partitions) {
+        if (partition->cursor) {
+            partition->cursor->invalidate(txn, dl);
+        }
+
+        auto& buffered = partition->results;
+        for (auto it = buffered.begin(); it != buffered.end();) {
+            if (it->id == dl) {
+                partition->bufferedBytes -= it->obj.objsize();
+                it = buffered.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void ParallelCollectionScan::doSaveState() {
+    _stopReads();
+}
+
+void ParallelCollectionScan::doRestoreState() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _stopped = false;
+}
+
+unique_ptr<PlanStageStats> ParallelCollectionScan::getStats() {
+    // Add a BSON representation of the filter to the stats tree, if there is one.
+    if (NULL != _filter) {
+        BSONObjBuilder bob;
+        _filter->toBSON(&bob);
+        _commonStats.filter = bob.obj();
+    }
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _specificStats.docsTested = _docsTested;
+    }
+
+    unique_ptr<PlanStageStats> ret =
+        make_unique<PlanStageStats>(_commonStats, STAGE_PARALLEL_COLLSCAN);
+    ret->specific = make_unique<ParallelCollectionScanStats>(_specificStats);
+    return ret;
+}
+
+const SpecificStats* ParallelCollectionScan::getSpecificStats() const {
+    return &_specificStats;
+}
+
+void ParallelCollectionScan::_start() {
+    vector<unique_ptr<RecordCursor>> cursors = _collection->getManyCursors(getOpCtx());
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    for (auto&& cursor : cursors) {
+        // The cursors get read on other threads, with OperationContexts of their own.
+        cursor->save();
+        cursor->detachFromOperationContext();
+
+        _partitions.push_back(make_unique<Partition>());
+        _partitions.back()->cursor = std::move(cursor);
+    }
+
+    _started = true;
+    _specificStats.partitions = _partitions.size();
+    LOG(3) << "parallel collection scan of " << _collection->ns() << " split into "
+           << _partitions.size() << " partitions";
+}
+
+void ParallelCollectionScan::_scheduleReads_inlock() {
+    if (_stopped || !_error.isOK()) {
+        return;
+    }
+
+    int numOpen = 0;
+    for (size_t i = _firstUnfinished; i < _partitions.size() && numOpen < _maxParallelism; ++i) {
+        Partition* partition = _partitions[i].get();
+        if (partition->finished()) {
+            continue;
+        }
+        ++numOpen;
+
+        // Refill a buffer only once it is half empty, so that the workers read in larger batches.
+        if (partition->reading || partition->exhausted ||
+            partition->bufferedBytes >= _partitionBufferBytes / 2) {
+            continue;
+        }
+
+        Status status = workerPool()->schedule([this, i] { _readPartition(i); });
+        if (!status.isOK()) {
+            _error = status;
+            return;
+        }
+        partition->reading = true;
+        ++_numReading;
+    }
+}
+
+void ParallelCollectionScan::_popResults_inlock(size_t maxResults, std::vector<Result>* results) {
+    while (results->size() < maxResults) {
+        while (_firstUnfinished < _partitions.size() &&
+               _partitions[_firstUnfinished]->finished()) {
+            // The cursor of a finished partition is detached, and no worker reads it any more.
+            _partitions[_firstUnfinished]->cursor.reset();
+            ++_firstUnfinished;
+        }
+
+        Partition* source = nullptr;
+        if (_ordered) {
+            if (_firstUnfinished < _partitions.size() &&
+                !_partitions[_firstUnfinished]->results.empty()) {
+                source = _partitions[_firstUnfinished].get();
+            }
+        } else {
+            int numOpen = 0;
+            for (size_t i = _firstUnfinished; i < _partitions.size() && numOpen < _maxParallelism;
+                 ++i) {
+                Partition* partition = _partitions[i].get();
+                if (partition->finished()) {
+                    continue;
+                }
+                ++numOpen;
+                if (!partition->results.empty()) {
+                    source = partition;
+                    break;
+                }
+            }
+        }
+
+        if (!source) {
+            return;
+        }
+
+        results->push_back(std::move(source->results.front()));
+        source->results.pop_front();
+        source->bufferedBytes -= results->back().obj.objsize();
+    }
+}
+
+void ParallelCollectionScan::_readPartition(size_t index) {
+    Client::initThreadIfNotAlready();
+    auto opCtx = cc().makeOperationContext();
+
+    Partition* partition;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        partition = _partitions[index].get();
+    }
+
+    // Only this worker uses the cursor until 'reading' is reset.
+    RecordCursor* cursor = partition->cursor.get();
+
+    vector<Result> batch;
+    size_t batchBytes = 0;
+    size_t batchTested = 0;
+    bool exhausted = false;
+    Status status = Status::OK();
+
+    // Hands the documents read so far over to the query. Returns whether to keep reading.
+    auto publish = [&]() -> bool {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        for (auto&& result : batch) {
+            partition->results.push_back(std::move(result));
+        }
+        partition->bufferedBytes += batchBytes;
+        _docsTested += batchTested;
+        batch.clear();
+        batchBytes = 0;
+        batchTested = 0;
+        _partitionsChanged.notify_all();
+        return !exhausted && !_stopped && partition->bufferedBytes < _partitionBufferBytes;
+    };
+
+    cursor->reattachToOperationContext(opCtx.get());
+    try {
+        if (!cursor->restore()) {
+            status = Status(ErrorCodes::OperationFailed,
+                            "parallel collection scan lost its position in the collection");
+        } else {
+            bool keepReading = true;
+            while (keepReading) {
+                for (size_t i = 0; i < kRecordsPerBatch; ++i) {
+                    auto record = cursor->next();
+                    if (!record) {
+                        exhausted = true;
+                        break;
+                    }
+
+                    ++batchTested;
+                    BSONObj obj = record->data.releaseToBson();
+                    if (_matches(obj)) {
+                        batchBytes += obj.objsize();
+                        batch.push_back({record->id, obj.getOwned()});
+                    }
+                }
+                keepReading = publish();
+            }
+            cursor->save();
+        }
+    } catch (const WriteConflictException&) {
+        // The cursor is still positioned after the last record read, so the next read of the
+        // partition picks up from there.
+        cursor->save();
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+    }
+
+    publish();
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (status.isOK()) {
+        cursor->detachFromOperationContext();
+    } else {
+        // The cursor can't be used any more, and has to go before the OperationContext.
+        partition->cursor.reset();
+        if (_error.isOK()) {
+            _error = status;
+        }
+    }
+    partition->exhausted = partition->exhausted || exhausted;
+    partition->reading = false;
+    --_numReading;
+    _partitionsChanged.notify_all();
+}
+
+void ParallelCollectionScan::_stopReads() {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    _stopped = true;
+    _partitionsChanged.wait(lk, [this] { return 0 == _numReading; });
+}
+
+bool ParallelCollectionScan::_matches(const BSONObj& obj) const {
+    if (_compiledFilter) {
+        return _compiledFilter->matchesBSON(obj);
+    }
+    return !_filter || _filter->matchesBSON(obj);
+}
+
+PlanStage::StageState ParallelCollectionScan::_returnResult(const Result& result,
+                                                            WorkingSetID* out) {
+    *out = _workingSet->allocate();
+    WorkingSetMember* member = _workingSet->get(*out);
+    member->loc = result.id;
+    member->obj = {getOpCtx()->recoveryUnit()->getSnapshotId(), result.obj};
+    _workingSet->transitionToLocAndObj(*out);
+    return PlanStage::ADVANCED;
+}
+
+}  // namespace mongo
@@ -0,0 +1,191 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/record_id.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+
+class Collection;
+class OperationContext;
+class RecordCursor;
+class WorkingSet;
+
+/**
+ * Scans a whole collection by splitting it into RecordId ranges with getManyCursors() and reading
+ * up to 'maxParallelism' of them at the same time on a shared pool of worker threads. The workers
+ * apply the filter and buffer the matching documents, which work() hands out on the query thread.
+ *
+ * If 'ordered' is true the partitions are drained one after another, so the documents come out in
+ * their natural order. Otherwise whichever partition has documents buffered is drained first.
+ *
+ * Every partition is read from its own snapshot, on an OperationContext of its worker thread, so
+ * the scan doesn't see a single point in time of the collection. It is only used for queries on
+ * storage engines with document level locking, which don't need the locks of the query to read.
+ */
+class ParallelCollectionScan final : public PlanStage {
+public:
+    ParallelCollectionScan(OperationContext* txn,
+                           const Collection* collection,
+                           int maxParallelism,
+                           bool ordered,
+                           WorkingSet* workingSet,
+                           const MatchExpression* filter);
+
+    ~ParallelCollectionScan();
+
+    StageState work(WorkingSetID* out) final;
+    StageState workBatch(size_t maxResults,
+                         std::vector<WorkingSetID>* results,
+                         WorkingSetID* out) final;
+    bool isEOF() final;
+
+    void doInvalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) final;
+    void doSaveState() final;
+    void doRestoreState() final;
+
+    StageType stageType() const final {
+        return STAGE_PARALLEL_COLLSCAN;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+    static const char* kStageType;
+
+private:
+    struct Result {
+        RecordId id;
+        BSONObj obj;  // Owned.
+    };
+
+    struct Partition {
+        bool finished() const {
+            return exhausted && results.empty();
+        }
+
+        // Saved and detached from any OperationContext, except while a worker reads from it.
+        std::unique_ptr<RecordCursor> cursor;
+
+        // Matching documents read by the workers which work() hasn't returned yet.
+        std::deque<Result> results;
+        size_t bufferedBytes = 0;
+
+        bool reading = false;
+        bool exhausted = false;
+    };
+
+    /**
+     * Splits the collection into partitions.
+     */
+    void _start();
+
+    /**
+     * Schedules a read of every partition which may be read and isn't buffering enough documents
+     * already. The partitions which may be read are the first 'maxParallelism' unfinished ones.
+     */
+    void _scheduleReads_inlock();
+
+    /**
+     * Moves up to 'maxResults' buffered documents to 'results', taking them from the partitions in
+     * the order the scan returns them.
+     */
+    void _popResults_inlock(size_t maxResults, std::vector<Result>* results);
+
+    /**
+     * Runs on a worker thread. Reads partition 'index' until it is exhausted, its buffer is full
+     * or the stage gets saved.
+     */
+    void _readPartition(size_t index);
+
+    /**
+     * Waits until no worker reads from any partition. No reads get scheduled until
+     * doRestoreState().
+     */
+    void _stopReads();
+
+    bool _matches(const BSONObj& obj) const;
+
+    StageState _returnResult(const Result& result, WorkingSetID* out);
+
+    const Collection* const _collection;
+
+    // WorkingSet is not owned by us.
+    WorkingSet* const _workingSet;
+
+    // The filter is not owned by us.
+    const MatchExpression* const _filter;
+
+    // The compiled form of '_filter', if it could be compiled.
+    std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
+    const int _maxParallelism;
+    const bool _ordered;
+
+    // How many bytes of documents each partition may buffer.
+    const size_t _partitionBufferBytes;
+
+    bool _started = false;
+
+    // Protects everything below, which the workers read and write.
+    stdx::mutex _mutex;
+
+    // Notified whenever a worker has read documents or stopped reading.
+    stdx::condition_variable _partitionsChanged;
+
+    std::vector<std::unique_ptr<Partition>> _partitions;
+
+    // Index of the first partition which isn't finished.
+    size_t _firstUnfinished = 0;
+
+    // How many partitions are being read.
+    int _numReading = 0;
+
+    bool _stopped = false;
+
+    // The first error a worker ran into, which fails the scan.
+    Status _error = Status::OK();
+
+    size_t _docsTested = 0;
+
+    ParallelCollectionScanStats _specificStats;
+};
+
+}  // namespace mongo
@@ -34,6 +34,12 @@
 
 namespace mongo {
 
+PlanStage::StageState PlanStage::workBatch(size_t maxResults,
+                                           std::vector<WorkingSetID>* results,
+                                           WorkingSetID* out) {
+    return workRepeatedly(this, maxResults, results, out);
+}
+
 void PlanStage::saveState() {
     ++_commonStats.yields;
     for (auto&& child : _children) {
@@ -187,6 +187,26 @@ public:
      */
     virtual StageState work(WorkingSetID* out) = 0;
 
+    /**
+     * Performs several units of work in one call, appending every result produced to 'results'.
+     * The batch ends when one of the following happens:
+     *
+     *   - 'maxResults' results have been appended. Returns ADVANCED.
+     *   - Some unit of work returned a state other than ADVANCED or NEED_TIME. That state is
+     *     returned, with *out set as work() would have set it. Any results appended to 'results'
+     *     were produced before that state and must be consumed before acting on it.
+     *   - 'maxResults' units of work returned NEED_TIME. Returns NEED_TIME, so that the caller
+     *     gets a chance to yield even if no results are found.
+     *
+     * A stage may also end a batch early with ADVANCED after appending fewer results, e.g. when
+     * it is about to reach a limit. Stages which can pass whole batches between themselves and
+     * their children override this to avoid a virtual call per result and per stage; the default
+     * implementation just calls work() repeatedly.
+     */
+    virtual StageState workBatch(size_t maxResults,
+                                 std::vector<WorkingSetID>* results,
+                                 WorkingSetID* out);
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -318,6 +338,34 @@ public:
     virtual const SpecificStats* getSpecificStats() const = 0;
 
 protected:
+    /**
+     * Implements workBatch() by calling stage->work() until the batch is over. A stage whose
+     * work() is final can use this to batch without a virtual call per unit of work.
+     */
+    template <typename Stage>
+    static StageState workRepeatedly(Stage* stage,
+                                     size_t maxResults,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out) {
+        size_t numResults = 0;
+        size_t numNeedTime = 0;
+        while (numResults < maxResults) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            const StageState state = stage->work(&id);
+            if (ADVANCED == state) {
+                results->push_back(id);
+                ++numResults;
+            } else if (NEED_TIME == state) {
+                if (++numNeedTime >= maxResults)
+                    return NEED_TIME;
+            } else {
+                *out = id;
+                return state;
+            }
+        }
+        return ADVANCED;
+    }
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
@@ -311,7 +311,7 @@ struct EnsureSortedStats : public SpecificStats {
 };
 
 struct FetchStats : public SpecificStats {
-    FetchStats() : alreadyHasObj(0), forcedFetches(0), docsExamined(0) {}
+    FetchStats() : alreadyHasObj(0), forcedFetches(0), docsExamined(0), docsPrefetched(0) {}
 
     SpecificStats* clone() const final {
         FetchStats* specific = new FetchStats(*this);
@@ -326,6 +326,9 @@ struct FetchStats : public SpecificStats {
 
     // The total number of full documents touched by the fetch stage.
     size_t docsExamined;
+
+    // How many documents the storage engine started reading ahead of time.
+    size_t docsPrefetched;
 };
 
 struct GroupStats : public SpecificStats {
@@ -455,6 +458,30 @@ struct OrStats : public SpecificStats {
     size_t locsForgotten;
 };
 
+struct ParallelCollectionScanStats : public SpecificStats {
+    ParallelCollectionScanStats()
+        : docsTested(0), partitions(0), maxParallelism(0), ordered(false), waits(0) {}
+
+    SpecificStats* clone() const final {
+        ParallelCollectionScanStats* specific = new ParallelCollectionScanStats(*this);
+        return specific;
+    }
+
+    // How many documents were checked against the filter, on any thread?
+    size_t docsTested;
+
+    // How many partitions the collection was split into, and how many of them were read at the
+    // same time at most.
+    size_t partitions;
+    int maxParallelism;
+
+    // Whether the documents are returned in their natural order.
+    bool ordered;
+
+    // How many times the query had to wait for a partition to be read.
+    size_t waits;
+};
+
 struct ProjectionStats : public SpecificStats {
     ProjectionStats() {}
 
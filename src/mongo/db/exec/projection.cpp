@@ -236,6 +236,53 @@ PlanStage::StageState ProjectionStage::work(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState ProjectionStage::workBatch(size_t maxResults,
+                                                 std::vector<WorkingSetID>* results,
+                                                 WorkingSetID* out) {
+    // Adds the amount of time taken by the batch to executionTimeMillis.
+    ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+    const size_t numBefore = results->size();
+    StageState status = child()->workBatch(maxResults, results, out);
+
+    for (size_t i = numBefore; i < results->size(); ++i) {
+        ++_commonStats.works;
+        Status projStatus = transform(_ws->get((*results)[i]));
+        if (!projStatus.isOK()) {
+            warning() << "Couldn't execute projection, status = " << projStatus.toString() << endl;
+
+            // The results before the failing one are still returned, the rest are dropped.
+            for (size_t j = i; j < results->size(); ++j) {
+                _ws->free((*results)[j]);
+            }
+            results->resize(i);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
+            return PlanStage::FAILURE;
+        }
+        ++_commonStats.advanced;
+    }
+
+    if (PlanStage::ADVANCED == status) {
+        return status;
+    }
+
+    ++_commonStats.works;
+    if (PlanStage::FAILURE == status || PlanStage::DEAD == status) {
+        if (WorkingSet::INVALID_ID == *out) {
+            mongoutils::str::stream ss;
+            ss << "projection stage failed to read in results from child";
+            Status status(ErrorCodes::InternalError, ss);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+        }
+    } else if (PlanStage::NEED_TIME == status) {
+        _commonStats.needTime++;
+    } else if (PlanStage::NEED_YIELD == status) {
+        _commonStats.needYield++;
+    }
+
+    return status;
+}
+
 unique_ptr<PlanStageStats> ProjectionStage::getStats() {
     _commonStats.isEOF = isEOF();
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_PROJECTION);
@@ -97,6 +97,49 @@ PlanStage::StageState SkipStage::work(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState SkipStage::workBatch(size_t maxResults,
+                                           std::vector<WorkingSetID>* results,
+                                           WorkingSetID* out) {
+    // Adds the amount of time taken by the batch to executionTimeMillis.
+    ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+    const size_t numBefore = results->size();
+    StageState status = child()->workBatch(maxResults, results, out);
+
+    // Drop as many of the child's results as we still have to skip.
+    const size_t numFromChild = results->size() - numBefore;
+    const size_t numToDrop = std::min(numFromChild, static_cast<size_t>(_toSkip));
+    for (size_t i = numBefore; i < numBefore + numToDrop; ++i) {
+        _ws->free((*results)[i]);
+    }
+    results->erase(results->begin() + numBefore, results->begin() + numBefore + numToDrop);
+    _toSkip -= numToDrop;
+
+    _commonStats.works += numFromChild;
+    _commonStats.needTime += numToDrop;
+    _commonStats.advanced += numFromChild - numToDrop;
+
+    if (PlanStage::ADVANCED == status) {
+        return numFromChild > numToDrop ? status : PlanStage::NEED_TIME;
+    }
+
+    ++_commonStats.works;
+    if (PlanStage::FAILURE == status || PlanStage::DEAD == status) {
+        if (WorkingSet::INVALID_ID == *out) {
+            mongoutils::str::stream ss;
+            ss << "skip stage failed to read in results from child";
+            Status status(ErrorCodes::InternalError, ss);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+        }
+    } else if (PlanStage::NEED_TIME == status) {
+        ++_commonStats.needTime;
+    } else if (PlanStage::NEED_YIELD == status) {
+        ++_commonStats.needYield;
+    }
+
+    return status;
+}
+
 unique_ptr<PlanStageStats> SkipStage::getStats() {
     _commonStats.isEOF = isEOF();
     _specificStats.skip = _toSkip;
@@ -48,6 +48,9 @@ public:
 
     bool isEOF() final;
     StageState work(WorkingSetID* out) final;
+    StageState workBatch(size_t maxResults,
+                         std::vector<WorkingSetID>* results,
+                         WorkingSetID* out) final;
 
     StageType stageType() const final {
         return STAGE_SKIP;
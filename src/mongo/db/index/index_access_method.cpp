@@ -32,6 +32,8 @@
 
 #include "mongo/db/index/btree_access_method.h"
 
+#include <algorithm>
+#include <utility>
 #include <vector>
 
 #include "mongo/base/error_codes.h"
@@ -44,6 +46,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/storage_options.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
 #include "mongo/util/progress_meter.h"
 
@@ -55,6 +58,11 @@ using std::vector;
 
 MONGO_EXPORT_SERVER_PARAMETER(failIndexKeyTooLong, bool, true);
 
+// Size of the Bloom filter set up for each unique index opened while this is positive, and the
+// memory all of the filters together may use.
+MONGO_EXPORT_SERVER_PARAMETER(indexBloomFilterSizeBytes, long long, 0);
+MONGO_EXPORT_SERVER_PARAMETER(indexBloomFilterMaxTotalBytes, long long, 256 * 1024 * 1024);
+
 //
 // Comparison for external sorter interface
 //
@@ -86,6 +94,21 @@ private:
     const int _version;
 };
 
+// BSONObjSet orders keys as if every field was ascending, which differs from the order of the
+// index as soon as it has a descending field.
+static void sortInIndexOrder(const IndexDescriptor* descriptor, vector<BSONObj>* keys) {
+    if (keys->size() < 2) {
+        return;
+    }
+
+    const BtreeExternalSortComparison cmp(descriptor->keyPattern(), descriptor->version());
+    std::sort(keys->begin(),
+              keys->end(),
+              [&cmp](const BSONObj& l, const BSONObj& r) {
+                  return cmp(std::make_pair(l, RecordId()), std::make_pair(r, RecordId())) < 0;
+              });
+}
+
 IndexAccessMethod::IndexAccessMethod(IndexCatalogEntry* btreeState, SortedDataInterface* btree)
     : _btreeState(btreeState), _descriptor(btreeState->descriptor()), _newInterface(btree) {
     verify(0 == _descriptor->version() || 1 == _descriptor->version());
@@ -108,45 +131,69 @@ Status IndexAccessMethod::insert(OperationContext* txn,
     // Delegate to the subclass.
     getKeys(obj, &keys);
 
-    Status ret = Status::OK();
-    for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
-        Status status = _newInterface->insert(txn, *i, loc, options.dupsAllowed);
+    const vector<BSONObj> sortedKeys = inIndexOrder(keys);
+
+    // Keys go into the filter before the index, so that a lookup never misses a key which is
+    // already in the index.
+    if (_bloomFilter) {
+        for (auto&& key : sortedKeys) {
+            _bloomFilter->add(key);
+        }
+    }
 
-        // Everything's OK, carry on.
+    // The storage engine stops at the first key it fails to insert. If the error can be ignored,
+    // the insert carries on with the keys after it.
+    vector<BSONObj> remaining;
+    const vector<BSONObj>* batch = &sortedKeys;
+    size_t batchStart = 0;
+    while (true) {
+        size_t numProcessed;
+        Status status =
+            _newInterface->insertKeys(txn, *batch, loc, options.dupsAllowed, &numProcessed);
+        *numInserted += numProcessed;
+
+        // Everything's OK, we're done.
         if (status.isOK()) {
-            ++*numInserted;
-            continue;
+            break;
         }
 
         // Error cases.
 
+        const BSONObj& failedKey = (*batch)[numProcessed];
+        bool ignore = false;
         if (status.code() == ErrorCodes::KeyTooLong && ignoreKeyTooLong(txn)) {
-            continue;
+            ignore = true;
         }
 
         if (status.code() == ErrorCodes::DuplicateKeyValue) {
             // A document might be indexed multiple times during a background index build
             // if it moves ahead of the collection scan cursor (e.g. via an update).
             if (!_btreeState->isReady(txn)) {
-                LOG(3) << "key " << *i << " already in index during background indexing (ok)";
-                continue;
+                LOG(3) << "key " << failedKey
+                       << " already in index during background indexing (ok)";
+                ignore = true;
             }
         }
 
-        // Clean up after ourselves.
-        for (BSONObjSet::const_iterator j = keys.begin(); j != i; ++j) {
-            removeOneKey(txn, *j, loc, options.dupsAllowed);
+        if (!ignore) {
+            // Clean up after ourselves.
+            for (size_t i = 0; i < batchStart + numProcessed; ++i) {
+                removeOneKey(txn, sortedKeys[i], loc, options.dupsAllowed);
+            }
             *numInserted = 0;
+            return status;
         }
 
-        return status;
+        batchStart += numProcessed + 1;
+        remaining.assign(sortedKeys.begin() + batchStart, sortedKeys.end());
+        batch = &remaining;
     }
 
     if (*numInserted > 1) {
         _btreeState->setMultikey(txn);
     }
 
-    return ret;
+    return Status::OK();
 }
 
 void IndexAccessMethod::removeOneKey(OperationContext* txn,
@@ -183,14 +230,35 @@ Status IndexAccessMethod::remove(OperationContext* txn,
     getKeys(obj, &keys);
     *numDeleted = 0;
 
-    for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
-        removeOneKey(txn, *i, loc, options.dupsAllowed);
-        ++*numDeleted;
+    try {
+        _newInterface->unindexKeys(txn, inIndexOrder(keys), loc, options.dupsAllowed);
+    } catch (AssertionException&) {
+        // Remove the keys one by one, which logs the one that failed and still removes the rest.
+        for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
+            removeOneKey(txn, *i, loc, options.dupsAllowed);
+        }
     }
+    *numDeleted = keys.size();
 
     return Status::OK();
 }
 
+vector<BSONObj> IndexAccessMethod::inIndexOrder(const BSONObjSet& keys) const {
+    vector<BSONObj> sorted(keys.begin(), keys.end());
+    sortInIndexOrder(_descriptor, &sorted);
+    return sorted;
+}
+
+vector<BSONObj> IndexAccessMethod::inIndexOrder(const vector<BSONObj*>& keys) const {
+    vector<BSONObj> sorted;
+    sorted.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        sorted.push_back(*keys[i]);
+    }
+    sortInIndexOrder(_descriptor, &sorted);
+    return sorted;
+}
+
 // Return keys in l that are not in r.
 // Lifted basically verbatim from elsewhere.
 static void setDifference(const BSONObjSet& l, const BSONObjSet& r, vector<BSONObj*>* diff) {
@@ -233,6 +301,10 @@ Status IndexAccessMethod::touch(OperationContext* txn) const {
 }
 
 RecordId IndexAccessMethod::findSingle(OperationContext* txn, const BSONObj& key) const {
+    if (_bloomFilter && !_bloomFilter->mayContain(key)) {
+        return RecordId();
+    }
+
     std::unique_ptr<SortedDataInterface::Cursor> cursor(_newInterface->newCursor(txn));
     const auto requestedInfo = kDebugBuild ? SortedDataInterface::Cursor::kKeyAndLoc
                                            : SortedDataInterface::Cursor::kWantLoc;
@@ -244,9 +316,48 @@ RecordId IndexAccessMethod::findSingle(OperationContext* txn, const BSONObj& key
         return kv->loc;
     }
 
+    if (_bloomFilter) {
+        _bloomFilter->recordFalsePositive();
+    }
     return RecordId();
 }
 
+void IndexAccessMethod::initBloomFilter(OperationContext* txn) {
+    invariant(!_bloomFilter);
+
+    const long long sizeBytes = indexBloomFilterSizeBytes;
+    if (!_descriptor->unique() || sizeBytes <= 0) {
+        return;
+    }
+
+    std::unique_ptr<IndexBloomFilter> filter =
+        IndexBloomFilter::make(sizeBytes, indexBloomFilterMaxTotalBytes);
+    if (!filter) {
+        LOG(1) << "not setting up a Bloom filter for " << _descriptor->indexNamespace()
+               << ", all filters together would exceed indexBloomFilterMaxTotalBytes";
+        return;
+    }
+
+    BSONObjBuilder minKey;
+    for (int i = 0; i < _descriptor->getNumFields(); i++) {
+        minKey.appendMinKey("");
+    }
+
+    std::unique_ptr<SortedDataInterface::Cursor> cursor(_newInterface->newCursor(txn));
+    for (auto kv = cursor->seek(minKey.obj(), true, SortedDataInterface::Cursor::kWantKey);
+         kv && !filter->isFull();
+         kv = cursor->next(SortedDataInterface::Cursor::kWantKey)) {
+        filter->add(kv->key);
+    }
+
+    if (filter->isFull()) {
+        LOG(1) << "not setting up a Bloom filter for " << _descriptor->indexNamespace()
+               << ", it has more keys than fit in indexBloomFilterSizeBytes";
+        return;
+    }
+    _bloomFilter = std::move(filter);
+}
+
 Status IndexAccessMethod::validate(OperationContext* txn,
                                    bool full,
                                    int64_t* numKeys,
@@ -261,7 +372,14 @@ Status IndexAccessMethod::validate(OperationContext* txn,
 bool IndexAccessMethod::appendCustomStats(OperationContext* txn,
                                           BSONObjBuilder* output,
                                           double scale) const {
-    return _newInterface->appendCustomStats(txn, output, scale);
+    bool appended = _newInterface->appendCustomStats(txn, output, scale);
+    if (_bloomFilter) {
+        BSONObjBuilder filterStats(output->subobjStart("bloomFilter"));
+        _bloomFilter->appendStats(&filterStats);
+        filterStats.doneFast();
+        appended = true;
+    }
+    return appended;
 }
 
 long long IndexAccessMethod::getSpaceUsedBytes(OperationContext* txn) const {
@@ -301,21 +419,28 @@ Status IndexAccessMethod::update(OperationContext* txn,
         _btreeState->setMultikey(txn);
     }
 
-    for (size_t i = 0; i < ticket.removed.size(); ++i) {
-        _newInterface->unindex(txn, *ticket.removed[i], ticket.loc, ticket.dupsAllowed);
-    }
+    _newInterface->unindexKeys(txn, inIndexOrder(ticket.removed), ticket.loc, ticket.dupsAllowed);
 
-    for (size_t i = 0; i < ticket.added.size(); ++i) {
+    vector<BSONObj> added = inIndexOrder(ticket.added);
+    if (_bloomFilter) {
+        for (auto&& key : added) {
+            _bloomFilter->add(key);
+        }
+    }
+    while (!added.empty()) {
+        size_t numProcessed;
         Status status =
-            _newInterface->insert(txn, *ticket.added[i], ticket.loc, ticket.dupsAllowed);
-        if (!status.isOK()) {
-            if (status.code() == ErrorCodes::KeyTooLong && ignoreKeyTooLong(txn)) {
-                // Ignore.
-                continue;
-            }
+            _newInterface->insertKeys(txn, added, ticket.loc, ticket.dupsAllowed, &numProcessed);
+        if (status.isOK()) {
+            break;
+        }
 
+        if (status.code() != ErrorCodes::KeyTooLong || !ignoreKeyTooLong(txn)) {
             return status;
         }
+
+        // Ignore, and go on with the keys after the one which was too long.
+        added.erase(added.begin(), added.begin() + numProcessed + 1);
     }
 
     *numUpdated = ticket.added.size();
@@ -323,17 +448,21 @@ Status IndexAccessMethod::update(OperationContext* txn,
     return Status::OK();
 }
 
-std::unique_ptr<IndexAccessMethod::BulkBuilder> IndexAccessMethod::initiateBulk() {
-    return std::unique_ptr<BulkBuilder>(new BulkBuilder(this, _descriptor));
+const size_t IndexAccessMethod::kDefaultBulkMaxMemoryUsageBytes;
+
+std::unique_ptr<IndexAccessMethod::BulkBuilder> IndexAccessMethod::initiateBulk(
+    size_t maxMemoryUsageBytes) {
+    return std::unique_ptr<BulkBuilder>(new BulkBuilder(this, _descriptor, maxMemoryUsageBytes));
 }
 
 IndexAccessMethod::BulkBuilder::BulkBuilder(const IndexAccessMethod* index,
-                                            const IndexDescriptor* descriptor)
+                                            const IndexDescriptor* descriptor,
+                                            size_t maxMemoryUsageBytes)
     : _sorter(Sorter::make(
           SortOptions()
               .TempDir(storageGlobalParams.dbpath + "/_tmp")
               .ExtSortAllowed()
-              .MaxMemoryUsageBytes(100 * 1024 * 1024),
+              .MaxMemoryUsageBytes(maxMemoryUsageBytes),
           BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version()))),
       _real(index) {}
 
@@ -365,14 +494,74 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
                                      bool mayInterrupt,
                                      bool dupsAllowed,
                                      set<RecordId>* dupsToDrop) {
+    std::vector<std::unique_ptr<BulkBuilder>> bulks;
+    bulks.push_back(std::move(bulk));
+    return commitBulk(txn, std::move(bulks), mayInterrupt, dupsAllowed, dupsToDrop);
+}
+
+Status IndexAccessMethod::commitBulk(OperationContext* txn,
+                                     std::vector<std::unique_ptr<BulkBuilder>> bulks,
+                                     bool mayInterrupt,
+                                     bool dupsAllowed,
+                                     set<RecordId>* dupsToDrop) {
+    invariant(!bulks.empty());
     Timer timer;
 
-    std::unique_ptr<BulkBuilder::Sorter::Iterator> i(bulk->_sorter->done());
+    int64_t keysInserted = 0;
+    bool isMultiKey = false;
+    for (auto&& bulk : bulks) {
+        keysInserted += bulk->_keysInserted;
+        isMultiKey = isMultiKey || bulk->_isMultiKey;
+    }
+
+    std::unique_ptr<BulkBuilder::Sorter::Iterator> i;
+    if (bulks.size() == 1) {
+        i.reset(bulks[0]->_sorter->done());
+    } else {
+        // Sorting what each builder still holds in memory, and spilling it if the builder has
+        // spilled before, is independent between builders, so do it concurrently.
+        stdx::unique_lock<Client> lk(*txn->getClient());
+        ProgressMeterHolder pm(*txn->setMessage_inlock("Index Bulk Build: (1/3) sorting partitions",
+                                                       "Index: (1/3) Sorting Partitions Progress",
+                                                       bulks.size()));
+        lk.unlock();
+
+        std::vector<std::shared_ptr<BulkBuilder::Sorter::Iterator>> partitions(bulks.size());
+        std::vector<Status> statuses(bulks.size(), Status::OK());
+        std::vector<stdx::thread> threads;
+        for (size_t p = 0; p < bulks.size(); p++) {
+            BulkBuilder* bulk = bulks[p].get();
+            std::shared_ptr<BulkBuilder::Sorter::Iterator>* partition = &partitions[p];
+            Status* status = &statuses[p];
+            threads.emplace_back([bulk, partition, status] {
+                try {
+                    partition->reset(bulk->_sorter->done());
+                } catch (const DBException& e) {
+                    *status = e.toStatus();
+                }
+            });
+        }
+        for (auto&& thread : threads) {
+            thread.join();
+            pm.hit();
+        }
+        pm.finished();
+
+        for (auto&& status : statuses) {
+            if (!status.isOK())
+                return status;
+        }
+
+        i.reset(BulkBuilder::Sorter::Iterator::merge(
+            partitions,
+            SortOptions(),
+            BtreeExternalSortComparison(_descriptor->keyPattern(), _descriptor->version())));
+    }
 
     stdx::unique_lock<Client> lk(*txn->getClient());
     ProgressMeterHolder pm(*txn->setMessage_inlock("Index Bulk Build: (2/3) btree bottom up",
                                                    "Index: (2/3) BTree Bottom Up Progress",
-                                                   bulk->_keysInserted,
+                                                   keysInserted,
                                                    10));
     lk.unlock();
 
@@ -381,7 +570,7 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
     MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
         WriteUnitOfWork wunit(txn);
 
-        if (bulk->_isMultiKey) {
+        if (isMultiKey) {
             _btreeState->setMultikey(txn);
         }
 
@@ -404,6 +593,9 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
 
         // Get the next datum and add it to the builder.
         BulkBuilder::Sorter::Data d = i->next();
+        if (_bloomFilter) {
+            _bloomFilter->add(d.first);
+        }
         Status status = builder->addKey(d.first, d.second);
 
         if (!status.isOK()) {
@@ -31,6 +31,7 @@
 #include <memory>
 
 #include "mongo/base/disallow_copying.h"
+#include "mongo/db/index/index_bloom_filter.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context.h"
@@ -180,8 +181,21 @@ public:
      */
     long long getSpaceUsedBytes(OperationContext* txn) const;
 
+    /**
+     * Returns the RecordId of the entry with 'key', or a null RecordId if there is none. Keys
+     * which the Bloom filter rules out are not looked up in the storage engine.
+     */
     RecordId findSingle(OperationContext* txn, const BSONObj& key) const;
 
+    /**
+     * Sets up the Bloom filter for a unique index, filled from the keys already in the index, if
+     * the indexBloomFilterSizeBytes server parameter asks for one.
+     *
+     * Every insert which starts before the filter exists has to be done or rolled back, and none
+     * may run concurrently with filling it, so the caller must hold the collection exclusively.
+     */
+    void initBloomFilter(OperationContext* txn);
+
     //
     // Bulk operations support
     //
@@ -190,6 +204,9 @@ public:
     public:
         /**
          * Insert into the BulkBuilder as-if inserting into an IndexAccessMethod.
+         *
+         * Only touches this BulkBuilder, so different BulkBuilders of the same index may be
+         * filled from different threads. 'txn' is not used and may be null.
          */
         Status insert(OperationContext* txn,
                       const BSONObj& obj,
@@ -202,7 +219,9 @@ public:
 
         using Sorter = mongo::Sorter<BSONObj, RecordId>;
 
-        BulkBuilder(const IndexAccessMethod* index, const IndexDescriptor* descriptor);
+        BulkBuilder(const IndexAccessMethod* index,
+                    const IndexDescriptor* descriptor,
+                    size_t maxMemoryUsageBytes);
 
         std::unique_ptr<Sorter> _sorter;
         const IndexAccessMethod* _real;
@@ -217,7 +236,8 @@ public:
      *
      * It is only legal to initiate bulk when the index is new and empty.
      */
-    std::unique_ptr<BulkBuilder> initiateBulk();
+    std::unique_ptr<BulkBuilder> initiateBulk(
+        size_t maxMemoryUsageBytes = kDefaultBulkMaxMemoryUsageBytes);
 
     /**
      * Call this when you are ready to finish your bulk work.
@@ -234,6 +254,21 @@ public:
                       bool dupsAllowed,
                       std::set<RecordId>* dups);
 
+    /**
+     * Like commitBulk() for several BulkBuilders, each filled with a share of the documents,
+     * possibly from different threads. The builders finish sorting concurrently and their keys
+     * are then merged into the index.
+     */
+    Status commitBulk(OperationContext* txn,
+                      std::vector<std::unique_ptr<BulkBuilder>> bulks,
+                      bool mayInterrupt,
+                      bool dupsAllowed,
+                      std::set<RecordId>* dups);
+
+    // Memory a BulkBuilder sorts in before it spills to disk, unless initiateBulk() is told
+    // otherwise.
+    static const size_t kDefaultBulkMaxMemoryUsageBytes = 100 * 1024 * 1024;
+
     /**
      * Fills 'keys' with the keys that should be generated for 'obj' on this index.
      */
@@ -252,7 +287,18 @@ private:
                       const RecordId& loc,
                       bool dupsAllowed);
 
+    /**
+     * Returns 'keys' sorted in the order of this index, which is the order in which
+     * SortedDataInterface::insertKeys() and unindexKeys() want them.
+     */
+    std::vector<BSONObj> inIndexOrder(const BSONObjSet& keys) const;
+    std::vector<BSONObj> inIndexOrder(const std::vector<BSONObj*>& keys) const;
+
     const std::unique_ptr<SortedDataInterface> _newInterface;
+
+    // Null unless the index is unique and initBloomFilter() set one up. Shared by all threads
+    // using the index.
+    std::unique_ptr<IndexBloomFilter> _bloomFilter;
 };
 
 /**
@@ -0,0 +1,154 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/index/index_bloom_filter.h"
+
+#include <algorithm>
+#include <third_party/murmurhash3/MurmurHash3.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/storage/key_string.h"
+
+namespace mongo {
+
+const int IndexBloomFilter::kBitsPerKey;
+const int IndexBloomFilter::kNumProbes;
+
+namespace {
+
+AtomicInt64 totalFilterBytes;
+
+const Ordering kAllAscending = Ordering::make(BSONObj());
+
+// Lookups may come with the field names of the query, which KeyString doesn't take.
+BSONObj stripFieldNames(const BSONObj& key) {
+    BSONObjIterator it(key);
+    while (it.more()) {
+        if (*it.next().fieldName()) {
+            BSONObjBuilder builder;
+            BSONForEach(elem, key) {
+                builder.appendAs(elem, StringData());
+            }
+            return builder.obj();
+        }
+    }
+    return key;
+}
+
+}  // namespace
+
+std::unique_ptr<IndexBloomFilter> IndexBloomFilter::make(long long sizeBytes,
+                                                         long long maxTotalBytes) {
+    // Round up to whole words, so that the filter has room for at least one key.
+    sizeBytes = std::max(sizeBytes, 1LL);
+    sizeBytes = (sizeBytes + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+
+    if (totalFilterBytes.addAndFetch(sizeBytes) > maxTotalBytes) {
+        totalFilterBytes.subtractAndFetch(sizeBytes);
+        return nullptr;
+    }
+    return std::unique_ptr<IndexBloomFilter>(new IndexBloomFilter(sizeBytes));
+}
+
+IndexBloomFilter::IndexBloomFilter(long long sizeBytes)
+    : _sizeBytes(sizeBytes),
+      _numBits(sizeBytes * 8),
+      _capacity(std::max(_numBits / kBitsPerKey, uint64_t(1))),
+      _words(new std::atomic<uint64_t>[sizeBytes / sizeof(uint64_t)]) {  // NOLINT
+    for (long long i = 0; i < _sizeBytes / static_cast<long long>(sizeof(uint64_t)); i++) {
+        _words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+IndexBloomFilter::~IndexBloomFilter() {
+    totalFilterBytes.subtractAndFetch(_sizeBytes);
+}
+
+long long IndexBloomFilter::totalBytes() {
+    return totalFilterBytes.load();
+}
+
+void IndexBloomFilter::add(const BSONObj& key) {
+    _numAdded.fetchAndAdd(1);
+
+    uint64_t h1, h2;
+    _hash(key, &h1, &h2);
+    for (int i = 0; i < kNumProbes; i++) {
+        const uint64_t bit = (h1 + i * h2) % _numBits;
+        _words[bit / 64].fetch_or(uint64_t(1) << (bit % 64));
+    }
+}
+
+bool IndexBloomFilter::mayContain(const BSONObj& key) {
+    _numLookups.fetchAndAdd(1);
+    if (isFull())
+        return true;
+
+    uint64_t h1, h2;
+    _hash(key, &h1, &h2);
+    for (int i = 0; i < kNumProbes; i++) {
+        const uint64_t bit = (h1 + i * h2) % _numBits;
+        if (!(_words[bit / 64].load() & (uint64_t(1) << (bit % 64)))) {
+            _numNegatives.fetchAndAdd(1);
+            return false;
+        }
+    }
+    return true;
+}
+
+void IndexBloomFilter::recordFalsePositive() {
+    _numFalsePositives.fetchAndAdd(1);
+}
+
+bool IndexBloomFilter::isFull() const {
+    return _numAdded.load() > _capacity;
+}
+
+void IndexBloomFilter::appendStats(BSONObjBuilder* builder) const {
+    builder->appendNumber("sizeBytes", _sizeBytes);
+    builder->appendNumber("capacity", _capacity);
+    builder->appendNumber("keysAdded", _numAdded.load());
+    builder->append("full", isFull());
+    builder->appendNumber("lookups", _numLookups.load());
+    builder->appendNumber("negatives", _numNegatives.load());
+    builder->appendNumber("falsePositives", _numFalsePositives.load());
+}
+
+void IndexBloomFilter::_hash(const BSONObj& key, uint64_t* h1, uint64_t* h2) const {
+    const KeyString ks(stripFieldNames(key), kAllAscending);
+    uint64_t hash[2];
+    MurmurHash3_x64_128(ks.getBuffer(), ks.getSize(), 0, hash);
+    *h1 = hash[0];
+    // An even second hash would only probe half of the positions when the number of bits is
+    // even, and zero would probe the same bit over and over.
+    *h2 = hash[1] | 1;
+}
+
+}  // namespace mongo
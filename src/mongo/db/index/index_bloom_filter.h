@@ -0,0 +1,113 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+class BSONObj;
+class BSONObjBuilder;
+
+/**
+ * A Bloom filter over the keys of a unique index, which lets lookups of keys that are not in the
+ * index return without asking the storage engine.
+ *
+ * Keys are hashed in their KeyString form, so keys which compare equal in the index, like 1 and
+ * 1.0, hash the same. The filter is safe to use from several threads at once.
+ *
+ * Entries can't be taken out of a Bloom filter. Keys which are removed from the index, or whose
+ * insert rolls back, stay in the filter and only make it answer "maybe" more often. Once more
+ * keys were added than it was sized for, the filter stops making claims and answers every lookup
+ * with "maybe".
+ */
+class IndexBloomFilter {
+    MONGO_DISALLOW_COPYING(IndexBloomFilter);
+
+public:
+    // With 10 bits per key and 7 probes, about 1% of the lookups of absent keys are false
+    // positives while the filter is within its capacity.
+    static const int kBitsPerKey = 10;
+    static const int kNumProbes = 7;
+
+    /**
+     * Returns a filter of 'sizeBytes', or nullptr if that would take the memory used by all
+     * filters over 'maxTotalBytes'.
+     */
+    static std::unique_ptr<IndexBloomFilter> make(long long sizeBytes, long long maxTotalBytes);
+
+    ~IndexBloomFilter();
+
+    /**
+     * Returns the memory used by all filters which currently exist.
+     */
+    static long long totalBytes();
+
+    void add(const BSONObj& key);
+
+    /**
+     * Returns false if 'key' is definitely not in the index, and true if it may be.
+     */
+    bool mayContain(const BSONObj& key);
+
+    /**
+     * Records that a key for which mayContain() returned true was not in the index after all.
+     */
+    void recordFalsePositive();
+
+    /**
+     * True once more keys were added than the filter was sized for.
+     */
+    bool isFull() const;
+
+    void appendStats(BSONObjBuilder* builder) const;
+
+private:
+    explicit IndexBloomFilter(long long sizeBytes);
+
+    // Returns the two hashes the probe positions are derived from.
+    void _hash(const BSONObj& key, uint64_t* h1, uint64_t* h2) const;
+
+    const long long _sizeBytes;
+    const uint64_t _numBits;
+    const long long _capacity;
+    const std::unique_ptr<std::atomic<uint64_t>[]> _words;  // NOLINT
+
+    AtomicInt64 _numAdded;
+    AtomicInt64 _numLookups;
+    AtomicInt64 _numNegatives;
+    AtomicInt64 _numFalsePositives;
+};
+
+}  // namespace mongo
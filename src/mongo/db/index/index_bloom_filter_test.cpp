@@ -0,0 +1,124 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/index/index_bloom_filter.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const long long kUnlimited = std::numeric_limits<long long>::max();
+
+TEST(IndexBloomFilterTest, FindsEveryAddedKey) {
+    auto filter = IndexBloomFilter::make(1024, kUnlimited);
+    ASSERT(filter);
+
+    for (int i = 0; i < 500; i++) {
+        filter->add(BSON("" << i));
+    }
+    ASSERT_FALSE(filter->isFull());
+    for (int i = 0; i < 500; i++) {
+        ASSERT_TRUE(filter->mayContain(BSON("" << i)));
+    }
+}
+
+TEST(IndexBloomFilterTest, RejectsMostAbsentKeys) {
+    auto filter = IndexBloomFilter::make(1024, kUnlimited);
+    for (int i = 0; i < 800; i++) {
+        filter->add(BSON("" << i));
+    }
+
+    int maybes = 0;
+    for (int i = 1000; i < 11000; i++) {
+        if (filter->mayContain(BSON("" << i)))
+            maybes++;
+    }
+    // About 1% is expected at capacity.
+    ASSERT_LESS_THAN(maybes, 300);
+}
+
+TEST(IndexBloomFilterTest, KeysWhichCompareEqualHashTheSame) {
+    auto filter = IndexBloomFilter::make(1024, kUnlimited);
+    filter->add(BSON("" << 1 << ""
+                        << "a"));
+    ASSERT_TRUE(filter->mayContain(BSON("" << 1.0 << ""
+                                           << "a")));
+    ASSERT_TRUE(filter->mayContain(BSON("" << 1LL << ""
+                                           << "a")));
+    // Field names are not part of index keys.
+    ASSERT_TRUE(filter->mayContain(BSON("x" << 1 << "y"
+                                            << "a")));
+}
+
+TEST(IndexBloomFilterTest, AnswersMaybeOnceFull) {
+    auto filter = IndexBloomFilter::make(8, kUnlimited);
+    for (int i = 0; i < 100; i++) {
+        filter->add(BSON("" << i));
+    }
+    ASSERT_TRUE(filter->isFull());
+    ASSERT_TRUE(filter->mayContain(BSON("" << 1000)));
+}
+
+TEST(IndexBloomFilterTest, StaysWithinTotalMemory) {
+    const long long before = IndexBloomFilter::totalBytes();
+    {
+        auto first = IndexBloomFilter::make(1024, before + 2048);
+        ASSERT(first);
+        auto second = IndexBloomFilter::make(1024, before + 2048);
+        ASSERT(second);
+        ASSERT_FALSE(IndexBloomFilter::make(1024, before + 2048));
+        ASSERT_EQUALS(before + 2048, IndexBloomFilter::totalBytes());
+    }
+    ASSERT_EQUALS(before, IndexBloomFilter::totalBytes());
+}
+
+TEST(IndexBloomFilterTest, ReportsStatistics) {
+    auto filter = IndexBloomFilter::make(1024, kUnlimited);
+    filter->add(BSON("" << 1));
+    ASSERT_TRUE(filter->mayContain(BSON("" << 1)));
+    filter->mayContain(BSON("" << 2));
+    filter->recordFalsePositive();
+
+    BSONObjBuilder builder;
+    filter->appendStats(&builder);
+    const BSONObj stats = builder.obj();
+    ASSERT_EQUALS(1024, stats["sizeBytes"].numberLong());
+    ASSERT_EQUALS(1024 * 8 / IndexBloomFilter::kBitsPerKey, stats["capacity"].numberLong());
+    ASSERT_EQUALS(1, stats["keysAdded"].numberLong());
+    ASSERT_EQUALS(2, stats["lookups"].numberLong());
+    ASSERT_EQUALS(1, stats["falsePositives"].numberLong());
+    ASSERT_FALSE(stats["full"].trueValue());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -82,6 +82,7 @@
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/s/sharded_connection_info.h"
 #include "mongo/db/s/sharding_state.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/storage/storage_engine.h"
@@ -155,6 +156,59 @@ MONGO_FP_DECLARE(rsStopGetMore);
 
 namespace {
 
+// What operations are grouped by when the storage engine shares its tickets fairly between
+// tenants: "database", or "vip" for the VIP through which the client connected.
+std::string admissionControlTenantKey = "database";
+
+class ExportedAdmissionControlTenantKeyParameter
+    : public ExportedServerParameter<std::string, ServerParameterType::kStartupOnly> {
+public:
+    ExportedAdmissionControlTenantKeyParameter()
+        : ExportedServerParameter<std::string, ServerParameterType::kStartupOnly>(
+              ServerParameterSet::getGlobal(),
+              "admissionControlTenantKey",
+              &admissionControlTenantKey) {}
+
+    virtual Status validate(const std::string& potentialNewValue) {
+        if (potentialNewValue != "database" && potentialNewValue != "vip") {
+            return Status(ErrorCodes::BadValue,
+                          "admissionControlTenantKey must be either 'database' or 'vip'");
+        }
+
+        return Status::OK();
+    }
+
+} exportedAdmissionControlTenantKeyParam;
+
+/**
+ * Returns the tenant on whose behalf the request in 'm' runs, or an empty string if it cannot
+ * be attributed to one.
+ */
+std::string admissionTenant(const Client& client, Message& m, const NamespaceString& nsString) {
+    if (admissionControlTenantKey == "vip") {
+        std::string vip;
+        int vport;
+        uint32_t vid;
+        if (!client.isVipMode(vip, vport, vid))
+            return std::string();
+        return str::stream() << vip << ':' << vport;
+    }
+
+    if (nsString.size())
+        return nsString.db().toString();
+
+    if (m.operation() == dbCommand) {
+        // The body of an OP_COMMAND starts with the name of the database.
+        const char* data = m.singleData().data();
+        const size_t len = m.singleData().dataLen();
+        const size_t dbLen = strnlen(data, len);
+        if (dbLen < len)
+            return std::string(data, dbLen);
+    }
+
+    return std::string();
+}
+
 unique_ptr<AuthzManagerExternalState> createAuthzManagerExternalStateMongod() {
     return stdx::make_unique<AuthzManagerExternalStateMongod>();
 }
@@ -480,6 +534,10 @@ void assembleResponse(OperationContext* txn,
     const char* ns = dbmsg.messageShouldHaveNs() ? dbmsg.getns() : NULL;
     const NamespaceString nsString = ns ? NamespaceString(ns) : NamespaceString();
 
+    if (!c.isInDirectClient()) {
+        txn->lockState()->setAdmissionTenant(admissionTenant(c, m, nsString));
+    }
+
     if (op == dbQuery) {
         if (nsString.isCommand()) {
             isCommand = true;
@@ -949,7 +1007,7 @@ bool receivedGetMore(OperationContext* txn, DbResponse& dbresponse, Message& m,
     }
 
     bool exhaust = false;
-    QueryResult::View msgdata = 0;
+    Message reply;
     bool isCursorAuthorized = false;
 
     try {
@@ -965,7 +1023,7 @@ bool receivedGetMore(OperationContext* txn, DbResponse& dbresponse, Message& m,
             sleepmillis(0);
         }
 
-        msgdata = getMore(txn, ns, ntoreturn, cursorid, &exhaust, &isCursorAuthorized);
+        reply = getMore(txn, ns, ntoreturn, cursorid, &exhaust, &isCursorAuthorized);
     } catch (AssertionException& e) {
         if (isCursorAuthorized) {
             // If a cursor with id 'cursorid' was authorized, it may have been advanced
@@ -988,9 +1046,10 @@ bool receivedGetMore(OperationContext* txn, DbResponse& dbresponse, Message& m,
         return false;
     }
 
-    dbresponse.response.setData(msgdata.view2ptr(), true);
+    dbresponse.response = std::move(reply);
     curop.debug().responseLength = dbresponse.response.header().dataLen();
-    curop.debug().nreturned = msgdata.getNReturned();
+    curop.debug().nreturned =
+        QueryResult::View(dbresponse.response.header().view2ptr()).getNReturned();
 
     dbresponse.responseTo = m.header().getId();
 
@@ -0,0 +1,355 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_match_expression.h"
+
+#include <cmath>
+
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+// Evaluation keeps the per document state on the stack, which bounds the number of distinct
+// paths a compiled expression can test.
+const size_t kMaxPaths = 16;
+
+}  // namespace
+
+struct CompiledMatchExpression::Context {
+    explicit Context(const BSONObj& doc) : doc(doc) {}
+
+    const BSONObj& doc;
+
+    // Whether the top level fields have been located yet.
+    bool scanned = false;
+    BSONElement topLevel[kMaxPaths];
+
+    bool isResolved[kMaxPaths] = {};
+    BSONElement resolved[kMaxPaths];
+};
+
+std::unique_ptr<CompiledMatchExpression> CompiledMatchExpression::compile(
+    const MatchExpression* expr) {
+    std::unique_ptr<CompiledMatchExpression> compiled(new CompiledMatchExpression(expr));
+    if (!compiled->_compileNode(expr)) {
+        return nullptr;
+    }
+    return compiled;
+}
+
+bool CompiledMatchExpression::_compileNode(const MatchExpression* node) {
+    const size_t pc = _program.size();
+    _program.emplace_back();
+
+    switch (node->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+        case MatchExpression::NOT: {
+            _program[pc].op = _opFor(node->matchType());
+            for (size_t i = 0; i < node->numChildren(); i++) {
+                if (!_compileNode(node->getChild(i))) {
+                    return false;
+                }
+            }
+            break;
+        }
+
+        case MatchExpression::EXISTS: {
+            _program[pc].op = _opFor(node->matchType());
+            if (!_internPath(node->path(), &_program[pc].path)) {
+                return false;
+            }
+            break;
+        }
+
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            const BSONElement rhs = static_cast<const ComparisonMatchExpression*>(node)->getData();
+
+            // These operands have special rules for comparisons across types, or match missing
+            // fields, and are left to the MatchExpression.
+            switch (rhs.type()) {
+                case jstNULL:
+                case Undefined:
+                case MinKey:
+                case MaxKey:
+                case Array:
+                    return false;
+                default:
+                    break;
+            }
+            if (rhs.isNumber() && std::isnan(rhs.numberDouble())) {
+                return false;
+            }
+
+            Instruction& instr = _program[pc];
+            instr.op = _opFor(node->matchType());
+            instr.rhs = rhs;
+            instr.rhsCanonicalType = rhs.canonicalType();
+            if (NumberInt == rhs.type() || NumberLong == rhs.type()) {
+                instr.kernel = Kernel::kInt64;
+                instr.rhsLong = rhs.numberLong();
+            } else if (NumberDouble == rhs.type()) {
+                instr.kernel = Kernel::kDouble;
+                instr.rhsDouble = rhs.numberDouble();
+            } else if (String == rhs.type()) {
+                instr.kernel = Kernel::kString;
+                instr.rhsString = StringData(rhs.valuestr(), rhs.valuestrsize() - 1);
+            } else {
+                instr.kernel = Kernel::kGeneric;
+            }
+            if (!_internPath(node->path(), &instr.path)) {
+                return false;
+            }
+            break;
+        }
+
+        default:
+            return false;
+    }
+
+    _program[pc].end = _program.size();
+    return true;
+}
+
+CompiledMatchExpression::Op CompiledMatchExpression::_opFor(MatchExpression::MatchType type) {
+    switch (type) {
+        case MatchExpression::AND:
+            return Op::kAnd;
+        case MatchExpression::OR:
+            return Op::kOr;
+        case MatchExpression::NOR:
+            return Op::kNor;
+        case MatchExpression::NOT:
+            return Op::kNot;
+        case MatchExpression::EXISTS:
+            return Op::kExists;
+        case MatchExpression::EQ:
+            return Op::kEq;
+        case MatchExpression::LT:
+            return Op::kLt;
+        case MatchExpression::LTE:
+            return Op::kLte;
+        case MatchExpression::GT:
+            return Op::kGt;
+        case MatchExpression::GTE:
+            return Op::kGte;
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+bool CompiledMatchExpression::_internPath(StringData dotted, size_t* index) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (true) {
+        const size_t dot = dotted.find('.', start);
+        const StringData part =
+            dotted.substr(start, dot == std::string::npos ? std::string::npos : dot - start);
+        if (part.empty()) {
+            return false;
+        }
+        parts.push_back(part.toString());
+        if (dot == std::string::npos)
+            break;
+        start = dot + 1;
+    }
+
+    size_t topLevelField = 0;
+    while (topLevelField < _topLevelFields.size() && _topLevelFields[topLevelField] != parts[0]) {
+        topLevelField++;
+    }
+    parts.erase(parts.begin());
+
+    for (size_t i = 0; i < _paths.size(); i++) {
+        if (_paths[i].topLevelField == topLevelField && _paths[i].rest == parts) {
+            *index = i;
+            return true;
+        }
+    }
+
+    if (_paths.size() == kMaxPaths) {
+        return false;
+    }
+    if (topLevelField == _topLevelFields.size()) {
+        _topLevelFields.push_back(dotted.substr(0, dotted.find('.')).toString());
+    }
+    _paths.push_back(Path{topLevelField, std::move(parts)});
+    *index = _paths.size() - 1;
+    return true;
+}
+
+bool CompiledMatchExpression::matchesBSON(const BSONObj& doc) const {
+    Context ctx(doc);
+    switch (_eval(0, &ctx)) {
+        case Result::kTrue:
+            return true;
+        case Result::kFalse:
+            return false;
+        case Result::kFallBack:
+            return _expr->matchesBSON(doc);
+    }
+    MONGO_UNREACHABLE;
+}
+
+CompiledMatchExpression::Result CompiledMatchExpression::_eval(size_t pc, Context* ctx) const {
+    const Instruction& instr = _program[pc];
+    switch (instr.op) {
+        case Op::kAnd:
+            for (size_t child = pc + 1; child < instr.end; child = _program[child].end) {
+                const Result result = _eval(child, ctx);
+                if (Result::kTrue != result)
+                    return result;
+            }
+            return Result::kTrue;
+
+        case Op::kOr:
+            for (size_t child = pc + 1; child < instr.end; child = _program[child].end) {
+                const Result result = _eval(child, ctx);
+                if (Result::kFalse != result)
+                    return result;
+            }
+            return Result::kFalse;
+
+        case Op::kNor:
+            for (size_t child = pc + 1; child < instr.end; child = _program[child].end) {
+                const Result result = _eval(child, ctx);
+                if (Result::kTrue == result)
+                    return Result::kFalse;
+                if (Result::kFallBack == result)
+                    return result;
+            }
+            return Result::kTrue;
+
+        case Op::kNot: {
+            const Result result = _eval(pc + 1, ctx);
+            if (Result::kFallBack == result)
+                return result;
+            return Result::kTrue == result ? Result::kFalse : Result::kTrue;
+        }
+
+        default:
+            return _evalLeaf(instr, ctx);
+    }
+}
+
+CompiledMatchExpression::Result CompiledMatchExpression::_evalLeaf(const Instruction& instr,
+                                                                   Context* ctx) const {
+    if (!ctx->isResolved[instr.path]) {
+        if (!ctx->scanned) {
+            // Locate all top level fields with one pass over the document. As with getField(),
+            // the first occurrence of a field name wins.
+            size_t numFound = 0;
+            BSONObjIterator it(ctx->doc);
+            while (it.more() && numFound < _topLevelFields.size()) {
+                const BSONElement e = it.next();
+                const StringData name = e.fieldNameStringData();
+                for (size_t i = 0; i < _topLevelFields.size(); i++) {
+                    if (ctx->topLevel[i].eoo() && name == _topLevelFields[i]) {
+                        ctx->topLevel[i] = e;
+                        numFound++;
+                        break;
+                    }
+                }
+            }
+            ctx->scanned = true;
+        }
+
+        const Path& path = _paths[instr.path];
+        BSONElement e = ctx->topLevel[path.topLevelField];
+        for (size_t i = 0; i < path.rest.size() && !e.eoo(); i++) {
+            if (Array == e.type())
+                return Result::kFallBack;
+            e = Object == e.type() ? e.embeddedObject().getField(path.rest[i]) : BSONElement();
+        }
+        if (Array == e.type())
+            return Result::kFallBack;
+
+        ctx->resolved[instr.path] = e;
+        ctx->isResolved[instr.path] = true;
+    }
+
+    const BSONElement& e = ctx->resolved[instr.path];
+    if (Op::kExists == instr.op) {
+        return e.eoo() ? Result::kFalse : Result::kTrue;
+    }
+    if (e.eoo()) {
+        return Result::kFalse;
+    }
+    return _compare(instr, e) ? Result::kTrue : Result::kFalse;
+}
+
+bool CompiledMatchExpression::_compare(const Instruction& instr, const BSONElement& e) {
+    int cmp;
+    if (Kernel::kInt64 == instr.kernel && (NumberInt == e.type() || NumberLong == e.type())) {
+        const long long value = e.numberLong();
+        cmp = value < instr.rhsLong ? -1 : value > instr.rhsLong ? 1 : 0;
+    } else if (Kernel::kDouble == instr.kernel && NumberDouble == e.type()) {
+        const double value = e._numberDouble();
+        if (std::isnan(value))
+            return false;
+        cmp = value < instr.rhsDouble ? -1 : value > instr.rhsDouble ? 1 : 0;
+    } else if (Kernel::kString == instr.kernel && String == e.type()) {
+        cmp = StringData(e.valuestr(), e.valuestrsize() - 1).compare(instr.rhsString);
+    } else {
+        // Same as ComparisonMatchExpression::matchesSingleElement() for the operand types which
+        // get compiled.
+        if (e.canonicalType() != instr.rhsCanonicalType)
+            return false;
+        if (std::isnan(e.numberDouble()))
+            return false;
+        cmp = compareElementValues(e, instr.rhs);
+    }
+
+    switch (instr.op) {
+        case Op::kEq:
+            return cmp == 0;
+        case Op::kLt:
+            return cmp < 0;
+        case Op::kLte:
+            return cmp <= 0;
+        case Op::kGt:
+            return cmp > 0;
+        case Op::kGte:
+            return cmp >= 0;
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,137 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+/**
+ * A MatchExpression flattened into a program which evaluates faster than walking the expression
+ * tree, for the common shapes of filters: $and, $or, $nor and $not over comparisons and $exists.
+ *
+ * Compilation resolves the paths of all predicates up front. During evaluation the top level
+ * fields are located with a single pass over the document and nested fields are looked up
+ * directly, instead of going through an ElementIterator per predicate. Each comparison uses a
+ * kernel specialized for the type of its operand.
+ *
+ * Array traversal is not compiled. When a path runs into an array, the document is matched with
+ * the original expression instead, so the results are always the same as those of
+ * MatchExpression::matchesBSON().
+ */
+class CompiledMatchExpression {
+    MONGO_DISALLOW_COPYING(CompiledMatchExpression);
+
+public:
+    /**
+     * Returns the compiled form of 'expr', or nullptr if 'expr' contains anything which cannot
+     * be compiled. 'expr' is not owned and must outlive the result.
+     */
+    static std::unique_ptr<CompiledMatchExpression> compile(const MatchExpression* expr);
+
+    /**
+     * Same as _expr->matchesBSON(doc).
+     */
+    bool matchesBSON(const BSONObj& doc) const;
+
+    /**
+     * The number of instructions in the program. Exposed for testing.
+     */
+    size_t programSize() const {
+        return _program.size();
+    }
+
+private:
+    enum class Op { kAnd, kOr, kNor, kNot, kExists, kEq, kLt, kLte, kGt, kGte };
+
+    // How a comparison is carried out, based on the type of its operand.
+    enum class Kernel { kInt64, kDouble, kString, kGeneric };
+
+    enum class Result { kFalse, kTrue, kFallBack };
+
+    struct Instruction {
+        Op op;
+
+        // Index of the first instruction after this one's subtree.
+        size_t end = 0;
+
+        // For predicates, the path being tested, as an index into _paths.
+        size_t path = 0;
+
+        // For comparisons, the operand and its pre-decoded value.
+        Kernel kernel = Kernel::kGeneric;
+        BSONElement rhs;
+        int rhsCanonicalType = 0;
+        long long rhsLong = 0;
+        double rhsDouble = 0;
+        StringData rhsString;
+    };
+
+    struct Path {
+        // Index into _topLevelFields of the first component.
+        size_t topLevelField;
+
+        // The remaining components, if the path is dotted.
+        std::vector<std::string> rest;
+    };
+
+    // Per document state of an evaluation.
+    struct Context;
+
+    explicit CompiledMatchExpression(const MatchExpression* expr) : _expr(expr) {}
+
+    bool _compileNode(const MatchExpression* node);
+
+    static Op _opFor(MatchExpression::MatchType type);
+
+    // Sets 'index' to the position of 'path' in _paths, adding it if necessary. Returns false if
+    // the path cannot be compiled.
+    bool _internPath(StringData path, size_t* index);
+
+    Result _eval(size_t pc, Context* ctx) const;
+
+    Result _evalLeaf(const Instruction& instr, Context* ctx) const;
+
+    static bool _compare(const Instruction& instr, const BSONElement& e);
+
+    const MatchExpression* const _expr;
+
+    std::vector<Instruction> _program;
+    std::vector<Path> _paths;
+    std::vector<std::string> _topLevelFields;
+};
+
+}  // namespace mongo
@@ -0,0 +1,175 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <limits>
+
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::unique_ptr<MatchExpression> parse(const BSONObj& query) {
+    StatusWithMatchExpression status = MatchExpressionParser::parse(query);
+    ASSERT_OK(status.getStatus());
+    return std::move(status.getValue());
+}
+
+std::vector<BSONObj> testDocuments() {
+    return {
+        BSONObj(),
+        fromjson("{a: 1}"),
+        fromjson("{a: 5, b: 'x'}"),
+        fromjson("{a: 5.5, b: 'xyz'}"),
+        fromjson("{a: NumberLong(5), b: 'y'}"),
+        fromjson("{a: NaN}"),
+        fromjson("{a: null, b: null}"),
+        fromjson("{a: 'str', b: 5}"),
+        fromjson("{a: true}"),
+        fromjson("{a: {b: 1, c: 'x'}}"),
+        fromjson("{a: {b: {c: 7}}}"),
+        fromjson("{a: {b: [1, 7]}}"),
+        fromjson("{a: [1, 5, 9]}"),
+        fromjson("{a: [{b: 1}, {b: 7}]}"),
+        fromjson("{a: 1, a: 9}"),
+        fromjson("{b: 'x', a: -0.0}"),
+        fromjson("{a: {$date: 1000}}"),
+        fromjson("{a: ObjectId('000000000000000000000001')}"),
+        fromjson("{a: {b: 1}, b: 2}"),
+        BSON("a" << std::numeric_limits<long long>::max() << "b" << 1.0),
+        BSON("a" << std::numeric_limits<long long>::max() - 1),
+    };
+}
+
+/**
+ * Checks that the compiled form of 'query' exists and agrees with the MatchExpression on every
+ * test document.
+ */
+void assertSameResults(const char* query) {
+    const BSONObj queryObj = fromjson(query);
+    std::unique_ptr<MatchExpression> expr = parse(queryObj);
+    std::unique_ptr<CompiledMatchExpression> compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled) << query;
+
+    for (auto&& doc : testDocuments()) {
+        ASSERT_EQUALS(expr->matchesBSON(doc), compiled->matchesBSON(doc))
+            << "query: " << query << " doc: " << doc;
+    }
+}
+
+void assertNotCompiled(const char* query) {
+    const BSONObj queryObj = fromjson(query);
+    std::unique_ptr<MatchExpression> expr = parse(queryObj);
+    ASSERT_FALSE(CompiledMatchExpression::compile(expr.get())) << query;
+}
+
+TEST(CompiledMatchExpressionTest, Comparisons) {
+    assertSameResults("{a: 5}");
+    assertSameResults("{a: {$lt: 5}}");
+    assertSameResults("{a: {$lte: 5.5}}");
+    assertSameResults("{a: {$gt: NumberLong(1)}}");
+    assertSameResults("{a: {$gte: 0}}");
+    assertSameResults("{a: 0}");
+    assertSameResults("{a: {$gt: 9223372036854775806}}");
+    assertSameResults("{a: {$gte: 'str'}}");
+    assertSameResults("{b: {$lt: 'xz'}}");
+    assertSameResults("{a: true}");
+    assertSameResults("{a: {$gt: {$date: 0}}}");
+    assertSameResults("{a: ObjectId('000000000000000000000001')}");
+    assertSameResults("{a: {b: 1, c: 'x'}}");
+}
+
+TEST(CompiledMatchExpressionTest, DottedPaths) {
+    assertSameResults("{'a.b': 1}");
+    assertSameResults("{'a.b': {$gte: 1}}");
+    assertSameResults("{'a.b.c': 7}");
+    assertSameResults("{'a.b': {$exists: true}}");
+    assertSameResults("{'a.b.c': {$exists: false}}");
+    assertSameResults("{'a.c': {$ne: 'x'}}");
+}
+
+TEST(CompiledMatchExpressionTest, Logical) {
+    assertSameResults("{a: {$gt: 1}, b: 'x'}");
+    assertSameResults("{$or: [{a: 1}, {b: {$gte: 'xy'}}]}");
+    assertSameResults("{$nor: [{a: 1}, {b: 5}]}");
+    assertSameResults("{a: {$not: {$gt: 2}}}");
+    assertSameResults("{a: {$ne: 5}}");
+    assertSameResults("{$and: [{a: {$exists: true}}, {$or: [{'a.b': 1}, {b: 2}]}]}");
+    assertSameResults("{$and: [{a: {$gte: 1}}, {a: {$lte: 9}}]}");
+}
+
+TEST(CompiledMatchExpressionTest, FallsBackOnArrays) {
+    const BSONObj query = fromjson("{'a.b': 7}");
+    std::unique_ptr<MatchExpression> expr = parse(query);
+    std::unique_ptr<CompiledMatchExpression> compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_TRUE(compiled->matchesBSON(fromjson("{a: [{b: 1}, {b: 7}]}")));
+    ASSERT_TRUE(compiled->matchesBSON(fromjson("{a: {b: [1, 7]}}")));
+    ASSERT_FALSE(compiled->matchesBSON(fromjson("{a: [{b: 1}]}")));
+}
+
+TEST(CompiledMatchExpressionTest, SharesPaths) {
+    const BSONObj query = fromjson("{a: {$gt: 1, $lt: 5}, 'a.b': 1}");
+    std::unique_ptr<MatchExpression> expr = parse(query);
+    std::unique_ptr<CompiledMatchExpression> compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_EQUALS(4U, compiled->programSize());
+}
+
+TEST(CompiledMatchExpressionTest, UnsupportedExpressionsAreNotCompiled) {
+    assertNotCompiled("{a: null}");
+    assertNotCompiled("{a: {$gt: {$minKey: 1}}}");
+    assertNotCompiled("{a: [1, 2]}");
+    assertNotCompiled("{a: NaN}");
+    assertNotCompiled("{a: {$in: [1, 2]}}");
+    assertNotCompiled("{a: /abc/}");
+    assertNotCompiled("{a: {$elemMatch: {$gt: 1}}}");
+    assertNotCompiled("{a: 1, b: {$size: 2}}");
+    assertNotCompiled("{'a..b': 1}");
+}
+
+TEST(CompiledMatchExpressionTest, LimitsNumberOfPaths) {
+    BSONObjBuilder builder;
+    for (int i = 0; i < 16; i++) {
+        builder.append(std::string(str::stream() << "f" << i), i);
+    }
+    const BSONObj query = builder.obj();
+    std::unique_ptr<MatchExpression> expr = parse(query);
+    ASSERT(CompiledMatchExpression::compile(expr.get()));
+
+    const BSONObj tooMany = BSONObjBuilder().appendElements(query).append("f16", 16).obj();
+    expr = parse(tooMany);
+    ASSERT_FALSE(CompiledMatchExpression::compile(expr.get()));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,102 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/column_batch.h"
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+ColumnBatch::ColumnBatch(std::vector<std::string> fieldNames)
+    : _fieldNames(std::move(fieldNames)), _columns(_fieldNames.size()) {
+    for (size_t i = 0; i < _fieldNames.size(); i++) {
+        _columnIndexes[_fieldNames[i]] = i;
+    }
+}
+
+size_t ColumnBatch::appendRow(const BSONObj& obj) {
+    for (auto&& column : _columns) {
+        column.emplace_back();
+    }
+
+    size_t bytes = 0;
+    size_t found = 0;
+    BSONObjIterator it(obj);
+    while (found < _columns.size() && it.more()) {
+        BSONElement element = it.next();
+        auto column = _columnIndexes.find(element.fieldNameStringData());
+        if (column == _columnIndexes.end())
+            continue;
+
+        // Like Document, only the first of several fields with the same name is visible.
+        Value& value = _columns[column->second].back();
+        if (!value.missing())
+            continue;
+
+        value = Value(element);
+        bytes += value.getApproximateSize();
+        found++;
+    }
+
+    _numRows++;
+    return bytes;
+}
+
+size_t ColumnBatch::appendRow(const Document& doc) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < _columns.size(); i++) {
+        _columns[i].push_back(doc[_fieldNames[i]]);
+        bytes += _columns[i].back().getApproximateSize();
+    }
+
+    _numRows++;
+    return bytes;
+}
+
+Document ColumnBatch::getRow(size_t row) const {
+    invariant(row < _numRows);
+
+    MutableDocument out;
+    for (size_t i = 0; i < _columns.size(); i++) {
+        if (!_columns[i][row].missing()) {
+            out.addField(_fieldNames[i], _columns[i][row]);
+        }
+    }
+    return out.freeze();
+}
+
+void ColumnBatch::clear() {
+    for (auto&& column : _columns) {
+        column.clear();
+    }
+    _numRows = 0;
+}
+
+}  // namespace mongo
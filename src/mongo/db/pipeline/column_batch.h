@@ -0,0 +1,98 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+class BSONObj;
+
+/**
+ * A batch of input documents stored column by column, holding only a fixed set of top-level
+ * fields. Filling it straight from BSON avoids building a Document, with its own table of fields,
+ * for every input document when a stage only reads a few of their fields.
+ *
+ * Row i of every column belongs to the same input document. A document without one of the fields
+ * holds a missing Value in its column.
+ */
+class ColumnBatch {
+public:
+    explicit ColumnBatch(std::vector<std::string> fieldNames);
+
+    size_t numColumns() const {
+        return _fieldNames.size();
+    }
+
+    const std::string& getFieldName(size_t column) const {
+        return _fieldNames[column];
+    }
+
+    const std::vector<Value>& getColumn(size_t column) const {
+        return _columns[column];
+    }
+
+    size_t size() const {
+        return _numRows;
+    }
+
+    bool empty() const {
+        return _numRows == 0;
+    }
+
+    /**
+     * Appends the fields of 'obj' as a new row. Returns the approximate number of bytes added.
+     */
+    size_t appendRow(const BSONObj& obj);
+
+    /**
+     * Like appendRow(const BSONObj&) for a document which has already been built.
+     */
+    size_t appendRow(const Document& doc);
+
+    /**
+     * Builds a document holding the fields of row 'row' which are not missing.
+     */
+    Document getRow(size_t row) const;
+
+    void clear();
+
+private:
+    std::vector<std::string> _fieldNames;
+    StringMap<size_t> _columnIndexes;
+    std::vector<std::vector<Value>> _columns;
+    size_t _numRows = 0;
+};
+
+}  // namespace mongo
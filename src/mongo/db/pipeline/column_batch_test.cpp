@@ -0,0 +1,93 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/pipeline/column_batch.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(ColumnBatchTest, ExtractsOnlyItsFields) {
+    ColumnBatch batch({"a", "c"});
+    batch.appendRow(BSON("a" << 1 << "b" << 2 << "c" << "x"));
+    batch.appendRow(BSON("c" << BSON("d" << 1) << "a" << BSON_ARRAY(1 << 2)));
+
+    ASSERT_EQUALS(2U, batch.numColumns());
+    ASSERT_EQUALS(2U, batch.size());
+    ASSERT_EQUALS(Value(1), batch.getColumn(0)[0]);
+    ASSERT_EQUALS(Value("x"), batch.getColumn(1)[0]);
+    ASSERT_EQUALS(Value(BSON_ARRAY(1 << 2)), batch.getColumn(0)[1]);
+    ASSERT_EQUALS(Value(DOC("d" << 1)), batch.getColumn(1)[1]);
+}
+
+TEST(ColumnBatchTest, MissingFieldsAreMissingValues) {
+    ColumnBatch batch({"a", "b"});
+    batch.appendRow(BSON("b" << 1));
+    batch.appendRow(BSONObj());
+
+    ASSERT_TRUE(batch.getColumn(0)[0].missing());
+    ASSERT_EQUALS(Value(1), batch.getColumn(1)[0]);
+    ASSERT_TRUE(batch.getColumn(0)[1].missing());
+    ASSERT_TRUE(batch.getColumn(1)[1].missing());
+    ASSERT_EQUALS(Document(), batch.getRow(1));
+}
+
+TEST(ColumnBatchTest, FirstOfDuplicateFieldsWins) {
+    ColumnBatch batch({"a"});
+    batch.appendRow(BSON("a" << 1 << "a" << 2));
+    ASSERT_EQUALS(Value(1), batch.getColumn(0)[0]);
+}
+
+TEST(ColumnBatchTest, MatchesRowsAppendedAsDocuments) {
+    const BSONObj obj = BSON("x" << 1 << "a" << "s" << "b" << BSONNULL);
+
+    ColumnBatch fromBson({"b", "a"});
+    ColumnBatch fromDocument({"b", "a"});
+    ASSERT_EQUALS(fromBson.appendRow(obj), fromDocument.appendRow(Document(obj)));
+
+    ASSERT_EQUALS(Document(BSON("b" << BSONNULL << "a" << "s")), fromBson.getRow(0));
+    ASSERT_EQUALS(fromBson.getRow(0), fromDocument.getRow(0));
+}
+
+TEST(ColumnBatchTest, ClearKeepsColumns) {
+    ColumnBatch batch({"a"});
+    batch.appendRow(BSON("a" << 1));
+    batch.clear();
+    ASSERT_TRUE(batch.empty());
+    ASSERT_EQUALS(1U, batch.numColumns());
+
+    batch.appendRow(BSON("a" << 2));
+    ASSERT_EQUALS(1U, batch.getColumn(0).size());
+    ASSERT_EQUALS(Value(2), batch.getColumn(0)[0]);
+}
+
+}  // namespace
+}  // namespace mongo
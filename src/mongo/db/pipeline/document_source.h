@@ -32,6 +32,7 @@
 
 #include <boost/optional.hpp>
 #include <boost/intrusive_ptr.hpp>
+#include <atomic>
 #include <deque>
 #include <list>
 #include <string>
@@ -46,6 +47,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/matcher.h"
 #include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/column_batch.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/dependencies.h"
 #include "mongo/db/pipeline/expression_context.h"
@@ -380,12 +382,20 @@ public:
     /// returns -1 for no limit
     long long getLimit() const;
 
+    /**
+     * Alternative to getNext() for a consumer which only reads the top-level fields of 'batch'.
+     * Replaces the contents of 'batch' with the next batch of documents, extracted straight from
+     * BSON into its columns. Returns false once the cursor is exhausted.
+     */
+    bool getNextColumnBatch(ColumnBatch* batch);
+
 private:
     DocumentSourceCursor(const std::string& ns,
                          const std::shared_ptr<PlanExecutor>& exec,
                          const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
 
-    void loadBatch();
+    // Loads the next batch into 'columns' if given, otherwise into _currentBatch.
+    void loadBatch(ColumnBatch* columns = nullptr);
 
     std::deque<Document> _currentBatch;
 
@@ -402,8 +412,22 @@ private:
 };
 
 
+// Memory $group may use for its groups before it spills them to disk.
+extern std::atomic<long long> internalDocumentSourceGroupMaxMemoryBytes;  // NOLINT
+
+/**
+ * Groups its input in a hash table. When the groups outgrow the memory budget and disk use is
+ * allowed, the partial state of every group is spilled to one of kNumSpillPartitions files
+ * according to the hash of its id, and the table is cleared. Once the input is exhausted, each
+ * partition is aggregated in memory on its own. A partition which is still too large for the
+ * budget is sorted by id with a Sorter, so that the parts of each group come out next to each
+ * other and can be merged.
+ */
 class DocumentSourceGroup final : public DocumentSource, public SplittableDocumentSource {
 public:
+    // Number of files the spilled groups are partitioned into.
+    static const size_t kNumSpillPartitions = 32;
+
     // virtuals from DocumentSource
     boost::optional<Document> getNext() final;
     const char* getSourceName() const final;
@@ -457,11 +481,29 @@ public:
 private:
     explicit DocumentSourceGroup(const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
 
-    /// Spill groups map to disk and returns an iterator to the file.
-    std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
+    typedef std::vector<boost::intrusive_ptr<Accumulator>> Accumulators;
+
+    /// Writes the partial state of every group to its spill partition and clears the groups.
+    void spill();
 
-    // Only used by spill. Would be function-local if that were legal in C++03.
-    class SpillSTLComparator;
+    /**
+     * Aggregates the next non-empty spilled partition into the groups map, or into
+     * _sorterIterator if it doesn't fit in memory. Returns false once all partitions are done.
+     */
+    bool loadNextPartition();
+
+    /**
+     * Returns the accumulators of the group with id 'id', creating them if the group is new.
+     * Adds the size of a new id to 'memoryUsageBytes' and subtracts the current size of the
+     * accumulators of an existing group, which the caller adds back after updating them.
+     */
+    Accumulators& getGroup(const Value& id, long long* memoryUsageBytes, bool* inserted);
+
+    /// Serializes the partial state of 'accums' for spilling.
+    Value serializeAccumulators(const Accumulators& accums) const;
+
+    /// Merges a partial state produced by serializeAccumulators() into 'accums'.
+    void mergeAccumulators(const Value& state, const Accumulators& accums) const;
 
     /*
       Before returning anything, this source must fetch everything from
@@ -472,6 +514,24 @@ private:
     void populate();
     bool populated;
 
+    /**
+     * Consumes all of the input from 'cursor' a ColumnBatch at a time, without building a
+     * Document per input, when the _id and all accumulator arguments are top-level fields of the
+     * input or constants. Returns false without consuming anything otherwise.
+     */
+    bool populateFromColumns(DocumentSourceCursor* cursor,
+                             long long* memoryUsageBytes,
+                             int* numStressSpills);
+
+    /**
+     * Adds an input with group id 'id' and accumulator arguments _arguments to its group,
+     * spilling first if the groups exceed the memory budget.
+     */
+    void processInput(const Value& id, long long* memoryUsageBytes, int* numStressSpills);
+
+    // Accumulator arguments of the input being processed.
+    std::vector<Value> _arguments;
+
     /**
      * Parses the raw id expression into _idExpressions and possibly _idFieldNames.
      */
@@ -489,7 +549,6 @@ private:
     Value expandId(const Value& val);
 
 
-    typedef std::vector<boost::intrusive_ptr<Accumulator>> Accumulators;
     typedef std::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
     GroupsMap groups;
 
@@ -515,15 +574,20 @@ private:
     bool _doingMerge;
     bool _spilled;
     const bool _extSortAllowed;
-    const int _maxMemoryUsageBytes;
+    const long long _maxMemoryUsageBytes;
     std::unique_ptr<Variables> _variables;
     std::vector<std::string> _idFieldNames;  // used when id is a document
     std::vector<boost::intrusive_ptr<Expression>> _idExpressions;
 
-    // only used when !_spilled
+    // used when !_spilled, and when _spilled for a partition which fit in memory
     GroupsMap::iterator groupsIterator;
 
     // only used when _spilled
+    std::vector<std::unique_ptr<SortedFileWriter<Value, Value>>> _partitionWriters;
+    std::vector<std::unique_ptr<Sorter<Value, Value>::Iterator>> _partitions;
+    size_t _nextPartition;
+
+    // only used when _spilled, for a partition which did not fit in memory
     std::unique_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
     std::pair<Value, Value> _firstPartOfNextGroup;
     Value _currentId;
@@ -1244,8 +1308,11 @@ private:
 };
 
 /**
- * Queries separate collection for equality matches with documents in the pipeline collection.
- * Adds matching documents to a new array field in the input document.
+ * Adds the documents of the foreign collection whose foreignField equals the localField of each
+ * input document. Depending on the size of the foreign collection and whether foreignField is
+ * indexed there, the matches are found with one query per input document, with one $in query per
+ * batch of input documents, or by reading the foreign collection into a hash table up front. See
+ * chooseStrategy().
  */
 class DocumentSourceLookUp final : public DocumentSource,
                                    public SplittableDocumentSource,
@@ -1288,8 +1355,53 @@ private:
         invariant(false);
     }
 
+    enum class Strategy {
+        // One query against the foreign collection per input document.
+        kPerDocument,
+        // One {$in: [...]} query per batch of input documents, whose results are then matched
+        // back to the input documents they belong to.
+        kBatchedProbe,
+        // The foreign collection is read once into a hash table on foreignField.
+        kHashJoin,
+    };
+
+    static const char* strategyName(Strategy strategy);
+
+    /**
+     * Estimates whether probing the foreign collection or reading all of it is cheaper. Without
+     * an index on foreignField every probe scans the collection, so a hash join is used whenever
+     * the collection fits in memory. With an index, the hash join only pays off for collections
+     * small enough to be read in about the time of a few probes.
+     */
+    Strategy chooseStrategy() const;
+
+    /**
+     * Reads the foreign collection into _foreignTable. Returns false, leaving the table empty, if
+     * it doesn't fit in memory.
+     */
+    bool buildForeignTable();
+
+    /**
+     * Pulls the next input documents and looks up their matches, a batch at a time for
+     * kBatchedProbe and one at a time otherwise. Returns false once the input is exhausted.
+     */
+    bool lookUpMoreInput();
+
+    /**
+     * Moves the next looked up input document into _input, and its matches into _matches or, if
+     * they are streamed, opens _cursor over them. Returns false once the input is exhausted.
+     */
+    bool nextLookedUpInput();
+
+    /**
+     * Iterate over the matches of _input.
+     */
+    bool moreMatches();
+    BSONObj nextMatch();
+
     boost::optional<Document> unwindResult();
-    BSONObj queryForInput(const Document& input) const;
+    Value keyForInput(const Document& input) const;
+    BSONObj queryForKey(const Value& key) const;
 
     NamespaceString _fromNs;
     FieldPath _as;
@@ -1299,8 +1411,29 @@ private:
 
     boost::intrusive_ptr<DocumentSourceUnwind> _unwindSrc;
     bool _handlingUnwind = false;
-    std::unique_ptr<DBClientCursor> _cursor;
-    long long _cursorIndex = 0;
+
+    bool _strategyChosen = false;
+    Strategy _strategy = Strategy::kPerDocument;
+
+    // Only used for kHashJoin. The foreign documents by every value of their foreignField which
+    // can be looked up by hash.
+    std::unordered_map<Value, std::vector<BSONObj>, Value::Hash> _foreignTable;
+
+    // Input documents whose matches were found ahead of time. Matches which have to be found with
+    // a query of their own are 'streamed' instead: they are only read once the input is reached.
+    struct LookedUpInput {
+        Document input;
+        bool streamed;
+        std::vector<BSONObj> matches;
+    };
+    std::deque<LookedUpInput> _lookedUp;
+
+    // The input document being returned, and its remaining matches: the rest of _cursor if they
+    // are streamed, or _matches from _matchesIndex on otherwise.
     boost::optional<Document> _input;
+    std::unique_ptr<DBClientCursor> _cursor;
+    std::vector<BSONObj> _matches;
+    size_t _matchesIndex = 0;
+    long long _unwindIndex = 0;
 };
 }
@@ -70,6 +70,23 @@ boost::optional<Document> DocumentSourceCursor::getNext() {
     return out;
 }
 
+bool DocumentSourceCursor::getNextColumnBatch(ColumnBatch* batch) {
+    pExpCtx->checkForInterrupt();
+
+    batch->clear();
+
+    // Hand out whatever was loaded as documents before switching to columns.
+    while (!_currentBatch.empty()) {
+        batch->appendRow(_currentBatch.front());
+        _currentBatch.pop_front();
+    }
+
+    if (batch->empty())
+        loadBatch(batch);
+
+    return !batch->empty();
+}
+
 void DocumentSourceCursor::dispose() {
     // Can't call in to PlanExecutor or ClientCursor registries from this function since it
     // will be called when an agg cursor is killed which would cause a deadlock.
@@ -77,7 +94,7 @@ void DocumentSourceCursor::dispose() {
     _currentBatch.clear();
 }
 
-void DocumentSourceCursor::loadBatch() {
+void DocumentSourceCursor::loadBatch(ColumnBatch* columns) {
     if (!_exec) {
         dispose();
         return;
@@ -94,10 +111,15 @@ void DocumentSourceCursor::loadBatch() {
     BSONObj obj;
     PlanExecutor::ExecState state;
     while ((state = _exec->getNext(&obj, NULL)) == PlanExecutor::ADVANCED) {
-        if (_dependencies) {
-            _currentBatch.push_back(_dependencies->extractFields(obj));
+        if (columns) {
+            memUsageBytes += columns->appendRow(obj);
         } else {
-            _currentBatch.push_back(Document::fromBsonWithMetaData(obj));
+            if (_dependencies) {
+                _currentBatch.push_back(_dependencies->extractFields(obj));
+            } else {
+                _currentBatch.push_back(Document::fromBsonWithMetaData(obj));
+            }
+            memUsageBytes += _currentBatch.back().getApproximateSize();
         }
 
         if (_limit) {
@@ -107,8 +129,6 @@ void DocumentSourceCursor::loadBatch() {
             verify(_docsAddedToBatches < _limit->getLimit());
         }
 
-        memUsageBytes += _currentBatch.back().getApproximateSize();
-
         if (memUsageBytes > FindCommon::kMaxBytesToReturnToClientAtOnce) {
             // End this batch and prepare PlanExecutor for yielding.
             _exec->saveState();
@@ -117,7 +137,7 @@ void DocumentSourceCursor::loadBatch() {
     }
 
     // If we got here, there won't be any more documents, so destroy the executor. Can't use
-    // dispose since we want to keep the _currentBatch.
+    // dispose since we want to keep the _currentBatch or 'columns'.
     _exec.reset();
 
     uassert(16028,
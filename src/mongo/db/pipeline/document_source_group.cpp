@@ -28,14 +28,18 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/column_batch.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
@@ -46,6 +50,83 @@ using std::vector;
 
 REGISTER_DOCUMENT_SOURCE(group, DocumentSourceGroup::createFromBson);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupMaxMemoryBytes,
+                              long long,
+                              100 * 1024 * 1024);
+
+const size_t DocumentSourceGroup::kNumSpillPartitions;
+
+namespace {
+// Seeds the hash which assigns spilled groups to partitions, so that it differs from the hash
+// the groups map uses for its buckets.
+const size_t kSpillPartitionHashSeed = 0x5bd1e995;
+
+size_t spillPartition(const Value& id) {
+    size_t seed = kSpillPartitionHashSeed;
+    id.hash_combine(seed);
+
+    // Numbers are hashed through their double representation, whose low bits are mostly zero, so
+    // mix all bits into the low ones the partition is taken from (the MurmurHash3 finalizer).
+    uint64_t hash = seed;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash % DocumentSourceGroup::kNumSpillPartitions;
+}
+
+/**
+ * Where $group finds the value of an expression in a ColumnBatch: in a column, or in 'constant'
+ * for a negative 'column'.
+ */
+struct ColumnarInput {
+    Value get(const ColumnBatch& batch, size_t row) const {
+        return column < 0 ? constant : batch.getColumn(column)[row];
+    }
+
+    int column;
+    Value constant;
+};
+
+/**
+ * Appends to 'inputs' where to find the value of 'expression', adding its field to 'fieldNames'
+ * if no other expression reads it yet. Returns false if 'expression' is neither a top-level field
+ * of the input document nor a constant.
+ */
+bool addColumnarInput(const intrusive_ptr<Expression>& expression,
+                      std::vector<std::string>* fieldNames,
+                      std::vector<ColumnarInput>* inputs) {
+    if (auto constant = dynamic_cast<ExpressionConstant*>(expression.get())) {
+        inputs->push_back(ColumnarInput{-1, constant->getValue()});
+        return true;
+    }
+
+    // A path of length 2, such as CURRENT.a, names a top-level field of the input document.
+    auto fieldPath = dynamic_cast<ExpressionFieldPath*>(expression.get());
+    if (!fieldPath || fieldPath->getVariableId() != Variables::ROOT_ID ||
+        fieldPath->getFieldPath().getPathLength() != 2) {
+        return false;
+    }
+
+    const std::string& fieldName = fieldPath->getFieldPath().getFieldName(1);
+    auto it = std::find(fieldNames->begin(), fieldNames->end(), fieldName);
+    if (it == fieldNames->end()) {
+        it = fieldNames->insert(fieldNames->end(), fieldName);
+    }
+    inputs->push_back(ColumnarInput{static_cast<int>(it - fieldNames->begin()), Value()});
+    return true;
+}
+
+class SorterComparator {
+public:
+    typedef pair<Value, Value> Data;
+    int operator()(const Data& lhs, const Data& rhs) const {
+        return Value::compare(lhs.first, rhs.first);
+    }
+};
+}
+
 const char* DocumentSourceGroup::getSourceName() const {
     return "$group";
 }
@@ -57,8 +138,22 @@ boost::optional<Document> DocumentSourceGroup::getNext() {
         populate();
 
     if (_spilled) {
-        if (!_sorterIterator)
-            return boost::none;
+        if (_partitions.empty())
+            return boost::none;  // disposed
+
+        while (!_sorterIterator && groupsIterator == groups.end()) {
+            if (!loadNextPartition()) {
+                dispose();
+                return boost::none;
+            }
+        }
+
+        if (!_sorterIterator) {
+            Document out =
+                makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->inShard);
+            ++groupsIterator;
+            return out;
+        }
 
         const size_t numAccumulators = vpAccumulatorFactory.size();
         for (size_t i = 0; i < numAccumulators; i++) {
@@ -69,29 +164,10 @@ boost::optional<Document> DocumentSourceGroup::getNext() {
         while (_currentId == _firstPartOfNextGroup.first) {
             // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
             // At loop exit, it is the first value to be processed in the next group.
-
-            switch (numAccumulators) {  // mirrors switch in spill()
-                case 0:                 // no Accumulators so no Values
-                    break;
-
-                case 1:  // single accumulators serialize as a single Value
-                    _currentAccumulators[0]->process(_firstPartOfNextGroup.second,
-                                                     /*merging=*/true);
-                    break;
-
-                default: {  // multiple accumulators serialize as an array
-                    const vector<Value>& accumulatorStates =
-                        _firstPartOfNextGroup.second.getArray();
-                    for (size_t i = 0; i < numAccumulators; i++) {
-                        _currentAccumulators[i]->process(accumulatorStates[i],
-                                                         /*merging=*/true);
-                    }
-                    break;
-                }
-            }
+            mergeAccumulators(_firstPartOfNextGroup.second, _currentAccumulators);
 
             if (!_sorterIterator->more()) {
-                dispose();
+                _sorterIterator.reset();
                 break;
             }
 
@@ -118,6 +194,8 @@ void DocumentSourceGroup::dispose() {
     // free our resources
     GroupsMap().swap(groups);
     _sorterIterator.reset();
+    _partitionWriters.clear();
+    _partitions.clear();
 
     // make us look done
     groupsIterator = groups.end();
@@ -203,7 +281,8 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
       _doingMerge(false),
       _spilled(false),
       _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter),
-      _maxMemoryUsageBytes(100 * 1024 * 1024) {}
+      _maxMemoryUsageBytes(internalDocumentSourceGroupMaxMemoryBytes.load()),
+      _nextPartition(0) {}
 
 void DocumentSourceGroup::addAccumulator(const std::string& fieldName,
                                          Accumulator::Factory accumulatorFactory,
@@ -295,113 +374,60 @@ intrusive_ptr<DocumentSource> DocumentSourceGroup::createFromBson(
     return pGroup;
 }
 
-namespace {
-class SorterComparator {
-public:
-    typedef pair<Value, Value> Data;
-    int operator()(const Data& lhs, const Data& rhs) const {
-        return Value::compare(lhs.first, rhs.first);
-    }
-};
-}
-
 void DocumentSourceGroup::populate() {
     const size_t numAccumulators = vpAccumulatorFactory.size();
     dassert(numAccumulators == vpExpression.size());
 
-    // pushed to on spill()
-    vector<shared_ptr<Sorter<Value, Value>::Iterator>> sortedFiles;
-    int memoryUsageBytes = 0;
-
-    // This loop consumes all input from pSource and buckets it based on pIdExpression.
-    while (boost::optional<Document> input = pSource->getNext()) {
-        if (memoryUsageBytes > _maxMemoryUsageBytes) {
-            uassert(16945,
-                    "Exceeded memory limit for $group, but didn't allow external sort."
-                    " Pass allowDiskUse:true to opt in.",
-                    _extSortAllowed);
-            sortedFiles.push_back(spill());
-            memoryUsageBytes = 0;
-        }
+    long long memoryUsageBytes = 0;
+    int numStressSpills = 0;
 
-        _variables->setRoot(*input);
+    _arguments.resize(numAccumulators);
 
-        /* get the _id value */
-        Value id = computeId(_variables.get());
+    DocumentSourceCursor* cursor = dynamic_cast<DocumentSourceCursor*>(pSource);
+    if (!cursor || !populateFromColumns(cursor, &memoryUsageBytes, &numStressSpills)) {
+        // This loop consumes all input from pSource and buckets it based on pIdExpression.
+        while (boost::optional<Document> input = pSource->getNext()) {
+            _variables->setRoot(*input);
 
-        /* treat missing values the same as NULL SERVER-4674 */
-        if (id.missing())
-            id = Value(BSONNULL);
+            /* get the _id value */
+            Value id = computeId(_variables.get());
 
-        /*
-          Look for the _id value in the map; if it's not there, add a
-          new entry with a blank accumulator.
-        */
-        const size_t oldSize = groups.size();
-        vector<intrusive_ptr<Accumulator>>& group = groups[id];
-        const bool inserted = groups.size() != oldSize;
-
-        if (inserted) {
-            memoryUsageBytes += id.getApproximateSize();
-
-            // Add the accumulators
-            group.reserve(numAccumulators);
-            for (size_t i = 0; i < numAccumulators; i++) {
-                group.push_back(vpAccumulatorFactory[i]());
-            }
-        } else {
             for (size_t i = 0; i < numAccumulators; i++) {
-                // subtract old mem usage. New usage added back after processing.
-                memoryUsageBytes -= group[i]->memUsageForSorter();
+                _arguments[i] = vpExpression[i]->evaluate(_variables.get());
             }
-        }
 
-        /* tickle all the accumulators for the group we found */
-        dassert(numAccumulators == group.size());
-        for (size_t i = 0; i < numAccumulators; i++) {
-            group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
-            memoryUsageBytes += group[i]->memUsageForSorter();
-        }
+            // We are done with the ROOT document so release it.
+            _variables->clearRoot();
 
-        // We are done with the ROOT document so release it.
-        _variables->clearRoot();
-
-        DEV {
-            // In debug mode, spill every time we have a duplicate id to stress merge logic.
-            if (!inserted  // is a dup
-                &&
-                !pExpCtx->inRouter  // can't spill to disk in router
-                &&
-                !_extSortAllowed  // don't change behavior when testing external sort
-                &&
-                sortedFiles.size() < 20  // don't open too many FDs
-                ) {
-                sortedFiles.push_back(spill());
-            }
+            processInput(id, &memoryUsageBytes, &numStressSpills);
         }
     }
 
     // These blocks do any final steps necessary to prepare to output results.
-    if (!sortedFiles.empty()) {
+    if (!_partitionWriters.empty()) {
         _spilled = true;
         if (!groups.empty()) {
-            sortedFiles.push_back(spill());
+            spill();
         }
 
-        // We won't be using groups again so free its memory.
+        // The groups map is reused for each partition, so only release its memory.
         GroupsMap().swap(groups);
+        groupsIterator = groups.end();
 
-        _sorterIterator.reset(
-            Sorter<Value, Value>::Iterator::merge(sortedFiles, SortOptions(), SorterComparator()));
+        _partitions.resize(kNumSpillPartitions);
+        for (size_t i = 0; i < kNumSpillPartitions; i++) {
+            // Partitions which no group hashed to have no file.
+            if (_partitionWriters[i]) {
+                _partitions[i].reset(_partitionWriters[i]->done());
+            }
+        }
+        _partitionWriters.clear();
 
         // prepare current to accumulate data
         _currentAccumulators.reserve(numAccumulators);
         for (size_t i = 0; i < numAccumulators; i++) {
             _currentAccumulators.push_back(vpAccumulatorFactory[i]());
         }
-
-        verify(_sorterIterator->more());  // we put data in, we should get something out.
-        _firstPartOfNextGroup = _sorterIterator->next();
     } else {
         // start the group iterator
         groupsIterator = groups.begin();
@@ -410,51 +436,144 @@ void DocumentSourceGroup::populate() {
     populated = true;
 }
 
-class DocumentSourceGroup::SpillSTLComparator {
-public:
-    bool operator()(const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
-        return Value::compare(lhs->first, rhs->first) < 0;
-    }
-};
+DocumentSourceGroup::Accumulators& DocumentSourceGroup::getGroup(const Value& id,
+                                                                 long long* memoryUsageBytes,
+                                                                 bool* inserted) {
+    const size_t numAccumulators = vpAccumulatorFactory.size();
+
+    const size_t oldSize = groups.size();
+    Accumulators& group = groups[id];
+    *inserted = groups.size() != oldSize;
+
+    if (*inserted) {
+        *memoryUsageBytes += id.getApproximateSize();
 
-shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
-    vector<const GroupsMap::value_type*> ptrs;  // using pointers to speed sorting
-    ptrs.reserve(groups.size());
-    for (GroupsMap::const_iterator it = groups.begin(), end = groups.end(); it != end; ++it) {
-        ptrs.push_back(&*it);
+        // Add the accumulators
+        group.reserve(numAccumulators);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            group.push_back(vpAccumulatorFactory[i]());
+        }
+    } else {
+        for (size_t i = 0; i < numAccumulators; i++) {
+            // subtract old mem usage. New usage added back after processing.
+            *memoryUsageBytes -= group[i]->memUsageForSorter();
+        }
     }
 
-    stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
+    return group;
+}
 
-    SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
-    switch (vpAccumulatorFactory.size()) {  // same as ptrs[i]->second.size() for all i.
-        case 0:                             // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
+bool DocumentSourceGroup::loadNextPartition() {
+    GroupsMap().swap(groups);
+    groupsIterator = groups.end();
+
+    while (_nextPartition < _partitions.size()) {
+        std::unique_ptr<Sorter<Value, Value>::Iterator> partition(
+            std::move(_partitions[_nextPartition++]));
+        if (!partition)
+            continue;
+
+        long long memoryUsageBytes = 0;
+        while (partition->more()) {
+            if (memoryUsageBytes > _maxMemoryUsageBytes) {
+                // Too many groups hashed to this partition. Sort the groups aggregated so far
+                // along with the rest of the partition by id, so that all parts of a group are
+                // next to each other, and merge them as they come out of the sorter.
+                std::unique_ptr<Sorter<Value, Value>> sorter(
+                    Sorter<Value, Value>::make(SortOptions()
+                                                   .TempDir(pExpCtx->tempDir)
+                                                   .MaxMemoryUsageBytes(_maxMemoryUsageBytes)
+                                                   .ExtSortAllowed(),
+                                               SorterComparator()));
+                for (auto&& group : groups) {
+                    sorter->add(group.first, serializeAccumulators(group.second));
+                }
+                GroupsMap().swap(groups);
+                groupsIterator = groups.end();
+
+                while (partition->more()) {
+                    const pair<Value, Value> part = partition->next();
+                    sorter->add(part.first, part.second);
+                }
+
+                _sorterIterator.reset(sorter->done());
+                verify(_sorterIterator->more());  // we put data in, we should get something out.
+                _firstPartOfNextGroup = _sorterIterator->next();
+                return true;
             }
-            break;
+
+            const pair<Value, Value> part = partition->next();
+            bool inserted;
+            Accumulators& group = getGroup(part.first, &memoryUsageBytes, &inserted);
+            mergeAccumulators(part.second, group);
+            for (size_t i = 0; i < group.size(); i++) {
+                memoryUsageBytes += group[i]->memUsageForSorter();
+            }
+        }
+
+        groupsIterator = groups.begin();
+        return true;
+    }
+
+    return false;
+}
+
+void DocumentSourceGroup::spill() {
+    if (_partitionWriters.empty()) {
+        _partitionWriters.resize(kNumSpillPartitions);
+    }
+
+    for (auto&& group : groups) {
+        auto& writer = _partitionWriters[spillPartition(group.first)];
+        if (!writer) {
+            writer.reset(
+                new SortedFileWriter<Value, Value>(SortOptions().TempDir(pExpCtx->tempDir)));
+        }
+
+        // The groups of a partition are aggregated in a hash table when read back, so they need
+        // not be written in order.
+        writer->addAlreadySorted(group.first, serializeAccumulators(group.second));
+    }
+
+    groups.clear();
+}
+
+Value DocumentSourceGroup::serializeAccumulators(const Accumulators& accums) const {
+    switch (accums.size()) {
+        case 0:  // no values, essentially a distinct
+            return Value();
 
         case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+            return accums[0]->getValue(/*toBeMerged=*/true);
+
+        default: {  // multiple values, serialize as array-typed Value
+            vector<Value> states;
+            states.reserve(accums.size());
+            for (size_t i = 0; i < accums.size(); i++) {
+                states.push_back(accums[i]->getValue(/*toBeMerged=*/true));
             }
+            return Value(std::move(states));
+        }
+    }
+}
+
+void DocumentSourceGroup::mergeAccumulators(const Value& state, const Accumulators& accums) const {
+    switch (accums.size()) {  // mirrors switch in serializeAccumulators()
+        case 0:                // no Accumulators so no Values
             break;
 
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
-                }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
+        case 1:  // single accumulators serialize as a single Value
+            accums[0]->process(state, /*merging=*/true);
+            break;
+
+        default: {  // multiple accumulators serialize as an array
+            const vector<Value>& states = state.getArray();
+            for (size_t i = 0; i < accums.size(); i++) {
+                accums[i]->process(states[i], /*merging=*/true);
             }
             break;
+        }
     }
-
-    groups.clear();
-
-    return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
 }
 
 void DocumentSourceGroup::parseIdExpression(BSONElement groupField,
@@ -489,6 +608,88 @@ void DocumentSourceGroup::parseIdExpression(BSONElement groupField,
     }
 }
 
+void DocumentSourceGroup::processInput(const Value& inputId,
+                                       long long* memoryUsageBytes,
+                                       int* numStressSpills) {
+    if (*memoryUsageBytes > _maxMemoryUsageBytes) {
+        uassert(16945,
+                "Exceeded memory limit for $group, but didn't allow external sort."
+                " Pass allowDiskUse:true to opt in.",
+                _extSortAllowed);
+        spill();
+        *memoryUsageBytes = 0;
+    }
+
+    /* treat missing values the same as NULL SERVER-4674 */
+    const Value id = inputId.missing() ? Value(BSONNULL) : inputId;
+
+    /*
+      Look for the _id value in the map; if it's not there, add a
+      new entry with a blank accumulator.
+    */
+    bool inserted;
+    Accumulators& group = getGroup(id, memoryUsageBytes, &inserted);
+
+    /* tickle all the accumulators for the group we found */
+    dassert(_arguments.size() == group.size());
+    for (size_t i = 0; i < group.size(); i++) {
+        group[i]->process(_arguments[i], _doingMerge);
+        *memoryUsageBytes += group[i]->memUsageForSorter();
+    }
+
+    DEV {
+        // In debug mode, spill every time we have a duplicate id to stress merge logic.
+        if (!inserted  // is a dup
+            &&
+            !pExpCtx->inRouter  // can't spill to disk in router
+            &&
+            !_extSortAllowed  // don't change behavior when testing external sort
+            &&
+            *numStressSpills < 20  // don't spend too long rewriting the same groups
+            ) {
+            spill();
+            (*numStressSpills)++;
+        }
+    }
+}
+
+bool DocumentSourceGroup::populateFromColumns(DocumentSourceCursor* cursor,
+                                              long long* memoryUsageBytes,
+                                              int* numStressSpills) {
+    std::vector<std::string> fieldNames;
+    std::vector<ColumnarInput> idInputs;
+    std::vector<ColumnarInput> argumentInputs;
+    for (auto&& expression : _idExpressions) {
+        if (!addColumnarInput(expression, &fieldNames, &idInputs))
+            return false;
+    }
+    for (auto&& expression : vpExpression) {
+        if (!addColumnarInput(expression, &fieldNames, &argumentInputs))
+            return false;
+    }
+
+    ColumnBatch batch(std::move(fieldNames));
+    vector<Value> idParts(idInputs.size());
+    while (cursor->getNextColumnBatch(&batch)) {
+        for (size_t row = 0; row < batch.size(); row++) {
+            for (size_t i = 0; i < argumentInputs.size(); i++) {
+                _arguments[i] = argumentInputs[i].get(batch, row);
+            }
+
+            // Same as computeId().
+            if (idInputs.size() == 1) {
+                processInput(idInputs[0].get(batch, row), memoryUsageBytes, numStressSpills);
+            } else {
+                for (size_t i = 0; i < idInputs.size(); i++) {
+                    idParts[i] = idInputs[i].get(batch, row);
+                }
+                processInput(Value(idParts), memoryUsageBytes, numStressSpills);
+            }
+        }
+    }
+    return true;
+}
+
 Value DocumentSourceGroup::computeId(Variables* vars) {
     // If only one expression return result directly
     if (_idExpressions.size() == 1)
@@ -30,18 +30,90 @@
 
 #include "document_source.h"
 
+#include <cctype>
+#include <cmath>
+
 #include "mongo/base/init.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/stdx/memory.h"
 
 namespace mongo {
 
 using boost::intrusive_ptr;
 
+// Largest foreign collection, in documents, to read into a hash table when foreignField is
+// indexed there. Without an index the hash join is limited only by the memory budget.
+MONGO_EXPORT_SERVER_PARAMETER(internalLookupHashJoinMaxForeignDocs, int, 10 * 1000);
+
+// Memory the hash table of the foreign collection may use.
+MONGO_EXPORT_SERVER_PARAMETER(internalLookupHashJoinMaxMemoryBytes,
+                              long long,
+                              32 * 1024 * 1024);
+
+// Number of input documents looked up with one $in query. 0 or 1 looks up every input document
+// with a query of its own.
+MONGO_EXPORT_SERVER_PARAMETER(internalLookupBatchSize, int, 64);
+
+// Memory the matches of one batch of input documents may use. The documents of a batch whose
+// matches don't fit are looked up with a query of their own instead.
+MONGO_EXPORT_SERVER_PARAMETER(internalLookupBatchMaxMemoryBytes,
+                              long long,
+                              32 * 1024 * 1024);
+
+namespace {
+
+// Upper bound on the size of the $in array of a batched probe.
+const int kMaxBatchKeyBytes = 1024 * 1024;
+
+/**
+ * Whether input documents with local key 'key' can be matched to foreign documents by hashing.
+ * An {$eq: key} query on a value of any of these types matches exactly the documents holding an
+ * equal value along the foreign field path. Null, arrays, documents and regular expressions have
+ * special matching rules and are always looked up with a query of their own.
+ */
+bool isHashableKey(const Value& key) {
+    switch (key.getType()) {
+        case NumberInt:
+        case NumberLong:
+        case NumberDouble:
+        case NumberDecimal:
+            return !std::isnan(key.coerceToDouble());
+        case String:
+        case jstOID:
+        case Bool:
+        case Date:
+        case bsonTimestamp:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Returns the distinct values of 'obj' along 'path', expanding arrays the way the query system
+ * does.
+ */
+BSONElementSet valuesAlongPath(const BSONObj& obj, StringData path) {
+    BSONElementSet values;
+    obj.getFieldsDotted(path, values);
+    return values;
+}
+
+bool isArrayIndex(const std::string& fieldName) {
+    for (char c : fieldName) {
+        if (!isdigit(c))
+            return false;
+    }
+    return true;
+}
+
+}  // namespace
+
 DocumentSourceLookUp::DocumentSourceLookUp(NamespaceString fromNs,
                                            std::string as,
                                            std::string localField,
@@ -60,38 +132,216 @@ const char* DocumentSourceLookUp::getSourceName() const {
     return "$lookup";
 }
 
+const char* DocumentSourceLookUp::strategyName(Strategy strategy) {
+    switch (strategy) {
+        case Strategy::kPerDocument:
+            return "perDocument";
+        case Strategy::kBatchedProbe:
+            return "batchedProbe";
+        case Strategy::kHashJoin:
+            return "hashJoin";
+    }
+    MONGO_UNREACHABLE;
+}
+
 boost::optional<Document> DocumentSourceLookUp::getNext() {
     pExpCtx->checkForInterrupt();
 
     uassert(4567, "from collection cannot be sharded", !_mongod->isSharded(_fromNs));
 
+    if (!_strategyChosen) {
+        _strategy = chooseStrategy();
+        if (_strategy == Strategy::kHashJoin && !buildForeignTable()) {
+            _strategy = Strategy::kBatchedProbe;
+        }
+        _strategyChosen = true;
+    }
+
     if (_handlingUnwind) {
         return unwindResult();
     }
 
-    boost::optional<Document> input = pSource->getNext();
-    if (!input)
+    if (!nextLookedUpInput())
         return {};
-    BSONObj query = queryForInput(*input);
-    std::unique_ptr<DBClientCursor> cursor = _mongod->directClient()->query(_fromNs.ns(), query);
 
     std::vector<Value> results;
     int objsize = 0;
-    while (cursor->more()) {
-        BSONObj result = cursor->nextSafe();
-        objsize += result.objsize();
+    while (moreMatches()) {
+        BSONObj match = nextMatch();
+        objsize += match.objsize();
         uassert(4568,
                 str::stream() << "Total size of documents in " << _fromNs.coll() << " matching "
-                              << query << " exceeds maximum document size",
+                              << queryForKey(keyForInput(*_input))
+                              << " exceeds maximum document size",
                 objsize <= BSONObjMaxInternalSize);
-        results.push_back(Value(result));
+        results.push_back(Value(match));
     }
+    _cursor.reset();
+    _matches.clear();
 
-    MutableDocument output(std::move(*input));
+    MutableDocument output(std::move(*_input));
     output.setNestedField(_as, Value(std::move(results)));
     return output.freeze();
 }
 
+DocumentSourceLookUp::Strategy DocumentSourceLookUp::chooseStrategy() const {
+    // Matching foreign documents to input documents without a query extracts the values along
+    // the foreign field path, which disagrees with the query system on explicit array indexes.
+    for (size_t i = 0; i < _foreignField.getPathLength(); i++) {
+        if (isArrayIndex(_foreignField.getFieldName(i)))
+            return Strategy::kPerDocument;
+    }
+
+    const Strategy probe =
+        internalLookupBatchSize.load() > 1 ? Strategy::kBatchedProbe : Strategy::kPerDocument;
+
+    DBClientBase* client = _mongod->directClient();
+    BSONObj collStats;
+    if (!client->runCommand(
+            _fromNs.db().toString(), BSON("collStats" << _fromNs.coll()), collStats)) {
+        // The foreign collection doesn't exist, so there is nothing to read.
+        return Strategy::kHashJoin;
+    }
+    if (collStats["size"].numberLong() > internalLookupHashJoinMaxMemoryBytes.load())
+        return probe;
+
+    bool indexed = false;
+    for (auto&& spec : client->getIndexSpecs(_fromNs.ns())) {
+        if (spec["key"].Obj().firstElementFieldName() == _foreignFieldFieldName) {
+            indexed = true;
+            break;
+        }
+    }
+    if (!indexed || collStats["count"].numberLong() <= internalLookupHashJoinMaxForeignDocs.load())
+        return Strategy::kHashJoin;
+
+    return probe;
+}
+
+bool DocumentSourceLookUp::buildForeignTable() {
+    const long long maxMemoryUsageBytes = internalLookupHashJoinMaxMemoryBytes.load();
+    long long memoryUsageBytes = 0;
+
+    std::unique_ptr<DBClientCursor> cursor = _mongod->directClient()->query(_fromNs.ns(), Query());
+    while (cursor->more()) {
+        pExpCtx->checkForInterrupt();
+
+        BSONObj foreign = cursor->nextSafe().getOwned();
+        memoryUsageBytes += foreign.objsize();
+        if (memoryUsageBytes > maxMemoryUsageBytes) {
+            _foreignTable.clear();
+            return false;
+        }
+
+        for (auto&& element : valuesAlongPath(foreign, _foreignFieldFieldName)) {
+            Value key(element);
+            if (isHashableKey(key)) {
+                _foreignTable[key].push_back(foreign);
+            }
+        }
+    }
+    return true;
+}
+
+bool DocumentSourceLookUp::lookUpMoreInput() {
+    const size_t batchSize = _strategy == Strategy::kBatchedProbe
+        ? static_cast<size_t>(std::max(1, internalLookupBatchSize.load()))
+        : 1;
+
+    // The positions in _lookedUp of the input documents waiting for the $in query, by key.
+    std::unordered_map<Value, std::vector<size_t>, Value::Hash> waiting;
+    BSONArrayBuilder keys;
+
+    while (_lookedUp.size() < batchSize && keys.len() < kMaxBatchKeyBytes) {
+        boost::optional<Document> input = pSource->getNext();
+        if (!input)
+            break;
+
+        Value key = keyForInput(*input);
+        _lookedUp.push_back(LookedUpInput{std::move(*input), false, {}});
+        LookedUpInput& lookedUp = _lookedUp.back();
+
+        if (_strategy == Strategy::kPerDocument || !isHashableKey(key)) {
+            // The matches are read through a cursor once this input is reached, so that they
+            // needn't fit in memory.
+            lookedUp.streamed = true;
+        } else if (_strategy == Strategy::kHashJoin) {
+            auto it = _foreignTable.find(key);
+            if (it != _foreignTable.end())
+                lookedUp.matches = it->second;
+        } else {
+            std::vector<size_t>& positions = waiting[key];
+            if (positions.empty())
+                key.addToBsonArray(&keys);
+            positions.push_back(_lookedUp.size() - 1);
+        }
+    }
+
+    if (!waiting.empty()) {
+        BSONObjBuilder query;
+        BSONObjBuilder subObj(query.subobjStart(_foreignFieldFieldName));
+        subObj.append("$in", keys.arr());
+        subObj.doneFast();
+
+        const long long maxMemoryUsageBytes = internalLookupBatchMaxMemoryBytes.load();
+        long long memoryUsageBytes = 0;
+
+        std::unique_ptr<DBClientCursor> cursor =
+            _mongod->directClient()->query(_fromNs.ns(), query.obj());
+        while (cursor->more()) {
+            pExpCtx->checkForInterrupt();
+
+            BSONObj foreign = cursor->nextSafe().getOwned();
+            memoryUsageBytes += foreign.objsize();
+            if (memoryUsageBytes > maxMemoryUsageBytes) {
+                for (auto&& entry : waiting) {
+                    for (size_t position : entry.second) {
+                        _lookedUp[position].matches.clear();
+                        _lookedUp[position].streamed = true;
+                    }
+                }
+                break;
+            }
+
+            for (auto&& element : valuesAlongPath(foreign, _foreignFieldFieldName)) {
+                auto it = waiting.find(Value(element));
+                if (it == waiting.end())
+                    continue;
+                for (size_t position : it->second) {
+                    _lookedUp[position].matches.push_back(foreign);
+                }
+            }
+        }
+    }
+
+    return !_lookedUp.empty();
+}
+
+bool DocumentSourceLookUp::nextLookedUpInput() {
+    if (_lookedUp.empty() && !lookUpMoreInput())
+        return false;
+
+    LookedUpInput& next = _lookedUp.front();
+    _input = std::move(next.input);
+    _matches = std::move(next.matches);
+    _matchesIndex = 0;
+    _cursor.reset();
+    if (next.streamed) {
+        _cursor =
+            _mongod->directClient()->query(_fromNs.ns(), queryForKey(keyForInput(*_input)));
+    }
+    _lookedUp.pop_front();
+    return true;
+}
+
+bool DocumentSourceLookUp::moreMatches() {
+    return _cursor ? _cursor->more() : _matchesIndex < _matches.size();
+}
+
+BSONObj DocumentSourceLookUp::nextMatch() {
+    return _cursor ? _cursor->nextSafe() : _matches[_matchesIndex++];
+}
+
 bool DocumentSourceLookUp::coalesce(const intrusive_ptr<DocumentSource>& pNextSource) {
     if (_handlingUnwind) {
         return false;
@@ -107,20 +357,26 @@ bool DocumentSourceLookUp::coalesce(const intrusive_ptr<DocumentSource>& pNextSo
 }
 
 void DocumentSourceLookUp::dispose() {
+    _foreignTable.clear();
+    _lookedUp.clear();
     _cursor.reset();
+    _matches.clear();
     pSource->dispose();
 }
 
-BSONObj DocumentSourceLookUp::queryForInput(const Document& input) const {
+Value DocumentSourceLookUp::keyForInput(const Document& input) const {
     Value localFieldVal = input.getNestedField(_localField);
     if (localFieldVal.missing()) {
         localFieldVal = Value(BSONNULL);
     }
+    return localFieldVal;
+}
 
+BSONObj DocumentSourceLookUp::queryForKey(const Value& key) const {
     // { _foreignFieldFiedlName : { "$eq" : localFieldValue } }
     BSONObjBuilder query;
     BSONObjBuilder subObj(query.subobjStart(_foreignFieldFieldName));
-    subObj << "$eq" << localFieldVal;
+    subObj << "$eq" << key;
     subObj.doneFast();
     return query.obj();
 }
@@ -131,16 +387,14 @@ boost::optional<Document> DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_cursor || !_cursor->more()) {
-        _input = pSource->getNext();
-        if (!_input)
+    while (!moreMatches()) {
+        if (!nextLookedUpInput())
             return {};
 
-        _cursor = _mongod->directClient()->query(_fromNs.ns(), queryForInput(*_input));
-        _cursorIndex = 0;
+        _unwindIndex = 0;
 
-        if (_unwindSrc->preserveNullAndEmptyArrays() && !_cursor->more()) {
-            // There were no results for this cursor, but the $unwind was asked to preserve empty
+        if (_unwindSrc->preserveNullAndEmptyArrays() && !moreMatches()) {
+            // There were no results for this input, but the $unwind was asked to preserve empty
             // arrays, so we should return a document without the array.
             MutableDocument output(std::move(*_input));
             // Note this will correctly objects in the prefix of '_as', to act as if we had created
@@ -152,18 +406,23 @@ boost::optional<Document> DocumentSourceLookUp::unwindResult() {
             return output.freeze();
         }
     }
-    invariant(_cursor->more() && bool(_input));
-    auto nextVal = Value(_cursor->nextSafe());
+    invariant(bool(_input));
+    auto nextVal = Value(nextMatch());
+    const bool isLastMatch = !moreMatches();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
-    MutableDocument output(_cursor->more() ? *_input : std::move(*_input));
+    MutableDocument output(isLastMatch ? std::move(*_input) : *_input);
     output.setNestedField(_as, nextVal);
 
     if (indexPath) {
-        output.setNestedField(*indexPath, Value(_cursorIndex));
+        output.setNestedField(*indexPath, Value(_unwindIndex));
     }
 
-    _cursorIndex++;
+    _unwindIndex++;
+    if (isLastMatch) {
+        _cursor.reset();
+        _matches.clear();
+    }
     return output.freeze();
 }
 
@@ -172,6 +431,10 @@ void DocumentSourceLookUp::serializeToArray(std::vector<Value>& array, bool expl
         DOC(getSourceName() << DOC("from" << _fromNs.coll() << "as" << _as.getPath(false)
                                           << "localField" << _localField.getPath(false)
                                           << "foreignField" << _foreignField.getPath(false))));
+    if (explain && _mongod) {
+        output[getSourceName()]["strategy"] =
+            Value(strategyName(_strategyChosen ? _strategy : chooseStrategy()));
+    }
     if (_handlingUnwind && explain) {
         const boost::optional<FieldPath> indexPath = _unwindSrc->indexPath();
         output[getSourceName()]["unwinding"] =
@@ -885,6 +885,74 @@ public:
     }
 };
 
+/** Groups which outgrow the memory budget are spilled to disk and merged back together. */
+class SpillBase : public Mock::Base {
+public:
+    SpillBase()
+        : _tempDir("DocumentSourceGroupSpillTest"),
+          _originalBudget(internalDocumentSourceGroupMaxMemoryBytes.load()) {}
+    virtual ~SpillBase() {
+        internalDocumentSourceGroupMaxMemoryBytes.store(_originalBudget);
+    }
+
+    void run() {
+        const int kGroups = 1000;
+        const int kDocsPerGroup = 3;
+
+        internalDocumentSourceGroupMaxMemoryBytes.store(memoryBudget());
+        intrusive_ptr<ExpressionContext> expCtx =
+            new ExpressionContext(_opCtx.get(), NamespaceString(ns));
+        expCtx->extSortAllowed = true;
+        expCtx->tempDir = _tempDir.path();
+
+        BSONObj spec = fromjson(
+            "{$group: {_id: '$x', count: {$sum: 1}, total: {$sum: '$y'}, ys: {$push: '$y'}}}");
+        intrusive_ptr<DocumentSource> group =
+            DocumentSourceGroup::createFromBson(spec.firstElement(), expCtx);
+
+        std::deque<Document> input;
+        for (int y = 0; y < kDocsPerGroup; y++) {
+            for (int x = 0; x < kGroups; x++) {
+                input.push_back(DOC("x" << x << "y" << y));
+            }
+        }
+        auto source = DocumentSourceMock::create(input);
+        group->setSource(source.get());
+
+        set<int> ids;
+        while (boost::optional<Document> next = group->getNext()) {
+            ASSERT(ids.insert(next->getField("_id").getInt()).second);
+            ASSERT_EQUALS(kDocsPerGroup, next->getField("count").getInt());
+            ASSERT_EQUALS(0 + 1 + 2, next->getField("total").getInt());
+            ASSERT_EQUALS(size_t(kDocsPerGroup), next->getField("ys").getArray().size());
+        }
+        ASSERT_EQUALS(size_t(kGroups), ids.size());
+        ASSERT(!group->getNext());
+        ASSERT(!group->getNext());
+    }
+
+protected:
+    virtual long long memoryBudget() = 0;
+
+private:
+    TempDir _tempDir;
+    const long long _originalBudget;
+};
+
+/** Each spilled partition fits in memory on its own. */
+class SpillPartitionsFitInMemory : public SpillBase {
+    long long memoryBudget() {
+        return 20 * 1024;
+    }
+};
+
+/** The spilled partitions are too large as well, so they are sorted to be merged. */
+class SpillPartitionsSorted : public SpillBase {
+    long long memoryBudget() {
+        return 1024;
+    }
+};
+
 }  // namespace DocumentSourceGroup
 
 namespace DocumentSourceProject {
@@ -2706,6 +2774,8 @@ public:
         add<DocumentSourceGroup::Dependencies>();
         add<DocumentSourceGroup::StringConstantIdAndAccumulatorExpressions>();
         add<DocumentSourceGroup::ArrayConstantAccumulatorExpression>();
+        add<DocumentSourceGroup::SpillPartitionsFitInMemory>();
+        add<DocumentSourceGroup::SpillPartitionsSorted>();
 
         add<DocumentSourceProject::Inclusion>();
         add<DocumentSourceProject::Optimize>();
@@ -749,6 +749,10 @@ public:
         return _fieldPath;
     }
 
+    Variables::Id getVariableId() const {
+        return _variable;
+    }
+
 private:
     ExpressionFieldPath(const std::string& fieldPath, Variables::Id variable);
 
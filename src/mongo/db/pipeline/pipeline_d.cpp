@@ -326,8 +326,11 @@ std::shared_ptr<PlanExecutor> PipelineD::prepareExecutor(
     //
     // LATER - We should attempt to determine if the results from the query are returned in some
     // order so we can then apply other optimizations there are tickets for, such as SERVER-4507.
+    //
+    // A leading $match is part of the query, so a parallel collection scan evaluates it on the
+    // workers along with the scan.
     size_t plannerOpts = QueryPlannerParams::DEFAULT | QueryPlannerParams::INCLUDE_SHARD_FILTER |
-        QueryPlannerParams::NO_BLOCKING_SORT;
+        QueryPlannerParams::NO_BLOCKING_SORT | QueryPlannerParams::PARALLEL_COLLSCAN;
 
     // The only way to get a text score is to let the query system handle the projection. In all
     // other cases, unless the query system can do an index-covered projection and avoid going to
@@ -148,6 +148,10 @@ size_t getDocsExamined(StageType type, const SpecificStats* specific) {
     if (STAGE_COLLSCAN == type) {
         const CollectionScanStats* spec = static_cast<const CollectionScanStats*>(specific);
         return spec->docsTested;
+    } else if (STAGE_PARALLEL_COLLSCAN == type) {
+        const ParallelCollectionScanStats* spec =
+            static_cast<const ParallelCollectionScanStats*>(specific);
+        return spec->docsTested;
     } else if (STAGE_FETCH == type) {
         const FetchStats* spec = static_cast<const FetchStats*>(specific);
         return spec->docsExamined;
@@ -326,6 +330,7 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainCommon::EXEC_STATS) {
             bob->appendNumber("docsExamined", spec->docsExamined);
             bob->appendNumber("alreadyHasObj", spec->alreadyHasObj);
+            bob->appendNumber("docsPrefetched", spec->docsPrefetched);
         }
     } else if (STAGE_GEO_NEAR_2D == stats.stageType || STAGE_GEO_NEAR_2DSPHERE == stats.stageType) {
         NearStats* spec = static_cast<NearStats*>(stats.specific.get());
@@ -390,6 +395,16 @@ void Explain::statsToBSON(const PlanStageStats& stats,
             bob->appendNumber("dupsDropped", spec->dupsDropped);
             bob->appendNumber("locsForgotten", spec->locsForgotten);
         }
+    } else if (STAGE_PARALLEL_COLLSCAN == stats.stageType) {
+        ParallelCollectionScanStats* spec =
+            static_cast<ParallelCollectionScanStats*>(stats.specific.get());
+        bob->append("ordered", spec->ordered);
+        bob->append("maxParallelism", spec->maxParallelism);
+        bob->appendNumber("partitions", spec->partitions);
+        if (verbosity >= ExplainCommon::EXEC_STATS) {
+            bob->appendNumber("docsExamined", spec->docsTested);
+            bob->appendNumber("waits", spec->waits);
+        }
     } else if (STAGE_LIMIT == stats.stageType) {
         LimitStats* spec = static_cast<LimitStats*>(stats.specific.get());
         bob->appendNumber("limitAmount", spec->limit);
@@ -728,9 +743,12 @@ std::string Explain::getPlanSummary(const PlanStage* root) {
 
 // static
 void Explain::getSummaryStats(const PlanExecutor& exec, PlanSummaryStats* statsOut) {
-    invariant(NULL != statsOut);
+    getSummaryStats(exec.getRootStage(), statsOut);
+}
 
-    PlanStage* root = exec.getRootStage();
+// static
+void Explain::getSummaryStats(const PlanStage* root, PlanSummaryStats* statsOut) {
+    invariant(NULL != statsOut);
 
     // We can get some of the fields we need from the common stats stored in the
     // root stage of the plan tree.
@@ -142,6 +142,11 @@ public:
      */
     static void getSummaryStats(const PlanExecutor& exec, PlanSummaryStats* statsOut);
 
+    /**
+     * Fills out 'statsOut' with summary stats using the execution tree rooted at 'root'.
+     */
+    static void getSummaryStats(const PlanStage* root, PlanSummaryStats* statsOut);
+
 private:
     /**
      * Private helper that does the heavy-lifting for the public statsToBSON(...) functions
@@ -55,6 +55,7 @@
 #include "mongo/db/server_options.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/storage_options.h"
+#include "mongo/rpc/legacy_reply_batch_builder.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/stale_exception.h"
 #include "mongo/stdx/memory.h"
@@ -206,7 +207,7 @@ namespace {
  */
 void generateBatch(int ntoreturn,
                    ClientCursor* cursor,
-                   BufBuilder* bb,
+                   rpc::LegacyReplyBatchBuilder* batch,
                    int* numResults,
                    Timestamp* slaveReadTill,
                    PlanExecutor::ExecState* state) {
@@ -215,7 +216,7 @@ void generateBatch(int ntoreturn,
     BSONObj obj;
     while (PlanExecutor::ADVANCED == (*state = exec->getNext(&obj, NULL))) {
         // Add result to output buffer.
-        bb->appendBuf((void*)obj.objdata(), obj.objsize());
+        batch->append(obj);
 
         // Count the result.
         (*numResults)++;
@@ -228,7 +229,7 @@ void generateBatch(int ntoreturn,
             }
         }
 
-        if (FindCommon::enoughForGetMore(ntoreturn, *numResults, bb->len())) {
+        if (FindCommon::enoughForGetMore(ntoreturn, *numResults, batch->len())) {
             break;
         }
     }
@@ -246,12 +247,12 @@ void generateBatch(int ntoreturn,
 /**
  * Called by db/instance.cpp.  This is the getMore entry point.
  */
-QueryResult::View getMore(OperationContext* txn,
-                          const char* ns,
-                          int ntoreturn,
-                          long long cursorid,
-                          bool* exhaust,
-                          bool* isCursorAuthorized) {
+Message getMore(OperationContext* txn,
+                const char* ns,
+                int ntoreturn,
+                long long cursorid,
+                bool* exhaust,
+                bool* isCursorAuthorized) {
     CurOp& curop = *CurOp::get(txn);
 
     // For testing, we may want to fail if we receive a getmore.
@@ -318,11 +319,7 @@ QueryResult::View getMore(OperationContext* txn,
     int numResults = 0;
     int startingResult = 0;
 
-    const int InitialBufSize =
-        512 + sizeof(QueryResult::Value) + FindCommon::kMaxBytesToReturnToClientAtOnce;
-
-    BufBuilder bb(InitialBufSize);
-    bb.skip(sizeof(QueryResult::Value));
+    rpc::LegacyReplyBatchBuilder batch;
 
     if (NULL == cc) {
         cursorid = 0;
@@ -388,7 +385,7 @@ QueryResult::View getMore(OperationContext* txn,
         exec->restoreState();
         PlanExecutor::ExecState state;
 
-        generateBatch(ntoreturn, cc, &bb, &numResults, &slaveReadTill, &state);
+        generateBatch(ntoreturn, cc, &batch, &numResults, &slaveReadTill, &state);
 
         // If this is an await data cursor, and we hit EOF without generating any results, then
         // we block waiting for new data to arrive.
@@ -412,7 +409,7 @@ QueryResult::View getMore(OperationContext* txn,
 
             // We woke up because either the timed_wait expired, or there was more data. Either
             // way, attempt to generate another batch of results.
-            generateBatch(ntoreturn, cc, &bb, &numResults, &slaveReadTill, &state);
+            generateBatch(ntoreturn, cc, &batch, &numResults, &slaveReadTill, &state);
         }
 
         // We have to do this before re-acquiring locks in the agg case because
@@ -467,16 +464,8 @@ QueryResult::View getMore(OperationContext* txn,
         }
     }
 
-    QueryResult::View qr = bb.buf();
-    qr.msgdata().setLen(bb.len());
-    qr.msgdata().setOperation(opReply);
-    qr.setResultFlags(resultFlags);
-    qr.setCursorId(cursorid);
-    qr.setStartingFrom(startingResult);
-    qr.setNReturned(numResults);
-    bb.decouple();
     LOG(5) << "getMore returned " << numResults << " results\n";
-    return qr;
+    return batch.done(resultFlags, cursorid, startingResult);
 }
 
 std::string runQuery(OperationContext* txn,
@@ -567,8 +556,7 @@ std::string runQuery(OperationContext* txn,
     // bb is used to hold query results
     // this buffer should contain either requested documents per query or
     // explain information, but not both
-    BufBuilder bb(FindCommon::kInitReplyBufferSize);
-    bb.skip(sizeof(QueryResult::Value));
+    rpc::LegacyReplyBatchBuilder batch;
 
     // How many results have we obtained from the executor?
     int numResults = 0;
@@ -588,7 +576,7 @@ std::string runQuery(OperationContext* txn,
 
     while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
         // Add result to output buffer.
-        bb.appendBuf((void*)obj.objdata(), obj.objsize());
+        batch.append(obj);
 
         // Count the result.
         ++numResults;
@@ -601,7 +589,7 @@ std::string runQuery(OperationContext* txn,
             }
         }
 
-        if (FindCommon::enoughForFirstBatch(pq, numResults, bb.len())) {
+        if (FindCommon::enoughForFirstBatch(pq, numResults, batch.len())) {
             LOG(5) << "Enough for first batch, wantMore=" << pq.wantMore()
                    << " ntoreturn=" << pq.getNToReturn().value_or(0) << " numResults=" << numResults
                    << endl;
@@ -682,17 +670,9 @@ std::string runQuery(OperationContext* txn,
         endQueryOp(txn, collection, *exec, dbProfilingLevel, numResults, ccId);
     }
 
-    // Add the results from the query into the output buffer.
-    result.appendData(bb.buf(), bb.len());
-    bb.decouple();
-
-    // Fill out the output buffer's header.
-    QueryResult::View qr = result.header().view2ptr();
-    qr.setCursorId(ccId);
-    qr.setResultFlagsToOk();
-    qr.msgdata().setOperation(opReply);
-    qr.setStartingFrom(0);
-    qr.setNReturned(numResults);
+    // Hand the results from the query over to the output message, filling out its header.
+    invariant(batch.numDocs() == numResults);
+    result = batch.done(ResultFlag_AwaitCapable, ccId, 0);
 
     // curop.debug().exhaust is set above.
     return curop.debug().exhaust ? nss.ns() : "";
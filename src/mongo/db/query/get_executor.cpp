@@ -36,8 +36,10 @@
 #include <memory>
 
 #include "mongo/base/error_codes.h"
+#include "mongo/base/counter.h"
 #include "mongo/base/parse_number.h"
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/count.h"
 #include "mongo/db/exec/delete.h"
@@ -61,7 +63,9 @@
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_cache_template.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/planner_access.h"
 #include "mongo/db/query/planner_analysis.h"
 #include "mongo/db/query/query_knobs.h"
@@ -80,6 +84,7 @@
 #include "mongo/scripting/engine.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -89,6 +94,80 @@ using std::string;
 using std::vector;
 using stdx::make_unique;
 
+namespace {
+// Number of queries whose plan was picked from cost estimates rather than by running candidates.
+Counter64 costBasedPlanSelections;
+ServerStatusMetricField<Counter64> displayCostBasedPlanSelections(
+    "queryExecutor.costBasedPlanSelections", &costBasedPlanSelections);
+
+// Plan cache lookups, and how the solutions of the cached entries were obtained.
+Counter64 planCacheHits;
+ServerStatusMetricField<Counter64> displayPlanCacheHits("queryExecutor.planCache.hits",
+                                                        &planCacheHits);
+Counter64 planCacheMisses;
+ServerStatusMetricField<Counter64> displayPlanCacheMisses("queryExecutor.planCache.misses",
+                                                          &planCacheMisses);
+Counter64 planCacheInstantiated;
+ServerStatusMetricField<Counter64> displayPlanCacheInstantiated(
+    "queryExecutor.planCache.instantiated", &planCacheInstantiated);
+Counter64 planCacheRebuilt;
+ServerStatusMetricField<Counter64> displayPlanCacheRebuilt("queryExecutor.planCache.rebuilt",
+                                                           &planCacheRebuilt);
+
+// Runtime feedback on cached plans: entries found degraded, background re-evaluations of their
+// alternatives, and replacements of a cached plan by a different one.
+ServerStatusMetricField<Counter64> displayPlanCacheDegraded("queryExecutor.planCache.degraded",
+                                                            &planCacheDegradedEntries);
+ServerStatusMetricField<Counter64> displayPlanCacheReevaluations(
+    "queryExecutor.planCache.reevaluations", &planCacheReevaluations);
+ServerStatusMetricField<Counter64> displayPlanCacheFlips("queryExecutor.planCache.flips",
+                                                         &planCacheFlips);
+
+/**
+ * Gets the solution for 'query' from the cache entry 'cs' was made from. Instantiates the
+ * parameterized solution of the entry if it applies to the query, and otherwise has the planner
+ * rebuild the solution from the cached index assignments. A rebuilt solution is parameterized for
+ * the next queries of the same shape.
+ */
+Status solutionFromCache(PlanCache* planCache,
+                         const CanonicalQuery& query,
+                         const QueryPlannerParams& params,
+                         const CachedSolution& cs,
+                         QuerySolution** out) {
+    planCacheHits.increment();
+    cs.usage->hits.fetchAndAdd(1);
+
+    Timer timer;
+    if (cs.planTemplate && internalQueryCacheParameterizedPlans) {
+        std::unique_ptr<QuerySolution> solution = cs.planTemplate->instantiate(query, params);
+        if (solution) {
+            planCacheInstantiated.increment();
+            cs.usage->instantiated.fetchAndAdd(1);
+            cs.usage->instantiateMicros.fetchAndAdd(timer.micros());
+            *out = solution.release();
+            return Status::OK();
+        }
+    }
+
+    Status status = QueryPlanner::planFromCache(query, params, cs, out);
+    if (!status.isOK()) {
+        return status;
+    }
+    planCacheRebuilt.increment();
+    cs.usage->rebuilt.fetchAndAdd(1);
+    cs.usage->rebuildMicros.fetchAndAdd(timer.micros());
+
+    if (!cs.planTemplate && internalQueryCacheParameterizedPlans) {
+        std::shared_ptr<const PlanCacheTemplate> planTemplate =
+            PlanCacheTemplate::make(query, params, **out);
+        if (planTemplate) {
+            planCache->setTemplate(cs, std::move(planTemplate));
+        }
+    }
+    return Status::OK();
+}
+}  // namespace
+
 // static
 void filterAllowedIndexEntries(const AllowedIndices& allowedIndices,
                                std::vector<IndexEntry>* indexEntries) {
@@ -141,6 +220,8 @@ void fillOutPlannerParams(OperationContext* txn,
                                                     desc->indexName(),
                                                     ice->getFilterExpression(),
                                                     desc->infoObj()));
+        plannerParams->indices.back().statistics =
+            collection->infoCache()->getIndexStatistics(desc->indexName());
     }
 
     // If query supports index filters, filter params.indices by indices in query settings.
@@ -206,6 +287,18 @@ void fillOutPlannerParams(OperationContext* txn,
     if (isMMAPV1()) {
         plannerParams->options |= QueryPlannerParams::SNAPSHOT_USE_ID;
     }
+
+    // The partitions of a parallel collection scan are read without the locks of the query, each
+    // from a snapshot of its own, which only storage engines with document level locking allow.
+    // Capped collections are scanned with a single cursor anyway, a majority committed snapshot
+    // can't be shared with the workers, and small collections aren't worth the overhead.
+    if (plannerParams->options & QueryPlannerParams::PARALLEL_COLLSCAN) {
+        if (!supportsDocLocking() || collection->isCapped() ||
+            txn->recoveryUnit()->isReadingFromMajorityCommittedSnapshot() ||
+            collection->numRecords(txn) < internalQueryParallelCollectionScanMinRecords.load()) {
+            plannerParams->options &= ~QueryPlannerParams::PARALLEL_COLLSCAN;
+        }
+    }
 }
 
 namespace {
@@ -305,13 +398,14 @@ Status prepareExecution(OperationContext* opCtx,
     }
 
     // Try to look up a cached solution for the query.
+    PlanCache* planCache = collection->infoCache()->getPlanCache();
+    const bool shouldCacheQuery = PlanCache::shouldCacheQuery(*canonicalQuery);
     CachedSolution* rawCS;
-    if (PlanCache::shouldCacheQuery(*canonicalQuery) &&
-        collection->infoCache()->getPlanCache()->get(*canonicalQuery, &rawCS).isOK()) {
-        // We have a CachedSolution.  Have the planner turn it into a QuerySolution.
+    if (shouldCacheQuery && planCache->get(*canonicalQuery, &rawCS).isOK()) {
+        // We have a CachedSolution.  Turn it into a QuerySolution.
         unique_ptr<CachedSolution> cs(rawCS);
         QuerySolution* qs;
-        Status status = QueryPlanner::planFromCache(*canonicalQuery, plannerParams, *cs, &qs);
+        Status status = solutionFromCache(planCache, *canonicalQuery, plannerParams, *cs, &qs);
 
         if (status.isOK()) {
             verify(StageBuilder::build(opCtx, collection, *qs, ws, rootOut));
@@ -326,12 +420,23 @@ Status prepareExecution(OperationContext* opCtx,
             // 'decisionWorks' is used to determine whether the existing cache entry should
             // be evicted, and the query replanned.
             //
+            // Executions run to completion are recorded in 'cs->usage', so that a plan which
+            // degrades gets its alternatives evaluated again.
+            //
             // Takes ownership of '*rootOut'.
-            *rootOut = new CachedPlanStage(
-                opCtx, collection, ws, canonicalQuery, plannerParams, cs->decisionWorks, *rootOut);
+            *rootOut = new CachedPlanStage(opCtx,
+                                           collection,
+                                           ws,
+                                           canonicalQuery,
+                                           plannerParams,
+                                           cs->decisionWorks,
+                                           cs->usage,
+                                           *rootOut);
             *querySolutionOut = qs;
             return Status::OK();
         }
+    } else if (shouldCacheQuery) {
+        planCacheMisses.increment();
     }
 
     if (internalQueryPlanOrChildrenIndependently &&
@@ -391,27 +496,54 @@ Status prepareExecution(OperationContext* opCtx,
 
         *querySolutionOut = solutions[0];
         return Status::OK();
-    } else {
-        // Many solutions. Create a MultiPlanStage to pick the best, update the cache,
-        // and so on. The working set will be shared by all candidate plans.
-        MultiPlanStage* multiPlanStage = new MultiPlanStage(opCtx, collection, canonicalQuery);
+    }
 
-        for (size_t ix = 0; ix < solutions.size(); ++ix) {
-            if (solutions[ix]->cacheData.get()) {
-                solutions[ix]->cacheData->indexFilterApplied = plannerParams.indexFiltersApplied;
+    // With statistics on the indexes, one of the solutions may be estimated to be so much cheaper
+    // than the others that it is not worth running them all. The choice is not cached, since it is
+    // cheap to make again. Queries which stop early are left to the MultiPlanStage, as the cost of
+    // a plan which stops early depends on where the results are.
+    const LiteParsedQuery& parsed = canonicalQuery->getParsed();
+    if (internalQueryCostBasedPlanSelection.load() && !parsed.getLimit() &&
+        !parsed.getNToReturn()) {
+        auto best = PlanRanker::pickBestPlanByCost(solutions, collection->numRecords(opCtx));
+        if (best) {
+            for (size_t ix = 0; ix < solutions.size(); ++ix) {
+                if (ix != *best) {
+                    delete solutions[ix];
+                }
             }
 
-            // version of StageBuild::build when WorkingSet is shared
-            PlanStage* nextPlanRoot;
-            verify(StageBuilder::build(opCtx, collection, *solutions[ix], ws, &nextPlanRoot));
+            verify(StageBuilder::build(opCtx, collection, *solutions[*best], ws, rootOut));
+            costBasedPlanSelections.increment();
+
+            LOG(2) << "Picked the plan with the lowest estimated cost; it will not be cached. "
+                   << canonicalQuery->toStringShort()
+                   << ", planSummary: " << Explain::getPlanSummary(*rootOut);
 
-            // Owns none of the arguments
-            multiPlanStage->addPlan(solutions[ix], nextPlanRoot, ws);
+            *querySolutionOut = solutions[*best];
+            return Status::OK();
         }
+    }
 
-        *rootOut = multiPlanStage;
-        return Status::OK();
+    // Many solutions. Create a MultiPlanStage to pick the best, update the cache,
+    // and so on. The working set will be shared by all candidate plans.
+    MultiPlanStage* multiPlanStage = new MultiPlanStage(opCtx, collection, canonicalQuery);
+
+    for (size_t ix = 0; ix < solutions.size(); ++ix) {
+        if (solutions[ix]->cacheData.get()) {
+            solutions[ix]->cacheData->indexFilterApplied = plannerParams.indexFiltersApplied;
+        }
+
+        // version of StageBuild::build when WorkingSet is shared
+        PlanStage* nextPlanRoot;
+        verify(StageBuilder::build(opCtx, collection, *solutions[ix], ws, &nextPlanRoot));
+
+        // Owns none of the arguments
+        multiPlanStage->addPlan(solutions[ix], nextPlanRoot, ws);
     }
+
+    *rootOut = multiPlanStage;
+    return Status::OK();
 }
 
 }  // namespace
@@ -573,6 +705,7 @@ StatusWith<unique_ptr<PlanExecutor>> getExecutorFind(OperationContext* txn,
     if (ShardingState::get(txn)->needCollectionMetadata(txn, nss.ns())) {
         options |= QueryPlannerParams::INCLUDE_SHARD_FILTER;
     }
+    options |= QueryPlannerParams::PARALLEL_COLLSCAN;
     return getExecutor(
         txn, collection, std::move(canonicalQuery), PlanExecutor::YIELD_AUTO, options);
 }
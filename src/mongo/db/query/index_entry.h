@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "mongo/db/index_names.h"
@@ -36,6 +37,7 @@
 
 namespace mongo {
 
+class IndexStatistics;
 class MatchExpression;
 
 /**
@@ -116,6 +118,10 @@ struct IndexEntry {
     // by the keyPattern?)
     IndexType type;
 
+    // Statistics from the last time the index was analyzed, if any. Used to estimate the cost of
+    // plans which scan the index.
+    std::shared_ptr<const IndexStatistics> statistics;
+
     std::string toString() const;
 };
 
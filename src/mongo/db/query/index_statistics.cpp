@@ -0,0 +1,369 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/db/query/interval.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+const size_t IndexStatistics::kMaxBuckets;
+
+namespace {
+
+// Statistics are not used once the collection has grown or shrunk by more than this factor
+// since they were computed.
+const double kMaxGrowthFactor = 2.0;
+
+BSONObj wrap(const BSONElement& elem) {
+    BSONObjBuilder b;
+    b.appendAs(elem, "");
+    return b.obj();
+}
+
+/**
+ * Estimates the number of distinct values in a population of 'populationSize' from a sample with
+ * 'distinctInSample' distinct values, 'singletons' of which were seen only once. This is the GEE
+ * estimator of Charikar et al.: values seen several times are likely frequent and were all seen,
+ * while each value seen once stands for sqrt(population / sample) values in the population.
+ */
+double estimateDistinct(long long populationSize,
+                        long long sampleSize,
+                        long long distinctInSample,
+                        long long singletons) {
+    if (sampleSize == 0)
+        return 0;
+    if (sampleSize >= populationSize)
+        return distinctInSample;
+
+    const double scale = std::sqrt(static_cast<double>(populationSize) / sampleSize);
+    const double estimate = scale * singletons + (distinctInSample - singletons);
+    return std::max<double>(distinctInSample,
+                            std::min<double>(estimate, std::max(populationSize, distinctInSample)));
+}
+
+/**
+ * Returns where 'value' lies between 'lower' and 'upper', as a fraction. Only numbers and dates
+ * can be interpolated. For other values the middle is assumed.
+ */
+double interpolate(const BSONElement& lower, const BSONElement& upper, const BSONElement& value) {
+    if (value.woCompare(lower, false) == 0)
+        return 0;
+
+    double low;
+    double high;
+    double v;
+    if (lower.isNumber() && upper.isNumber() && value.isNumber()) {
+        low = lower.numberDouble();
+        high = upper.numberDouble();
+        v = value.numberDouble();
+    } else if (lower.type() == Date && upper.type() == Date && value.type() == Date) {
+        low = lower.date().toMillisSinceEpoch();
+        high = upper.date().toMillisSinceEpoch();
+        v = value.date().toMillisSinceEpoch();
+    } else {
+        return 0.5;
+    }
+
+    if (!(high > low))
+        return 0.5;
+    return std::max(0.0, std::min(1.0, (v - low) / (high - low)));
+}
+
+bool isAllValues(const OrderedIntervalList& oil) {
+    if (oil.intervals.size() != 1)
+        return false;
+    const Interval& interval = oil.intervals[0];
+    const BSONType start = interval.start.type();
+    const BSONType end = interval.end.type();
+    return (start == MinKey && end == MaxKey) || (start == MaxKey && end == MinKey);
+}
+
+}  // namespace
+
+IndexStatistics IndexStatistics::build(std::vector<BSONObj> sample,
+                                       long long numKeys,
+                                       long long numRecords) {
+    IndexStatistics stats;
+    stats._numKeys = numKeys;
+    stats._numRecords = numRecords;
+    stats._sampleSize = sample.size();
+    if (sample.empty())
+        return stats;
+
+    std::sort(sample.begin(), sample.end(), [](const BSONObj& lhs, const BSONObj& rhs) {
+        return lhs.woCompare(rhs, BSONObj(), false) < 0;
+    });
+
+    const long long n = sample.size();
+    const long long population = std::max(numKeys, n);
+
+    // Distinct keys.
+    long long distinctKeys = 0;
+    long long singletonKeys = 0;
+    for (long long i = 0; i < n;) {
+        long long j = i + 1;
+        while (j < n && sample[j].woCompare(sample[i], BSONObj(), false) == 0) {
+            j++;
+        }
+        distinctKeys++;
+        singletonKeys += (j - i == 1);
+        i = j;
+    }
+    stats._distinctKeys = estimateDistinct(population, n, distinctKeys, singletonKeys);
+
+    // Distinct values of the leading field, and the histogram. Values run in order, as the keys
+    // are sorted.
+    const long long perBucket = (n + kMaxBuckets - 1) / kMaxBuckets;
+    long long distinctValues = 0;
+    long long singletonValues = 0;
+    long long bucketKeys = 0;
+    long long bucketDistinct = 0;
+    stats._lower = wrap(sample[0].firstElement());
+    for (long long i = 0; i < n;) {
+        const BSONElement value = sample[i].firstElement();
+        long long j = i + 1;
+        while (j < n && sample[j].firstElement().woCompare(value, false) == 0) {
+            j++;
+        }
+        const long long run = j - i;
+        distinctValues++;
+        singletonValues += (run == 1);
+        bucketKeys += run;
+        bucketDistinct++;
+
+        if (bucketKeys >= perBucket || j == n) {
+            Bucket bucket;
+            bucket.upper = wrap(value);
+            bucket.fraction = static_cast<double>(bucketKeys) / n;
+            bucket.upperFraction = static_cast<double>(run) / n;
+            bucket.distinct = bucketDistinct;
+            stats._buckets.push_back(std::move(bucket));
+            bucketKeys = 0;
+            bucketDistinct = 0;
+        }
+        i = j;
+    }
+    stats._distinctLeadingValues =
+        estimateDistinct(population, n, distinctValues, singletonValues);
+
+    return stats;
+}
+
+StatusWith<IndexStatistics> IndexStatistics::parse(const BSONObj& obj) {
+    IndexStatistics stats;
+    for (auto&& field : {"numKeys", "numRecords", "sampleSize", "distinctKeys", "distinctValues"}) {
+        if (!obj[field].isNumber()) {
+            return {ErrorCodes::BadValue,
+                    str::stream() << "index statistics need a numeric '" << field << "'"};
+        }
+    }
+    stats._numKeys = obj["numKeys"].safeNumberLong();
+    stats._numRecords = obj["numRecords"].safeNumberLong();
+    stats._sampleSize = obj["sampleSize"].safeNumberLong();
+    stats._distinctKeys = obj["distinctKeys"].numberDouble();
+    stats._distinctLeadingValues = obj["distinctValues"].numberDouble();
+
+    if (obj.hasField("lower")) {
+        stats._lower = wrap(obj["lower"]).getOwned();
+    }
+
+    if (obj["buckets"].type() != Array) {
+        return {ErrorCodes::BadValue, "index statistics need a 'buckets' array"};
+    }
+    for (auto&& elem : obj["buckets"].Obj()) {
+        if (elem.type() != Object) {
+            return {ErrorCodes::BadValue, "index statistics buckets must be objects"};
+        }
+        BSONObj bucketObj = elem.Obj();
+        if (!bucketObj.hasField("upper") || !bucketObj["fraction"].isNumber() ||
+            !bucketObj["upperFraction"].isNumber() || !bucketObj["distinct"].isNumber()) {
+            return {ErrorCodes::BadValue,
+                    str::stream() << "malformed index statistics bucket " << bucketObj};
+        }
+        Bucket bucket;
+        bucket.upper = wrap(bucketObj["upper"]).getOwned();
+        bucket.fraction = bucketObj["fraction"].numberDouble();
+        bucket.upperFraction = bucketObj["upperFraction"].numberDouble();
+        bucket.distinct = bucketObj["distinct"].safeNumberLong();
+        stats._buckets.push_back(std::move(bucket));
+    }
+
+    if (!stats._buckets.empty() && stats._lower.isEmpty()) {
+        return {ErrorCodes::BadValue, "index statistics with buckets need a 'lower' bound"};
+    }
+    return {std::move(stats)};
+}
+
+BSONObj IndexStatistics::toBSON() const {
+    BSONObjBuilder b;
+    b.append("numKeys", _numKeys);
+    b.append("numRecords", _numRecords);
+    b.append("sampleSize", _sampleSize);
+    b.append("distinctKeys", _distinctKeys);
+    b.append("distinctValues", _distinctLeadingValues);
+    if (!_lower.isEmpty()) {
+        b.appendAs(_lower.firstElement(), "lower");
+    }
+
+    BSONArrayBuilder buckets(b.subarrayStart("buckets"));
+    for (auto&& bucket : _buckets) {
+        BSONObjBuilder bucketBuilder(buckets.subobjStart());
+        bucketBuilder.appendAs(bucket.upper.firstElement(), "upper");
+        bucketBuilder.append("fraction", bucket.fraction);
+        bucketBuilder.append("upperFraction", bucket.upperFraction);
+        bucketBuilder.append("distinct", bucket.distinct);
+        bucketBuilder.doneFast();
+    }
+    buckets.doneFast();
+    return b.obj();
+}
+
+boost::optional<double> IndexStatistics::estimateKeys(const IndexBounds& bounds,
+                                                      long long numRecords) const {
+    if (_buckets.empty() || _numRecords <= 0)
+        return boost::none;
+
+    const double growth = static_cast<double>(numRecords) / _numRecords;
+    if (growth > kMaxGrowthFactor || growth < 1 / kMaxGrowthFactor)
+        return boost::none;
+    const double keys = _numKeys * growth;
+
+    if (bounds.isSimpleRange) {
+        if (bounds.startKey.nFields() != 1 || bounds.endKey.nFields() != 1)
+            return boost::none;
+        BSONObjBuilder b;
+        b.appendAs(bounds.startKey.firstElement(), "");
+        b.appendAs(bounds.endKey.firstElement(), "");
+        return keys * estimateLeadingFraction(Interval(b.obj(), true, bounds.endKeyInclusive));
+    }
+
+    if (bounds.fields.empty())
+        return boost::none;
+
+    double leading = 0;
+    for (auto&& interval : bounds.fields[0].intervals) {
+        leading += estimateLeadingFraction(interval);
+    }
+    leading = std::min(1.0, leading);
+
+    // Only the leading field has a histogram. Further fields can be accounted for if they are all
+    // equalities, through the number of distinct keys, or if they are not constrained at all.
+    size_t pointFields = 0;
+    double combinations = 1;
+    bool constrained = true;
+    for (size_t i = 1; i < bounds.fields.size(); i++) {
+        const OrderedIntervalList& oil = bounds.fields[i];
+        if (isAllValues(oil)) {
+            constrained = false;
+            continue;
+        }
+        if (!constrained)
+            return boost::none;
+        for (auto&& interval : oil.intervals) {
+            if (!interval.isPoint())
+                return boost::none;
+        }
+        combinations *= oil.intervals.size();
+        pointFields++;
+    }
+
+    if (pointFields == 0)
+        return keys * leading;
+    if (pointFields != bounds.fields.size() - 1)
+        return boost::none;
+
+    // Keys with the same leading value are assumed to be spread evenly over the distinct keys.
+    const double keysPerLeadingValue = _distinctKeys / std::max(1.0, _distinctLeadingValues);
+    const double inBounds =
+        keys * leading * std::min(1.0, combinations / std::max(1.0, keysPerLeadingValue));
+
+    // A scan which doesn't constrain the leading field skips from one leading value to the next,
+    // landing on a couple of keys outside of the bounds for each of them.
+    if (isAllValues(bounds.fields[0])) {
+        return inBounds + 2 * _distinctLeadingValues;
+    }
+    return inBounds;
+}
+
+double IndexStatistics::estimateLeadingFraction(const Interval& interval) const {
+    if (_buckets.empty())
+        return 0;
+
+    // Intervals over descending fields run backwards.
+    const bool reversed = interval.start.woCompare(interval.end, false) > 0;
+    const BSONElement& start = reversed ? interval.end : interval.start;
+    const BSONElement& end = reversed ? interval.start : interval.end;
+    const bool startInclusive = reversed ? interval.endInclusive : interval.startInclusive;
+    const bool endInclusive = reversed ? interval.startInclusive : interval.endInclusive;
+
+    const double fraction =
+        _fractionBefore(end, endInclusive) - _fractionBefore(start, !startInclusive);
+    return std::max(0.0, fraction);
+}
+
+double IndexStatistics::_fractionBefore(const BSONElement& value, bool inclusive) const {
+    double before = 0;
+    BSONElement lower = _lower.firstElement();
+    for (auto&& bucket : _buckets) {
+        const BSONElement upper = bucket.upper.firstElement();
+        const int cmp = value.woCompare(upper, false);
+        if (cmp > 0) {
+            before += bucket.fraction;
+            lower = upper;
+            continue;
+        }
+
+        // The keys of the bucket below its upper bound.
+        const double inner = bucket.fraction - bucket.upperFraction;
+        if (cmp == 0)
+            return before + inner + (inclusive ? bucket.upperFraction : 0);
+
+        if (value.woCompare(lower, false) < 0)
+            return before;  // Only possible before the first bucket.
+
+        // Somewhere within the bucket. Its values other than the upper bound are assumed to be
+        // equally frequent.
+        double within = inner * interpolate(lower, upper, value);
+        if (inclusive) {
+            within += inner / std::max<long long>(1, bucket.distinct - 1);
+        }
+        return before + std::min(inner, within);
+    }
+    return before;
+}
+
+}  // namespace mongo
@@ -0,0 +1,125 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+struct IndexBounds;
+struct Interval;
+
+/**
+ * Statistics about the keys of an index, computed from a sample of its entries, which let the
+ * planner estimate how many keys a scan over some bounds examines.
+ *
+ * They consist of the number of keys and documents when the sample was taken, estimates of the
+ * number of distinct keys and distinct values of the leading field, and an equi-depth histogram
+ * of the leading field: each bucket covers about the same fraction of the keys and records how
+ * many of them equal its upper bound. A value never spans two buckets.
+ */
+class IndexStatistics {
+public:
+    static const size_t kMaxBuckets = 64;
+
+    struct Bucket {
+        BSONObj upper;         // Single field, holds the upper bound of the bucket.
+        double fraction;       // Fraction of the keys in the bucket, including the upper bound.
+        double upperFraction;  // Fraction of the keys equal to the upper bound.
+        long long distinct;    // Distinct values in the bucket, including the upper bound.
+    };
+
+    /**
+     * Computes the statistics from 'sample', a uniform sample of the keys of an index which holds
+     * 'numKeys' keys for 'numRecords' documents. The keys don't need to be sorted.
+     */
+    static IndexStatistics build(std::vector<BSONObj> sample,
+                                 long long numKeys,
+                                 long long numRecords);
+
+    static StatusWith<IndexStatistics> parse(const BSONObj& obj);
+
+    BSONObj toBSON() const;
+
+    /**
+     * Estimates how many keys a scan over 'bounds' examines, for a collection which currently has
+     * 'numRecords' documents. Returns boost::none if the bounds can't be estimated with some
+     * confidence from the statistics, or if they are too stale for the current collection size.
+     */
+    boost::optional<double> estimateKeys(const IndexBounds& bounds, long long numRecords) const;
+
+    /**
+     * Estimates the fraction of the keys whose leading field falls within 'interval'.
+     */
+    double estimateLeadingFraction(const Interval& interval) const;
+
+    long long numKeys() const {
+        return _numKeys;
+    }
+
+    long long numRecords() const {
+        return _numRecords;
+    }
+
+    long long sampleSize() const {
+        return _sampleSize;
+    }
+
+    double distinctKeys() const {
+        return _distinctKeys;
+    }
+
+    double distinctLeadingValues() const {
+        return _distinctLeadingValues;
+    }
+
+    const std::vector<Bucket>& buckets() const {
+        return _buckets;
+    }
+
+private:
+    // Returns the fraction of keys with a leading field before 'value', or at or before it if
+    // 'inclusive' is true.
+    double _fractionBefore(const BSONElement& value, bool inclusive) const;
+
+    long long _numKeys = 0;
+    long long _numRecords = 0;
+    long long _sampleSize = 0;
+    double _distinctKeys = 0;
+    double _distinctLeadingValues = 0;
+
+    BSONObj _lower;  // Single field, holds the lowest value of the leading field.
+    std::vector<Bucket> _buckets;
+};
+
+}  // namespace mongo
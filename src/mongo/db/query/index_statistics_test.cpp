@@ -0,0 +1,180 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_statistics.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Keys {"": i % 'modulo', "": i} for i in [0, count).
+ */
+std::vector<BSONObj> makeKeys(int count, int modulo) {
+    std::vector<BSONObj> keys;
+    for (int i = count - 1; i >= 0; i--) {
+        keys.push_back(BSON("" << (i % modulo) << "" << i));
+    }
+    return keys;
+}
+
+OrderedIntervalList makeOil(const char* name, const BSONObj& interval, bool inclusiveEnd = true) {
+    OrderedIntervalList oil(name);
+    oil.intervals.push_back(Interval(interval, true, inclusiveEnd));
+    return oil;
+}
+
+TEST(IndexStatisticsTest, ExactForCompleteSample) {
+    IndexStatistics stats = IndexStatistics::build(makeKeys(1000, 10), 1000, 1000);
+    ASSERT_EQUALS(1000, stats.sampleSize());
+    ASSERT_EQUALS(1000, stats.distinctKeys());
+    ASSERT_EQUALS(10, stats.distinctLeadingValues());
+    ASSERT_LESS_THAN_OR_EQUALS(stats.buckets().size(), IndexStatistics::kMaxBuckets);
+
+    // Every value is 10% of the keys.
+    for (int i = 0; i < 10; i++) {
+        ASSERT_APPROX_EQUAL(
+            0.1,
+            stats.estimateLeadingFraction(Interval(BSON("" << i << "" << i), true, true)),
+            0.001);
+    }
+    ASSERT_APPROX_EQUAL(
+        0.3, stats.estimateLeadingFraction(Interval(BSON("" << 2 << "" << 5), true, false)), 0.001);
+    ASSERT_APPROX_EQUAL(
+        0.0,
+        stats.estimateLeadingFraction(Interval(BSON("" << 20 << "" << 30), true, true)),
+        0.001);
+}
+
+TEST(IndexStatisticsTest, InterpolatesWithinBuckets) {
+    IndexStatistics stats = IndexStatistics::build(makeKeys(10000, 10000), 10000, 10000);
+    ASSERT_EQUALS(IndexStatistics::kMaxBuckets, stats.buckets().size());
+
+    ASSERT_APPROX_EQUAL(
+        0.25,
+        stats.estimateLeadingFraction(Interval(BSON("" << 1000 << "" << 3500), true, true)),
+        0.01);
+    ASSERT_APPROX_EQUAL(
+        0.0001,
+        stats.estimateLeadingFraction(Interval(BSON("" << 4321 << "" << 4321), true, true)),
+        0.0001);
+
+    // Intervals over descending fields run backwards.
+    ASSERT_APPROX_EQUAL(
+        0.25,
+        stats.estimateLeadingFraction(Interval(BSON("" << 3500 << "" << 1000), true, true)),
+        0.01);
+}
+
+TEST(IndexStatisticsTest, EstimatesDistinctValuesFromSample) {
+    // Every tenth key of an index with a unique leading field.
+    std::vector<BSONObj> sample;
+    for (int i = 0; i < 100000; i += 10) {
+        sample.push_back(BSON("" << i));
+    }
+    IndexStatistics stats = IndexStatistics::build(sample, 100000, 100000);
+    ASSERT_GREATER_THAN(stats.distinctLeadingValues(), 10000);
+    ASSERT_LESS_THAN_OR_EQUALS(stats.distinctLeadingValues(), 100000);
+
+    // A handful of frequent values are all seen in the sample, and not extrapolated.
+    stats = IndexStatistics::build(makeKeys(10000, 5), 100000, 100000);
+    ASSERT_EQUALS(5, stats.distinctLeadingValues());
+}
+
+TEST(IndexStatisticsTest, EstimatesKeysForCompoundBounds) {
+    IndexStatistics stats = IndexStatistics::build(makeKeys(1000, 10), 1000, 1000);
+
+    IndexBounds bounds;
+    bounds.fields.push_back(makeOil("a", BSON("" << 3 << "" << 3)));
+    bounds.fields.push_back(makeOil("b", BSON("" << MINKEY << "" << MAXKEY)));
+    ASSERT_APPROX_EQUAL(100, *stats.estimateKeys(bounds, 1000), 0.1);
+
+    // The estimate scales with the collection.
+    ASSERT_APPROX_EQUAL(150, *stats.estimateKeys(bounds, 1500), 0.1);
+    ASSERT_FALSE(stats.estimateKeys(bounds, 5000));
+
+    // Equality on all fields.
+    bounds.fields[1] = makeOil("b", BSON("" << 13 << "" << 13));
+    ASSERT_APPROX_EQUAL(1, *stats.estimateKeys(bounds, 1000), 0.1);
+
+    // Without a constraint on the leading field, the scan also lands on a couple of keys for each
+    // leading value it skips over.
+    bounds.fields[0] = makeOil("a", BSON("" << MINKEY << "" << MAXKEY));
+    ASSERT_APPROX_EQUAL(10 + 2 * 10, *stats.estimateKeys(bounds, 1000), 0.1);
+
+    // Ranges on later fields can't be estimated.
+    bounds.fields[1] = makeOil("b", BSON("" << 0 << "" << 500));
+    ASSERT_FALSE(stats.estimateKeys(bounds, 1000));
+}
+
+TEST(IndexStatisticsTest, RoundTripsThroughBSON) {
+    IndexStatistics stats = IndexStatistics::build(makeKeys(1000, 100), 2000, 1000);
+    BSONObj obj = stats.toBSON();
+
+    auto parsed = IndexStatistics::parse(obj);
+    ASSERT_OK(parsed.getStatus());
+    ASSERT_EQUALS(obj, parsed.getValue().toBSON());
+    ASSERT_EQUALS(2000, parsed.getValue().numKeys());
+    ASSERT_EQUALS(stats.buckets().size(), parsed.getValue().buckets().size());
+
+    ASSERT_NOT_OK(IndexStatistics::parse(BSON("numKeys" << 1)).getStatus());
+}
+
+TEST(IndexStatisticsTest, RejectsMalformedBuckets) {
+    BSONObj obj = IndexStatistics::build(makeKeys(1000, 100), 2000, 1000).toBSON();
+
+    BSONObjBuilder missing;
+    missing.appendElements(obj.removeField("buckets"));
+    ASSERT_EQUALS(ErrorCodes::BadValue, IndexStatistics::parse(missing.obj()).getStatus());
+
+    BSONObjBuilder notArray;
+    notArray.appendElements(obj.removeField("buckets"));
+    notArray.append("buckets", BSON("0" << obj["buckets"].Obj().firstElement().Obj()));
+    ASSERT_EQUALS(ErrorCodes::BadValue, IndexStatistics::parse(notArray.obj()).getStatus());
+
+    BSONObjBuilder badBucket;
+    badBucket.appendElements(obj.removeField("buckets"));
+    badBucket.append("buckets", BSON_ARRAY(1));
+    ASSERT_EQUALS(ErrorCodes::BadValue, IndexStatistics::parse(badBucket.obj()).getStatus());
+}
+
+TEST(IndexStatisticsTest, EmptySampleHasNoEstimates) {
+    IndexStatistics stats = IndexStatistics::build({}, 0, 0);
+    IndexBounds bounds;
+    bounds.fields.push_back(makeOil("a", BSON("" << 3 << "" << 3)));
+    ASSERT_FALSE(stats.estimateKeys(bounds, 0));
+    ASSERT_OK(IndexStatistics::parse(stats.toBSON()).getStatus());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -39,6 +39,7 @@
 #include "mongo/client/dbclientinterface.h"  // For QueryOption_foobar
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/query/plan_cache_template.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/query/query_knobs.h"
@@ -312,7 +313,9 @@ CachedSolution::CachedSolution(const PlanCacheKey& key, const PlanCacheEntry& en
       query(entry.query.getOwned()),
       sort(entry.sort.getOwned()),
       projection(entry.projection.getOwned()),
-      decisionWorks(entry.decision->stats[0]->common.works) {
+      decisionWorks(entry.decision->stats[0]->common.works),
+      planTemplate(entry.planTemplate),
+      usage(entry.usage) {
     // CachedSolution should not having any references into
     // cache entry. All relevant data should be cloned/copied.
     for (size_t i = 0; i < entry.plannerData.size(); ++i) {
@@ -321,6 +324,125 @@ CachedSolution::CachedSolution(const PlanCacheKey& key, const PlanCacheEntry& en
     }
 }
 
+namespace {
+
+// Windows whose executions examine fewer keys and documents than this on average don't tell a
+// degraded plan apart from noise, and wouldn't gain much from another plan anyway.
+const double kMinExaminedPerExecution = 100;
+
+}  // namespace
+
+Counter64 planCacheDegradedEntries;
+Counter64 planCacheReevaluations;
+Counter64 planCacheFlips;
+
+bool PlanCacheEntryUsage::recordExecution(long long keys,
+                                          long long docs,
+                                          long long returned,
+                                          long long micros) {
+    executions.fetchAndAdd(1);
+    keysExamined.fetchAndAdd(keys);
+    docsExamined.fetchAndAdd(docs);
+    nReturned.fetchAndAdd(returned);
+    executionMicros.fetchAndAdd(micros);
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _windowExecutions++;
+    _windowExamined += keys + docs;
+    _windowReturned += returned;
+    if (_windowExecutions < internalQueryCacheReevaluationWindow) {
+        return false;
+    }
+
+    const double examinedPerResult =
+        static_cast<double>(_windowExamined) / std::max(_windowReturned, 1LL);
+    const double examinedPerExecution = static_cast<double>(_windowExamined) / _windowExecutions;
+    _windowExecutions = 0;
+    _windowExamined = 0;
+    _windowReturned = 0;
+    _lastExaminedPerResult = examinedPerResult;
+
+    if (_baselineExaminedPerResult < 0) {
+        _baselineExaminedPerResult = examinedPerResult;
+        return false;
+    }
+
+    if (_degraded || examinedPerExecution < kMinExaminedPerExecution ||
+        examinedPerResult <=
+            internalQueryCacheReevaluationRatio * std::max(_baselineExaminedPerResult, 1.0)) {
+        return false;
+    }
+    _degraded = true;
+    return true;
+}
+
+void PlanCacheEntryUsage::inherit(const PlanCacheEntryUsage& replaced, bool planFlipped) {
+    reevaluations.store(replaced.reevaluations.load());
+    flips.store(replaced.flips.load() + (planFlipped ? 1 : 0));
+}
+
+bool PlanCacheEntryUsage::isDegraded() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _degraded;
+}
+
+void PlanCacheEntryUsage::appendStats(BSONObjBuilder* builder) const {
+    builder->append("hits", hits.load());
+    builder->append("instantiated", instantiated.load());
+    builder->append("instantiateMicros", instantiateMicros.load());
+    builder->append("rebuilt", rebuilt.load());
+    builder->append("rebuildMicros", rebuildMicros.load());
+    builder->append("executions", executions.load());
+    builder->append("keysExamined", keysExamined.load());
+    builder->append("docsExamined", docsExamined.load());
+    builder->append("nReturned", nReturned.load());
+    builder->append("executionMicros", executionMicros.load());
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_baselineExaminedPerResult >= 0) {
+            builder->append("baselineExaminedPerResult", _baselineExaminedPerResult);
+            builder->append("lastExaminedPerResult", _lastExaminedPerResult);
+        }
+        builder->append("degraded", _degraded);
+    }
+
+    builder->append("reevaluations", reevaluations.load());
+    builder->append("flips", flips.load());
+}
+
+PlanCacheReevaluationQueue& PlanCacheReevaluationQueue::get() {
+    static PlanCacheReevaluationQueue queue;
+    return queue;
+}
+
+bool PlanCacheReevaluationQueue::push(const CanonicalQuery& query,
+                                      std::shared_ptr<PlanCacheEntryUsage> usage) {
+    const LiteParsedQuery& pq = query.getParsed();
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_requests.size() >= kMaxRequests) {
+        return false;
+    }
+    _requests.push_back({query.ns(),
+                         pq.getFilter().getOwned(),
+                         pq.getSort().getOwned(),
+                         pq.getProj().getOwned(),
+                         std::move(usage)});
+    _requestsChanged.notify_one();
+    return true;
+}
+
+bool PlanCacheReevaluationQueue::waitForRequest(Milliseconds timeout, Request* out) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    if (!_requestsChanged.wait_for(lk, timeout, [this] { return !_requests.empty(); })) {
+        return false;
+    }
+    *out = std::move(_requests.front());
+    _requests.pop_front();
+    return true;
+}
+
 CachedSolution::~CachedSolution() {
     for (std::vector<SolutionCacheData*>::const_iterator i = plannerData.begin();
          i != plannerData.end();
@@ -336,7 +458,9 @@ CachedSolution::~CachedSolution() {
 
 PlanCacheEntry::PlanCacheEntry(const std::vector<QuerySolution*>& solutions,
                                PlanRankingDecision* why)
-    : plannerData(solutions.size()), decision(why) {
+    : plannerData(solutions.size()),
+      decision(why),
+      usage(std::make_shared<PlanCacheEntryUsage>()) {
     invariant(why);
 
     // The caller of this constructor is responsible for ensuring
@@ -380,6 +504,9 @@ PlanCacheEntry* PlanCacheEntry::clone() const {
         fb->score = feedback[i]->score;
         entry->feedback.push_back(fb);
     }
+
+    entry->planTemplate = planTemplate;
+    entry->usage = usage;
     return entry;
 }
 
@@ -464,6 +591,10 @@ std::string SolutionCacheData::toString() const {
                                  << "tree=" << this->tree->toString() << ")";
         case COLLSCAN_SOLN:
             return "(collection scan)";
+        case SKIP_IXSCAN_SOLN:
+            verify(this->tree.get());
+            return str::stream() << "(skip index scan solution: "
+                                 << "tree=" << this->tree->toString() << ")";
         case USE_INDEX_TAGS_SOLN:
             verify(this->tree.get());
             return str::stream() << "(index-tagged expression tree: "
@@ -652,8 +783,24 @@ Status PlanCache::add(const CanonicalQuery& query,
     }
     entry->projection = projBuilder.obj();
 
+    const PlanCacheKey key = computeKey(query);
     stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(computeKey(query), entry);
+
+    // Keep the history of the shape across replanning, and count the plan flips.
+    PlanCacheEntry* replacedEntry;
+    if (_cache.get(key, &replacedEntry).isOK()) {
+        const bool planFlipped =
+            replacedEntry->plannerData[0]->toString() != entry->plannerData[0]->toString();
+        if (planFlipped) {
+            planCacheFlips.increment();
+            LOG(1) << _ns << ": plan cache entry " << key << " flipped from winning plan "
+                   << replacedEntry->plannerData[0]->toString() << " to "
+                   << entry->plannerData[0]->toString();
+        }
+        entry->usage->inherit(*replacedEntry->usage, planFlipped);
+    }
+
+    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(key, entry);
 
     if (NULL != evictedEntry.get()) {
         LOG(1) << _ns << ": plan cache maximum size exceeded - "
@@ -680,6 +827,16 @@ Status PlanCache::get(const CanonicalQuery& query, CachedSolution** crOut) const
     return Status::OK();
 }
 
+void PlanCache::setTemplate(const CachedSolution& cs,
+                            std::shared_ptr<const PlanCacheTemplate> planTemplate) {
+    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    PlanCacheEntry* entry;
+    if (!_cache.get(cs.key, &entry).isOK() || entry->usage != cs.usage || entry->planTemplate) {
+        return;
+    }
+    entry->planTemplate = std::move(planTemplate);
+}
+
 Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback) {
     if (NULL == feedback) {
         return Status(ErrorCodes::BadValue, "feedback is NULL");
@@ -28,9 +28,11 @@
 
 #pragma once
 
+#include <deque>
 #include <set>
 #include <boost/optional/optional.hpp>
 
+#include "mongo/base/counter.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_tag.h"
@@ -38,17 +40,134 @@
 #include "mongo/db/query/plan_cache_indexability.h"
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
 // A PlanCacheKey is a string-ified version of a query's predicate/projection/sort.
 typedef std::string PlanCacheKey;
 
+class PlanCacheTemplate;
 struct PlanRankingDecision;
 struct QuerySolution;
 struct QuerySolutionNode;
 
+/**
+ * How often a cache entry was used, how long getting the solution for the queries it was used for
+ * took, and how the executions of its plan went. Shared by the entry and the CachedSolutions made
+ * from it, so that queries record their use without taking the cache lock.
+ *
+ * The executions are compared by the keys and documents they examine per result: once a window of
+ * executions examines many times more than the first one did, the plan is considered degraded,
+ * for instance because the values of the queries moved to a part of the data where another plan
+ * is better, and the alternative plans should be evaluated again.
+ */
+class PlanCacheEntryUsage {
+public:
+    /**
+     * Records a completed execution of the plan. Returns true if it completed a window which
+     * shows the plan degraded. Only returns true once per entry.
+     */
+    bool recordExecution(long long keysExamined,
+                         long long docsExamined,
+                         long long nReturned,
+                         long long micros);
+
+    /**
+     * Carries the history of the entry this one replaces over.
+     */
+    void inherit(const PlanCacheEntryUsage& replaced, bool planFlipped);
+
+    bool isDegraded() const;
+
+    void appendStats(BSONObjBuilder* builder) const;
+
+    AtomicInt64 hits;
+
+    // Solutions instantiated from the parameterized template of the entry.
+    AtomicInt64 instantiated;
+    AtomicInt64 instantiateMicros;
+
+    // Solutions the planner rebuilt from the cached index assignments.
+    AtomicInt64 rebuilt;
+    AtomicInt64 rebuildMicros;
+
+    // Executions of the plan which ran to completion.
+    AtomicInt64 executions;
+    AtomicInt64 keysExamined;
+    AtomicInt64 docsExamined;
+    AtomicInt64 nReturned;
+    AtomicInt64 executionMicros;
+
+    // Times the alternative plans were evaluated again because the plan degraded, and times the
+    // entry was replaced by one with another winning plan, including by the entries it replaced.
+    AtomicInt64 reevaluations;
+    AtomicInt64 flips;
+
+private:
+    mutable stdx::mutex _mutex;
+
+    // Keys and documents examined per result in the first window, or a negative value until it
+    // completes.
+    double _baselineExaminedPerResult = -1;
+    double _lastExaminedPerResult = -1;
+    bool _degraded = false;
+
+    // The current window.
+    long long _windowExecutions = 0;
+    long long _windowExamined = 0;
+    long long _windowReturned = 0;
+};
+
+/**
+ * Queries whose cached plan degraded, waiting for the alternative plans to be evaluated again with
+ * their values. Bounded, as the evaluations are only worth doing for a few shapes at a time.
+ */
+class PlanCacheReevaluationQueue {
+    MONGO_DISALLOW_COPYING(PlanCacheReevaluationQueue);
+
+public:
+    struct Request {
+        std::string ns;
+        BSONObj filter;
+        BSONObj sort;
+        BSONObj projection;
+
+        // Usage of the entry which degraded, to tell whether it is still cached.
+        std::shared_ptr<PlanCacheEntryUsage> usage;
+    };
+
+    static const size_t kMaxRequests = 64;
+
+    PlanCacheReevaluationQueue() = default;
+
+    static PlanCacheReevaluationQueue& get();
+
+    /**
+     * Queues a request for 'query', which ran the plan of the entry 'usage' belongs to. Returns
+     * false if the queue is full.
+     */
+    bool push(const CanonicalQuery& query, std::shared_ptr<PlanCacheEntryUsage> usage);
+
+    /**
+     * Waits up to 'timeout' for a request. Returns false if none came.
+     */
+    bool waitForRequest(Milliseconds timeout, Request* out);
+
+private:
+    stdx::mutex _mutex;
+    stdx::condition_variable _requestsChanged;
+    std::deque<Request> _requests;
+};
+
+// Across all plan caches: entries whose plan degraded, evaluations of the alternative plans of
+// degraded entries, and entries replaced by one with another winning plan.
+extern Counter64 planCacheDegradedEntries;
+extern Counter64 planCacheReevaluations;
+extern Counter64 planCacheFlips;
+
 /**
  * When the CachedPlanStage runs a cached query, it can provide feedback to the cache.  This
  * feedback is available to anyone who retrieves that query in the future.
@@ -154,6 +273,10 @@ struct SolutionCacheData {
         // The cached plan is a collection scan.
         COLLSCAN_SOLN,
 
+        // The plan skips from one value of the leading field
+        // of the index in 'tree' to the next.
+        SKIP_IXSCAN_SOLN,
+
         // Build the solution by using 'tree'
         // to tag the match expression.
         USE_INDEX_TAGS_SOLN
@@ -200,6 +323,12 @@ public:
     // The number of work cycles taken to decide on a winning plan when the plan was first
     // cached.
     size_t decisionWorks;
+
+    // The parameterized solution of the entry, if it has one.
+    std::shared_ptr<const PlanCacheTemplate> planTemplate;
+
+    // Usage of the entry, shared with it.
+    std::shared_ptr<PlanCacheEntryUsage> usage;
 };
 
 /**
@@ -257,6 +386,13 @@ public:
     // Annotations from cached runs.  The CachedPlanStage provides these stats about its
     // runs when they complete.
     std::vector<PlanCacheEntryFeedback*> feedback;
+
+    // The winning solution, parameterized by the values of the query. Made the first time the
+    // entry is used, as the solution isn't complete until the planner rebuilds it from
+    // 'plannerData'. Null if the solution can't be parameterized or wasn't rebuilt yet.
+    std::shared_ptr<const PlanCacheTemplate> planTemplate;
+
+    std::shared_ptr<PlanCacheEntryUsage> usage;
 };
 
 /**
@@ -327,6 +463,13 @@ public:
      */
     Status feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback);
 
+    /**
+     * Gives the entry 'cs' was made from the parameterized solution 'planTemplate', unless the
+     * entry was replaced or evicted in the meantime, or already has one.
+     */
+    void setTemplate(const CachedSolution& cs,
+                     std::shared_ptr<const PlanCacheTemplate> planTemplate);
+
     /**
      * Remove the entry corresponding to 'ck' from the cache.  Returns Status::OK() if the plan
      * was present and removed and an error status otherwise.
@@ -0,0 +1,184 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cache_reevaluator.h"
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/multi_plan.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_planner.h"
+#include "mongo/db/query/query_planner_params.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/db/query/stage_builder.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/background.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+namespace {
+
+class PlanCacheReevaluator : public BackgroundJob {
+public:
+    PlanCacheReevaluator() : BackgroundJob(true) {}
+
+    std::string name() const final {
+        return "PlanCacheReevaluator";
+    }
+
+    void run() final {
+        Client::initThread(name().c_str());
+        AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+        PlanCacheReevaluationQueue::Request request;
+        while (!inShutdown()) {
+            if (!PlanCacheReevaluationQueue::get().waitForRequest(Seconds(1), &request)) {
+                continue;
+            }
+
+            try {
+                reevaluate(request);
+            } catch (const WriteConflictException&) {
+                LOG(1) << "Got WriteConflictException re-evaluating the plans of " << request.ns;
+            } catch (const DBException& e) {
+                LOG(1) << "Failed to re-evaluate the plans of a degraded cache entry for "
+                       << request.ns << ": " << e.what();
+            }
+            request = PlanCacheReevaluationQueue::Request();
+        }
+    }
+
+private:
+    /**
+     * Plans the query of 'request' from scratch and runs the candidate plans through the trial
+     * period, as a query missing the cache would. The MultiPlanStage caches the winner, which
+     * replaces the degraded entry.
+     */
+    void reevaluate(const PlanCacheReevaluationQueue::Request& request) {
+        OperationContextImpl txn;
+        const NamespaceString nss(request.ns);
+        AutoGetCollectionForRead ctx(&txn, nss);
+        Collection* collection = ctx.getCollection();
+        if (!collection) {
+            return;
+        }
+
+        auto statusWithCQ = CanonicalQuery::canonicalize(nss,
+                                                         request.filter,
+                                                         request.sort,
+                                                         request.projection,
+                                                         ExtensionsCallbackReal(&txn, &nss));
+        if (!statusWithCQ.isOK()) {
+            return;
+        }
+        std::unique_ptr<CanonicalQuery> cq = std::move(statusWithCQ.getValue());
+
+        // Leave the entry alone if it was evicted or replaced since it degraded.
+        PlanCache* planCache = collection->infoCache()->getPlanCache();
+        PlanCacheEntry* rawEntry;
+        if (!planCache->getEntry(*cq, &rawEntry).isOK()) {
+            return;
+        }
+        std::unique_ptr<PlanCacheEntry> entry(rawEntry);
+        if (entry->usage != request.usage) {
+            return;
+        }
+
+        QueryPlannerParams plannerParams;
+        fillOutPlannerParams(&txn, collection, cq.get(), &plannerParams);
+
+        std::vector<QuerySolution*> solutions;
+        Status status = QueryPlanner::plan(*cq, plannerParams, &solutions);
+        if (!status.isOK()) {
+            return;
+        }
+        if (solutions.size() < 2) {
+            // Nothing to pick from.
+            for (auto solution : solutions) {
+                delete solution;
+            }
+            return;
+        }
+
+        planCacheReevaluations.increment();
+        request.usage->reevaluations.fetchAndAdd(1);
+        LOG(1) << "Re-evaluating " << solutions.size()
+               << " plans of degraded cache entry: " << cq->toStringShort();
+
+        auto ws = stdx::make_unique<WorkingSet>();
+        auto multiPlanStage = stdx::make_unique<MultiPlanStage>(
+            &txn, collection, cq.get(), MultiPlanStage::CachingMode::AlwaysCache);
+        for (auto solution : solutions) {
+            if (solution->cacheData.get()) {
+                solution->cacheData->indexFilterApplied = plannerParams.indexFiltersApplied;
+            }
+
+            PlanStage* root;
+            verify(StageBuilder::build(&txn, collection, *solution, ws.get(), &root));
+
+            // Takes ownership of 'solution' and 'root'.
+            multiPlanStage->addPlan(solution, root, ws.get());
+        }
+
+        // Making the executor runs the trial period, which caches the best plan.
+        auto statusWithExec = PlanExecutor::make(&txn,
+                                                 std::move(ws),
+                                                 std::move(multiPlanStage),
+                                                 std::move(cq),
+                                                 collection,
+                                                 PlanExecutor::YIELD_AUTO);
+        if (!statusWithExec.isOK()) {
+            LOG(1) << "Failed to re-evaluate the plans of a degraded cache entry for "
+                   << request.ns << ": " << statusWithExec.getStatus();
+        }
+    }
+};
+
+}  // namespace
+
+void startPlanCacheReevaluator() {
+    (new PlanCacheReevaluator())->go();
+}
+
+}  // namespace mongo
@@ -0,0 +1,388 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cache_template.h"
+
+#include <cmath>
+
+#include "mongo/db/index_names.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/query_planner_params.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+
+namespace {
+
+bool isComparison(MatchExpression::MatchType type) {
+    switch (type) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Appends the comparison leaves of 'expr' to 'out' in preorder. Returns false if 'expr' has
+ * predicates whose values can't be parameterized.
+ */
+bool collectComparisons(const MatchExpression* expr,
+                        std::vector<const ComparisonMatchExpression*>* out) {
+    switch (expr->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+            for (size_t i = 0; i < expr->numChildren(); ++i) {
+                if (!collectComparisons(expr->getChild(i), out)) {
+                    return false;
+                }
+            }
+            return true;
+        case MatchExpression::EXISTS:
+            return true;
+        default:
+            if (!isComparison(expr->matchType())) {
+                return false;
+            }
+            out->push_back(static_cast<const ComparisonMatchExpression*>(expr));
+            return true;
+    }
+}
+
+bool sameValue(const BSONElement& lhs, const BSONElement& rhs) {
+    return lhs.canonicalType() == rhs.canonicalType() && lhs.woCompare(rhs, false) == 0;
+}
+
+/**
+ * Returns whether the planner treats 'value' like any other value of its type, so that another
+ * value of the type can take its place. The planner brackets values by type with the minimum and
+ * maximum values of the type, and handles NaN and infinities separately.
+ */
+bool isSubstitutable(const BSONElement& value) {
+    switch (value.type()) {
+        case NumberInt:
+        case NumberLong:
+        case NumberDouble:
+            if (!std::isfinite(value.numberDouble())) {
+                return false;
+            }
+            break;
+        case String:
+        case Date:
+        case jstOID:
+            break;
+        default:
+            return false;
+    }
+
+    BSONObjBuilder bob;
+    bob.appendMinForType("", value.type());
+    bob.appendMaxForType("", value.type());
+    BSONObj brackets = bob.obj();
+    for (auto&& bracket : brackets) {
+        if (sameValue(bracket, value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int compareValues(const BSONElement& lhs, const BSONElement& rhs) {
+    const int cmp = lhs.woCompare(rhs, false);
+    return cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
+}
+
+const IndexEntry* findIndex(const QueryPlannerParams& params, const IndexScanNode& scan) {
+    for (auto&& index : params.indices) {
+        if (index.keyPattern.binaryEqual(scan.indexKeyPattern)) {
+            return &index;
+        }
+    }
+    return nullptr;
+}
+
+bool queryHasOptions(const CanonicalQuery& query) {
+    const LiteParsedQuery& parsed = query.getParsed();
+    return parsed.getSkip() || parsed.getLimit() || parsed.getNToReturn() ||
+        parsed.getMaxScan() != 0 || parsed.returnKey() || !parsed.getMin().isEmpty() ||
+        !parsed.getMax().isEmpty();
+}
+
+}  // namespace
+
+std::unique_ptr<PlanCacheTemplate> PlanCacheTemplate::make(const CanonicalQuery& query,
+                                                           const QueryPlannerParams& params,
+                                                           const QuerySolution& solution) {
+    // The values of the parameters point into the filter the solution holds on to.
+    if (queryHasOptions(query) || !solution.root || !solution.filterData.isOwned() ||
+        solution.filterData.objdata() != query.getQueryObj().objdata()) {
+        return nullptr;
+    }
+
+    std::vector<const ComparisonMatchExpression*> comparisons;
+    if (!collectComparisons(query.root(), &comparisons)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<PlanCacheTemplate> planTemplate(new PlanCacheTemplate());
+    planTemplate->_filter = solution.filterData;
+    for (auto&& comparison : comparisons) {
+        Parameter parameter;
+        parameter.matchType = comparison->matchType();
+        parameter.path = comparison->path().toString();
+        parameter.value = comparison->getData();
+        parameter.fixed = !isSubstitutable(parameter.value);
+        planTemplate->_parameters.push_back(parameter);
+    }
+
+    if (!planTemplate->_parameterizeScans(solution.root.get(), params)) {
+        return nullptr;
+    }
+
+    // A template is only worth keeping if it saves planning with other values.
+    bool hasVariables = false;
+    for (auto&& parameter : planTemplate->_parameters) {
+        hasVariables = hasVariables || !parameter.fixed;
+    }
+    if (!hasVariables) {
+        return nullptr;
+    }
+
+    planTemplate->_plannerOptions = params.options;
+    planTemplate->_solution = stdx::make_unique<QuerySolution>();
+    planTemplate->_solution->root.reset(solution.root->clone());
+    planTemplate->_solution->filterData = solution.filterData;
+    planTemplate->_solution->hasBlockingStage = solution.hasBlockingStage;
+    return planTemplate;
+}
+
+std::unique_ptr<QuerySolution> PlanCacheTemplate::instantiate(
+    const CanonicalQuery& query, const QueryPlannerParams& params) const {
+    if (queryHasOptions(query) || params.options != _plannerOptions) {
+        return nullptr;
+    }
+
+    std::vector<const ComparisonMatchExpression*> comparisons;
+    if (!collectComparisons(query.root(), &comparisons) ||
+        comparisons.size() != _parameters.size()) {
+        return nullptr;
+    }
+
+    std::vector<BSONElement> values;
+    for (size_t i = 0; i < _parameters.size(); ++i) {
+        const Parameter& parameter = _parameters[i];
+        const BSONElement& value = comparisons[i]->getData();
+        if (comparisons[i]->matchType() != parameter.matchType ||
+            comparisons[i]->path() != parameter.path) {
+            return nullptr;
+        }
+
+        if (parameter.fixed) {
+            if (value.type() != parameter.value.type() || !sameValue(value, parameter.value)) {
+                return nullptr;
+            }
+        } else if (value.canonicalType() != parameter.value.canonicalType() ||
+                   !isSubstitutable(value)) {
+            return nullptr;
+        }
+
+        // The values compared to a path have to be ordered like those the solution was planned
+        // for, or the planner would have combined the bounds differently.
+        for (size_t j = 0; j < i; ++j) {
+            if (_parameters[j].path == parameter.path &&
+                compareValues(values[j], value) !=
+                    compareValues(_parameters[j].value, parameter.value)) {
+                return nullptr;
+            }
+        }
+        values.push_back(value);
+    }
+
+    auto solution = stdx::make_unique<QuerySolution>();
+    solution->root.reset(_solution->root->clone());
+    size_t scan = 0;
+    if (!_substitute(solution->root.get(), query, params, values, &scan)) {
+        return nullptr;
+    }
+
+    solution->filterData = query.getQueryObj();
+    solution->hasBlockingStage = _solution->hasBlockingStage;
+    solution->indexFilterApplied = params.indexFiltersApplied;
+    return solution;
+}
+
+int PlanCacheTemplate::_findParameter(StringData path, const BSONElement& value) const {
+    for (size_t i = 0; i < _parameters.size(); ++i) {
+        const Parameter& parameter = _parameters[i];
+        if (!parameter.fixed && parameter.path == path && sameValue(parameter.value, value)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool PlanCacheTemplate::_parameterizeScans(const QuerySolutionNode* node,
+                                           const QueryPlannerParams& params) {
+    switch (node->getType()) {
+        case STAGE_COLLSCAN:
+        case STAGE_FETCH:
+        case STAGE_AND_HASH:
+        case STAGE_AND_SORTED:
+        case STAGE_OR:
+        case STAGE_SORT_MERGE:
+        case STAGE_PROJECTION:
+        case STAGE_SORT_KEY_GENERATOR:
+        case STAGE_SORT:
+        case STAGE_ENSURE_SORTED:
+        case STAGE_SHARDING_FILTER:
+        case STAGE_KEEP_MUTATIONS:
+            break;
+        case STAGE_IXSCAN: {
+            const IndexScanNode* ixscan = static_cast<const IndexScanNode*>(node);
+            const IndexEntry* index = findIndex(params, *ixscan);
+
+            // Hashed and special indices don't key on the values themselves, and whether a
+            // partial index can answer the query depends on the values.
+            if (!index || index->filterExpr ||
+                IndexNames::findPluginName(index->keyPattern) != IndexNames::BTREE ||
+                ixscan->bounds.isSimpleRange || ixscan->maxScan != 0) {
+                return false;
+            }
+
+            ScanParameters scanParameters;
+            for (auto&& oil : ixscan->bounds.fields) {
+                if (oil.intervals.empty()) {
+                    return false;
+                }
+                std::vector<IntervalParameters> fieldParameters;
+                for (auto&& interval : oil.intervals) {
+                    fieldParameters.push_back({_findParameter(oil.name, interval.start),
+                                               _findParameter(oil.name, interval.end)});
+                }
+                scanParameters.push_back(std::move(fieldParameters));
+            }
+            _scans.push_back(std::move(scanParameters));
+            break;
+        }
+        default:
+            return false;
+    }
+
+    for (auto&& child : node->children) {
+        if (!_parameterizeScans(child, params)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PlanCacheTemplate::_substitute(QuerySolutionNode* node,
+                                    const CanonicalQuery& query,
+                                    const QueryPlannerParams& params,
+                                    const std::vector<BSONElement>& values,
+                                    size_t* scan) const {
+    if (node->filter) {
+        _substituteInFilter(node->filter.get(), values);
+    }
+
+    switch (node->getType()) {
+        case STAGE_IXSCAN: {
+            IndexScanNode* ixscan = static_cast<IndexScanNode*>(node);
+            const IndexEntry* index = findIndex(params, *ixscan);
+            if (!index || index->multikey != ixscan->indexIsMultiKey || index->filterExpr) {
+                return false;
+            }
+            ixscan->indexStatistics = index->statistics;
+
+            const ScanParameters& scanParameters = _scans[(*scan)++];
+            for (size_t field = 0; field < scanParameters.size(); ++field) {
+                OrderedIntervalList& oil = ixscan->bounds.fields[field];
+                for (size_t i = 0; i < oil.intervals.size(); ++i) {
+                    const IntervalParameters& parameters = scanParameters[field][i];
+                    if (parameters.start < 0 && parameters.end < 0) {
+                        continue;
+                    }
+
+                    Interval& interval = oil.intervals[i];
+                    BSONObjBuilder bob;
+                    bob.appendAs(parameters.start < 0 ? interval.start : values[parameters.start],
+                                 "");
+                    bob.appendAs(parameters.end < 0 ? interval.end : values[parameters.end], "");
+                    interval = Interval(bob.obj(), interval.startInclusive, interval.endInclusive);
+                }
+            }
+            break;
+        }
+        case STAGE_PROJECTION:
+            static_cast<ProjectionNode*>(node)->fullExpression = query.root();
+            break;
+        case STAGE_SORT_KEY_GENERATOR:
+            static_cast<SortKeyGeneratorNode*>(node)->queryObj = query.getParsed().getFilter();
+            break;
+        default:
+            break;
+    }
+
+    for (auto&& child : node->children) {
+        if (!_substitute(child, query, params, values, scan)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PlanCacheTemplate::_substituteInFilter(MatchExpression* expr,
+                                            const std::vector<BSONElement>& values) const {
+    if (isComparison(expr->matchType())) {
+        ComparisonMatchExpression* comparison = static_cast<ComparisonMatchExpression*>(expr);
+        for (size_t i = 0; i < _parameters.size(); ++i) {
+            const Parameter& parameter = _parameters[i];
+            if (parameter.matchType == comparison->matchType() &&
+                comparison->path() == parameter.path &&
+                sameValue(parameter.value, comparison->getData())) {
+                comparison->init(parameter.path, values[i]);
+                return;
+            }
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < expr->numChildren(); ++i) {
+        _substituteInFilter(expr->getChild(i), values);
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,136 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+class CanonicalQuery;
+struct QueryPlannerParams;
+struct QuerySolution;
+struct QuerySolutionNode;
+
+/**
+ * The solution planned for a query, parameterized by the values the query compares fields to, so
+ * that the solution for another query of the same shape can be instantiated from it without
+ * running the planner again.
+ *
+ * The parameters are the operands of the $eq, $lt, $lte, $gt and $gte predicates. Instantiating
+ * substitutes the values of the new query for those of the original one in the filters and index
+ * bounds of the solution. This yields the solution the planner would build as long as each new
+ * value has the same type as the original one, numbers of any type counting as one, and the values
+ * compared to each path are ordered the same way as the original ones: the planner only combines
+ * intervals by comparing their endpoints. Values which the planner also uses to bracket other
+ * values by type, such as "" or booleans, and infinities and NaN, can't be substituted and have
+ * to match exactly.
+ *
+ * Queries with other predicates which carry values ($in, $regex, geo, text...), or with skip,
+ * limit or other options which shape the solution, are not parameterized.
+ */
+class PlanCacheTemplate {
+    MONGO_DISALLOW_COPYING(PlanCacheTemplate);
+
+public:
+    /**
+     * Parameterizes 'solution', which the planner built for 'query' with 'params'. Returns nullptr
+     * if it can't be parameterized.
+     */
+    static std::unique_ptr<PlanCacheTemplate> make(const CanonicalQuery& query,
+                                                   const QueryPlannerParams& params,
+                                                   const QuerySolution& solution);
+
+    /**
+     * Returns the solution for 'query', which has to have the same shape as the query the
+     * template was made from, or nullptr if its values or 'params' don't allow instantiating it.
+     */
+    std::unique_ptr<QuerySolution> instantiate(const CanonicalQuery& query,
+                                               const QueryPlannerParams& params) const;
+
+    size_t numParameters() const {
+        return _parameters.size();
+    }
+
+private:
+    struct Parameter {
+        MatchExpression::MatchType matchType;
+        std::string path;
+        BSONElement value;
+
+        // The value can't be substituted, and has to be the same in instantiating queries.
+        bool fixed;
+    };
+
+    // Parameters to substitute for the endpoints of an interval, or -1 to keep them.
+    struct IntervalParameters {
+        int start;
+        int end;
+    };
+
+    // For each field of the bounds of an index scan, the parameters of each interval.
+    using ScanParameters = std::vector<std::vector<IntervalParameters>>;
+
+    PlanCacheTemplate() = default;
+
+    // Returns the parameter for 'value' of a predicate on 'path', or -1 if there is none.
+    int _findParameter(StringData path, const BSONElement& value) const;
+
+    // Records where parameters occur in the bounds of the index scans under 'node'. Returns false
+    // if the solution depends on the values in ways substitution can't reproduce.
+    bool _parameterizeScans(const QuerySolutionNode* node, const QueryPlannerParams& params);
+
+    // Substitutes 'values' for the parameters in the tree rooted at 'node', which is planned for
+    // 'query'. 'scan' counts the index scans visited so far. Returns false if an index the tree
+    // scans changed in 'params'.
+    bool _substitute(QuerySolutionNode* node,
+                     const CanonicalQuery& query,
+                     const QueryPlannerParams& params,
+                     const std::vector<BSONElement>& values,
+                     size_t* scan) const;
+
+    // Substitutes 'values' for the parameters in the leaves of 'expr'.
+    void _substituteInFilter(MatchExpression* expr, const std::vector<BSONElement>& values) const;
+
+    // Owns the values of the parameters and those the filters of '_solution' point to.
+    BSONObj _filter;
+
+    std::vector<Parameter> _parameters;
+    std::vector<ScanParameters> _scans;  // In preorder of the index scans.
+
+    size_t _plannerOptions = 0;
+    std::unique_ptr<QuerySolution> _solution;
+};
+
+}  // namespace mongo
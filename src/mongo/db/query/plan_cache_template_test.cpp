@@ -0,0 +1,180 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cache_template.h"
+
+#include "mongo/db/json.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/query_planner.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using std::unique_ptr;
+
+const NamespaceString nss("test.collection");
+
+unique_ptr<CanonicalQuery> canonicalize(const char* queryStr, const char* sortStr = "{}") {
+    auto statusWithCQ =
+        CanonicalQuery::canonicalize(nss, fromjson(queryStr), fromjson(sortStr), BSONObj());
+    ASSERT_OK(statusWithCQ.getStatus());
+    return std::move(statusWithCQ.getValue());
+}
+
+class PlanCacheTemplateTest : public mongo::unittest::Test {
+protected:
+    void addIndex(BSONObj keyPattern, bool multikey = false) {
+        params.indices.push_back(
+            IndexEntry(keyPattern, multikey, false, false, "index", nullptr, BSONObj()));
+    }
+
+    /**
+     * Returns the first solution the planner builds for 'query'.
+     */
+    unique_ptr<QuerySolution> plan(const CanonicalQuery& query) {
+        std::vector<QuerySolution*> solutions;
+        ASSERT_OK(QueryPlanner::plan(query, params, &solutions));
+        ASSERT_FALSE(solutions.empty());
+        for (size_t i = 1; i < solutions.size(); ++i) {
+            delete solutions[i];
+        }
+        return unique_ptr<QuerySolution>(solutions[0]);
+    }
+
+    unique_ptr<PlanCacheTemplate> makeTemplate(const char* queryStr, const char* sortStr = "{}") {
+        unique_ptr<CanonicalQuery> query = canonicalize(queryStr, sortStr);
+        unique_ptr<QuerySolution> solution = plan(*query);
+        return PlanCacheTemplate::make(*query, params, *solution);
+    }
+
+    /**
+     * Asserts that 'planTemplate' instantiates to the solution the planner builds for the query.
+     */
+    void assertInstantiates(const PlanCacheTemplate& planTemplate,
+                            const char* queryStr,
+                            const char* sortStr = "{}") {
+        unique_ptr<CanonicalQuery> query = canonicalize(queryStr, sortStr);
+        unique_ptr<QuerySolution> instance = planTemplate.instantiate(*query, params);
+        ASSERT(instance);
+        ASSERT_EQUALS(plan(*query)->toString(), instance->toString());
+        ASSERT_EQUALS(query->getQueryObj(), instance->filterData);
+    }
+
+    bool instantiates(const PlanCacheTemplate& planTemplate, const char* queryStr) {
+        return static_cast<bool>(planTemplate.instantiate(*canonicalize(queryStr), params));
+    }
+
+    QueryPlannerParams params;
+};
+
+TEST_F(PlanCacheTemplateTest, SubstitutesRangeBounds) {
+    addIndex(BSON("a" << 1));
+    unique_ptr<PlanCacheTemplate> planTemplate = makeTemplate("{a: {$gt: 5, $lt: 10}}");
+    ASSERT(planTemplate);
+    ASSERT_EQUALS(2U, planTemplate->numParameters());
+
+    assertInstantiates(*planTemplate, "{a: {$gt: 1, $lt: 3}}");
+    assertInstantiates(*planTemplate, "{a: {$gt: -2.5, $lt: 30000000000}}");
+}
+
+TEST_F(PlanCacheTemplateTest, SubstitutesBoundsAndResidualFilters) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    unique_ptr<PlanCacheTemplate> planTemplate =
+        makeTemplate("{a: 5, b: {$gte: 2}, c: 'x'}", "{b: -1}");
+    ASSERT(planTemplate);
+
+    assertInstantiates(*planTemplate, "{a: 7, b: {$gte: 100}, c: 'yz'}", "{b: -1}");
+}
+
+TEST_F(PlanCacheTemplateTest, SubstitutesBoundsOfEachBranch) {
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("b" << 1));
+    unique_ptr<PlanCacheTemplate> planTemplate = makeTemplate("{$or: [{a: 1}, {b: {$lte: 2}}]}");
+    ASSERT(planTemplate);
+
+    assertInstantiates(*planTemplate, "{$or: [{a: 3}, {b: {$lte: 4}}]}");
+}
+
+TEST_F(PlanCacheTemplateTest, RequiresValuesOrderedTheSameWay) {
+    addIndex(BSON("a" << 1));
+    unique_ptr<PlanCacheTemplate> planTemplate = makeTemplate("{a: {$gt: 5, $lt: 10}}");
+    ASSERT(planTemplate);
+
+    ASSERT_FALSE(instantiates(*planTemplate, "{a: {$gt: 10, $lt: 5}}"));
+    ASSERT_FALSE(instantiates(*planTemplate, "{a: {$gt: 5, $lt: 5}}"));
+}
+
+TEST_F(PlanCacheTemplateTest, RequiresSameTypes) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    unique_ptr<PlanCacheTemplate> planTemplate = makeTemplate("{a: 5, b: null}");
+    ASSERT(planTemplate);
+
+    assertInstantiates(*planTemplate, "{a: 6, b: null}");
+    assertInstantiates(*planTemplate, "{a: 6.5, b: null}");
+    ASSERT_FALSE(instantiates(*planTemplate, "{a: 'x', b: null}"));
+    ASSERT_FALSE(instantiates(*planTemplate, "{a: 6, b: 1}"));
+    ASSERT_FALSE(instantiates(*planTemplate, "{a: 6, b: {$gt: 1}}"));
+}
+
+TEST_F(PlanCacheTemplateTest, DoesNotSubstituteTypeBrackets) {
+    addIndex(BSON("a" << 1));
+    unique_ptr<PlanCacheTemplate> planTemplate = makeTemplate("{a: {$gt: 'abc'}}");
+    ASSERT(planTemplate);
+
+    assertInstantiates(*planTemplate, "{a: {$gt: 'b'}}");
+    ASSERT_FALSE(instantiates(*planTemplate, "{a: {$gt: ''}}"));
+    ASSERT_FALSE(makeTemplate("{a: {$gt: ''}}"));
+}
+
+TEST_F(PlanCacheTemplateTest, RequiresSameIndexes) {
+    addIndex(BSON("a" << 1));
+    unique_ptr<PlanCacheTemplate> planTemplate = makeTemplate("{a: {$gte: 1}}");
+    ASSERT(planTemplate);
+
+    params.indices[0].multikey = true;
+    ASSERT_FALSE(instantiates(*planTemplate, "{a: {$gte: 2}}"));
+    params.indices.clear();
+    ASSERT_FALSE(instantiates(*planTemplate, "{a: {$gte: 2}}"));
+}
+
+TEST_F(PlanCacheTemplateTest, DoesNotParameterizeOtherPredicatesOrIndexes) {
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("b"
+                  << "hashed"));
+    ASSERT_FALSE(makeTemplate("{a: {$in: [1, 2]}}"));
+    ASSERT_FALSE(makeTemplate("{a: /^x/}"));
+    ASSERT_FALSE(makeTemplate("{b: 1}"));
+    ASSERT_FALSE(makeTemplate("{a: {$exists: true}}"));
+}
+
+}  // namespace
+}  // namespace mongo
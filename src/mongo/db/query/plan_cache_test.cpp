@@ -388,6 +388,79 @@ TEST(PlanCacheTest, AddValidSolution) {
     ASSERT_EQUALS(planCache.size(), 1U);
 }
 
+TEST(PlanCacheTest, UsageFlagsDegradedPlanOnce) {
+    PlanCacheEntryUsage usage;
+
+    // The first window sets the baseline of 2 keys and documents examined per result.
+    for (int i = 0; i < internalQueryCacheReevaluationWindow; ++i) {
+        ASSERT_FALSE(usage.recordExecution(10, 10, 10, 100));
+    }
+    ASSERT_FALSE(usage.isDegraded());
+
+    // Only a completed window is compared with the baseline.
+    for (int i = 0; i < internalQueryCacheReevaluationWindow - 1; ++i) {
+        ASSERT_FALSE(usage.recordExecution(1000, 1000, 1, 100));
+    }
+    ASSERT_TRUE(usage.recordExecution(1000, 1000, 1, 100));
+    ASSERT_TRUE(usage.isDegraded());
+
+    for (int i = 0; i < internalQueryCacheReevaluationWindow; ++i) {
+        ASSERT_FALSE(usage.recordExecution(1000, 1000, 1, 100));
+    }
+
+    BSONObjBuilder bob;
+    usage.appendStats(&bob);
+    BSONObj stats = bob.obj();
+    ASSERT_EQUALS(3 * internalQueryCacheReevaluationWindow, stats["executions"].numberLong());
+    ASSERT_EQUALS(2.0, stats["baselineExaminedPerResult"].numberDouble());
+    ASSERT_EQUALS(2000.0, stats["lastExaminedPerResult"].numberDouble());
+    ASSERT_TRUE(stats["degraded"].trueValue());
+}
+
+TEST(PlanCacheTest, UsageIgnoresCheapExecutions) {
+    PlanCacheEntryUsage usage;
+    for (int i = 0; i < internalQueryCacheReevaluationWindow; ++i) {
+        ASSERT_FALSE(usage.recordExecution(1, 0, 1, 100));
+    }
+
+    // Many times more examined per result than the baseline, but too little work to bother.
+    for (int i = 0; i < internalQueryCacheReevaluationWindow; ++i) {
+        ASSERT_FALSE(usage.recordExecution(50, 0, 0, 100));
+    }
+    ASSERT_FALSE(usage.isDegraded());
+}
+
+TEST(PlanCacheTest, ReplacingEntryWithAnotherPlanCountsFlip) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+
+    QuerySolution indexSolution;
+    indexSolution.cacheData.reset(new SolutionCacheData());
+    indexSolution.cacheData->tree.reset(new PlanCacheIndexTree());
+    QuerySolution collScanSolution;
+    collScanSolution.cacheData.reset(new SolutionCacheData());
+    collScanSolution.cacheData->solnType = SolutionCacheData::COLLSCAN_SOLN;
+    collScanSolution.cacheData->tree.reset(new PlanCacheIndexTree());
+
+    const long long flipsBefore = planCacheFlips.get();
+    std::vector<QuerySolution*> solns{&indexSolution};
+    ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+
+    // The same plan winning again is no flip.
+    ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+    PlanCacheEntry* rawEntry;
+    ASSERT_OK(planCache.getEntry(*cq, &rawEntry));
+    unique_ptr<PlanCacheEntry> entry(rawEntry);
+    ASSERT_EQUALS(0, entry->usage->flips.load());
+
+    solns = {&collScanSolution};
+    ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+    ASSERT_OK(planCache.getEntry(*cq, &rawEntry));
+    entry.reset(rawEntry);
+    ASSERT_EQUALS(1, entry->usage->flips.load());
+    ASSERT_EQUALS(flipsBefore + 1, planCacheFlips.get());
+}
+
 /**
  * Each test in the CachePlanSelectionTest suite goes through
  * the following flow:
@@ -42,6 +42,7 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/stdx/memory.h"
 
@@ -76,6 +77,32 @@ PlanStage* getStageByType(PlanStage* root, StageType type) {
 
     return NULL;
 }
+
+/**
+ * Returns how many results to pull through 'root' at a time. Batches are only used when every
+ * stage of the plan has a workBatch() implementation which does better than calling work()
+ * repeatedly; otherwise there is nothing to gain from buffering the results.
+ */
+size_t getBatchSize(PlanStage* root) {
+    const int batchSize = internalQueryExecBatchSize.load();
+    if (batchSize <= 1) {
+        return 1;
+    }
+
+    switch (root->stageType()) {
+        case STAGE_COLLSCAN:
+        case STAGE_IXSCAN:
+        case STAGE_PARALLEL_COLLSCAN:
+            return batchSize;
+        case STAGE_FETCH:
+        case STAGE_LIMIT:
+        case STAGE_PROJECTION:
+        case STAGE_SKIP:
+            return getBatchSize(root->getChildren()[0].get());
+        default:
+            return 1;
+    }
+}
 }
 
 // static
@@ -262,6 +289,12 @@ void PlanExecutor::saveState() {
         WorkingSetCommon::prepareForSnapshotChange(_workingSet.get());
     }
 
+    // Results of a batch that have not been returned yet may point into storage engine memory
+    // which is only valid until the next cursor operation.
+    for (auto id : _batchResults) {
+        _workingSet->get(id)->makeObjOwnedIfNeeded();
+    }
+
     if (!killed()) {
         _root->saveState();
     }
@@ -315,6 +348,15 @@ void PlanExecutor::invalidate(OperationContext* txn, const RecordId& dl, Invalid
     if (!killed()) {
         _root->invalidate(txn, dl, type);
     }
+
+    // The stages no longer know about the results buffered here, so handle them like any other
+    // stage which holds on to results would.
+    for (auto id : _batchResults) {
+        WorkingSetMember* member = _workingSet->get(id);
+        if (member->hasLoc() && member->loc == dl) {
+            WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+        }
+    }
 }
 
 PlanExecutor::ExecState PlanExecutor::getNext(BSONObj* objOut, RecordId* dlOut) {
@@ -368,8 +410,9 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
         //   1) The yield policy's timer elapsed, or
         //   2) some stage requested a yield due to a document fetch, or
         //   3) we need to yield and retry due to a WriteConflictException.
-        // In all cases, the actual yielding happens here.
-        if (_yieldPolicy->shouldYield()) {
+        // In all cases, the actual yielding happens here. Results of the current batch are
+        // returned before yielding.
+        if (_batchResults.empty() && _yieldPolicy->shouldYield()) {
             if (!_yieldPolicy->yield(fetcher.get())) {
                 // A return of false from a yield should only happen if we've been killed during the
                 // yield.
@@ -390,7 +433,7 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
         fetcher.reset();
 
         WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState code = _root->work(&id);
+        PlanStage::StageState code = workRoot(&id);
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
@@ -476,9 +519,45 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
     }
 }
 
+PlanStage::StageState PlanExecutor::workRoot(WorkingSetID* out) {
+    if (!_batchResults.empty()) {
+        *out = _batchResults.front();
+        _batchResults.pop_front();
+        return PlanStage::ADVANCED;
+    }
+
+    if (_hasBatchState) {
+        _hasBatchState = false;
+        *out = _batchStateId;
+        return _batchState;
+    }
+
+    const size_t batchSize = getBatchSize(_root.get());
+    if (batchSize <= 1) {
+        return _root->work(out);
+    }
+
+    _batchScratch.clear();
+    PlanStage::StageState state = _root->workBatch(batchSize, &_batchScratch, out);
+    if (_batchScratch.empty()) {
+        return state;
+    }
+
+    if (PlanStage::ADVANCED != state) {
+        _hasBatchState = true;
+        _batchState = state;
+        _batchStateId = *out;
+    }
+
+    _batchResults.assign(_batchScratch.begin() + 1, _batchScratch.end());
+    *out = _batchScratch.front();
+    return PlanStage::ADVANCED;
+}
+
 bool PlanExecutor::isEOF() {
     invariant(_currentState == kUsable);
-    return killed() || (_stash.empty() && _root->isEOF());
+    return killed() ||
+        (_stash.empty() && _batchResults.empty() && !_hasBatchState && _root->isEOF());
 }
 
 void PlanExecutor::registerExec() {
@@ -29,9 +29,13 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 #include <queue>
+#include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/storage/snapshot.h"
@@ -41,7 +45,6 @@ namespace mongo {
 class BSONObj;
 class Collection;
 class RecordId;
-class PlanStage;
 class PlanExecutor;
 struct PlanStageStats;
 class PlanYieldPolicy;
@@ -372,6 +375,13 @@ public:
 private:
     ExecState getNextImpl(Snapshotted<BSONObj>* objOut, RecordId* dlOut);
 
+    /**
+     * Produces the next result of the plan the same way _root->work() does. When the plan
+     * supports it and internalQueryExecBatchSize allows, results are pulled from the plan in
+     * batches with workBatch() and handed out one at a time from here.
+     */
+    PlanStage::StageState workRoot(WorkingSetID* out);
+
     /**
      * RAII approach to ensuring that plan executors are deregistered.
      *
@@ -463,6 +473,16 @@ private:
     // stages.
     std::queue<BSONObj> _stash;
 
+    // Results of the last batch pulled from the plan with workBatch() which have not been
+    // returned yet, and the state that batch ended with if it was not ADVANCED.
+    std::deque<WorkingSetID> _batchResults;
+    bool _hasBatchState = false;
+    PlanStage::StageState _batchState = PlanStage::ADVANCED;
+    WorkingSetID _batchStateId = WorkingSet::INVALID_ID;
+
+    // Reused to receive batches from the plan.
+    std::vector<WorkingSetID> _batchScratch;
+
     enum { kUsable, kSaved, kDetached } _currentState = kUsable;
 
     bool _everDetachedFromOperationContext = false;
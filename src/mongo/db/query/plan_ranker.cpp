@@ -40,6 +40,7 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/explain.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/server_options.h"
@@ -57,6 +58,67 @@ bool scoreComparator(const std::pair<double, size_t>& lhs, const std::pair<doubl
     return lhs.first > rhs.first;
 }
 
+// Costs relative to examining one index key.
+const double kDocumentScanCost = 1.0;
+const double kFetchCost = 4.0;
+
+struct CostEstimate {
+    double cost;
+    double results;
+};
+
+boost::optional<CostEstimate> estimateNode(const mongo::QuerySolutionNode* node,
+                                           long long numRecords) {
+    using namespace mongo;
+
+    switch (node->getType()) {
+        case STAGE_COLLSCAN:
+            return CostEstimate{numRecords * kDocumentScanCost, static_cast<double>(numRecords)};
+        case STAGE_IXSCAN: {
+            const IndexScanNode* isn = static_cast<const IndexScanNode*>(node);
+            if (!isn->indexStatistics)
+                return boost::none;
+            auto keys = isn->indexStatistics->estimateKeys(isn->bounds, numRecords);
+            if (!keys)
+                return boost::none;
+            // Even an empty scan has to seek into the index.
+            const double examined = std::max(1.0, *keys);
+            return CostEstimate{examined, examined};
+        }
+        case STAGE_FETCH: {
+            auto child = estimateNode(node->children[0], numRecords);
+            if (!child)
+                return boost::none;
+            return CostEstimate{child->cost + child->results * kFetchCost, child->results};
+        }
+        case STAGE_OR:
+        case STAGE_SORT_MERGE:
+        case STAGE_AND_HASH:
+        case STAGE_AND_SORTED: {
+            const bool intersect =
+                node->getType() == STAGE_AND_HASH || node->getType() == STAGE_AND_SORTED;
+            CostEstimate total{0, intersect ? static_cast<double>(numRecords) : 0};
+            for (auto&& child : node->children) {
+                auto estimate = estimateNode(child, numRecords);
+                if (!estimate)
+                    return boost::none;
+                total.cost += estimate->cost;
+                total.results = intersect ? std::min(total.results, estimate->results)
+                                          : total.results + estimate->results;
+            }
+            total.results = std::min<double>(total.results, numRecords);
+            return total;
+        }
+        case STAGE_PROJECTION:
+        case STAGE_SHARDING_FILTER:
+        case STAGE_KEEP_MUTATIONS:
+            return estimateNode(node->children[0], numRecords);
+        default:
+            // Blocking sorts, limits and the like make the cost depend on more than the scans.
+            return boost::none;
+    }
+}
+
 }  // namespace
 
 namespace mongo {
@@ -160,6 +222,48 @@ size_t PlanRanker::pickBestPlan(const vector<CandidatePlan>& candidates, PlanRan
     return bestChild;
 }
 
+// static
+boost::optional<size_t> PlanRanker::pickBestPlanByCost(const vector<QuerySolution*>& solutions,
+                                                       long long numRecords) {
+    if (solutions.size() < 2)
+        return boost::none;
+
+    vector<double> costs;
+    for (auto&& solution : solutions) {
+        auto cost = estimateCost(solution->root.get(), numRecords);
+        if (!cost) {
+            LOG(5) << "No cost estimate for solution, plans have to be ranked by running them: "
+                   << solution->toString();
+            return boost::none;
+        }
+        costs.push_back(*cost);
+    }
+
+    const size_t best = std::min_element(costs.begin(), costs.end()) - costs.begin();
+    double runnerUp = -1;
+    for (size_t i = 0; i < costs.size(); ++i) {
+        if (i != best && (runnerUp < 0 || costs[i] < runnerUp)) {
+            runnerUp = costs[i];
+        }
+    }
+
+    const double ratio = internalQueryCostBasedPlanSelectionMinRatio.load();
+    LOG(2) << "Estimated cost of the cheapest plan " << costs[best] << ", of the runner-up "
+           << runnerUp << ", required ratio " << ratio;
+    if (runnerUp < costs[best] * ratio)
+        return boost::none;
+    return best;
+}
+
+// static
+boost::optional<double> PlanRanker::estimateCost(const QuerySolutionNode* node,
+                                                 long long numRecords) {
+    auto estimate = estimateNode(node, numRecords);
+    if (!estimate)
+        return boost::none;
+    return estimate->cost;
+}
+
 // TODO: Move this out.  This is a signal for ranking but will become its own complicated
 // stats-collecting beast.
 double computeSelectivity(const PlanStageStats* stats) {
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <list>
 #include <memory>
 #include <vector>
@@ -62,6 +63,26 @@ public:
      * the plan. The exact value isn't meaningful except for imposing a ranking.
      */
     static double scoreTree(const PlanStageStats* stats);
+
+    /**
+     * Estimates the cost of each of 'solutions' over a collection of 'numRecords' documents,
+     * from the statistics of the indexes they scan, and returns the index of the cheapest one if
+     * it is estimated to be at least internalQueryCostBasedPlanSelectionMinRatio times cheaper
+     * than every other solution.
+     *
+     * Returns boost::none if any solution can't be estimated, for instance because it scans an
+     * index which was never analyzed or has a blocking stage, or if no solution stands out. The
+     * plans then have to be ranked by running them.
+     */
+    static boost::optional<size_t> pickBestPlanByCost(const std::vector<QuerySolution*>& solutions,
+                                                      long long numRecords);
+
+    /**
+     * Estimates the cost of executing the tree rooted at 'node', in units of index keys
+     * examined, or returns boost::none if it can't be estimated.
+     */
+    static boost::optional<double> estimateCost(const QuerySolutionNode* node,
+                                                long long numRecords);
 };
 
 /**
@@ -41,7 +41,9 @@
 #include "mongo/db/matcher/expression_text.h"
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/index_bounds_builder.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/index_tag.h"
+#include "mongo/db/query/planner_ixselect.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_common.h"
@@ -52,6 +54,18 @@ namespace {
 
 using namespace mongo;
 
+// A skip scan lands on a couple of keys for each distinct value of the leading field, so it only
+// beats scanning the whole index if every leading value has many more keys than that.
+const double kMinKeysPerSkippedValue = 10;
+
+bool isAllValues(const OrderedIntervalList& oil) {
+    if (oil.intervals.size() != 1) {
+        return false;
+    }
+    const Interval& interval = oil.intervals[0];
+    return MinKey == interval.start.type() && MaxKey == interval.end.type();
+}
+
 /**
  * Text node functors.
  */
@@ -124,10 +138,12 @@ QuerySolutionNode* QueryPlannerAccess::makeCollectionScan(const CanonicalQuery&
     csn->maxScan = query.getParsed().getMaxScan();
 
     // If the hint is {$natural: +-1} this changes the direction of the collection scan.
+    bool naturalOrder = false;
     if (!query.getParsed().getHint().isEmpty()) {
         BSONElement natural = query.getParsed().getHint().getFieldDotted("$natural");
         if (!natural.eoo()) {
             csn->direction = natural.numberInt() >= 0 ? 1 : -1;
+            naturalOrder = true;
         }
     }
 
@@ -138,9 +154,22 @@ QuerySolutionNode* QueryPlannerAccess::makeCollectionScan(const CanonicalQuery&
         BSONElement natural = sortObj.getFieldDotted("$natural");
         if (!natural.eoo()) {
             csn->direction = natural.numberInt() >= 0 ? 1 : -1;
+            naturalOrder = true;
         }
     }
 
+    // The partitions of a parallel scan are read forward, and $where runs on the thread of the
+    // query. Scans of queries with a limit stay serial too, as they are likely to stop long before
+    // the end of the collection.
+    const int maxDegree = internalQueryParallelCollectionScanMaxDegree;
+    if ((params.options & QueryPlannerParams::PARALLEL_COLLSCAN) && maxDegree > 1 && !tailable &&
+        0 == csn->maxScan && 1 == csn->direction && !query.getParsed().getLimit() &&
+        !query.getParsed().getNToReturn() &&
+        !QueryPlannerCommon::hasNode(query.root(), MatchExpression::WHERE)) {
+        csn->maxParallelism = maxDegree;
+        csn->parallelOrdered = naturalOrder;
+    }
+
     return csn;
 }
 
@@ -205,6 +234,7 @@ QuerySolutionNode* QueryPlannerAccess::makeLeafNode(
         IndexScanNode* isn = new IndexScanNode();
         isn->indexKeyPattern = index.keyPattern;
         isn->indexIsMultiKey = index.multikey;
+        isn->indexStatistics = index.statistics;
         isn->bounds.fields.resize(index.keyPattern.nFields());
         isn->maxScan = query.getParsed().getMaxScan();
         isn->addKeyMetadata = query.getParsed().returnKey();
@@ -1236,6 +1266,7 @@ QuerySolutionNode* QueryPlannerAccess::scanWholeIndex(const IndexEntry& index,
     unique_ptr<IndexScanNode> isn = make_unique<IndexScanNode>();
     isn->indexKeyPattern = index.keyPattern;
     isn->indexIsMultiKey = index.multikey;
+    isn->indexStatistics = index.statistics;
     isn->maxScan = query.getParsed().getMaxScan();
     isn->addKeyMetadata = query.getParsed().returnKey();
 
@@ -1263,6 +1294,92 @@ QuerySolutionNode* QueryPlannerAccess::scanWholeIndex(const IndexEntry& index,
     return solnRoot;
 }
 
+// static
+QuerySolutionNode* QueryPlannerAccess::makeSkipScan(const IndexEntry& index,
+                                                    const CanonicalQuery& query,
+                                                    const QueryPlannerParams& params) {
+    if (INDEX_BTREE != index.type || index.multikey || index.sparse || index.filterExpr ||
+        index.keyPattern.nFields() < 2 || !index.statistics) {
+        return NULL;
+    }
+
+    const double leadingValues = index.statistics->distinctLeadingValues();
+    if (leadingValues < 1 || leadingValues > internalQueryPlannerSkipScanMaxLeadingValues ||
+        leadingValues * kMinKeysPerSkippedValue > index.statistics->numKeys()) {
+        return NULL;
+    }
+
+    // Queries over the leading field get regular index scans.
+    MatchExpression* root = query.root();
+    BSONObjIterator it(index.keyPattern);
+    const BSONElement leadingElt = it.next();
+    unordered_set<std::string> fields;
+    QueryPlannerIXSelect::getFields(root, "", &fields);
+    if (fields.count(leadingElt.fieldName())) {
+        return NULL;
+    }
+
+    // Only the predicates of a top-level AND can bound the scan.
+    vector<MatchExpression*> predicates;
+    if (MatchExpression::AND == root->matchType()) {
+        for (size_t i = 0; i < root->numChildren(); ++i) {
+            predicates.push_back(root->getChild(i));
+        }
+    } else {
+        predicates.push_back(root);
+    }
+
+    unique_ptr<IndexScanNode> isn = make_unique<IndexScanNode>();
+    isn->indexKeyPattern = index.keyPattern;
+    isn->indexIsMultiKey = index.multikey;
+    isn->indexStatistics = index.statistics;
+    isn->maxScan = query.getParsed().getMaxScan();
+    isn->addKeyMetadata = query.getParsed().returnKey();
+    isn->bounds.fields.resize(index.keyPattern.nFields());
+    IndexBoundsBuilder::allValuesForField(leadingElt, &isn->bounds.fields[0]);
+
+    bool constrained = false;
+    for (size_t field = 1; it.more(); ++field) {
+        const BSONElement kpElt = it.next();
+        OrderedIntervalList* oil = &isn->bounds.fields[field];
+
+        bool bounded = false;
+        for (auto&& predicate : predicates) {
+            if (predicate->path() != kpElt.fieldNameStringData() || predicate->isArray() ||
+                !Indexability::nodeCanUseIndexOnOwnField(predicate) ||
+                !QueryPlannerIXSelect::compatible(kpElt, index, predicate)) {
+                continue;
+            }
+
+            // The fetch applies the whole query, so the bounds don't have to be exact.
+            IndexBoundsBuilder::BoundsTightness tightness;
+            if (bounded) {
+                IndexBoundsBuilder::translateAndIntersect(predicate, kpElt, index, oil, &tightness);
+            } else {
+                IndexBoundsBuilder::translate(predicate, kpElt, index, oil, &tightness);
+                bounded = true;
+            }
+        }
+
+        if (!bounded) {
+            IndexBoundsBuilder::allValuesForField(kpElt, oil);
+        } else if (!isAllValues(*oil)) {
+            constrained = true;
+        }
+    }
+
+    if (!constrained) {
+        return NULL;
+    }
+
+    IndexBoundsBuilder::alignBounds(&isn->bounds, index.keyPattern);
+
+    unique_ptr<FetchNode> fetch = make_unique<FetchNode>();
+    fetch->filter = root->shallowClone();
+    fetch->children.push_back(isn.release());
+    return fetch.release();
+}
+
 // static
 void QueryPlannerAccess::addFilterToSolutionNode(QuerySolutionNode* node,
                                                  MatchExpression* match,
@@ -1372,6 +1489,7 @@ QuerySolutionNode* QueryPlannerAccess::makeIndexScan(const IndexEntry& index,
     IndexScanNode* isn = new IndexScanNode();
     isn->indexKeyPattern = index.keyPattern;
     isn->indexIsMultiKey = index.multikey;
+    isn->indexStatistics = index.statistics;
     isn->direction = 1;
     isn->maxScan = query.getParsed().getMaxScan();
     isn->addKeyMetadata = query.getParsed().returnKey();
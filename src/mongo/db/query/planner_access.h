@@ -197,6 +197,16 @@ public:
                                              const QueryPlannerParams& params,
                                              int direction = 1);
 
+    /**
+     * Return a plan that scans 'index' for the predicates of 'query' over the fields after its
+     * leading field, skipping from one distinct value of the leading field to the next. Returns
+     * NULL unless the query leaves the leading field unconstrained, constrains a further field,
+     * and the statistics of the index show few distinct leading values with many keys each.
+     */
+    static QuerySolutionNode* makeSkipScan(const IndexEntry& index,
+                                           const CanonicalQuery& query,
+                                           const QueryPlannerParams& params);
+
     /**
      * Return a plan that scans the provided index from [startKey to endKey).
      */
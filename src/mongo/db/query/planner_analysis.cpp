@@ -210,6 +210,7 @@ void explodeScan(IndexScanNode* isn,
         child->maxScan = isn->maxScan;
         child->addKeyMetadata = isn->addKeyMetadata;
         child->indexIsMultiKey = isn->indexIsMultiKey;
+        child->indexStatistics = isn->indexStatistics;
 
         // Copy the filter, if there is one.
         if (isn->filter.get()) {
@@ -44,6 +44,12 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheFeedbacksStored, int, 20);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheEvictionRatio, double, 10.0);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheReevaluationWindow, int, 20);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheReevaluationRatio, double, 10.0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheBackgroundReevaluation, bool, true);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerMaxIndexedSolutions, int, 64);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnumerationMaxOrSolutions, int, 10);
@@ -56,14 +62,34 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableIndexIntersection, bool,
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableHashIntersection, bool, false);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCostBasedPlanSelection, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCostBasedPlanSelectionMinRatio, double, 4.0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheParameterizedPlans, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryIndexStatisticsSampleSize, int, 10000);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanOrChildrenIndependently, bool, true);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerSkipScanMaxLeadingValues, int, 1000);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1024 * 1024);
 
 // Yield every 128 cycles or 10ms.
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBatchSize, int, 1);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCompileMatchExpressions, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryFetchReadAheadWindow, int, 0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanMaxDegree, int, 1);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanMinRecords, int, 100000);
+
 }  // namespace mongo
@@ -58,6 +58,21 @@ extern std::atomic<bool> internalQueryPlannerEnableIndexIntersection;  // NOLINT
 // Do we use hash-based intersection for rooted $and queries?
 extern std::atomic<bool> internalQueryPlannerEnableHashIntersection;  // NOLINT
 
+// Do we pick a plan from index statistics, without a trial run, when the cost estimates tell the
+// plans clearly apart?
+extern std::atomic<bool> internalQueryCostBasedPlanSelection;  // NOLINT
+
+// How many times cheaper than every other plan must the cheapest plan be estimated to be picked
+// without a trial run?
+extern AtomicDouble internalQueryCostBasedPlanSelectionMinRatio;  // NOLINT
+
+// Do we parameterize cached solutions, so that queries of the same shape get theirs by
+// substituting their values rather than by running the planner?
+extern std::atomic<bool> internalQueryCacheParameterizedPlans;  // NOLINT
+
+// How many keys are sampled by analyzeIndexes when the command doesn't specify it?
+extern std::atomic<int> internalQueryIndexStatisticsSampleSize;  // NOLINT
+
 //
 // plan cache
 //
@@ -73,6 +88,16 @@ extern std::atomic<int> internalQueryCacheFeedbacksStored;  // NOLINT
 // and replanning?
 extern AtomicDouble internalQueryCacheEvictionRatio;  // NOLINT
 
+// Over how many completed executions do we compare a cached plan with its first executions?
+extern std::atomic<int> internalQueryCacheReevaluationWindow;  // NOLINT
+
+// How many times more keys and documents per result must a window of executions examine than the
+// first one for the cached plan to be considered degraded?
+extern AtomicDouble internalQueryCacheReevaluationRatio;  // NOLINT
+
+// Do we evaluate the alternative plans of degraded cache entries again in the background?
+extern std::atomic<bool> internalQueryCacheBackgroundReevaluation;  // NOLINT
+
 //
 // Planning and enumeration.
 //
@@ -93,6 +118,10 @@ extern std::atomic<bool> internalQueryPlanOrChildrenIndependently;  // NOLINT
 // during explodeForSort?
 extern std::atomic<int> internalQueryMaxScansToExplode;  // NOLINT
 
+// How many distinct values may the leading field of a compound index have at most, for the planner
+// to skip from one to the next to answer predicates over the other fields of the index?
+extern std::atomic<int> internalQueryPlannerSkipScanMaxLeadingValues;  // NOLINT
+
 //
 // Query execution.
 //
@@ -105,6 +134,25 @@ extern std::atomic<int> internalQueryExecYieldIterations;  // NOLINT
 // Yield if it's been at least this many milliseconds since we last yielded.
 extern std::atomic<int> internalQueryExecYieldPeriodMS;  // NOLINT
 
+// How many results to pull through the plan at once, for plans made up of stages which support
+// batches. Values of 1 or less execute one result at a time.
+extern std::atomic<int> internalQueryExecBatchSize;  // NOLINT
+
+// Whether collection scans and fetches evaluate their filters in compiled form where possible.
+extern std::atomic<bool> internalQueryCompileMatchExpressions;  // NOLINT
+
+// How many results a fetch stage collects from its child ahead of time, so that the storage
+// engine can start reading their documents in the background. Values of 1 or less turn this
+// read-ahead off.
+extern std::atomic<int> internalQueryFetchReadAheadWindow;  // NOLINT
+
+// How many partitions of a collection do the collection scans of finds and aggregations read in
+// parallel at most? Values of 1 or less read every collection on the thread running the query.
+extern std::atomic<int> internalQueryParallelCollectionScanMaxDegree;  // NOLINT
+
+// How many documents does a collection need before its scans are read in parallel?
+extern std::atomic<int> internalQueryParallelCollectionScanMinRecords;  // NOLINT
+
 // Limit the size that we write without yielding to 16MB / 64 (max expected number of indexes)
 const int64_t insertVectorMaxBytes = 256 * 1024;
 
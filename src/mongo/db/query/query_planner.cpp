@@ -228,6 +228,16 @@ QuerySolution* buildWholeIXSoln(const IndexEntry& index,
     return QueryPlannerAnalysis::analyzeDataAccess(query, params, solnRoot);
 }
 
+QuerySolution* buildSkipScanSoln(const IndexEntry& index,
+                                 const CanonicalQuery& query,
+                                 const QueryPlannerParams& params) {
+    QuerySolutionNode* solnRoot = QueryPlannerAccess::makeSkipScan(index, query, params);
+    if (NULL == solnRoot) {
+        return NULL;
+    }
+    return QueryPlannerAnalysis::analyzeDataAccess(query, params, solnRoot);
+}
+
 bool providesSort(const CanonicalQuery& query, const BSONObj& kp) {
     return query.getParsed().getSort().isPrefixOf(kp);
 }
@@ -354,6 +364,14 @@ Status QueryPlanner::planFromCache(const CanonicalQuery& query,
             *out = soln;
             return Status::OK();
         }
+    } else if (SolutionCacheData::SKIP_IXSCAN_SOLN == winnerCacheData.solnType) {
+        QuerySolution* soln = buildSkipScanSoln(*winnerCacheData.tree->entry, query, params);
+        if (soln == NULL) {
+            return Status(ErrorCodes::BadValue, "plan cache error: skip index scan soln");
+        } else {
+            *out = soln;
+            return Status::OK();
+        }
     } else if (SolutionCacheData::COLLSCAN_SOLN == winnerCacheData.solnType) {
         // The cached solution is a collection scan. We don't cache collscans
         // with tailable==true, hence the false below.
@@ -812,6 +830,34 @@ Status QueryPlanner::plan(const CanonicalQuery& query,
         return Status::OK();
     }
 
+    // A compound index whose leading field the query doesn't constrain can still answer the
+    // predicates over its other fields, by skipping from one leading value to the next.
+    size_t numSkipScans = 0;
+    if (!QueryPlannerCommon::hasNode(query.root(), MatchExpression::GEO_NEAR) &&
+        !QueryPlannerCommon::hasNode(query.root(), MatchExpression::TEXT)) {
+        for (size_t i = 0; i < params.indices.size(); ++i) {
+            if (out->size() >= params.maxIndexedSolutions) {
+                break;
+            }
+
+            QuerySolution* soln = buildSkipScanSoln(params.indices[i], query, params);
+            if (NULL == soln) {
+                continue;
+            }
+
+            LOG(5) << "Planner: outputting soln that skips over leading values of index "
+                   << params.indices[i].keyPattern << endl;
+            PlanCacheIndexTree* indexTree = new PlanCacheIndexTree();
+            indexTree->setIndexEntry(params.indices[i]);
+            SolutionCacheData* scd = new SolutionCacheData();
+            scd->tree.reset(indexTree);
+            scd->solnType = SolutionCacheData::SKIP_IXSCAN_SOLN;
+            soln->cacheData.reset(scd);
+            out->push_back(soln);
+            ++numSkipScans;
+        }
+    }
+
     // If a sort order is requested, there may be an index that provides it, even if that
     // index is not over any predicates in the query.
     //
@@ -907,7 +953,9 @@ Status QueryPlanner::plan(const CanonicalQuery& query,
     bool collscanRequested = (params.options & QueryPlannerParams::INCLUDE_COLLSCAN);
 
     // No indexed plans?  We must provide a collscan if possible or else we can't run the query.
-    bool collscanNeeded = (0 == out->size() && canTableScan);
+    // Skip scans only pay off if the predicates over the later fields are selective, so they
+    // don't replace the collscan.
+    bool collscanNeeded = (numSkipScans == out->size() && canTableScan);
 
     if (possibleToCollscan && (collscanRequested || collscanNeeded)) {
         QuerySolution* collscan = buildCollscanSoln(query, isTailable, params);
@@ -95,6 +95,11 @@ struct QueryPlannerParams {
         // Set this if you don't want any plans with a non-covered projection stage. All projections
         // must be provided/covered by an index.
         NO_UNCOVERED_PROJECTIONS = 1 << 10,
+
+        // Set this if a collection scan may read partitions of the collection in parallel. Only
+        // for queries which don't modify the documents they read, as the partitions are read on
+        // other threads, each from its own snapshot.
+        PARALLEL_COLLSCAN = 1 << 11,
     };
 
     // See Options enum above.
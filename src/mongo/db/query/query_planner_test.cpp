@@ -34,6 +34,8 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
+#include "mongo/db/query/index_statistics.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_test_fixture.h"
 
@@ -2247,6 +2249,47 @@ TEST_F(QueryPlannerTest, NaturalSortAndHint) {
     assertSolutionExists("{cscan: {dir: 1}}");
 }
 
+TEST_F(QueryPlannerTest, ParallelCollectionScan) {
+    const int oldMaxDegree = internalQueryParallelCollectionScanMaxDegree.load();
+    internalQueryParallelCollectionScanMaxDegree.store(4);
+    params.options = QueryPlannerParams::PARALLEL_COLLSCAN;
+
+    auto collectionScan = [this]() {
+        ASSERT_EQUALS(STAGE_COLLSCAN, solns[0]->root->getType());
+        return static_cast<const CollectionScanNode*>(solns[0]->root.get());
+    };
+
+    runQuery(fromjson("{a: {$gt: 1}}"));
+    assertNumSolutions(1U);
+    ASSERT_EQUALS(4, collectionScan()->maxParallelism);
+    ASSERT_FALSE(collectionScan()->parallelOrdered);
+
+    // A $natural sort asks for the partitions to be returned in order.
+    runQuerySortHint(fromjson("{a: {$gt: 1}}"), BSON("$natural" << 1), BSONObj());
+    assertNumSolutions(1U);
+    ASSERT_EQUALS(4, collectionScan()->maxParallelism);
+    ASSERT_TRUE(collectionScan()->parallelOrdered);
+
+    // Reverse scans, limits and $where stay serial.
+    runQuerySortHint(fromjson("{a: {$gt: 1}}"), BSON("$natural" << -1), BSONObj());
+    ASSERT_EQUALS(1, collectionScan()->maxParallelism);
+    runQuerySkipLimit(fromjson("{a: {$gt: 1}}"), 0, 5);
+    ASSERT_EQUALS(1, collectionScan()->maxParallelism);
+    runQuery(fromjson("{$where: 'this.a > 1'}"));
+    ASSERT_EQUALS(1, collectionScan()->maxParallelism);
+
+    // Without the option, or with the knob at 1, the scan stays serial.
+    params.options = QueryPlannerParams::DEFAULT;
+    runQuery(fromjson("{a: {$gt: 1}}"));
+    ASSERT_EQUALS(1, collectionScan()->maxParallelism);
+    params.options = QueryPlannerParams::PARALLEL_COLLSCAN;
+    internalQueryParallelCollectionScanMaxDegree.store(1);
+    runQuery(fromjson("{a: {$gt: 1}}"));
+    ASSERT_EQUALS(1, collectionScan()->maxParallelism);
+
+    internalQueryParallelCollectionScanMaxDegree.store(oldMaxDegree);
+}
+
 TEST_F(QueryPlannerTest, HintOverridesNaturalSort) {
     addIndex(BSON("x" << 1));
     runQuerySortHint(fromjson("{x: {$exists: true}}"), BSON("$natural" << -1), BSON("x" << 1));
@@ -4176,4 +4219,96 @@ TEST_F(QueryPlannerTest, NToReturnHackWithSingleBatch) {
         "{cscan: {dir:1, filter: {}}}}}}}");
 }
 
+//
+// Skip scans
+//
+
+/**
+ * Statistics of an index over {a, b} with 'numLeadingValues' distinct values of 'a', each with
+ * 100 keys.
+ */
+std::shared_ptr<const IndexStatistics> makeStatistics(int numLeadingValues) {
+    std::vector<BSONObj> sample;
+    for (int i = 0; i < numLeadingValues * 100; i++) {
+        sample.push_back(BSON("" << (i % numLeadingValues) << "" << i));
+    }
+    const long long numKeys = sample.size();
+    return std::make_shared<const IndexStatistics>(
+        IndexStatistics::build(std::move(sample), numKeys, numKeys));
+}
+
+TEST_F(QueryPlannerTest, SkipScanOverLowCardinalityLeadingField) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.indices.back().statistics = makeStatistics(10);
+
+    runQuery(fromjson("{b: 5, c: 1}"));
+
+    // The skip scan competes with the collection scan.
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {b: 5, c: 1}}}");
+    assertSolutionExists(
+        "{fetch: {filter: {b: 5, c: 1}, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [['MinKey','MaxKey',true,true]], b: [[5,5,true,true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanOverSeveralTrailingFields) {
+    addIndex(BSON("a" << 1 << "b" << 1 << "c" << 1));
+    params.indices.back().statistics = makeStatistics(10);
+
+    runQuery(fromjson("{b: {$gt: 5, $lt: 10}, c: {$in: [1, 2]}}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists(
+        "{fetch: {filter: {$and: [{b: {$lt: 10}}, {b: {$gt: 5}}, {c: {$in: [1, 2]}}]}, "
+        "node: {ixscan: {pattern: {a: 1, b: 1, c: 1}, bounds: "
+        "{a: [['MinKey','MaxKey',true,true]], b: [[5,10,false,false]], "
+        "c: [[1,1,true,true], [2,2,true,true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, NoSkipScanWhenLeadingFieldIsConstrained) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.indices.back().statistics = makeStatistics(10);
+
+    runQuery(fromjson("{a: {$gt: 1}, b: 5}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {a: {$gt: 1}, b: 5}}}");
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [[1,Infinity,false,true]], b: [[5,5,true,true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, NoSkipScanWithoutLowCardinalityStatistics) {
+    // Without statistics, the cardinality of the leading field is unknown.
+    addIndex(BSON("a" << 1 << "b" << 1));
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {b: 5}}}");
+
+    // Too many distinct leading values.
+    const int oldMaxLeadingValues = internalQueryPlannerSkipScanMaxLeadingValues.load();
+    internalQueryPlannerSkipScanMaxLeadingValues.store(5);
+    params.indices.back().statistics = makeStatistics(10);
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {b: 5}}}");
+    internalQueryPlannerSkipScanMaxLeadingValues.store(oldMaxLeadingValues);
+
+    // Predicates which don't bound the later fields.
+    params.indices.back().statistics = makeStatistics(10);
+    runQuery(fromjson("{b: {$exists: true}, c: 5}"));
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {b: {$exists: true}, c: 5}}}");
+}
+
+TEST_F(QueryPlannerTest, NoSkipScanOverMultikeyIndex) {
+    addIndex(BSON("a" << 1 << "b" << 1), true);
+    params.indices.back().statistics = makeStatistics(10);
+
+    runQuery(fromjson("{b: 5}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {b: 5}}}");
+}
+
 }  // namespace
@@ -105,7 +105,8 @@ QuerySolutionNode* TextNode::clone() const {
 // CollectionScanNode
 //
 
-CollectionScanNode::CollectionScanNode() : tailable(false), direction(1), maxScan(0) {}
+CollectionScanNode::CollectionScanNode()
+    : tailable(false), direction(1), maxScan(0), maxParallelism(1), parallelOrdered(false) {}
 
 void CollectionScanNode::appendToString(mongoutils::str::stream* ss, int indent) const {
     addIndent(ss, indent);
@@ -116,6 +117,11 @@ void CollectionScanNode::appendToString(mongoutils::str::stream* ss, int indent)
         addIndent(ss, indent + 1);
         *ss << "filter = " << filter->toString();
     }
+    if (maxParallelism > 1) {
+        addIndent(ss, indent + 1);
+        *ss << "maxParallelism = " << maxParallelism << (parallelOrdered ? ", ordered" : "")
+            << '\n';
+    }
     addCommon(ss, indent);
 }
 
@@ -128,6 +134,8 @@ QuerySolutionNode* CollectionScanNode::clone() const {
     copy->tailable = this->tailable;
     copy->direction = this->direction;
     copy->maxScan = this->maxScan;
+    copy->maxParallelism = this->maxParallelism;
+    copy->parallelOrdered = this->parallelOrdered;
 
     return copy;
 }
@@ -580,6 +588,7 @@ QuerySolutionNode* IndexScanNode::clone() const {
     copy->_sorts = this->_sorts;
     copy->indexKeyPattern = this->indexKeyPattern;
     copy->indexIsMultiKey = this->indexIsMultiKey;
+    copy->indexStatistics = this->indexStatistics;
     copy->direction = this->direction;
     copy->maxScan = this->maxScan;
     copy->addKeyMetadata = this->addKeyMetadata;
@@ -40,6 +40,7 @@
 namespace mongo {
 
 class GeoNearExpression;
+class IndexStatistics;
 
 /**
  * This is an abstract representation of a query plan.  It can be transcribed into a tree of
@@ -290,6 +291,12 @@ struct CollectionScanNode : public QuerySolutionNode {
 
     // maxScan option to .find() limits how many docs we look at.
     int maxScan;
+
+    // How many partitions of the collection may be read in parallel. 1 if the scan is serial.
+    int maxParallelism;
+
+    // Whether a parallel scan has to return the documents in their natural order.
+    bool parallelOrdered;
 };
 
 struct AndHashNode : public QuerySolutionNode {
@@ -462,6 +469,9 @@ struct IndexScanNode : public QuerySolutionNode {
     BSONObj indexKeyPattern;
     bool indexIsMultiKey;
 
+    // Statistics of the index, if it was analyzed. Only used to estimate the cost of the scan.
+    std::shared_ptr<const IndexStatistics> indexStatistics;
+
     int direction;
 
     // maxScan option to .find() limits how many docs we look at.
@@ -46,6 +46,7 @@
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/sort.h"
@@ -78,6 +79,10 @@ PlanStage* buildStages(OperationContext* txn,
         params.direction =
             (csn->direction == 1) ? CollectionScanParams::FORWARD : CollectionScanParams::BACKWARD;
         params.maxScan = csn->maxScan;
+        if (csn->maxParallelism > 1) {
+            return new ParallelCollectionScan(
+                txn, collection, csn->maxParallelism, csn->parallelOrdered, ws, csn->filter.get());
+        }
         return new CollectionScan(txn, params, ws, csn->filter.get());
     } else if (STAGE_IXSCAN == root->getType()) {
         const IndexScanNode* ixn = static_cast<const IndexScanNode*>(root);
@@ -87,6 +87,10 @@ enum StageType {
     STAGE_MULTI_PLAN,
     STAGE_OPLOG_START,
     STAGE_OR,
+
+    // Reads the partitions of a collection scan on other threads.
+    STAGE_PARALLEL_COLLSCAN,
+
     STAGE_PROJECTION,
 
     // Stage for running aggregation pipelines.
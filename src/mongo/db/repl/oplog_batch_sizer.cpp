@@ -0,0 +1,94 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_batch_sizer.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace repl {
+
+OplogBatchSizer::OplogBatchSizer(size_t minOps, size_t maxOps)
+    : _minOps(minOps), _maxOps(maxOps), _limit(maxOps) {
+    invariant(_minOps > 0);
+    invariant(_maxOps >= _minOps);
+}
+
+size_t OplogBatchSizer::getLimit() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _limit;
+}
+
+void OplogBatchSizer::recordBatch(size_t ops, long long applyMicros, long long targetMicros) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _lastBatchOps = ops;
+    _lastApplyMicros = applyMicros;
+    _targetMicros = targetMicros;
+
+    if (targetMicros <= 0) {
+        _limit = _maxOps;
+        return;
+    }
+
+    if (applyMicros > targetMicros && ops >= _limit) {
+        const size_t limit = std::max(_minOps, _limit - _limit / 4);
+        if (limit < _limit) {
+            _limit = limit;
+            _decreases++;
+        }
+    } else if (applyMicros < targetMicros / 2 && ops >= _limit) {
+        const size_t limit = std::min(_maxOps, _limit + std::max<size_t>(1, _limit / 4));
+        if (limit > _limit) {
+            _limit = limit;
+            _increases++;
+        }
+    }
+}
+
+BSONObj OplogBatchSizer::getReport() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    BSONObjBuilder b;
+    b.append("limitOps", static_cast<long long>(_limit));
+    b.append("minOps", static_cast<long long>(_minOps));
+    b.append("maxOps", static_cast<long long>(_maxOps));
+    b.append("targetMicros", _targetMicros);
+    b.append("lastBatchOps", _lastBatchOps);
+    b.append("lastApplyMicros", _lastApplyMicros);
+    b.append("increases", _increases);
+    b.append("decreases", _decreases);
+    return b.obj();
+}
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,94 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Adapts the number of operations in an oplog application batch to the time batches take to
+ * apply.
+ *
+ * Batches which fill up to the limit and take longer than the target time to apply hold back the
+ * next batch, whose operations are already fetched, and delay the point at which their writes
+ * become visible. They shrink the limit multiplicatively. Batches which fill up to the limit and
+ * apply in less than half of the target grow it, so that the per batch overhead is amortized over
+ * more operations. Batches below the limit say nothing about it, since they are cut short by a
+ * lack of operations, a command or the time limit on building a batch.
+ */
+class OplogBatchSizer {
+    MONGO_DISALLOW_COPYING(OplogBatchSizer);
+
+public:
+    /**
+     * The limit starts out at 'maxOps' and stays within [minOps, maxOps].
+     */
+    OplogBatchSizer(size_t minOps, size_t maxOps);
+
+    /**
+     * Returns the current maximum number of operations in a batch.
+     */
+    size_t getLimit() const;
+
+    /**
+     * Records that a batch of 'ops' operations took 'applyMicros' to apply and adjusts the limit
+     * towards 'targetMicros'. A target of 0 or less disables the adaptation and resets the limit
+     * to its maximum.
+     */
+    void recordBatch(size_t ops, long long applyMicros, long long targetMicros);
+
+    /**
+     * Reports the current limit, the last batch and the number of adjustments made.
+     */
+    BSONObj getReport() const;
+    operator BSONObj() const {
+        return getReport();
+    }
+
+private:
+    const size_t _minOps;
+    const size_t _maxOps;
+
+    mutable stdx::mutex _mutex;
+    size_t _limit;
+    long long _lastBatchOps = 0;
+    long long _lastApplyMicros = 0;
+    long long _targetMicros = 0;
+    long long _increases = 0;
+    long long _decreases = 0;
+};
+
+}  // namespace repl
+}  // namespace mongo
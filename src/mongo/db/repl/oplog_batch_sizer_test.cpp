@@ -0,0 +1,103 @@
+/*    Copyright 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/repl/oplog_batch_sizer.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+const long long kTargetMicros = 100 * 1000;
+
+TEST(OplogBatchSizerTest, StartsAtMaximum) {
+    OplogBatchSizer sizer(100, 5000);
+    ASSERT_EQUALS(5000U, sizer.getLimit());
+}
+
+TEST(OplogBatchSizerTest, ShrinksWhenFullBatchesAreSlow) {
+    OplogBatchSizer sizer(100, 5000);
+    sizer.recordBatch(5000, 2 * kTargetMicros, kTargetMicros);
+    ASSERT_EQUALS(3750U, sizer.getLimit());
+
+    for (int i = 0; i < 100; i++) {
+        sizer.recordBatch(sizer.getLimit(), 2 * kTargetMicros, kTargetMicros);
+    }
+    ASSERT_EQUALS(100U, sizer.getLimit());
+}
+
+TEST(OplogBatchSizerTest, IgnoresSmallSlowBatches) {
+    OplogBatchSizer sizer(100, 5000);
+    sizer.recordBatch(1, 10 * kTargetMicros, kTargetMicros);
+    ASSERT_EQUALS(5000U, sizer.getLimit());
+
+    sizer.recordBatch(4999, 10 * kTargetMicros, kTargetMicros);
+    ASSERT_EQUALS(5000U, sizer.getLimit());
+}
+
+TEST(OplogBatchSizerTest, GrowsOnlyWhenFullBatchesAreFast) {
+    OplogBatchSizer sizer(100, 5000);
+    sizer.recordBatch(5000, 2 * kTargetMicros, kTargetMicros);
+    ASSERT_EQUALS(3750U, sizer.getLimit());
+
+    sizer.recordBatch(1000, kTargetMicros / 10, kTargetMicros);
+    ASSERT_EQUALS(3750U, sizer.getLimit());
+
+    sizer.recordBatch(3750, kTargetMicros / 10, kTargetMicros);
+    ASSERT_EQUALS(4687U, sizer.getLimit());
+
+    sizer.recordBatch(4687, kTargetMicros / 10, kTargetMicros);
+    ASSERT_EQUALS(5000U, sizer.getLimit());
+}
+
+TEST(OplogBatchSizerTest, DisablingTargetResetsLimit) {
+    OplogBatchSizer sizer(100, 5000);
+    sizer.recordBatch(5000, 2 * kTargetMicros, kTargetMicros);
+    sizer.recordBatch(3750, 2 * kTargetMicros, 0);
+    ASSERT_EQUALS(5000U, sizer.getLimit());
+}
+
+TEST(OplogBatchSizerTest, ReportsAdjustments) {
+    OplogBatchSizer sizer(100, 5000);
+    sizer.recordBatch(5000, 2 * kTargetMicros, kTargetMicros);
+    sizer.recordBatch(3750, kTargetMicros / 10, kTargetMicros);
+
+    BSONObj report = sizer.getReport();
+    ASSERT_EQUALS(4687, report["limitOps"].numberLong());
+    ASSERT_EQUALS(3750, report["lastBatchOps"].numberLong());
+    ASSERT_EQUALS(kTargetMicros / 10, report["lastApplyMicros"].numberLong());
+    ASSERT_EQUALS(1, report["increases"].numberLong());
+    ASSERT_EQUALS(1, report["decreases"].numberLong());
+}
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,184 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_writer_partitioner.h"
+
+#include <unordered_map>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/string_map.h"
+#include "third_party/murmurhash3/MurmurHash3.h"
+
+namespace mongo {
+namespace repl {
+
+namespace {
+
+bool isCrudOpType(StringData opType) {
+    return opType == "i" || opType == "u" || opType == "d";
+}
+
+// Keys of operations which must be applied in order. The low bit tells namespace keys and
+// document keys apart. Distinct groups which hash to the same key are merely applied by the same
+// writer, which is always safe.
+uint64_t namespaceKey(uint32_t nsHash) {
+    return static_cast<uint64_t>(nsHash) << 1;
+}
+
+uint64_t documentKey(uint32_t nsHash, const BSONElement& id) {
+    const size_t idHash = BSONElement::Hasher()(id);
+    uint32_t hash;
+    MurmurHash3_x86_32(&idHash, sizeof(idHash), nsHash, &hash);
+    return (static_cast<uint64_t>(hash) << 1) | 1;
+}
+
+}  // namespace
+
+OplogWriterPartitioner::OplogWriterPartitioner(Mode mode,
+                                               GetCollectionPropertiesFn getCollectionProperties)
+    : _mode(mode), _getCollectionProperties(std::move(getCollectionProperties)) {}
+
+bool OplogWriterPartitioner::parseMode(StringData name, Mode* mode) {
+    if (name == "namespace") {
+        *mode = Mode::kNamespace;
+    } else if (name == "document") {
+        *mode = Mode::kDocument;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::vector<size_t> OplogWriterPartitioner::partition(const std::vector<Op>& ops,
+                                                      size_t numWriters) {
+    invariant(numWriters > 0);
+
+    // First find the namespaces whose operations all have to be applied in order.
+    struct NamespaceInfo {
+        bool known = false;
+        bool hasUniqueSecondaryIndex = false;
+        bool ordered = false;
+    };
+    StringMap<NamespaceInfo> namespaces;
+    for (auto&& op : ops) {
+        NamespaceInfo& info = namespaces[op.ns];
+        if (!info.known) {
+            info.known = true;
+            if (Mode::kNamespace == _mode) {
+                info.ordered = true;
+            } else {
+                const CollectionProperties properties = _getCollectionProperties(op.ns);
+                info.hasUniqueSecondaryIndex = properties.hasUniqueSecondaryIndex;
+                info.ordered = properties.isCapped;
+            }
+        }
+
+        if (info.ordered || !isCrudOpType(op.opType))
+            continue;
+
+        // Without an _id the document cannot be identified. An update or delete can free up a
+        // unique key which another document in the batch takes on, so the two have to be applied
+        // in order.
+        if (op.id.eoo() ||
+            (info.hasUniqueSecondaryIndex && (op.opType == "u" || op.opType == "d"))) {
+            info.ordered = true;
+        }
+    }
+
+    std::vector<size_t> writers;
+    writers.reserve(ops.size());
+    std::vector<size_t> load(numWriters, 0);
+    std::unordered_map<uint64_t, size_t> writerForKey;
+
+    for (auto&& op : ops) {
+        const uint32_t nsHash = StringMapTraits::hash(op.ns);
+        const bool byNamespace = !isCrudOpType(op.opType) || namespaces[op.ns].ordered;
+        const uint64_t key = byNamespace ? namespaceKey(nsHash) : documentKey(nsHash, op.id);
+
+        auto it = writerForKey.find(key);
+        if (it == writerForKey.end()) {
+            size_t leastLoaded = 0;
+            for (size_t i = 1; i < numWriters; i++) {
+                if (load[i] < load[leastLoaded])
+                    leastLoaded = i;
+            }
+            it = writerForKey.insert(std::make_pair(key, leastLoaded)).first;
+        }
+
+        load[it->second]++;
+        writers.push_back(it->second);
+    }
+
+    return writers;
+}
+
+void OplogWriterStats::recordBatch(const std::vector<size_t>& opsPerWriter,
+                                   const std::vector<long long>& busyMicrosPerWriter,
+                                   long long batchMicros) {
+    invariant(opsPerWriter.size() == busyMicrosPerWriter.size());
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_writers.size() < opsPerWriter.size()) {
+        _writers.resize(opsPerWriter.size());
+    }
+
+    _batches++;
+    _batchMicros += batchMicros;
+    for (size_t i = 0; i < opsPerWriter.size(); i++) {
+        _writers[i].ops += opsPerWriter[i];
+        _writers[i].busyMicros += busyMicrosPerWriter[i];
+    }
+}
+
+BSONObj OplogWriterStats::getReport() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    BSONObjBuilder b;
+    b.append("batches", _batches);
+    b.append("batchMicros", _batchMicros);
+
+    BSONArrayBuilder writers(b.subarrayStart("writers"));
+    for (auto&& writer : _writers) {
+        BSONObjBuilder writerBuilder(writers.subobjStart());
+        writerBuilder.append("ops", writer.ops);
+        writerBuilder.append("busyMicros", writer.busyMicros);
+        writerBuilder.append("utilization",
+                             _batchMicros ? static_cast<double>(writer.busyMicros) / _batchMicros
+                                          : 0.0);
+        writerBuilder.doneFast();
+    }
+    writers.doneFast();
+
+    return b.obj();
+}
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,149 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Decides which writer thread applies each operation of an oplog batch.
+ *
+ * Operations given to the same writer are applied in oplog order, while different writers run
+ * concurrently. In kNamespace mode all operations on a namespace go to the same writer. In
+ * kDocument mode CRUD operations are keyed by namespace and _id, so that the writes to a single
+ * hot collection spread over all writers. Operations whose order matters beyond their own
+ * document still share a writer with the rest of their namespace:
+ *  - operations on capped collections, whose insertion order must be kept,
+ *  - operations without an _id,
+ *  - all operations on a collection with a unique secondary index when the batch also updates or
+ *    deletes documents of that collection, because the value of a unique key can move from one
+ *    document to another within the batch.
+ * Commands and index builds are never part of a batch with other operations.
+ *
+ * Each group of operations which must stay ordered is given to the writer with the fewest
+ * operations so far, which balances the writers better than hashing the key would.
+ */
+class OplogWriterPartitioner {
+    MONGO_DISALLOW_COPYING(OplogWriterPartitioner);
+
+public:
+    enum class Mode { kNamespace, kDocument };
+
+    /**
+     * What the partitioner needs to know about a collection.
+     */
+    struct CollectionProperties {
+        bool isCapped = false;
+        bool hasUniqueSecondaryIndex = false;
+    };
+
+    /**
+     * Looks up the properties of the collection 'ns'. Missing collections have default properties.
+     * Only called in kDocument mode.
+     */
+    using GetCollectionPropertiesFn = stdx::function<CollectionProperties(StringData ns)>;
+
+    /**
+     * The parts of an oplog entry used for partitioning.
+     */
+    struct Op {
+        StringData ns;
+        StringData opType;
+
+        // The _id of the document the operation modifies, for CRUD operations.
+        BSONElement id;
+    };
+
+    OplogWriterPartitioner(Mode mode, GetCollectionPropertiesFn getCollectionProperties);
+
+    /**
+     * Returns the index of the writer, in [0, numWriters), which applies each of 'ops'.
+     */
+    std::vector<size_t> partition(const std::vector<Op>& ops, size_t numWriters);
+
+    /**
+     * Parses the value of the replWriterPartitioning server parameter.
+     */
+    static bool parseMode(StringData name, Mode* mode);
+
+private:
+    const Mode _mode;
+    const GetCollectionPropertiesFn _getCollectionProperties;
+};
+
+/**
+ * Accumulates how busy each writer thread was over the batches applied so far.
+ */
+class OplogWriterStats {
+    MONGO_DISALLOW_COPYING(OplogWriterStats);
+
+public:
+    OplogWriterStats() = default;
+
+    /**
+     * Records a batch in which writer i applied 'opsPerWriter[i]' operations and was busy for
+     * 'busyMicrosPerWriter[i]', while the whole batch took 'batchMicros' to apply.
+     */
+    void recordBatch(const std::vector<size_t>& opsPerWriter,
+                     const std::vector<long long>& busyMicrosPerWriter,
+                     long long batchMicros);
+
+    /**
+     * Reports the number of batches and, per writer, the operations applied, the time spent
+     * applying them and the fraction of the batch time the writer was busy.
+     */
+    BSONObj getReport() const;
+    operator BSONObj() const {
+        return getReport();
+    }
+
+private:
+    struct Writer {
+        long long ops = 0;
+        long long busyMicros = 0;
+    };
+
+    mutable stdx::mutex _mutex;
+    long long _batches = 0;
+    long long _batchMicros = 0;
+    std::vector<Writer> _writers;
+};
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,220 @@
+/*    Copyright 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <set>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/repl/oplog_writer_partitioner.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+using Partitioner = OplogWriterPartitioner;
+
+const size_t kNumWriters = 4;
+
+Partitioner::CollectionProperties properties(StringData ns) {
+    Partitioner::CollectionProperties props;
+    props.isCapped = ns == "test.capped";
+    props.hasUniqueSecondaryIndex = ns == "test.unique";
+    return props;
+}
+
+/**
+ * Holds the oplog documents so that the partitioner ops can refer to them.
+ */
+class Batch {
+public:
+    void add(StringData ns, StringData opType, int id) {
+        _add(ns, opType, BSON("_id" << id));
+    }
+
+    void addWithoutId(StringData ns, StringData opType) {
+        _add(ns, opType, BSON("x" << 1));
+    }
+
+    const std::vector<Partitioner::Op>& ops() {
+        _ops.clear();
+        for (auto&& entry : _entries) {
+            Partitioner::Op op;
+            op.ns = entry["ns"].valueStringData();
+            op.opType = entry["op"].valueStringData();
+            op.id = entry["o"].Obj()["_id"];
+            _ops.push_back(op);
+        }
+        return _ops;
+    }
+
+private:
+    void _add(StringData ns, StringData opType, const BSONObj& o) {
+        _entries.push_back(BSON("ns" << ns << "op" << opType << "o" << o));
+    }
+
+    std::vector<BSONObj> _entries;
+    std::vector<Partitioner::Op> _ops;
+};
+
+std::set<size_t> writersUsed(const std::vector<size_t>& writers) {
+    return std::set<size_t>(writers.begin(), writers.end());
+}
+
+TEST(OplogWriterPartitionerTest, SpreadsSingleCollectionOverAllWriters) {
+    Batch batch;
+    for (int i = 0; i < 100; i++) {
+        batch.add("test.hot", "i", i);
+    }
+
+    Partitioner partitioner(Partitioner::Mode::kDocument, properties);
+    auto writers = partitioner.partition(batch.ops(), kNumWriters);
+    ASSERT_EQUALS(100U, writers.size());
+
+    std::vector<size_t> load(kNumWriters, 0);
+    for (auto writer : writers) {
+        load[writer]++;
+    }
+    for (auto ops : load) {
+        ASSERT_EQUALS(25U, ops);
+    }
+}
+
+TEST(OplogWriterPartitionerTest, KeepsOperationsOnSameDocumentTogether) {
+    Batch batch;
+    for (int i = 0; i < 20; i++) {
+        batch.add("test.hot", "i", i);
+    }
+    for (int i = 0; i < 20; i++) {
+        batch.add("test.hot", "u", i);
+        batch.add("test.hot", "d", i);
+    }
+
+    Partitioner partitioner(Partitioner::Mode::kDocument, properties);
+    auto writers = partitioner.partition(batch.ops(), kNumWriters);
+    for (int i = 0; i < 20; i++) {
+        ASSERT_EQUALS(writers[i], writers[20 + 2 * i]);
+        ASSERT_EQUALS(writers[i], writers[21 + 2 * i]);
+    }
+    ASSERT_EQUALS(kNumWriters, writersUsed(writers).size());
+}
+
+TEST(OplogWriterPartitionerTest, SameIdInDifferentCollectionsIsIndependent) {
+    Batch batch;
+    batch.add("test.a", "i", 1);
+    batch.add("test.b", "i", 1);
+
+    Partitioner partitioner(Partitioner::Mode::kDocument, properties);
+    auto writers = partitioner.partition(batch.ops(), kNumWriters);
+    ASSERT_NOT_EQUALS(writers[0], writers[1]);
+}
+
+TEST(OplogWriterPartitionerTest, KeepsCappedCollectionOnOneWriter) {
+    Batch batch;
+    for (int i = 0; i < 20; i++) {
+        batch.add("test.capped", "i", i);
+    }
+
+    Partitioner partitioner(Partitioner::Mode::kDocument, properties);
+    ASSERT_EQUALS(1U, writersUsed(partitioner.partition(batch.ops(), kNumWriters)).size());
+}
+
+TEST(OplogWriterPartitionerTest, KeepsOperationsWithoutIdInNamespaceOrder) {
+    Batch batch;
+    for (int i = 0; i < 20; i++) {
+        batch.add("test.hot", "i", i);
+    }
+    batch.addWithoutId("test.hot", "u");
+
+    Partitioner partitioner(Partitioner::Mode::kDocument, properties);
+    ASSERT_EQUALS(1U, writersUsed(partitioner.partition(batch.ops(), kNumWriters)).size());
+}
+
+TEST(OplogWriterPartitionerTest, UniqueIndexOnlyOrdersBatchesWithUpdatesOrDeletes) {
+    Partitioner partitioner(Partitioner::Mode::kDocument, properties);
+
+    Batch inserts;
+    for (int i = 0; i < 20; i++) {
+        inserts.add("test.unique", "i", i);
+    }
+    ASSERT_EQUALS(kNumWriters, writersUsed(partitioner.partition(inserts.ops(), kNumWriters)).size());
+
+    Batch mixed;
+    for (int i = 0; i < 20; i++) {
+        mixed.add("test.unique", "i", i);
+    }
+    mixed.add("test.unique", "d", 0);
+    ASSERT_EQUALS(1U, writersUsed(partitioner.partition(mixed.ops(), kNumWriters)).size());
+}
+
+TEST(OplogWriterPartitionerTest, NamespaceModeKeepsCollectionsTogether) {
+    Batch batch;
+    for (int i = 0; i < 10; i++) {
+        batch.add("test.a", "i", i);
+        batch.add("test.b", "i", i);
+    }
+
+    Partitioner partitioner(Partitioner::Mode::kNamespace, properties);
+    auto writers = partitioner.partition(batch.ops(), kNumWriters);
+    ASSERT_EQUALS(2U, writersUsed(writers).size());
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQUALS(writers[0], writers[2 * i]);
+        ASSERT_EQUALS(writers[1], writers[2 * i + 1]);
+    }
+}
+
+TEST(OplogWriterPartitionerTest, ParsesMode) {
+    Partitioner::Mode mode;
+    ASSERT_TRUE(Partitioner::parseMode("namespace", &mode));
+    ASSERT(Partitioner::Mode::kNamespace == mode);
+    ASSERT_TRUE(Partitioner::parseMode("document", &mode));
+    ASSERT(Partitioner::Mode::kDocument == mode);
+    ASSERT_FALSE(Partitioner::parseMode("collection", &mode));
+}
+
+TEST(OplogWriterStatsTest, ReportsWriterUtilization) {
+    OplogWriterStats stats;
+    stats.recordBatch({10, 0}, {500, 0}, 1000);
+    stats.recordBatch({30, 20}, {1500, 1000}, 1000);
+
+    BSONObj report = stats.getReport();
+    ASSERT_EQUALS(2, report["batches"].numberLong());
+    ASSERT_EQUALS(2000, report["batchMicros"].numberLong());
+
+    std::vector<BSONElement> writers = report["writers"].Array();
+    ASSERT_EQUALS(2U, writers.size());
+    ASSERT_EQUALS(40, writers[0]["ops"].numberLong());
+    ASSERT_EQUALS(2000, writers[0]["busyMicros"].numberLong());
+    ASSERT_EQUALS(1.0, writers[0]["utilization"].numberDouble());
+    ASSERT_EQUALS(0.5, writers[1]["utilization"].numberDouble());
+}
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -35,7 +35,6 @@
 
 #include <boost/functional/hash.hpp>
 #include <memory>
-#include "third_party/murmurhash3/MurmurHash3.h"
 
 #include "mongo/base/counter.h"
 #include "mongo/db/auth/authorization_session.h"
@@ -49,6 +48,7 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/global_timestamp.h"
 #include "mongo/db/operation_context_impl.h"
@@ -57,6 +57,8 @@
 #include "mongo/db/repl/minvalid.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplogreader.h"
+#include "mongo/db/repl/oplog_batch_sizer.h"
+#include "mongo/db/repl/oplog_writer_partitioner.h"
 #include "mongo/db/repl/repl_client_info.h"
 #include "mongo/db/repl/replica_set_config.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
@@ -68,6 +70,7 @@
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -103,6 +106,33 @@ public:
 
 } exportedWriterThreadCountParam;
 
+namespace {
+std::string replWriterPartitioning = "document";
+}  // namespace
+
+class ExportedWriterPartitioningParameter
+    : public ExportedServerParameter<std::string, ServerParameterType::kStartupOnly> {
+public:
+    ExportedWriterPartitioningParameter()
+        : ExportedServerParameter<std::string, ServerParameterType::kStartupOnly>(
+              ServerParameterSet::getGlobal(),
+              "replWriterPartitioning",
+              &replWriterPartitioning) {}
+
+    virtual Status validate(const std::string& potentialNewValue) {
+        OplogWriterPartitioner::Mode mode;
+        if (!OplogWriterPartitioner::parseMode(potentialNewValue, &mode)) {
+            return Status(ErrorCodes::BadValue,
+                          "replWriterPartitioning must be either 'document' or 'namespace'");
+        }
+
+        return Status::OK();
+    }
+
+} exportedWriterPartitioningParam;
+
+// Apply time that the batcher aims for when sizing batches. 0 disables the adaptation.
+MONGO_EXPORT_SERVER_PARAMETER(replBatchTargetApplyMillis, int, 100);
 
 static Counter64 opsAppliedStats;
 
@@ -115,6 +145,16 @@ MONGO_FP_DECLARE(rsSyncApplyStop);
 static TimerStats applyBatchStats;
 static ServerStatusMetricField<TimerStats> displayOpBatchesApplied("repl.apply.batches",
                                                                    &applyBatchStats);
+
+// Operations applied and time spent by each writer thread
+static OplogWriterStats writerStats;
+static ServerStatusMetricField<OplogWriterStats> displayWriterStats("repl.apply.writers",
+                                                                    &writerStats);
+
+// Batches which were partitioned between the writers while the previous batch was applied
+static Counter64 preparedBatchesStats;
+static ServerStatusMetricField<Counter64> displayPreparedBatches("repl.apply.preparedBatches",
+                                                                 &preparedBatchesStats);
 void initializePrefetchThread() {
     if (!ClientBasic::getCurrent()) {
         Client::initThreadIfNotAlready();
@@ -406,6 +446,11 @@ void prefetchOp(const BSONObj& op) {
             // one possible tweak here would be to stay in the read lock for this database
             // for multiple prefetches if they are for the same database.
             OperationContextImpl txn;
+
+            // Prefetching only warms up pages, so it may run while the previous batch is being
+            // applied.
+            txn.lockState()->setIsBatchWriter(true);
+
             AutoGetCollectionForRead ctx(&txn, ns);
             Database* db = ctx.getDb();
             if (db) {
@@ -429,89 +474,119 @@ void prefetchOps(const std::deque<SyncTail::OplogEntry>& ops, OldThreadPool* pre
     prefetcherPool->join();
 }
 
-// Doles out all the work to the writer pool threads and waits for them to complete
+// Doles out all the work to the writer pool threads. Each writer records the time it spends
+// applying its operations in 'busyMicros', which may be read once the pool has been joined.
 void applyOps(const std::vector<std::vector<BSONObj>>& writerVectors,
               OldThreadPool* writerPool,
               SyncTail::MultiSyncApplyFunc func,
-              SyncTail* sync) {
+              SyncTail* sync,
+              std::vector<long long>* busyMicros) {
     TimerHolder timer(&applyBatchStats);
-    for (std::vector<std::vector<BSONObj>>::const_iterator it = writerVectors.begin();
-         it != writerVectors.end();
-         ++it) {
-        if (!it->empty()) {
-            writerPool->schedule(func, stdx::cref(*it), sync);
+    busyMicros->assign(writerVectors.size(), 0);
+    for (size_t i = 0; i < writerVectors.size(); i++) {
+        if (!writerVectors[i].empty()) {
+            const std::vector<BSONObj>* ops = &writerVectors[i];
+            long long* busy = &(*busyMicros)[i];
+            writerPool->schedule([func, ops, sync, busy] {
+                Timer t;
+                func(*ops, sync);
+                *busy = t.micros();
+            });
         }
     }
 }
 
 /**
- * A caching functor that returns true if a namespace refers to a capped collection.
- * Collections that don't exist are implicitly not capped.
+ * A caching functor that returns the properties of a collection which matter for partitioning
+ * operations between writers. Collections that don't exist are implicitly not capped and have no
+ * indexes.
  */
-class CachingCappedChecker {
+class CachingCollectionPropertiesChecker {
 public:
-    bool operator()(OperationContext* txn, const StringMapTraits::HashedKey& ns) {
+    using CollectionProperties = OplogWriterPartitioner::CollectionProperties;
+
+    explicit CachingCollectionPropertiesChecker(OperationContext* txn) : _txn(txn) {}
+
+    CollectionProperties operator()(StringData ns) {
         auto it = _cache.find(ns);
         if (it != _cache.end()) {
             return it->second;
         }
 
-        bool isCapped = isCappedImpl(txn, ns.key());
-        _cache[ns] = isCapped;
-        return isCapped;
+        CollectionProperties properties = getPropertiesImpl(ns);
+        _cache[ns] = properties;
+        return properties;
     }
 
 private:
-    bool isCappedImpl(OperationContext* txn, StringData ns) {
-        auto db = dbHolder().get(txn, ns);
+    CollectionProperties getPropertiesImpl(StringData ns) {
+        CollectionProperties properties;
+        Lock::DBLock dbLock(_txn->lockState(), nsToDatabaseSubstring(ns), MODE_IS);
+        auto db = dbHolder().get(_txn, ns);
         if (!db)
-            return false;
+            return properties;
 
         auto collection = db->getCollection(ns);
-        return collection && collection->isCapped();
+        if (!collection)
+            return properties;
+
+        properties.isCapped = collection->isCapped();
+
+        // Unfinished indexes are included, since a background index build may already enforce
+        // the uniqueness of its key.
+        auto indexes = collection->getIndexCatalog()->getIndexIterator(_txn, true);
+        while (indexes.more()) {
+            const IndexDescriptor* desc = indexes.next();
+            if (desc->unique() && !desc->isIdIndex()) {
+                properties.hasUniqueSecondaryIndex = true;
+                break;
+            }
+        }
+        return properties;
     }
 
-    StringMap<bool> _cache;
+    OperationContext* const _txn;
+    StringMap<CollectionProperties> _cache;
 };
 
 void fillWriterVectors(OperationContext* txn,
                        const std::deque<SyncTail::OplogEntry>& ops,
                        std::vector<std::vector<BSONObj>>* writerVectors) {
-    const bool supportsDocLocking =
-        getGlobalServiceContext()->getGlobalStorageEngine()->supportsDocLocking();
-    const uint32_t numWriters = writerVectors->size();
-
-    Lock::GlobalRead globalReadLock(txn->lockState());
-
-    CachingCappedChecker isCapped;
+    // Engines without document level locking would serialize writers on the same collection
+    // anyway, so they keep each namespace on a single writer.
+    OplogWriterPartitioner::Mode mode = OplogWriterPartitioner::Mode::kNamespace;
+    if (getGlobalServiceContext()->getGlobalStorageEngine()->supportsDocLocking()) {
+        fassert(40002, OplogWriterPartitioner::parseMode(replWriterPartitioning, &mode));
+    }
 
+    std::vector<OplogWriterPartitioner::Op> partitionerOps;
+    partitionerOps.reserve(ops.size());
     for (auto&& op : ops) {
-        StringMapTraits::HashedKey hashedNs(op.ns);
-        uint32_t hash = hashedNs.hash();
+        OplogWriterPartitioner::Op partitionerOp;
+        partitionerOp.ns = op.ns;
+        partitionerOp.opType = op.opType;
 
         const char* opType = op.opType.rawData();
-
-        // For doc locking engines, include the _id of the document in the hash so we get
-        // parallelism even if all writes are to a single collection. We can't do this for capped
-        // collections because the order of inserts is a guaranteed property, unlike for normal
-        // collections.
-        if (supportsDocLocking && isCrudOpType(opType) && !isCapped(txn, hashedNs)) {
-            BSONElement id;
+        if (isCrudOpType(opType)) {
             switch (opType[0]) {
                 case 'u':
-                    id = op.o2.Obj()["_id"];
+                    partitionerOp.id = op.o2.Obj()["_id"];
                     break;
                 case 'd':
                 case 'i':
-                    id = op.o.Obj()["_id"];
+                    partitionerOp.id = op.o.Obj()["_id"];
                     break;
             }
-
-            const size_t idHash = BSONElement::Hasher()(id);
-            MurmurHash3_x86_32(&idHash, sizeof(idHash), hash, &hash);
         }
+        partitionerOps.push_back(partitionerOp);
+    }
 
-        (*writerVectors)[hash % numWriters].push_back(op.raw);
+    OplogWriterPartitioner partitioner(mode, CachingCollectionPropertiesChecker(txn));
+    const std::vector<size_t> writers =
+        partitioner.partition(partitionerOps, writerVectors->size());
+
+    for (size_t i = 0; i < ops.size(); i++) {
+        (*writerVectors)[writers[i]].push_back(ops[i].raw);
     }
 }
 
@@ -520,16 +595,26 @@ void fillWriterVectors(OperationContext* txn,
 // Applies a batch of oplog entries, by using a set of threads to apply the operations and then
 // writes the oplog entries to the local oplog.
 OpTime SyncTail::multiApply(OperationContext* txn, const OpQueue& ops) {
+    BatchPreparation preparation;
+    return multiApply(txn, ops, &preparation);
+}
+
+OpTime SyncTail::multiApply(OperationContext* txn,
+                            const OpQueue& ops,
+                            BatchPreparation* preparation) {
     invariant(_applyFunc);
 
-    if (getGlobalServiceContext()->getGlobalStorageEngine()->isMmapV1()) {
+    if (!preparation->prefetched &&
+        getGlobalServiceContext()->getGlobalStorageEngine()->isMmapV1()) {
         // Use a ThreadPool to prefetch all the operations in a batch.
         prefetchOps(ops.getDeque(), &_prefetcherPool);
     }
 
-    std::vector<std::vector<BSONObj>> writerVectors(replWriterThreadCount);
-
-    fillWriterVectors(txn, ops.getDeque(), &writerVectors);
+    std::vector<std::vector<BSONObj>>& writerVectors = preparation->writerVectors;
+    if (writerVectors.empty()) {
+        writerVectors.resize(replWriterThreadCount);
+        fillWriterVectors(txn, ops.getDeque(), &writerVectors);
+    }
     LOG(2) << "replication batch size is " << ops.getDeque().size() << endl;
     // We must grab this because we're going to grab write locks later.
     // We hold this mutex the entire time we're writing; it doesn't matter
@@ -545,7 +630,9 @@ OpTime SyncTail::multiApply(OperationContext* txn, const OpQueue& ops) {
         fassertFailed(28527);
     }
 
-    applyOps(writerVectors, &_writerPool, _applyFunc, this);
+    Timer batchTimer;
+    std::vector<long long> busyMicros;
+    applyOps(writerVectors, &_writerPool, _applyFunc, this, &busyMicros);
 
     OpTime lastOpTime;
     {
@@ -558,6 +645,13 @@ OpTime SyncTail::multiApply(OperationContext* txn, const OpQueue& ops) {
         lastOpTime = writeOpsToOplog(txn, raws);
     }
 
+    std::vector<size_t> opsPerWriter;
+    opsPerWriter.reserve(writerVectors.size());
+    for (auto&& writerVector : writerVectors) {
+        opsPerWriter.push_back(writerVector.size());
+    }
+    writerStats.recordBatch(opsPerWriter, busyMicros, batchTimer.micros());
+
     if (inShutdownStrict()) {
         log() << "Cannot apply operations due to shutdown in progress";
         return OpTime();
@@ -613,6 +707,14 @@ class SyncTail::OpQueueBatcher {
     MONGO_DISALLOW_COPYING(OpQueueBatcher);
 
 public:
+    /**
+     * A batch ready to be applied, along with the work already done on it.
+     */
+    struct Batch {
+        OpQueue ops;
+        BatchPreparation preparation;
+    };
+
     explicit OpQueueBatcher(SyncTail* syncTail) : _syncTail(syncTail), _thread([&] { run(); }) {}
     ~OpQueueBatcher() {
         _inShutdown.store(true);
@@ -620,19 +722,27 @@ public:
         _thread.join();
     }
 
-    OpQueue getNextBatch(Seconds maxWaitTime) {
+    Batch getNextBatch(Seconds maxWaitTime) {
         stdx::unique_lock<stdx::mutex> lk(_mutex);
-        if (_ops.empty()) {
+        if (_batch.ops.empty()) {
             // We intentionally don't care about whether this returns due to signaling or timeout
-            // since we do the same thing either way: return whatever is in _ops.
+            // since we do the same thing either way: return whatever is in _batch.
             (void)_cv.wait_for(lk, maxWaitTime);
         }
 
-        OpQueue ops = std::move(_ops);
-        _ops = {};
+        Batch batch = std::move(_batch);
+        _batch = {};
         _cv.notify_all();
 
-        return ops;
+        return batch;
+    }
+
+    /**
+     * Adjusts the size of the following batches to the time it took to apply 'ops'.
+     */
+    static void recordApplied(const OpQueue& ops, long long applyMicros) {
+        batchSizer.recordBatch(
+            ops.getDeque().size(), applyMicros, replBatchTargetApplyMillis.load() * 1000LL);
     }
 
 private:
@@ -641,8 +751,13 @@ private:
         OperationContextImpl txn;
         auto replCoord = ReplicationCoordinator::get(&txn);
 
+        // The batcher only looks at collection metadata, which the batches being applied cannot
+        // change (see prepare()), so it does not have to wait for them to finish.
+        txn.lockState()->setIsBatchWriter(true);
+
         while (!_inShutdown.load()) {
             Timer batchTimer;
+            const size_t limitOperations = batchSizer.getLimit();
 
             OpQueue ops;
             // tryPopAndWaitForMore returns true when we need to end a batch early
@@ -654,7 +769,7 @@ private:
                 if (!ops.empty()) {
                     if (now > replBatchLimitSeconds)
                         break;
-                    if (ops.getDeque().size() > replBatchLimitOperations)
+                    if (ops.getDeque().size() > limitOperations)
                         break;
                 }
 
@@ -684,28 +799,72 @@ private:
                 sleepmillis(0);
             }
 
+            Batch batch;
+            batch.ops = std::move(ops);
+            prepare(&txn, &batch);
+
             stdx::unique_lock<stdx::mutex> lk(_mutex);
-            while (!_ops.empty()) {
+            while (!_batch.ops.empty()) {
                 // Block until the previous batch has been taken.
                 if (_inShutdown.load())
                     return;
                 _cv.wait(lk);
             }
-            _ops = std::move(ops);
+            _batch = std::move(batch);
             _cv.notify_all();
         }
     }
 
+    /**
+     * Does the work on 'batch' which does not depend on the previous batch having been applied.
+     *
+     * Partitioning looks up which collections are capped or have unique indexes. Only commands
+     * and index builds change that, so the batches following one of them, until it is known to be
+     * applied, are partitioned at apply time instead (see CatalogChangeTracker). Collections
+     * created implicitly by inserts of earlier batches have the same properties as missing ones.
+     */
+    void prepare(OperationContext* txn, Batch* batch) {
+        const auto& ops = batch->ops.getDeque();
+        if (ops.empty() || ops.back().raw.isEmpty()) {
+            // Nothing to apply.
+            return;
+        }
+
+        if (getGlobalServiceContext()->getGlobalStorageEngine()->isMmapV1()) {
+            prefetchOps(ops, &_syncTail->_prefetcherPool);
+            batch->preparation.prefetched = true;
+        }
+
+        if (_catalogChanges.canPrepareNextBatch()) {
+            batch->preparation.writerVectors.resize(replWriterThreadCount);
+            fillWriterVectors(txn, ops, &batch->preparation.writerVectors);
+            preparedBatchesStats.increment();
+        }
+
+        _catalogChanges.recordBatch(ops);
+    }
+
+    // Adapts the limit on the number of operations in a batch to the time batches take to apply.
+    static OplogBatchSizer batchSizer;
+    static ServerStatusMetricField<OplogBatchSizer> displayBatchSizer;
+
     AtomicWord<bool> _inShutdown;
     SyncTail* const _syncTail;
 
-    stdx::mutex _mutex;  // Guards _ops.
+    // Only used by the batcher thread.
+    CatalogChangeTracker _catalogChanges;
+
+    stdx::mutex _mutex;  // Guards _batch.
     stdx::condition_variable _cv;
-    OpQueue _ops;
+    Batch _batch;
 
     stdx::thread _thread;  // Must be last so all other members are initialized before starting.
 };
 
+OplogBatchSizer SyncTail::OpQueueBatcher::batchSizer(100, replBatchLimitOperations);
+ServerStatusMetricField<OplogBatchSizer> SyncTail::OpQueueBatcher::displayBatchSizer(
+    "repl.apply.batchSizer", &batchSizer);
+
 /* tail an oplog.  ok to return, will be re-called. */
 void SyncTail::oplogApplication() {
     OpQueueBatcher batcher(this);
@@ -718,7 +877,7 @@ void SyncTail::oplogApplication() {
     OpTime originalEndOpTime(minValidBoundaries.end);
     OpTime lastWriteOpTime{replCoord->getMyLastOptime()};
     while (!inShutdown()) {
-        OpQueue ops;
+        OpQueueBatcher::Batch batch;
 
         do {
             if (BackgroundSync::get()->getInitialSyncRequestedFlag()) {
@@ -730,12 +889,13 @@ void SyncTail::oplogApplication() {
 
             // Blocks up to a second waiting for a batch to be ready to apply. If one doesn't become
             // ready in time, we'll loop again so we can do the above checks periodically.
-            ops = batcher.getNextBatch(Seconds(1));
-        } while (!inShutdown() && ops.empty());
+            batch = batcher.getNextBatch(Seconds(1));
+        } while (!inShutdown() && batch.ops.empty());
 
         if (inShutdown())
             return;
 
+        const OpQueue& ops = batch.ops;
         invariant(!ops.empty());
 
         const BSONObj lastOp = ops.back().raw;
@@ -789,7 +949,8 @@ void SyncTail::oplogApplication() {
         // This write will not journal/checkpoint.
         setMinValid(&txn, {start, end});
 
-        lastWriteOpTime = multiApply(&txn, ops);
+        Timer applyTimer;
+        lastWriteOpTime = multiApply(&txn, ops, &batch.preparation);
         if (lastWriteOpTime.isNull()) {
             // fassert if oplog application failed for any reasons other than shutdown.
             error() << "Failed to apply " << ops.getDeque().size()
@@ -799,6 +960,8 @@ void SyncTail::oplogApplication() {
             return;
         }
 
+        OpQueueBatcher::recordApplied(ops, applyTimer.micros());
+
         setNewTimestamp(lastWriteOpTime.getTimestamp());
         setMinValid(&txn, end, DurableRequirement::None);
         minValidBoundaries.start = {};
@@ -824,6 +987,19 @@ SyncTail::OplogEntry::OplogEntry(const BSONObj& rawInput) : raw(rawInput.getOwne
     }
 }
 
+void SyncTail::CatalogChangeTracker::recordBatch(const std::deque<OplogEntry>& ops) {
+    for (auto&& op : ops) {
+        if (op.opType[0] == 'c' ||
+            (!op.ns.empty() && nsToCollectionSubstring(op.ns) == "system.indexes")) {
+            _batchesSinceCatalogChange = 0;
+            return;
+        }
+    }
+    if (_batchesSinceCatalogChange < kBatchesInFlight) {
+        _batchesSinceCatalogChange++;
+    }
+}
+
 // Copies ops out of the bgsync queue into the deque passed in as a parameter.
 // Returns true if the batch should be ended early.
 // Batch should end early if we encounter a command, or if
@@ -144,6 +144,36 @@ public:
         size_t _size;
     };
 
+    /**
+     * Tells whether the next batch may be partitioned between the writer threads before it is
+     * handed off to be applied. Partitioning looks up which collections are capped or have unique
+     * indexes, which only commands and index builds change. When a batch is prepared, the two
+     * batches handed off before it may not have been applied yet: one waiting to be taken, and
+     * the one being applied.
+     */
+    class CatalogChangeTracker {
+    public:
+        // Number of batches handed off which may still be unapplied when the next is prepared.
+        static const int kBatchesInFlight = 2;
+
+        /**
+         * Returns true if none of the batches which may still be unapplied changes the catalog.
+         */
+        bool canPrepareNextBatch() const {
+            return _batchesSinceCatalogChange >= kBatchesInFlight;
+        }
+
+        /**
+         * Records that a batch of 'ops' is handed off to be applied.
+         */
+        void recordBatch(const std::deque<OplogEntry>& ops);
+
+    private:
+        // Starts out as if a batch which changed the catalog was just handed off, since the
+        // batcher cannot know what was applied before it was started.
+        int _batchesSinceCatalogChange = 0;
+    };
+
     // returns true if we should continue waiting for BSONObjs, false if we should
     // stop waiting and apply the queue we have.  Only returns false if !ops.empty().
     bool tryPopAndWaitForMore(OperationContext* txn, OpQueue* ops);
@@ -173,10 +203,25 @@ protected:
     static const int replBatchLimitSeconds = 1;
     static const unsigned int replBatchLimitOperations = 5000;
 
+    /**
+     * Work done on a batch before it is applied, while the previous batch is still being applied.
+     */
+    struct BatchPreparation {
+        // Whether the pages the operations touch have already been prefetched (MMAPv1 only).
+        bool prefetched = false;
+
+        // The operations partitioned between the writer threads, or empty if that has not been
+        // done yet.
+        std::vector<std::vector<BSONObj>> writerVectors;
+    };
+
     // Apply a batch of operations, using multiple threads.
     // Returns the last OpTime applied during the apply batch, ops.end["ts"] basically.
     OpTime multiApply(OperationContext* txn, const OpQueue& ops);
 
+    // Like above, but skips the steps 'preparation' says were already done for the batch.
+    OpTime multiApply(OperationContext* txn, const OpQueue& ops, BatchPreparation* preparation);
+
 private:
     class OpQueueBatcher;
 
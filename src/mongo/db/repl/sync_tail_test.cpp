@@ -357,4 +357,63 @@ TEST_F(SyncTailTest, SyncApplyCommandThrowsException) {
     ASSERT_EQUALS(1U, _opsApplied);
 }
 
+
+std::deque<SyncTail::OplogEntry> makeBatch(const BSONObj& op) {
+    std::deque<SyncTail::OplogEntry> ops;
+    ops.emplace_back(op);
+    return ops;
+}
+
+TEST(SyncTailCatalogChangeTrackerTest, PreparesOnlyOnceCatalogChangesAreApplied) {
+    const auto crud = makeBatch(BSON("op"
+                                     << "i"
+                                     << "ns"
+                                     << "test.t"
+                                     << "o" << BSON("_id" << 1)));
+    const auto command = makeBatch(BSON("op"
+                                        << "c"
+                                        << "ns"
+                                        << "test.$cmd"
+                                        << "o" << BSON("create"
+                                                       << "t")));
+    const auto indexBuild = makeBatch(BSON("op"
+                                           << "i"
+                                           << "ns"
+                                           << "test.system.indexes"
+                                           << "o" << BSON("ns"
+                                                          << "test.t"
+                                                          << "key" << BSON("a" << 1) << "name"
+                                                          << "a_1"
+                                                          << "unique" << true)));
+
+    // Nothing is known about what was applied before the first batch.
+    SyncTail::CatalogChangeTracker tracker;
+    ASSERT_FALSE(tracker.canPrepareNextBatch());
+    tracker.recordBatch(crud);
+    ASSERT_FALSE(tracker.canPrepareNextBatch());
+    tracker.recordBatch(crud);
+    ASSERT_TRUE(tracker.canPrepareNextBatch());
+
+    // While a command is applied, the batch after it waits to be taken, so neither of the two
+    // following batches can be prepared.
+    tracker.recordBatch(command);
+    ASSERT_FALSE(tracker.canPrepareNextBatch());
+    tracker.recordBatch(crud);
+    ASSERT_FALSE(tracker.canPrepareNextBatch());
+    tracker.recordBatch(crud);
+    ASSERT_TRUE(tracker.canPrepareNextBatch());
+
+    // Back to back catalog changes.
+    tracker.recordBatch(indexBuild);
+    ASSERT_FALSE(tracker.canPrepareNextBatch());
+    tracker.recordBatch(command);
+    ASSERT_FALSE(tracker.canPrepareNextBatch());
+    tracker.recordBatch(crud);
+    ASSERT_FALSE(tracker.canPrepareNextBatch());
+    tracker.recordBatch(crud);
+    ASSERT_TRUE(tracker.canPrepareNextBatch());
+    tracker.recordBatch(crud);
+    ASSERT_TRUE(tracker.canPrepareNextBatch());
+}
+
 }  // namespace
@@ -56,6 +56,8 @@ struct ServerGlobalParams {
           doFork(0),
           socket("/tmp"),
           maxConns(DEFAULT_MAX_CONN),
+          serviceExecutor("synchronous"),
+          serviceExecutorThreads(0),
           unixSocketPermissions(DEFAULT_UNIX_PERMS),
           auditOpFilter(0),
           auditAuthSuccess(false),
@@ -103,6 +105,9 @@ struct ServerGlobalParams {
 
     int maxConns;  // Maximum number of simultaneous open connections.
 
+    std::string serviceExecutor;  // --serviceExecutor: "synchronous" or "epoll"
+    int serviceExecutorThreads;   // --serviceExecutorThreads, 0 means pick from the core count
+
     int unixSocketPermissions;  // permissions for the UNIX domain socket
 
     std::string keyFile;  // Path to keyfile, or empty if none.
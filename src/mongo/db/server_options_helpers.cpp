@@ -207,6 +207,22 @@ Status addGeneralServerOptions(moe::OptionSection* options) {
     options->addOptionChaining(
         "net.maxIncomingConnections", "maxConns", moe::Int, maxConnInfoBuilder.str().c_str());
 
+#ifdef __linux__
+    options->addOptionChaining("net.serviceExecutor",
+                               "serviceExecutor",
+                               moe::String,
+                               "how client connections are serviced: a thread per connection "
+                               "(synchronous, the default) or a fixed pool of worker threads "
+                               "driven by epoll (epoll)")
+        .format("(:?synchronous)|(:?epoll)", "(synchronous/epoll)");
+
+    options->addOptionChaining("net.serviceExecutorThreads",
+                               "serviceExecutorThreads",
+                               moe::Int,
+                               "number of worker threads used by the epoll service executor "
+                               "(defaults to twice the number of cores)");
+#endif
+
     options->addOptionChaining(
                  "logpath",
                  "logpath",
@@ -831,6 +847,18 @@ Status storeServerOptions(const moe::Environment& params, const std::vector<std:
         }
     }
 
+    if (params.count("net.serviceExecutor")) {
+        serverGlobalParams.serviceExecutor = params["net.serviceExecutor"].as<std::string>();
+    }
+
+    if (params.count("net.serviceExecutorThreads")) {
+        serverGlobalParams.serviceExecutorThreads = params["net.serviceExecutorThreads"].as<int>();
+
+        if (serverGlobalParams.serviceExecutorThreads < 1) {
+            return Status(ErrorCodes::BadValue, "serviceExecutorThreads has to be at least 1");
+        }
+    }
+
     if (params.count("net.wireObjectCheck")) {
         serverGlobalParams.objcheck = params["net.wireObjectCheck"].as<bool>();
     }
@@ -158,8 +158,17 @@ void NetworkCounter::append(BSONObjBuilder& b) {
     b.append("numRequests", static_cast<long long>(_requests.loadRelaxed()));
 }
 
+void ServiceExecutorCounter::append(BSONObjBuilder& b) const {
+    b.append("sessions", static_cast<long long>(_sessions.loadRelaxed()));
+    b.append("queued", static_cast<long long>(_queued.loadRelaxed()));
+    b.append("inFlight", static_cast<long long>(_inFlight.loadRelaxed()));
+    b.append("totalScheduled", static_cast<long long>(_totalScheduled.loadRelaxed()));
+    b.append("totalQueuedMicros", static_cast<long long>(_totalQueuedMicros.loadRelaxed()));
+}
+
 
 OpCounters globalOpCounters;
 OpCounters replOpCounters;
 NetworkCounter networkCounter;
+ServiceExecutorCounter serviceExecutorCounter;
 }
@@ -106,4 +106,56 @@ private:
 };
 
 extern NetworkCounter networkCounter;
+
+/**
+ * Counters maintained by service executors which multiplex client connections over a fixed pool
+ * of worker threads (see ServiceExecutorEpoll).
+ */
+class ServiceExecutorCounter {
+public:
+    ServiceExecutorCounter()
+        : _sessions(0), _queued(0), _inFlight(0), _totalScheduled(0), _totalQueuedMicros(0) {}
+
+    void sessionAdded() {
+        _sessions.fetchAndAdd(1);
+    }
+    void sessionEnded() {
+        _sessions.fetchAndSubtract(1);
+    }
+
+    /** A session became ready and is waiting for a worker thread. */
+    void enqueued() {
+        _queued.fetchAndAdd(1);
+        _totalScheduled.fetchAndAdd(1);
+    }
+
+    /** A worker thread picked up a ready session which had been waiting for 'queuedMicros'. */
+    void started(long long queuedMicros) {
+        _queued.fetchAndSubtract(1);
+        _inFlight.fetchAndAdd(1);
+        _totalQueuedMicros.fetchAndAdd(queuedMicros);
+    }
+
+    void finished() {
+        _inFlight.fetchAndSubtract(1);
+    }
+
+    long long queued() const {
+        return _queued.loadRelaxed();
+    }
+    long long inFlight() const {
+        return _inFlight.loadRelaxed();
+    }
+
+    void append(BSONObjBuilder& b) const;
+
+private:
+    AtomicInt64 _sessions;
+    AtomicInt64 _queued;
+    AtomicInt64 _inFlight;
+    AtomicInt64 _totalScheduled;
+    AtomicInt64 _totalQueuedMicros;
+};
+
+extern ServiceExecutorCounter serviceExecutorCounter;
 }
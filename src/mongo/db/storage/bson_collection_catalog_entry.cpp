@@ -102,6 +102,15 @@ bool BSONCollectionCatalogEntry::isIndexReady(OperationContext* txn, StringData
     return md.indexes[offset].ready;
 }
 
+BSONObj BSONCollectionCatalogEntry::getIndexStatistics(OperationContext* txn,
+                                                       StringData indexName) const {
+    MetaData md = _getMetaData(txn);
+
+    int offset = md.findIndexOffset(indexName);
+    invariant(offset >= 0);
+    return md.indexes[offset].statistics;
+}
+
 // --------------------------
 
 void BSONCollectionCatalogEntry::IndexMetaData::updateTTLSetting(long long newExpireSeconds) {
@@ -161,6 +170,9 @@ BSONObj BSONCollectionCatalogEntry::MetaData::toBSON() const {
             sub.appendBool("ready", indexes[i].ready);
             sub.appendBool("multikey", indexes[i].multikey);
             sub.append("head", static_cast<long long>(indexes[i].head.repr()));
+            if (!indexes[i].statistics.isEmpty()) {
+                sub.append("statistics", indexes[i].statistics);
+            }
             sub.done();
         }
         arr.done();
@@ -189,6 +201,9 @@ void BSONCollectionCatalogEntry::MetaData::parse(const BSONObj& obj) {
                 imd.head = RecordId(idx["head_a"].Int(), idx["head_b"].Int());
             }
             imd.multikey = idx["multikey"].trueValue();
+            if (idx["statistics"].isABSONObj()) {
+                imd.statistics = idx["statistics"].Obj().getOwned();
+            }
             indexes.push_back(imd);
         }
     }
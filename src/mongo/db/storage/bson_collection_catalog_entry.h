@@ -63,6 +63,8 @@ public:
 
     virtual bool isIndexReady(OperationContext* txn, StringData indexName) const;
 
+    virtual BSONObj getIndexStatistics(OperationContext* txn, StringData indexName) const;
+
     // ------ for implementors
 
     struct IndexMetaData {
@@ -80,6 +82,9 @@ public:
         bool ready;
         RecordId head;
         bool multikey;
+
+        // Serialized IndexStatistics, empty if the index was never analyzed.
+        BSONObj statistics;
     };
 
     struct MetaData {
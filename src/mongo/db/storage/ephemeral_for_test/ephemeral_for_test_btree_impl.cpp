@@ -172,6 +172,42 @@ public:
         return Status::OK();
     }
 
+    virtual Status insertKeys(OperationContext* txn,
+                              const std::vector<BSONObj>& keys,
+                              const RecordId& loc,
+                              bool dupsAllowed,
+                              size_t* numProcessed) {
+        invariant(loc.isNormal());
+
+        // Sorted keys go right after the entry inserted before them, so each insert is
+        // amortized constant with that entry as the hint.
+        IndexSet::iterator hint = _data->end();
+        for (*numProcessed = 0; *numProcessed < keys.size(); ++*numProcessed) {
+            const BSONObj& key = keys[*numProcessed];
+            invariant(!hasFieldNames(key));
+
+            if (key.objsize() >= TempKeyMaxSize) {
+                string msg = mongoutils::str::stream()
+                    << "EphemeralForTestBtree::insert: key too large to index, failing " << ' '
+                    << key.objsize() << ' ' << key;
+                return Status(ErrorCodes::KeyTooLong, msg);
+            }
+
+            if (!dupsAllowed && isDup(*_data, key, loc))
+                return dupKeyError(key);
+
+            IndexKeyEntry entry(key.getOwned(), loc);
+            const size_t sizeBefore = _data->size();
+            hint = _data->insert(hint, entry);
+            if (_data->size() != sizeBefore) {
+                _currentKeySize += key.objsize();
+                txn->recoveryUnit()->registerChange(new IndexChange(_data, entry, true));
+            }
+            ++hint;
+        }
+        return Status::OK();
+    }
+
     virtual void unindex(OperationContext* txn,
                          const BSONObj& key,
                          const RecordId& loc,
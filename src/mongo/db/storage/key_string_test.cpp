@@ -30,14 +30,20 @@
 
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
 
+#include <algorithm>
 #include <cmath>
+#include <memory>
+#include <vector>
 
 #include "mongo/platform/basic.h"
 #include "mongo/config.h"
 #include "mongo/db/storage/key_string.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/hex.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
 #include "mongo/base/owned_pointer_vector.h"
 
 using std::string;
@@ -847,3 +853,108 @@ TEST(KeyStringTest, RecordIds) {
         }
     }
 }
+
+TEST(KeyStringTest, StringsAroundWordBoundaries) {
+    // Strings are copied and inverted several bytes at a time. Cover every length around the
+    // word sizes with the NUL byte, which needs escaping, in every position.
+    std::vector<BSONObj> elements;
+    for (size_t length = 0; length <= 40; length++) {
+        const std::string plain(length, 'x');
+        elements.push_back(BSON("" << plain));
+        for (size_t nulPos = 0; nulPos < length; nulPos++) {
+            std::string withNul = plain;
+            withNul[nulPos] = '\0';
+            elements.push_back(BSON("" << withNul));
+            elements.push_back(BSON("" << BSONSymbol(withNul)));
+        }
+    }
+
+    for (size_t i = 0; i < elements.size(); i++) {
+        ROUNDTRIP(elements[i]);
+    }
+    for (size_t i = 1; i < elements.size(); i++) {
+        COMPARES_SAME(elements[i - 1], elements[i]);
+    }
+}
+
+namespace {
+
+const int kBenchmarkKeys = 10 * 1000;
+const int kBenchmarkRounds = 100;
+
+/**
+ * Logs how many keys per second KeyString encodes from 'keys' in 'ord', so that a change to the
+ * encoder can be measured by comparing the numbers before and after it.
+ */
+void benchmarkEncoding(const std::string& name, const std::vector<BSONObj>& keys, Ordering ord) {
+    KeyString ks;
+    size_t totalSize = 0;
+
+    Timer timer;
+    for (int round = 0; round < kBenchmarkRounds; round++) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            ks.resetToKey(keys[i], ord);
+            totalSize += ks.getSize();
+        }
+    }
+    const long long micros = std::max(timer.micros(), 1LL);
+
+    const long long numKeys = static_cast<long long>(keys.size()) * kBenchmarkRounds;
+    log() << "KeyString encoding " << name << ": " << numKeys * 1000 * 1000 / micros
+          << " keys/sec, " << totalSize / numKeys << " bytes/key";
+}
+
+void benchmarkComparison(const std::string& name, const std::vector<BSONObj>& keys) {
+    std::vector<std::unique_ptr<KeyString>> encoded;
+    for (size_t i = 0; i < keys.size(); i++) {
+        encoded.push_back(stdx::make_unique<KeyString>(keys[i], ALL_ASCENDING));
+    }
+
+    int checksum = 0;
+    Timer timer;
+    for (int round = 0; round < kBenchmarkRounds; round++) {
+        for (size_t i = 1; i < encoded.size(); i++) {
+            checksum += encoded[i - 1]->compare(*encoded[i]);
+        }
+    }
+    const long long micros = std::max(timer.micros(), 1LL);
+
+    const long long numComparisons = static_cast<long long>(encoded.size() - 1) * kBenchmarkRounds;
+    log() << "KeyString comparison " << name << ": "
+          << numComparisons * 1000 * 1000 / micros << " comparisons/sec (" << checksum << ")";
+}
+
+void benchmark(const std::string& name, const std::vector<BSONObj>& keys) {
+    benchmarkEncoding(name + " ascending", keys, ALL_ASCENDING);
+    benchmarkEncoding(name + " descending", keys, ONE_DESCENDING);
+    benchmarkComparison(name, keys);
+}
+
+}  // namespace
+
+TEST(KeyStringTest, Benchmarks) {
+// Timings of non-optimized builds say nothing about the encoder.
+#if !defined(MONGO_CONFIG_OPTIMIZED_BUILD)
+    log() << "\t\t\tskipping benchmarks on non-optimized build";
+    return;
+#endif
+
+    std::vector<BSONObj> ints, doubles, oids, shortStrings, longStrings, compound;
+    for (int i = 0; i < kBenchmarkKeys; i++) {
+        ints.push_back(BSON("" << i * 7919));
+        doubles.push_back(BSON("" << i * 1.37));
+        oids.push_back(BSON("" << OID::gen()));
+
+        const std::string str = str::stream() << "user" << i;
+        shortStrings.push_back(BSON("" << str));
+        longStrings.push_back(BSON("" << std::string(200, 'a') + str));
+        compound.push_back(BSON("" << str << "" << i << "" << oids.back().firstElement().OID()));
+    }
+
+    benchmark("int", ints);
+    benchmark("double", doubles);
+    benchmark("ObjectId", oids);
+    benchmark("short string", shortStrings);
+    benchmark("long string", longStrings);
+    benchmark("compound (string, int, ObjectId)", compound);
+}
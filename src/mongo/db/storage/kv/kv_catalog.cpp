@@ -292,6 +292,10 @@ void KVCatalog::putMetaData(OperationContext* opCtx,
     LOG(3) << "recording new metadata: " << obj;
     StatusWith<RecordId> status =
         _rs->updateRecord(opCtx, loc, obj.objdata(), obj.objsize(), false, NULL);
+    if (status.getStatus().code() == ErrorCodes::ExceededMemoryLimit) {
+        // An in-memory storage engine is full. The operation fails and its changes roll back.
+        uassertStatusOK(status.getStatus());
+    }
     fassert(28521, status.getStatus());
     invariant(status.getValue() == loc);
 }
@@ -324,6 +328,9 @@ Status KVCatalog::renameCollection(OperationContext* opCtx,
         BSONObj obj = b.obj();
         StatusWith<RecordId> status =
             _rs->updateRecord(opCtx, loc, obj.objdata(), obj.objsize(), false, NULL);
+        if (status.getStatus().code() == ErrorCodes::ExceededMemoryLimit) {
+            return status.getStatus();
+        }
         fassert(28522, status.getStatus());
         invariant(status.getValue() == loc);
     }
@@ -106,6 +106,16 @@ void KVCollectionCatalogEntry::setIndexHead(OperationContext* txn,
     _catalog->putMetaData(txn, ns().toString(), md);
 }
 
+void KVCollectionCatalogEntry::setIndexStatistics(OperationContext* txn,
+                                                  StringData indexName,
+                                                  const BSONObj& statistics) {
+    MetaData md = _getMetaData(txn);
+    int offset = md.findIndexOffset(indexName);
+    invariant(offset >= 0);
+    md.indexes[offset].statistics = statistics.getOwned();
+    _catalog->putMetaData(txn, ns().toString(), md);
+}
+
 Status KVCollectionCatalogEntry::removeIndex(OperationContext* txn, StringData indexName) {
     MetaData md = _getMetaData(txn);
 
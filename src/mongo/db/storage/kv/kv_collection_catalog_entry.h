@@ -56,6 +56,10 @@ public:
 
     void setIndexHead(OperationContext* txn, StringData indexName, const RecordId& newHead) final;
 
+    void setIndexStatistics(OperationContext* txn,
+                            StringData indexName,
+                            const BSONObj& statistics) final;
+
     Status removeIndex(OperationContext* txn, StringData indexName) final;
 
     Status prepareForIndexBuild(OperationContext* txn, const IndexDescriptor* spec) final;
@@ -177,6 +177,7 @@ public:
     enum UserFlags {
         Flag_UsePowerOf2Sizes = 1 << 0,
         Flag_NoPadding = 1 << 1,
+        Flag_Compressed = 1 << 2,
     };
 
     IndexDetails& idx(int idxNo, bool missingExpected = false);
@@ -54,4 +54,16 @@ size_t compress(const char* input, size_t input_length, std::string* output) {
 bool uncompress(const char* compressed, size_t compressed_length, std::string* uncompressed) {
     return snappy::Uncompress(compressed, compressed_length, uncompressed);
 }
+
+bool rawUncompress(const char* compressed,
+                   size_t compressed_length,
+                   char* uncompressed,
+                   size_t uncompressed_length) {
+    size_t length;
+    if (!snappy::GetUncompressedLength(compressed, compressed_length, &length) ||
+        length != uncompressed_length) {
+        return false;
+    }
+    return snappy::RawUncompress(compressed, compressed_length, uncompressed);
+}
 }
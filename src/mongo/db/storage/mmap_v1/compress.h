@@ -38,6 +38,15 @@ size_t compress(const char* input, size_t input_length, std::string* output);
 
 bool uncompress(const char* compressed, size_t compressed_length, std::string* uncompressed);
 
+/**
+ * Uncompresses into a caller provided buffer. Returns false if the input is corrupt or does not
+ * uncompress to exactly 'uncompressed_length' bytes, in which case nothing is written.
+ */
+bool rawUncompress(const char* compressed,
+                   size_t compressed_length,
+                   char* uncompressed,
+                   size_t uncompressed_length);
+
 size_t maxCompressedLength(size_t source_len);
 void rawCompress(const char* input,
                  size_t input_length,
@@ -0,0 +1,102 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/mmap_v1/decompressed_record_cache.h"
+
+#include <iterator>
+
+#include "mongo/bson/bsonobjbuilder.h"
+
+namespace mongo {
+
+DecompressedRecordCache::DecompressedRecordCache(size_t maxBytes) : _maxBytes(maxBytes) {}
+
+bool DecompressedRecordCache::find(const RecordId& id, RecordData* out) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _index.find(id);
+    if (it == _index.end()) {
+        _misses++;
+        return false;
+    }
+
+    _hits++;
+    _entries.splice(_entries.begin(), _entries, it->second);
+    *out = RecordData(it->second->data, it->second->size);
+    return true;
+}
+
+void DecompressedRecordCache::insert(const RecordId& id, SharedBuffer data, int size) {
+    if (static_cast<size_t>(size) > _maxBytes)
+        return;
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _index.find(id);
+    if (it != _index.end())
+        _remove_inlock(it->second);
+
+    while (!_entries.empty() && _bytes + size > _maxBytes) {
+        _remove_inlock(std::prev(_entries.end()));
+    }
+
+    _entries.push_front(Entry{id, std::move(data), size});
+    _index[id] = _entries.begin();
+    _bytes += size;
+}
+
+void DecompressedRecordCache::invalidate(const RecordId& id) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _index.find(id);
+    if (it != _index.end())
+        _remove_inlock(it->second);
+}
+
+void DecompressedRecordCache::clear() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _entries.clear();
+    _index.clear();
+    _bytes = 0;
+}
+
+void DecompressedRecordCache::appendStats(BSONObjBuilder* builder) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    builder->appendNumber("cacheEntries", static_cast<long long>(_entries.size()));
+    builder->appendNumber("cacheBytes", static_cast<long long>(_bytes));
+    builder->appendNumber("cacheMaxBytes", static_cast<long long>(_maxBytes));
+    builder->appendNumber("cacheHits", _hits);
+    builder->appendNumber("cacheMisses", _misses);
+}
+
+void DecompressedRecordCache::_remove_inlock(EntryList::iterator it) {
+    _bytes -= it->size;
+    _index.erase(it->id);
+    _entries.erase(it);
+}
+
+}  // namespace mongo
@@ -0,0 +1,100 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/record_data.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * Keeps the most recently read records of a compressed collection in their uncompressed form,
+ * so that repeated reads of a hot record don't pay for decompression each time. The cache is
+ * bounded by the total size of the records it holds and evicts the least recently used ones.
+ *
+ * The record store must invalidate a location whenever the bytes stored there change. Entries
+ * are shared with the RecordData handed out by find(), so eviction never frees a buffer that a
+ * reader is still using.
+ */
+class DecompressedRecordCache {
+    MONGO_DISALLOW_COPYING(DecompressedRecordCache);
+
+public:
+    explicit DecompressedRecordCache(size_t maxBytes);
+
+    /**
+     * Returns true and sets 'out' to an owned RecordData if 'id' is cached.
+     */
+    bool find(const RecordId& id, RecordData* out);
+
+    /**
+     * Caches the 'size' bytes in 'data' as the contents of 'id'. Records bigger than the whole
+     * cache are not kept.
+     */
+    void insert(const RecordId& id, SharedBuffer data, int size);
+
+    void invalidate(const RecordId& id);
+
+    void clear();
+
+    void appendStats(BSONObjBuilder* builder) const;
+
+private:
+    struct Entry {
+        RecordId id;
+        SharedBuffer data;
+        int size;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    void _remove_inlock(EntryList::iterator it);
+
+    const size_t _maxBytes;
+
+    mutable stdx::mutex _mutex;
+
+    // Most recently used first.
+    EntryList _entries;
+    std::unordered_map<RecordId, EntryList::iterator, RecordId::Hasher> _index;
+    size_t _bytes = 0;
+
+    long long _hits = 0;
+    long long _misses = 0;
+};
+
+}  // namespace mongo
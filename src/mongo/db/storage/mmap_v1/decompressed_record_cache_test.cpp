@@ -0,0 +1,111 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/mmap_v1/decompressed_record_cache.h"
+
+#include <cstring>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+SharedBuffer makeBuffer(const char* contents) {
+    SharedBuffer buffer = SharedBuffer::allocate(std::strlen(contents) + 1);
+    std::strcpy(buffer.get(), contents);
+    return buffer;
+}
+
+void insert(DecompressedRecordCache* cache, int id, const char* contents) {
+    cache->insert(RecordId(id), makeBuffer(contents), std::strlen(contents) + 1);
+}
+
+TEST(DecompressedRecordCacheTest, FindReturnsOwnedCopy) {
+    DecompressedRecordCache cache(100);
+    insert(&cache, 1, "one");
+
+    RecordData data;
+    ASSERT_TRUE(cache.find(RecordId(1), &data));
+    ASSERT_TRUE(data.isOwned());
+    ASSERT_EQUALS(4, data.size());
+    ASSERT_EQUALS(std::string("one"), data.data());
+    ASSERT_FALSE(cache.find(RecordId(2), &data));
+
+    // Dropping the entry doesn't free the buffer from under the reader.
+    cache.clear();
+    ASSERT_EQUALS(std::string("one"), data.data());
+}
+
+TEST(DecompressedRecordCacheTest, EvictsLeastRecentlyUsed) {
+    DecompressedRecordCache cache(12);
+    insert(&cache, 1, "one");
+    insert(&cache, 2, "two");
+    insert(&cache, 3, "six");
+
+    RecordData data;
+    ASSERT_TRUE(cache.find(RecordId(1), &data));
+    insert(&cache, 4, "ten");
+
+    ASSERT_TRUE(cache.find(RecordId(1), &data));
+    ASSERT_FALSE(cache.find(RecordId(2), &data));
+    ASSERT_TRUE(cache.find(RecordId(3), &data));
+    ASSERT_TRUE(cache.find(RecordId(4), &data));
+}
+
+TEST(DecompressedRecordCacheTest, InvalidateAndReplace) {
+    DecompressedRecordCache cache(100);
+    insert(&cache, 1, "one");
+    insert(&cache, 1, "uno");
+
+    RecordData data;
+    ASSERT_TRUE(cache.find(RecordId(1), &data));
+    ASSERT_EQUALS(std::string("uno"), data.data());
+
+    cache.invalidate(RecordId(1));
+    ASSERT_FALSE(cache.find(RecordId(1), &data));
+}
+
+TEST(DecompressedRecordCacheTest, SkipsRecordsLargerThanTheCache) {
+    DecompressedRecordCache cache(4);
+    insert(&cache, 1, "toolarge");
+
+    RecordData data;
+    ASSERT_FALSE(cache.find(RecordId(1), &data));
+
+    BSONObjBuilder builder;
+    cache.appendStats(&builder);
+    BSONObj stats = builder.obj();
+    ASSERT_EQUALS(0, stats["cacheBytes"].numberLong());
+    ASSERT_EQUALS(1, stats["cacheMisses"].numberLong());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -120,6 +120,14 @@ public:
      */
     virtual std::unique_ptr<RecordFetcher> recordNeedsFetch(const DiskLoc& loc) const = 0;
 
+    /**
+     * Asks the OS to start reading the page the record at 'loc' starts on, without waiting for
+     * it. Returns false if that isn't supported.
+     */
+    virtual bool prefetchRecord(const DiskLoc& loc) const {
+        return false;
+    }
+
     /**
      * @param loc - has to be for a specific MmapV1RecordHeader (not an Extent)
      * Note(erh) see comment on recordFor
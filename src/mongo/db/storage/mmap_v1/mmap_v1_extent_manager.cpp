@@ -32,6 +32,10 @@
 
 #include <boost/filesystem/operations.hpp>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
 #include "mongo/db/storage/mmap_v1/mmap_v1_extent_manager.h"
 
 #include "mongo/base/counter.h"
@@ -311,6 +315,17 @@ std::unique_ptr<RecordFetcher> MmapV1ExtentManager::recordNeedsFetch(const DiskL
     return {};
 }
 
+bool MmapV1ExtentManager::prefetchRecord(const DiskLoc& loc) const {
+#ifdef _WIN32
+    return false;
+#else
+    // Only the address is computed here, reading the record could block on a page fault.
+    const uintptr_t address = reinterpret_cast<uintptr_t>(_recordForV1(loc));
+    const uintptr_t page = address & ~(static_cast<uintptr_t>(g_minOSPageSizeBytes) - 1);
+    return madvise(reinterpret_cast<void*>(page), g_minOSPageSizeBytes, MADV_WILLNEED) == 0;
+#endif
+}
+
 DiskLoc MmapV1ExtentManager::extentLocForV1(const DiskLoc& loc) const {
     MmapV1RecordHeader* record = recordForV1(loc);
     return DiskLoc(loc.a(), record->extentOfs());
@@ -121,6 +121,8 @@ public:
 
     std::unique_ptr<RecordFetcher> recordNeedsFetch(const DiskLoc& loc) const final;
 
+    bool prefetchRecord(const DiskLoc& loc) const final;
+
     /**
      * @param loc - has to be for a specific MmapV1RecordHeader (not an Extent)
      * Note(erh) see comment on recordFor
@@ -33,9 +33,13 @@
 #include "mongo/db/storage/mmap_v1/record_store_v1_base.h"
 
 
+#include "mongo/base/data_view.h"
+#include "mongo/bson/util/builder.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/client.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/mmap_v1/compress.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
 #include "mongo/db/storage/mmap_v1/record.h"
@@ -52,6 +56,44 @@ using std::unique_ptr;
 using std::set;
 using std::string;
 
+namespace {
+
+// Upper bound on the uncompressed records each compressed collection keeps in memory.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(mmapv1DecompressedRecordCacheSizeBytes,
+                                      int,
+                                      16 * 1024 * 1024);
+
+// A compressed record starts with this marker, followed by the uncompressed and the compressed
+// size and then the snappy compressed document. A BSON document starts with its length, which is
+// positive, so the two forms can't be confused.
+const int kCompressedRecordMarker = -0x52504d43;
+const int kCompressedRecordHeaderSize = 3 * sizeof(int);
+
+bool isCompressedRecord(const char* data) {
+    return ConstDataView(data).read<LittleEndian<int>>() == kCompressedRecordMarker;
+}
+
+/**
+ * Compresses 'len' bytes at 'data' into 'out', header included. Returns false if that doesn't
+ * make the record any smaller, in which case it should be stored as is.
+ */
+bool compressRecord(const char* data, int len, std::string* out) {
+    out->resize(kCompressedRecordHeaderSize + maxCompressedLength(len));
+    size_t compressedLen;
+    rawCompress(data, len, &(*out)[kCompressedRecordHeaderSize], &compressedLen);
+    if (kCompressedRecordHeaderSize + compressedLen >= static_cast<size_t>(len))
+        return false;
+
+    DataView header(&(*out)[0]);
+    header.write<LittleEndian<int>>(kCompressedRecordMarker);
+    header.write<LittleEndian<int>>(len, sizeof(int));
+    header.write<LittleEndian<int>>(static_cast<int>(compressedLen), 2 * sizeof(int));
+    out->resize(kCompressedRecordHeaderSize + compressedLen);
+    return true;
+}
+
+}  // namespace
+
 /* Deleted list buckets are used to quickly locate free space based on size.  Each bucket
    contains records up to that size (meaning a record with a size exactly equal to
    bucketSizes[n] would go into bucket n+1).
@@ -133,7 +175,11 @@ RecordStoreV1Base::RecordStoreV1Base(StringData ns,
                                      RecordStoreV1MetaData* details,
                                      ExtentManager* em,
                                      bool isSystemIndexes)
-    : RecordStore(ns), _details(details), _extentManager(em), _isSystemIndexes(isSystemIndexes) {}
+    : RecordStore(ns),
+      _details(details),
+      _extentManager(em),
+      _isSystemIndexes(isSystemIndexes),
+      _decompressedCache(mmapv1DecompressedRecordCacheSizeBytes) {}
 
 RecordStoreV1Base::~RecordStoreV1Base() {}
 
@@ -170,7 +216,8 @@ int64_t RecordStoreV1Base::storageSize(OperationContext* txn,
 }
 
 RecordData RecordStoreV1Base::dataFor(OperationContext* txn, const RecordId& loc) const {
-    return recordFor(DiskLoc::fromRecordId(loc))->toRecordData();
+    const DiskLoc dl = DiskLoc::fromRecordId(loc);
+    return _recordDataFor(dl, recordFor(dl));
 }
 
 bool RecordStoreV1Base::findRecord(OperationContext* txn,
@@ -179,14 +226,55 @@ bool RecordStoreV1Base::findRecord(OperationContext* txn,
     // this is a bit odd, as the semantics of using the storage engine imply it _has_ to be.
     // And in fact we can't actually check.
     // So we assume the best.
-    MmapV1RecordHeader* rec = recordFor(DiskLoc::fromRecordId(loc));
+    const DiskLoc dl = DiskLoc::fromRecordId(loc);
+    MmapV1RecordHeader* rec = recordFor(dl);
     if (!rec) {
         return false;
     }
-    *rd = rec->toRecordData();
+    *rd = _recordDataFor(dl, rec);
     return true;
 }
 
+RecordData RecordStoreV1Base::_recordDataFor(const DiskLoc& loc,
+                                             const MmapV1RecordHeader* rec) const {
+    if (!compressRecords() || !isCompressedRecord(rec->data()))
+        return rec->toRecordData();
+
+    const RecordId id = loc.toRecordId();
+    RecordData cached;
+    if (_decompressedCache.find(id, &cached))
+        return cached;
+
+    ConstDataView header(rec->data());
+    const int len = header.read<LittleEndian<int>>(sizeof(int));
+    const int compressedLen = header.read<LittleEndian<int>>(2 * sizeof(int));
+    if (len <= 0 || len > BSONObjMaxInternalSize || compressedLen <= 0 ||
+        compressedLen > rec->netLength() - kCompressedRecordHeaderSize) {
+        // Hand out the raw bytes, which validation reports as an invalid document. A corrupt
+        // length must not make us allocate more than any record can hold.
+        return rec->toRecordData();
+    }
+
+    SharedBuffer buffer = SharedBuffer::allocate(len);
+    if (!rawUncompress(
+            rec->data() + kCompressedRecordHeaderSize, compressedLen, buffer.get(), len)) {
+        return rec->toRecordData();
+    }
+
+    _decompressedCache.insert(id, buffer, len);
+    return RecordData(std::move(buffer), len);
+}
+
+void RecordStoreV1Base::_invalidateDecompressed(OperationContext* txn, const DiskLoc& loc) {
+    if (!compressRecords())
+        return;
+
+    const RecordId id = loc.toRecordId();
+    DecompressedRecordCache* const cache = &_decompressedCache;
+    cache->invalidate(id);
+    txn->recoveryUnit()->onRollback([cache, id]() { cache->invalidate(id); });
+}
+
 MmapV1RecordHeader* RecordStoreV1Base::recordFor(const DiskLoc& loc) const {
     return _extentManager->recordForV1(loc);
 }
@@ -305,6 +393,15 @@ StatusWith<RecordId> RecordStoreV1Base::insertRecord(OperationContext* txn,
     if (lenWHdr > MaxAllowedAllocation) {
         return StatusWith<RecordId>(ErrorCodes::InvalidLength, "record has to be <= 16.5MB");
     }
+
+    if (compressRecords()) {
+        // The document has to be written out to be compressed. How much padding it gets then
+        // depends on its compressed size, like for any other insert.
+        std::unique_ptr<char[]> buffer(new char[docSize]);
+        doc->writeDocument(buffer.get());
+        return insertRecord(txn, buffer.get(), docSize, enforceQuota);
+    }
+
     const int lenToAlloc =
         (doc->addPadding() && shouldPadInserts()) ? quantizeAllocationSpace(lenWHdr) : lenWHdr;
 
@@ -338,6 +435,11 @@ StatusWith<RecordId> RecordStoreV1Base::insertRecord(OperationContext* txn,
         return StatusWith<RecordId>(ErrorCodes::InvalidLength, "record has to be <= 16.5MB");
     }
 
+    std::string compressed;
+    if (compressRecords() && compressRecord(data, len, &compressed)) {
+        return _insertRecord(txn, compressed.data(), compressed.size(), enforceQuota);
+    }
+
     return _insertRecord(txn, data, len, enforceQuota);
 }
 
@@ -359,6 +461,7 @@ StatusWith<RecordId> RecordStoreV1Base::_insertRecord(OperationContext* txn,
     // copy the data
     r = reinterpret_cast<MmapV1RecordHeader*>(txn->recoveryUnit()->writingPtr(r, lenWHdr));
     memcpy(r->data(), data, len);
+    _invalidateDecompressed(txn, loc.getValue());
 
     _addRecordToRecListInExtent(txn, r, loc.getValue());
 
@@ -373,7 +476,14 @@ StatusWith<RecordId> RecordStoreV1Base::updateRecord(OperationContext* txn,
                                                      int dataSize,
                                                      bool enforceQuota,
                                                      UpdateNotifier* notifier) {
-    MmapV1RecordHeader* oldRecord = recordFor(DiskLoc::fromRecordId(oldLocation));
+    std::string compressed;
+    if (compressRecords() && compressRecord(data, dataSize, &compressed)) {
+        data = compressed.data();
+        dataSize = compressed.size();
+    }
+
+    const DiskLoc oldLoc = DiskLoc::fromRecordId(oldLocation);
+    MmapV1RecordHeader* oldRecord = recordFor(oldLoc);
     if (oldRecord->netLength() >= dataSize) {
         // Make sure to notify other queries before we do an in-place update.
         if (notifier) {
@@ -384,6 +494,7 @@ StatusWith<RecordId> RecordStoreV1Base::updateRecord(OperationContext* txn,
 
         // we fit
         memcpy(txn->recoveryUnit()->writingPtr(oldRecord->data(), dataSize), data, dataSize);
+        _invalidateDecompressed(txn, oldLoc);
         return StatusWith<RecordId>(oldLocation);
     }
 
@@ -401,8 +512,9 @@ StatusWith<RecordId> RecordStoreV1Base::updateRecord(OperationContext* txn,
 
     // insert worked, so we delete old record
     if (notifier) {
-        Status moveStatus = notifier->recordStoreGoingToMove(
-            txn, oldLocation, oldRecord->data(), oldRecord->netLength());
+        const RecordData oldData = _recordDataFor(oldLoc, oldRecord);
+        Status moveStatus =
+            notifier->recordStoreGoingToMove(txn, oldLocation, oldData.data(), oldData.size());
         if (!moveStatus.isOK())
             return StatusWith<RecordId>(moveStatus);
     }
@@ -413,7 +525,8 @@ StatusWith<RecordId> RecordStoreV1Base::updateRecord(OperationContext* txn,
 }
 
 bool RecordStoreV1Base::updateWithDamagesSupported() const {
-    return true;
+    // Damages are offsets into the uncompressed document.
+    return !compressRecords();
 }
 
 StatusWith<RecordData> RecordStoreV1Base::updateWithDamages(
@@ -478,6 +591,8 @@ void RecordStoreV1Base::deleteRecord(OperationContext* txn, const RecordId& rid)
         }
     }
 
+    _invalidateDecompressed(txn, dl);
+
     /* add to the free list */
     {
         _details->incrementStats(txn, -1 * todelete->netLength(), -1);
@@ -732,7 +847,7 @@ Status RecordStoreV1Base::validate(OperationContext* txn,
 
                 if (full) {
                     size_t dataSize = 0;
-                    const Status status = adaptor->validate(r->toRecordData(), &dataSize);
+                    const Status status = adaptor->validate(_recordDataFor(dl, r), &dataSize);
                     if (!status.isOK()) {
                         results->valid = false;
                         if (nInvalid == 0)  // only log once;
@@ -850,6 +965,11 @@ void RecordStoreV1Base::appendCustomStats(OperationContext* txn,
         result->appendNumber("max", _details->maxCappedDocs());
         result->appendNumber("maxSize", static_cast<long long>(storageSize(txn, NULL, 0) / scale));
     }
+    if (compressRecords()) {
+        BSONObjBuilder compression(result->subobjStart("compression"));
+        _decompressedCache.appendStats(&compression);
+        compression.doneFast();
+    }
 }
 
 
@@ -33,6 +33,7 @@
 #include "mongo/util/concurrency/spin_lock.h"
 #include "mongo/platform/unordered_set.h"
 
+#include "mongo/db/storage/mmap_v1/decompressed_record_cache.h"
 #include "mongo/db/storage/mmap_v1/diskloc.h"
 #include "mongo/db/storage/record_store.h"
 
@@ -271,6 +272,14 @@ protected:
 
     virtual bool shouldPadInserts() const = 0;
 
+    /**
+     * Whether new records are stored snappy compressed. Compressed and plain records may be
+     * mixed in one collection, each record says which form it is in.
+     */
+    virtual bool compressRecords() const {
+        return false;
+    }
+
     virtual StatusWith<DiskLoc> allocRecord(OperationContext* txn,
                                             int lengthWithHeaders,
                                             bool enforceQuota) = 0;
@@ -312,10 +321,24 @@ protected:
                                        int len,
                                        bool enforceQuota);
 
+    /**
+     * Returns the contents of the record at 'loc', uncompressing it if it is stored compressed.
+     */
+    RecordData _recordDataFor(const DiskLoc& loc, const MmapV1RecordHeader* rec) const;
+
+    /**
+     * Drops the uncompressed copy of the record at 'loc', now and if the unit of work in 'txn'
+     * rolls back, since rolling back restores bytes the cache knows nothing about.
+     */
+    void _invalidateDecompressed(OperationContext* txn, const DiskLoc& loc);
+
     std::unique_ptr<RecordStoreV1MetaData> _details;
     ExtentManager* _extentManager;
     bool _isSystemIndexes;
 
+    // Only used when compressRecords() is true.
+    mutable DecompressedRecordCache _decompressedCache;
+
     friend class RecordStoreV1RepairCursor;
 };
 
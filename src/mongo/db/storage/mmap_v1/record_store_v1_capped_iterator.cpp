@@ -212,4 +212,13 @@ std::unique_ptr<RecordFetcher> CappedRecordStoreV1Iterator::fetcherForId(const R
     return _recordStore->_extentManager->recordNeedsFetch(DiskLoc::fromRecordId(id));
 }
 
+size_t CappedRecordStoreV1Iterator::prefetch(const std::vector<RecordId>& ids) {
+    size_t prefetched = 0;
+    for (auto&& id : ids) {
+        if (_recordStore->_extentManager->prefetchRecord(DiskLoc::fromRecordId(id)))
+            prefetched++;
+    }
+    return prefetched;
+}
+
 }  // namespace mongo
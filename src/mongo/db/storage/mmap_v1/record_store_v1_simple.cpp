@@ -199,6 +199,8 @@ Status SimpleRecordStoreV1::truncate(OperationContext* txn) {
         return Status::OK();
     }
 
+    _decompressedCache.clear();
+
     // Free all extents except the first.
     Extent* firstExt = _extentManager->getExtent(firstExtLoc);
     if (!firstExt->xnext.isNull()) {
@@ -260,13 +262,13 @@ public:
     /**
      * param allocationSize - allocation size WITH header
      */
-    CompactDocWriter(const MmapV1RecordHeader* rec, unsigned dataSize, size_t allocationSize)
-        : _rec(rec), _dataSize(dataSize), _allocationSize(allocationSize) {}
+    CompactDocWriter(const char* data, unsigned dataSize, size_t allocationSize)
+        : _data(data), _dataSize(dataSize), _allocationSize(allocationSize) {}
 
     virtual ~CompactDocWriter() {}
 
     virtual void writeDocument(char* buf) const {
-        memcpy(buf, _rec->data(), _dataSize);
+        memcpy(buf, _data, _dataSize);
     }
 
     virtual size_t documentSize() const {
@@ -278,7 +280,7 @@ public:
     }
 
 private:
-    const MmapV1RecordHeader* _rec;
+    const char* _data;
     size_t _dataSize;
     size_t _allocationSize;
 };
@@ -325,7 +327,7 @@ void SimpleRecordStoreV1::_compactExtent(OperationContext* txn,
 
             WriteUnitOfWork wunit(txn);
             MmapV1RecordHeader* recOld = recordFor(nextSourceLoc);
-            RecordData oldData = recOld->toRecordData();
+            RecordData oldData = _recordDataFor(nextSourceLoc, recOld);
             nextSourceLoc = getNextRecordInExtent(txn, nextSourceLoc);
 
             if (compactOptions->validateDocuments && !adaptor->isDataValid(oldData)) {
@@ -367,17 +369,21 @@ void SimpleRecordStoreV1::_compactExtent(OperationContext* txn,
                 // Copy the data to a new record. Because we orphaned the record freelist at the
                 // start of the compact, this insert will allocate a record in a new extent.
                 // See the comment in compact() for more details.
-                CompactDocWriter writer(recOld, rawDataSize, allocationSize);
-                StatusWith<RecordId> status = insertRecord(txn, &writer, false);
+                // In a compressed collection the padding has to follow the compressed size, so
+                // the record is inserted like any other and the padding mode doesn't apply.
+                CompactDocWriter writer(oldData.data(), rawDataSize, allocationSize);
+                StatusWith<RecordId> status = compressRecords()
+                    ? insertRecord(txn, oldData.data(), rawDataSize, false)
+                    : insertRecord(txn, &writer, false);
                 uassertStatusOK(status.getStatus());
-                const MmapV1RecordHeader* newRec =
-                    recordFor(DiskLoc::fromRecordId(status.getValue()));
-                invariant(unsigned(newRec->netLength()) >= rawDataSize);
+                const DiskLoc newLoc = DiskLoc::fromRecordId(status.getValue());
+                const MmapV1RecordHeader* newRec = recordFor(newLoc);
+                invariant(compressRecords() || unsigned(newRec->netLength()) >= rawDataSize);
                 totalNetSize += newRec->netLength();
 
                 // Tells the caller that the record has been moved, so it can do things such as
                 // add it to indexes.
-                adaptor->inserted(newRec->toRecordData(), status.getValue());
+                adaptor->inserted(_recordDataFor(newLoc, newRec), status.getValue());
             }
 
             // Remove the old record from the linked list of records withing the sourceExtent.
@@ -82,6 +82,9 @@ protected:
     virtual bool shouldPadInserts() const {
         return !_details->isUserFlagSet(CollectionOptions::Flag_NoPadding);
     }
+    virtual bool compressRecords() const {
+        return _details->isUserFlagSet(CollectionOptions::Flag_Compressed);
+    }
 
     virtual StatusWith<DiskLoc> allocRecord(OperationContext* txn,
                                             int lengthWithHeaders,
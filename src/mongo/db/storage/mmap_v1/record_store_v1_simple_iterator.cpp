@@ -126,4 +126,13 @@ std::unique_ptr<RecordFetcher> SimpleRecordStoreV1Iterator::fetcherForNext() con
 std::unique_ptr<RecordFetcher> SimpleRecordStoreV1Iterator::fetcherForId(const RecordId& id) const {
     return _recordStore->_extentManager->recordNeedsFetch(DiskLoc::fromRecordId(id));
 }
+
+size_t SimpleRecordStoreV1Iterator::prefetch(const std::vector<RecordId>& ids) {
+    size_t prefetched = 0;
+    for (auto&& id : ids) {
+        if (_recordStore->_extentManager->prefetchRecord(DiskLoc::fromRecordId(id)))
+            prefetched++;
+    }
+    return prefetched;
+}
 }
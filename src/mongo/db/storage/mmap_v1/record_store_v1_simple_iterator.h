@@ -60,6 +60,7 @@ public:
     void invalidate(OperationContext* txn, const RecordId& dl) final;
     std::unique_ptr<RecordFetcher> fetcherForNext() const final;
     std::unique_ptr<RecordFetcher> fetcherForId(const RecordId& id) const final;
+    size_t prefetch(const std::vector<RecordId>& ids) final;
 
 private:
     void advance();
@@ -30,10 +30,14 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
 
+#include <limits>
+
+#include "mongo/base/data_view.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/storage/mmap_v1/record_store_v1_test_help.h"
+#include "mongo/platform/random.h"
 #include "mongo/unittest/unittest.h"
 
 using namespace mongo;
@@ -449,4 +453,108 @@ TEST(SimpleRecordStoreV1, Truncate) {
         assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
     }
 }
+
+// -----------------
+
+BSONObj compressibleDoc(char c) {
+    return BSON("_id" << 1 << "s" << string(1000, c));
+}
+
+BSONObj incompressibleDoc() {
+    PseudoRandom random(12345);
+    string s;
+    for (int i = 0; i < 1000; i++) {
+        s += static_cast<char>(random.nextInt32());
+    }
+    return BSON("_id" << 1 << "s" << s);
+}
+
+TEST(SimpleRecordStoreV1, CompressedInsertRoundTrips) {
+    OperationContextNoop txn;
+    DummyExtentManager em;
+    DummyRecordStoreV1MetaData* md =
+        new DummyRecordStoreV1MetaData(false, CollectionOptions::Flag_Compressed);
+    SimpleRecordStoreV1 rs(&txn, "test.foo", md, &em, false);
+
+    const BSONObj doc = compressibleDoc('a');
+    StatusWith<RecordId> result = rs.insertRecord(&txn, doc.objdata(), doc.objsize(), false);
+    ASSERT_OK(result.getStatus());
+    ASSERT_LESS_THAN(md->dataSize(), doc.objsize());
+    ASSERT_EQUALS(doc, rs.dataFor(&txn, result.getValue()).toBson());
+
+    // Served from the cache the second time.
+    ASSERT_EQUALS(doc, rs.dataFor(&txn, result.getValue()).toBson());
+    BSONObjBuilder stats;
+    rs.appendCustomStats(&txn, &stats, 1);
+    ASSERT_EQUALS(1, stats.obj()["compression"]["cacheHits"].numberLong());
+
+    // Records which don't get smaller are stored as they are.
+    StatusWith<RecordId> small = rs.insertRecord(&txn, "abc", 4, false);
+    ASSERT_OK(small.getStatus());
+    ASSERT_EQUALS(string("abc"), string(rs.dataFor(&txn, small.getValue()).data()));
+
+    ASSERT_FALSE(rs.updateWithDamagesSupported());
+}
+
+TEST(SimpleRecordStoreV1, CompressedRecordWithCorruptLength) {
+    OperationContextNoop txn;
+    DummyExtentManager em;
+    DummyRecordStoreV1MetaData* md =
+        new DummyRecordStoreV1MetaData(false, CollectionOptions::Flag_Compressed);
+    SimpleRecordStoreV1 rs(&txn, "test.foo", md, &em, false);
+
+    const BSONObj doc = compressibleDoc('a');
+    StatusWith<RecordId> result = rs.insertRecord(&txn, doc.objdata(), doc.objsize(), false);
+    ASSERT_OK(result.getStatus());
+
+    // The uncompressed length follows the marker of the header. A length no record can have is
+    // not allocated, and the raw bytes are returned instead.
+    MmapV1RecordHeader* rec = em.recordForV1(DiskLoc::fromRecordId(result.getValue()));
+    DataView(rec->data()).write<LittleEndian<int>>(std::numeric_limits<int>::max(), sizeof(int));
+    ASSERT_EQUALS(rec->data(), rs.dataFor(&txn, result.getValue()).data());
+}
+
+TEST(SimpleRecordStoreV1, CompressedInsertWithDocWriter) {
+    OperationContextNoop txn;
+    DummyExtentManager em;
+    DummyRecordStoreV1MetaData* md =
+        new DummyRecordStoreV1MetaData(false, CollectionOptions::Flag_Compressed);
+    SimpleRecordStoreV1 rs(&txn, "test.foo", md, &em, false);
+
+    const BSONObj doc = compressibleDoc('a');
+    BsonDocWriter docWriter(doc, true);
+    StatusWith<RecordId> result = rs.insertRecord(&txn, &docWriter, false);
+    ASSERT_OK(result.getStatus());
+    ASSERT_LESS_THAN(md->dataSize(), doc.objsize());
+    ASSERT_EQUALS(doc, rs.dataFor(&txn, result.getValue()).toBson());
+}
+
+TEST(SimpleRecordStoreV1, CompressedUpdate) {
+    OperationContextNoop txn;
+    DummyExtentManager em;
+    DummyRecordStoreV1MetaData* md =
+        new DummyRecordStoreV1MetaData(false, CollectionOptions::Flag_Compressed);
+    SimpleRecordStoreV1 rs(&txn, "test.foo", md, &em, false);
+
+    const BSONObj doc = compressibleDoc('a');
+    StatusWith<RecordId> result = rs.insertRecord(&txn, doc.objdata(), doc.objsize(), false);
+    ASSERT_OK(result.getStatus());
+    const RecordId loc = result.getValue();
+    ASSERT_EQUALS(doc, rs.dataFor(&txn, loc).toBson());
+
+    // Compresses to the same size, so it fits in place. The cached copy must not be returned.
+    const BSONObj inPlace = compressibleDoc('b');
+    result = rs.updateRecord(&txn, loc, inPlace.objdata(), inPlace.objsize(), false, NULL);
+    ASSERT_OK(result.getStatus());
+    ASSERT_EQUALS(loc, result.getValue());
+    ASSERT_EQUALS(inPlace, rs.dataFor(&txn, loc).toBson());
+
+    // Doesn't compress, so it has to move.
+    const BSONObj moved = incompressibleDoc();
+    result = rs.updateRecord(&txn, loc, moved.objdata(), moved.objsize(), false, NULL);
+    ASSERT_OK(result.getStatus());
+    ASSERT_NOT_EQUALS(loc, result.getValue());
+    ASSERT_EQUALS(moved, rs.dataFor(&txn, result.getValue()).toBson());
+    ASSERT_EQUALS(1, md->numRecords());
+}
 }
@@ -31,6 +31,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <vector>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/bson/mutable/damage_vector.h"
@@ -263,6 +264,15 @@ public:
     virtual std::unique_ptr<RecordFetcher> fetcherForId(const RecordId& id) const {
         return {};
     }
+
+    /**
+     * Hints that the records in 'ids' are about to be read with seekExact(), so that the
+     * storage engine can start bringing them into memory in the background. Must not wait for
+     * any I/O. Returns for how many of the records a read was started, which may be none.
+     */
+    virtual size_t prefetch(const std::vector<RecordId>& ids) {
+        return 0;
+    }
 };
 
 /**
@@ -463,7 +473,9 @@ public:
 
     /**
      * Returns many RecordCursors that partition the RecordStore into many disjoint sets.
-     * Iterating all returned RecordCursors is equivalent to iterating the full store.
+     * Iterating all returned RecordCursors is equivalent to iterating the full store. Unless the
+     * store is capped, iterating them one after the other returns the records in the order of a
+     * forward cursor.
      */
     virtual std::vector<std::unique_ptr<RecordCursor>> getManyCursors(OperationContext* txn) const {
         std::vector<std::unique_ptr<RecordCursor>> out(1);
@@ -29,6 +29,7 @@
 #include <boost/optional/optional.hpp>
 #include <boost/optional/optional_io.hpp>
 #include <memory>
+#include <vector>
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context.h"
@@ -111,6 +112,42 @@ public:
                          const RecordId& loc,
                          bool dupsAllowed) = 0;
 
+    /**
+     * Insert an entry with the RecordId 'loc' for every key in 'keys', as insert() would for
+     * each of them in turn. The keys should be sorted in the order of the index, so that
+     * implementations can make use of consecutive keys landing next to each other in the tree.
+     * Results do not depend on the order, only the speed does.
+     *
+     * Stops at the first key which cannot be inserted and returns its status. The keys before
+     * it stay inserted. '*numProcessed' is set to the position of the failing key, or to the
+     * number of keys if all of them succeeded.
+     */
+    virtual Status insertKeys(OperationContext* txn,
+                              const std::vector<BSONObj>& keys,
+                              const RecordId& loc,
+                              bool dupsAllowed,
+                              size_t* numProcessed) {
+        for (*numProcessed = 0; *numProcessed < keys.size(); ++*numProcessed) {
+            Status status = insert(txn, keys[*numProcessed], loc, dupsAllowed);
+            if (!status.isOK())
+                return status;
+        }
+        return Status::OK();
+    }
+
+    /**
+     * Remove the entries with the RecordId 'loc' for every key in 'keys', as unindex() would
+     * for each of them in turn. The keys should be sorted in the order of the index.
+     */
+    virtual void unindexKeys(OperationContext* txn,
+                             const std::vector<BSONObj>& keys,
+                             const RecordId& loc,
+                             bool dupsAllowed) {
+        for (auto&& key : keys) {
+            unindex(txn, key, loc, dupsAllowed);
+        }
+    }
+
     /**
      * Return ErrorCodes::DuplicateKey if 'key' already exists in 'this'
      * index at a RecordId other than 'loc', and Status::OK() otherwise.
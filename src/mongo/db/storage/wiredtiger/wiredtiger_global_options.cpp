@@ -99,7 +99,21 @@ Status WiredTigerGlobalOptions::add(moe::OptionSection* options) {
                                         moe::String,
                                         "WiredTiger custom index configuration settings").hidden();
 
-    return options->addSection(wiredTigerOptions);
+    Status ret = options->addSection(wiredTigerOptions);
+    if (!ret.isOK()) {
+        return ret;
+    }
+
+    // InMemory storage engine options
+    moe::OptionSection inMemoryOptions("InMemory options");
+    inMemoryOptions.addOptionChaining("storage.inMemory.engineConfig.inMemorySizeGB",
+                                      "inMemorySizeGB",
+                                      moe::Int,
+                                      "maximum amount of memory to use for data and indexes of the "
+                                      "inMemory storage engine; defaults to 1/2 of physical RAM "
+                                      "minus 1GB").validRange(1, 10000);
+
+    return options->addSection(inMemoryOptions);
 }
 
 Status WiredTigerGlobalOptions::store(const moe::Environment& params,
@@ -153,6 +167,12 @@ Status WiredTigerGlobalOptions::store(const moe::Environment& params,
         log() << "Index custom option: " << wiredTigerGlobalOptions.indexConfig;
     }
 
+    // InMemory storage engine options
+    if (params.count("storage.inMemory.engineConfig.inMemorySizeGB")) {
+        wiredTigerGlobalOptions.inMemorySizeGB =
+            params["storage.inMemory.engineConfig.inMemorySizeGB"].as<int>();
+    }
+
     return Status::OK();
 }
 
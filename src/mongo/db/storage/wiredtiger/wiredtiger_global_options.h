@@ -45,7 +45,8 @@ public:
           statisticsLogDelaySecs(0),
           directoryForIndexes(false),
           useCollectionPrefixCompression(false),
-          useIndexPrefixCompression(false){};
+          useIndexPrefixCompression(false),
+          inMemorySizeGB(0){};
 
     Status add(moe::OptionSection* options);
     Status store(const moe::Environment& params, const std::vector<std::string>& args);
@@ -63,6 +64,9 @@ public:
     bool useIndexPrefixCompression;
     std::string collectionConfig;
     std::string indexConfig;
+
+    // Options of the inMemory storage engine, which runs WiredTiger without any files.
+    size_t inMemorySizeGB;
 };
 
 extern WiredTigerGlobalOptions wiredTigerGlobalOptions;
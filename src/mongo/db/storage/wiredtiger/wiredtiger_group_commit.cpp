@@ -0,0 +1,150 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_group_commit.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+const int WiredTigerGroupCommit::Histogram::kNumBuckets;
+
+void WiredTigerGroupCommit::Histogram::record(uint64_t value) {
+    int bucket = 0;
+    while (value != 0 && bucket < kNumBuckets - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    _buckets[bucket]++;
+}
+
+void WiredTigerGroupCommit::Histogram::append(BSONObjBuilder* b) const {
+    for (int i = 0; i < kNumBuckets - 1; i++) {
+        b->append(std::string(str::stream() << "lt" << (1LL << i)), _buckets[i]);
+    }
+    const std::string last = str::stream() << "ge" << (1LL << (kNumBuckets - 2));
+    b->append(last, _buckets[kNumBuckets - 1]);
+}
+
+WiredTigerGroupCommit::WiredTigerGroupCommit(FlushFn flush, Microseconds maxWindow)
+    : _flush(std::move(flush)), _maxWindowMicros(durationCount<Microseconds>(maxWindow)) {}
+
+void WiredTigerGroupCommit::waitForFlush() {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    uint64_t batch = _openBatch;
+    _openBatchSize++;
+    _waiters++;
+    if (_openBatchSize >= _lastBatchSize) {
+        _batchFullCV.notify_one();
+    }
+
+    while (_lastFlushedBatch < batch) {
+        if (_leaderActive) {
+            _flushedCV.wait(lk);
+            continue;
+        }
+
+        if (batch < _openBatch) {
+            // The flush for our batch failed, so try again with the open one.
+            batch = _openBatch;
+            _openBatchSize++;
+        }
+        invariant(batch == _openBatch);
+
+        // Lead the open batch. Callers arriving from here on join it and wait for us.
+        _leaderActive = true;
+        if (_windowMicros > 0 && _openBatchSize < _lastBatchSize) {
+            _batchFullCV.wait_for(lk, Microseconds(_windowMicros), [this] {
+                return _openBatchSize >= _lastBatchSize;
+            });
+        }
+
+        const long long batchSize = _openBatchSize;
+        _openBatch++;
+        _openBatchSize = 0;
+        lk.unlock();
+
+        Timer timer;
+        try {
+            _flush();
+        } catch (...) {
+            lk.lock();
+            _flushFailures++;
+            _leaderActive = false;
+            _flushedCV.notify_all();
+            throw;
+        }
+        const long long flushMicros = timer.micros();
+
+        lk.lock();
+        _leaderActive = false;
+        _lastFlushedBatch = batch;
+        _flushes++;
+        _batchSizes.record(batchSize);
+        _flushMicros.record(flushMicros);
+        _adaptWindow_inlock(flushMicros, batchSize);
+        _flushedCV.notify_all();
+    }
+}
+
+void WiredTigerGroupCommit::appendStats(BSONObjBuilder* b) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    b->append("flushes", _flushes);
+    b->append("waiters", _waiters);
+    b->append("flushFailures", _flushFailures);
+    b->append("windowMicros", _windowMicros);
+    b->append("maxWindowMicros", _maxWindowMicros);
+    b->append("avgFlushMicros", _avgFlushMicros);
+    b->append("queued", _openBatchSize);
+
+    BSONObjBuilder batchSizes(b->subobjStart("batchSize"));
+    _batchSizes.append(&batchSizes);
+    batchSizes.doneFast();
+
+    BSONObjBuilder flushMicros(b->subobjStart("flushMicros"));
+    _flushMicros.append(&flushMicros);
+    flushMicros.doneFast();
+}
+
+void WiredTigerGroupCommit::_adaptWindow_inlock(long long flushMicros, long long batchSize) {
+    _avgFlushMicros =
+        _avgFlushMicros == 0 ? flushMicros : (7 * _avgFlushMicros + flushMicros) / 8;
+    _lastBatchSize = batchSize;
+
+    // Waiting for more callers only pays off when they keep arriving while a flush is running.
+    _windowMicros = _openBatchSize > 0 ? std::min(_maxWindowMicros, _avgFlushMicros / 2) : 0;
+}
+
+}  // namespace mongo
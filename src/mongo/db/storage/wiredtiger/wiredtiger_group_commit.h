@@ -0,0 +1,130 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * Batches callers waiting for their writes to become durable, so that one flush of the journal
+ * serves all of them.
+ *
+ * Every caller of waitForFlush() needs a flush which starts after it arrived. The first caller of
+ * a batch becomes its leader. The leader may hold the batch open for a short window so that more
+ * callers can join, then runs the flush on behalf of the whole batch while callers arriving in the
+ * meantime form the next one.
+ *
+ * The window adapts to the load: it is only opened while callers queue up behind flushes, and
+ * then lasts half the average flush time, capped at 'maxWindow'. The leader closes it early once
+ * its batch is as big as the previous one. A lone writer never waits.
+ */
+class WiredTigerGroupCommit {
+    MONGO_DISALLOW_COPYING(WiredTigerGroupCommit);
+
+public:
+    using FlushFn = stdx::function<void()>;
+
+    /**
+     * Counts of values in power of two buckets. Bucket i holds values below 2^i, the last one
+     * everything else.
+     */
+    class Histogram {
+    public:
+        static const int kNumBuckets = 20;
+
+        void record(uint64_t value);
+
+        /**
+         * Appends one field per bucket, named after its bounds.
+         */
+        void append(BSONObjBuilder* b) const;
+
+    private:
+        long long _buckets[kNumBuckets] = {};
+    };
+
+    /**
+     * 'flush' makes everything written before it started durable. It may throw, in which case the
+     * error is reported to the leader which called it and the rest of the batch tries again.
+     */
+    WiredTigerGroupCommit(FlushFn flush, Microseconds maxWindow);
+
+    /**
+     * Blocks until a flush which started after the call has completed.
+     */
+    void waitForFlush();
+
+    /**
+     * Appends the number of flushes and waiters, the number of callers queued for the next flush,
+     * the current window and histograms of the batch sizes and flush latencies.
+     */
+    void appendStats(BSONObjBuilder* b) const;
+
+private:
+    // Adapts the window after a flush which took 'flushMicros' for a batch of 'batchSize'.
+    void _adaptWindow_inlock(long long flushMicros, long long batchSize);
+
+    const FlushFn _flush;
+    const long long _maxWindowMicros;
+
+    mutable stdx::mutex _mutex;
+
+    // Signalled when a flush completes or the leader gives up.
+    stdx::condition_variable _flushedCV;
+
+    // Signalled when the batch is full enough for the leader to stop waiting for more callers.
+    stdx::condition_variable _batchFullCV;
+
+    // Batches are numbered. '_openBatch' accepts new callers until its leader starts flushing.
+    uint64_t _openBatch = 1;
+    long long _openBatchSize = 0;
+    uint64_t _lastFlushedBatch = 0;
+    bool _leaderActive = false;
+
+    long long _windowMicros = 0;
+    long long _avgFlushMicros = 0;
+    long long _lastBatchSize = 1;
+
+    long long _flushes = 0;
+    long long _waiters = 0;
+    long long _flushFailures = 0;
+    Histogram _batchSizes;
+    Histogram _flushMicros;
+};
+
+}  // namespace mongo
@@ -0,0 +1,169 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_group_commit.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+BSONObj stats(const WiredTigerGroupCommit& groupCommit) {
+    BSONObjBuilder b;
+    groupCommit.appendStats(&b);
+    return b.obj();
+}
+
+/**
+ * A flush which blocks until released, to let callers queue up behind it.
+ */
+class BlockingFlush {
+public:
+    void operator()() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _calls++;
+        _cv.notify_all();
+        _cv.wait(lk, [this] { return _released; });
+    }
+
+    void waitForCalls(int calls) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait(lk, [this, calls] { return _calls >= calls; });
+    }
+
+    void release() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _released = true;
+        _cv.notify_all();
+    }
+
+    int calls() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _calls;
+    }
+
+private:
+    stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+    int _calls = 0;
+    bool _released = false;
+};
+
+TEST(WiredTigerGroupCommitTest, HistogramBucketsByPowersOfTwo) {
+    WiredTigerGroupCommit::Histogram histogram;
+    for (uint64_t value : {0, 1, 2, 3, 4, 7, 8, 1000}) {
+        histogram.record(value);
+    }
+    histogram.record(1ULL << 40);
+
+    BSONObjBuilder b;
+    histogram.append(&b);
+    BSONObj buckets = b.obj();
+    ASSERT_EQUALS(WiredTigerGroupCommit::Histogram::kNumBuckets, buckets.nFields());
+    ASSERT_EQUALS(1, buckets["lt1"].numberLong());
+    ASSERT_EQUALS(1, buckets["lt2"].numberLong());
+    ASSERT_EQUALS(2, buckets["lt4"].numberLong());
+    ASSERT_EQUALS(2, buckets["lt8"].numberLong());
+    ASSERT_EQUALS(1, buckets["lt16"].numberLong());
+    ASSERT_EQUALS(1, buckets["lt1024"].numberLong());
+    ASSERT_EQUALS(1, buckets["ge262144"].numberLong());
+}
+
+TEST(WiredTigerGroupCommitTest, FlushesForEveryCallerWithoutConcurrency) {
+    int flushes = 0;
+    WiredTigerGroupCommit groupCommit([&flushes] { flushes++; }, Milliseconds(10));
+    for (int i = 0; i < 3; i++) {
+        groupCommit.waitForFlush();
+        ASSERT_EQUALS(i + 1, flushes);
+    }
+
+    BSONObj s = stats(groupCommit);
+    ASSERT_EQUALS(3, s["flushes"].numberLong());
+    ASSERT_EQUALS(3, s["waiters"].numberLong());
+    ASSERT_EQUALS(3, s["batchSize"]["lt2"].numberLong());
+    ASSERT_EQUALS(0, s["windowMicros"].numberLong());
+}
+
+TEST(WiredTigerGroupCommitTest, CoalescesCallersQueuedBehindAFlush) {
+    BlockingFlush flush;
+    WiredTigerGroupCommit groupCommit([&flush] { flush(); }, Microseconds(0));
+
+    stdx::thread leader([&groupCommit] { groupCommit.waitForFlush(); });
+    flush.waitForCalls(1);
+
+    std::vector<stdx::thread> followers;
+    for (int i = 0; i < 5; i++) {
+        followers.emplace_back([&groupCommit] { groupCommit.waitForFlush(); });
+    }
+    while (stats(groupCommit)["queued"].numberLong() < 5) {
+        sleepmillis(1);
+    }
+
+    flush.release();
+    leader.join();
+    for (auto&& follower : followers) {
+        follower.join();
+    }
+
+    ASSERT_EQUALS(2, flush.calls());
+    BSONObj s = stats(groupCommit);
+    ASSERT_EQUALS(2, s["flushes"].numberLong());
+    ASSERT_EQUALS(6, s["waiters"].numberLong());
+    ASSERT_EQUALS(1, s["batchSize"]["lt2"].numberLong());
+    ASSERT_EQUALS(1, s["batchSize"]["lt8"].numberLong());
+    ASSERT_EQUALS(0, s["queued"].numberLong());
+}
+
+TEST(WiredTigerGroupCommitTest, ReportsFailedFlushToTheLeader) {
+    bool fail = true;
+    WiredTigerGroupCommit groupCommit([&fail] {
+        if (fail) {
+            fail = false;
+            uasserted(ErrorCodes::InternalError, "flush failed");
+        }
+    }, Microseconds(0));
+
+    ASSERT_THROWS(groupCommit.waitForFlush(), UserException);
+    groupCommit.waitForFlush();
+
+    BSONObj s = stats(groupCommit);
+    ASSERT_EQUALS(1, s["flushes"].numberLong());
+    ASSERT_EQUALS(1, s["flushFailures"].numberLong());
+}
+
+}  // namespace
+}  // namespace mongo
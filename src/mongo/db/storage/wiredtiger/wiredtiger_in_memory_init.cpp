@@ -0,0 +1,133 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/base/init.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/kv/kv_storage_engine.h"
+#include "mongo/db/storage/storage_engine_lock_file.h"
+#include "mongo/db/storage/storage_engine_metadata.h"
+#include "mongo/db/storage/storage_options.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_index.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_parameters.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_server_status.h"
+#include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+
+namespace {
+const char kInMemoryEngineName[] = "inMemory";
+
+/**
+ * Runs WiredTiger with in_memory=true: collections and indexes live in the WiredTiger cache only,
+ * and no data, index or journal files are written to the dbpath.
+ * This keeps WiredTiger's concurrent btrees, document level locking and snapshots, while the
+ * cache size becomes a hard limit on the data held. Writes which would exceed it fail with
+ * ExceededMemoryLimit.
+ */
+class InMemoryFactory : public StorageEngine::Factory {
+public:
+    virtual ~InMemoryFactory() {}
+    virtual StorageEngine* create(const StorageGlobalParams& params,
+                                  const StorageEngineLockFile& lockFile) const {
+        size_t cacheSizeGB = wiredTigerGlobalOptions.inMemorySizeGB;
+        if (cacheSizeGB == 0) {
+            // Unlike the on-disk cache, this is all the data there is, so take a larger share
+            // of the memory, still reserving 1GB for the system and binaries.
+            ProcessInfo pi;
+            double memSizeMB = pi.getMemSizeMB();
+            if (memSizeMB > 0) {
+                double cacheMB = memSizeMB * 0.5 - 1024;
+                cacheSizeGB = static_cast<size_t>(cacheMB / 1024);
+            }
+            if (cacheSizeGB < 1)
+                cacheSizeGB = 1;
+        }
+        log() << "inMemory engine limited to " << cacheSizeGB << "GB of data and indexes";
+
+        const bool durable = false;
+        const bool ephemeral = true;
+        WiredTigerKVEngine* kv = new WiredTigerKVEngine(getCanonicalName().toString(),
+                                                        params.dbpath,
+                                                        wiredTigerGlobalOptions.engineConfig,
+                                                        cacheSizeGB,
+                                                        durable,
+                                                        ephemeral,
+                                                        params.repair);
+        kv->setRecordStoreExtraOptions(wiredTigerGlobalOptions.collectionConfig);
+        kv->setSortedDataInterfaceExtraOptions(wiredTigerGlobalOptions.indexConfig);
+        // Intentionally leaked.
+        new WiredTigerServerStatusSection(kv);
+        new WiredTigerEngineRuntimeConfigParameter(kv);
+
+        KVStorageEngineOptions options;
+        options.directoryPerDB = params.directoryperdb;
+        options.forRepair = params.repair;
+        return new KVStorageEngine(kv, options);
+    }
+
+    virtual StringData getCanonicalName() const {
+        return kInMemoryEngineName;
+    }
+
+    virtual Status validateCollectionStorageOptions(const BSONObj& options) const {
+        return WiredTigerRecordStore::parseOptionsField(options).getStatus();
+    }
+
+    virtual Status validateIndexStorageOptions(const BSONObj& options) const {
+        return WiredTigerIndex::parseIndexOptions(options).getStatus();
+    }
+
+    virtual Status validateMetadata(const StorageEngineMetadata& metadata,
+                                    const StorageGlobalParams& params) const {
+        return metadata.validateStorageEngineOption("directoryPerDB", params.directoryperdb);
+    }
+
+    virtual BSONObj createMetadataOptions(const StorageGlobalParams& params) const {
+        BSONObjBuilder builder;
+        builder.appendBool("directoryPerDB", params.directoryperdb);
+        return builder.obj();
+    }
+};
+}  // namespace
+
+MONGO_INITIALIZER_WITH_PREREQUISITES(InMemoryEngineInit, ("SetGlobalEnvironment"))
+(InitializerContext* context) {
+    getGlobalServiceContext()->registerStorageEngine(kInMemoryEngineName, new InMemoryFactory());
+
+    return Status::OK();
+}
+}  // namespace mongo
@@ -262,6 +262,47 @@ void WiredTigerIndex::unindex(OperationContext* txn,
     _unindex(c, key, id, dupsAllowed);
 }
 
+Status WiredTigerIndex::insertKeys(OperationContext* txn,
+                                   const std::vector<BSONObj>& keys,
+                                   const RecordId& id,
+                                   bool dupsAllowed,
+                                   size_t* numProcessed) {
+    invariant(id.isNormal());
+
+    WiredTigerCursor curwrap(_uri, _tableId, false, txn);
+    curwrap.assertInActiveTxn();
+    WT_CURSOR* c = curwrap.get();
+
+    for (*numProcessed = 0; *numProcessed < keys.size(); ++*numProcessed) {
+        const BSONObj& key = keys[*numProcessed];
+        dassert(!hasFieldNames(key));
+
+        Status s = checkKeySize(key);
+        if (s.isOK())
+            s = _insert(c, key, id, dupsAllowed);
+        if (!s.isOK())
+            return s;
+    }
+    return Status::OK();
+}
+
+void WiredTigerIndex::unindexKeys(OperationContext* txn,
+                                  const std::vector<BSONObj>& keys,
+                                  const RecordId& id,
+                                  bool dupsAllowed) {
+    invariant(id.isNormal());
+
+    WiredTigerCursor curwrap(_uri, _tableId, false, txn);
+    curwrap.assertInActiveTxn();
+    WT_CURSOR* c = curwrap.get();
+    invariant(c);
+
+    for (auto&& key : keys) {
+        dassert(!hasFieldNames(key));
+        _unindex(c, key, id, dupsAllowed);
+    }
+}
+
 void WiredTigerIndex::fullValidate(OperationContext* txn,
                                    bool full,
                                    long long* numKeysOut,
@@ -943,6 +984,109 @@ public:
     }
 };
 
+/**
+ * Returns index entries in a random order, with replacement, using WiredTiger's next_random
+ * cursors. Only supports next().
+ */
+class WiredTigerIndexRandomCursor final : public SortedDataInterface::Cursor {
+public:
+    WiredTigerIndexRandomCursor(const WiredTigerIndex& idx, OperationContext* txn)
+        : _txn(txn), _idx(idx) {
+        restore();
+    }
+
+    ~WiredTigerIndexRandomCursor() {
+        if (_cursor)
+            detachFromOperationContext();
+    }
+
+    boost::optional<IndexKeyEntry> next(RequestedInfo parts) override {
+        int ret = WT_OP_CHECK(_cursor->next(_cursor));
+        if (ret == WT_NOTFOUND)
+            return {};
+        invariantWTOK(ret);
+
+        WT_ITEM keyItem;
+        invariantWTOK(_cursor->get_key(_cursor, &keyItem));
+        WT_ITEM valueItem;
+        invariantWTOK(_cursor->get_value(_cursor, &valueItem));
+
+        // Same formats as read by the updateIdAndTypeBits() implementations above.
+        RecordId id;
+        KeyString::TypeBits typeBits;
+        BufReader br(valueItem.data, valueItem.size);
+        if (_idx.unique()) {
+            id = KeyString::decodeRecordId(&br);
+        } else {
+            id = KeyString::decodeRecordIdAtEnd(keyItem.data, keyItem.size);
+        }
+        typeBits.resetFromBuffer(&br);
+
+        BSONObj key;
+        if (parts & kWantKey) {
+            key = KeyString::toBson(static_cast<const char*>(keyItem.data),
+                                    keyItem.size,
+                                    _idx.ordering(),
+                                    typeBits);
+        }
+        return {{std::move(key), id}};
+    }
+
+    void setEndPosition(const BSONObj& key, bool inclusive) override {
+        MONGO_UNREACHABLE;
+    }
+
+    boost::optional<IndexKeyEntry> seek(const BSONObj& key,
+                                        bool inclusive,
+                                        RequestedInfo parts) override {
+        MONGO_UNREACHABLE;
+    }
+
+    boost::optional<IndexKeyEntry> seek(const IndexSeekPoint& seekPoint,
+                                        RequestedInfo parts) override {
+        MONGO_UNREACHABLE;
+    }
+
+    void save() override {
+        if (_cursor && !wt_keeptxnopen()) {
+            try {
+                _cursor->reset(_cursor);
+            } catch (const WriteConflictException& wce) {
+                // Ignore since this is only called when we are about to kill our transaction
+                // anyway.
+            }
+        }
+    }
+
+    void restore() override {
+        // We can't use the CursorCache since this cursor needs a special config string.
+        WT_SESSION* session = WiredTigerRecoveryUnit::get(_txn)->getSession(_txn)->getSession();
+
+        if (!_cursor) {
+            invariantWTOK(session->open_cursor(
+                session, _idx.uri().c_str(), nullptr, "next_random", &_cursor));
+            invariant(_cursor);
+        }
+    }
+
+    void detachFromOperationContext() override {
+        invariant(_txn);
+        _txn = nullptr;
+        _cursor->close(_cursor);
+        _cursor = nullptr;
+    }
+
+    void reattachToOperationContext(OperationContext* txn) override {
+        invariant(!_txn);
+        _txn = txn;
+    }
+
+private:
+    OperationContext* _txn;
+    WT_CURSOR* _cursor = nullptr;
+    const WiredTigerIndex& _idx;  // not owned
+};
+
 }  // namespace
 
 WiredTigerIndexUnique::WiredTigerIndexUnique(OperationContext* ctx,
@@ -950,6 +1094,11 @@ WiredTigerIndexUnique::WiredTigerIndexUnique(OperationContext* ctx,
                                              const IndexDescriptor* desc)
     : WiredTigerIndex(ctx, uri, desc) {}
 
+std::unique_ptr<SortedDataInterface::Cursor> WiredTigerIndex::newRandomCursor(
+    OperationContext* txn) const {
+    return stdx::make_unique<WiredTigerIndexRandomCursor>(*this, txn);
+}
+
 std::unique_ptr<SortedDataInterface::Cursor> WiredTigerIndexUnique::newCursor(OperationContext* txn,
                                                                               bool forward) const {
     return stdx::make_unique<WiredTigerIndexUniqueCursor>(*this, txn, forward);
@@ -89,6 +89,21 @@ public:
                          const RecordId& id,
                          bool dupsAllowed);
 
+    /**
+     * Inserts all of 'keys' through a single cursor. Sorted keys encode to ascending KeyStrings,
+     * so consecutive inserts go to the same or a neighbouring page.
+     */
+    virtual Status insertKeys(OperationContext* txn,
+                              const std::vector<BSONObj>& keys,
+                              const RecordId& id,
+                              bool dupsAllowed,
+                              size_t* numProcessed);
+
+    virtual void unindexKeys(OperationContext* txn,
+                             const std::vector<BSONObj>& keys,
+                             const RecordId& id,
+                             bool dupsAllowed);
+
     virtual void fullValidate(OperationContext* txn,
                               bool full,
                               long long* numKeysOut,
@@ -106,6 +121,9 @@ public:
 
     bool isDup(WT_CURSOR* c, const BSONObj& key, const RecordId& id);
 
+    std::unique_ptr<SortedDataInterface::Cursor> newRandomCursor(
+        OperationContext* txn) const override;
+
     virtual Status initAsEmpty(OperationContext* txn);
 
     const std::string& uri() const {
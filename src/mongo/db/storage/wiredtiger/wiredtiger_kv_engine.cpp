@@ -49,6 +49,7 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/json.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_customization_hooks.h"
@@ -62,10 +63,12 @@
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/util/log.h"
 #include "mongo/util/background.h"
+#include "mongo/util/concurrency/fair_ticket_holder.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/system_tick_source.h"
 #include "mongo/util/time_support.h"
 
 #if !defined(__has_feature)
@@ -120,12 +123,29 @@ private:
 
 namespace {
 
+// When enabled, the read and write tickets are shared fairly between databases (or VIPs) and
+// their number adapts to the observed latency, up to the configured number of concurrent
+// transactions.
+bool wiredTigerAdmissionControl = false;
+ExportedServerParameter<bool, ServerParameterType::kStartupOnly> wiredTigerAdmissionControlParam(
+    ServerParameterSet::getGlobal(), "wiredTigerAdmissionControl", &wiredTigerAdmissionControl);
+
+// Admission control never shrinks the ticket pools below this size.
+const int kMinAdmissionTickets = 8;
+
+std::unique_ptr<FairTicketHolder> fairWriteTransaction;
+std::unique_ptr<FairTicketHolder> fairReadTransaction;
+
 class TicketServerParameter : public ServerParameter {
     MONGO_DISALLOW_COPYING(TicketServerParameter);
 
 public:
-    TicketServerParameter(TicketHolder* holder, const std::string& name)
-        : ServerParameter(ServerParameterSet::getGlobal(), name, true, true), _holder(holder) {}
+    TicketServerParameter(TicketHolder* holder,
+                          std::unique_ptr<FairTicketHolder>* fairHolder,
+                          const std::string& name)
+        : ServerParameter(ServerParameterSet::getGlobal(), name, true, true),
+          _holder(holder),
+          _fairHolder(fairHolder) {}
 
     virtual void append(OperationContext* txn, BSONObjBuilder& b, const std::string& name) {
         b.append(name, _holder->outof());
@@ -150,21 +170,121 @@ public:
             return Status(ErrorCodes::BadValue, str::stream() << name() << " has to be > 0");
         }
 
+        if (*_fairHolder) {
+            Status status = (*_fairHolder)->setMaxTickets(newNum);
+            if (!status.isOK())
+                return status;
+        }
+
         return _holder->resize(newNum);
     }
 
 private:
     TicketHolder* _holder;
+    std::unique_ptr<FairTicketHolder>* _fairHolder;
 };
 
 TicketHolder openWriteTransaction(128);
 TicketServerParameter openWriteTransactionParam(&openWriteTransaction,
+                                                &fairWriteTransaction,
                                                 "wiredTigerConcurrentWriteTransactions");
 
 TicketHolder openReadTransaction(128);
 TicketServerParameter openReadTransactionParam(&openReadTransaction,
+                                               &fairReadTransaction,
                                                "wiredTigerConcurrentReadTransactions");
 
+/**
+ * Per tenant admission control weights, as a document mapping tenant names to positive integers.
+ * A tenant with weight 2 gets twice the share of tickets of a tenant with the default weight 1.
+ */
+class AdmissionWeightsServerParameter : public ServerParameter {
+    MONGO_DISALLOW_COPYING(AdmissionWeightsServerParameter);
+
+public:
+    AdmissionWeightsServerParameter()
+        : ServerParameter(
+              ServerParameterSet::getGlobal(), "wiredTigerAdmissionControlWeights", true, true) {}
+
+    virtual void append(OperationContext* txn, BSONObjBuilder& b, const std::string& name) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        b.append(name, _weights);
+    }
+
+    virtual Status set(const BSONElement& newValueElement) {
+        if (newValueElement.type() != Object) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << name() << " has to be an object");
+        }
+        return _set(newValueElement.Obj().getOwned());
+    }
+
+    virtual Status setFromString(const std::string& str) {
+        BSONObj weights;
+        try {
+            weights = fromjson(str);
+        } catch (const DBException& ex) {
+            return ex.toStatus();
+        }
+        return _set(weights);
+    }
+
+    /**
+     * Applies the current weights to the fair ticket holders, once they have been created.
+     */
+    Status apply() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _apply_inlock(_weights);
+    }
+
+private:
+    Status _set(const BSONObj& weights) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        Status status = _apply_inlock(weights);
+        if (status.isOK())
+            _weights = weights;
+        return status;
+    }
+
+    Status _apply_inlock(const BSONObj& weights) {
+        std::map<std::string, int> parsed;
+        for (auto&& elem : weights) {
+            if (!elem.isNumber()) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << "weight for tenant '" << elem.fieldName()
+                                            << "' has to be a number");
+            }
+            parsed[elem.fieldName()] = elem.numberInt();
+        }
+
+        for (auto holder : {fairReadTransaction.get(), fairWriteTransaction.get()}) {
+            if (!holder)
+                continue;
+            Status status = holder->setWeights(parsed);
+            if (!status.isOK())
+                return status;
+        }
+        return Status::OK();
+    }
+
+    stdx::mutex _mutex;
+    BSONObj _weights;
+} admissionWeightsParam;
+
+void appendTicketStats(TicketHolder* holder, FairTicketHolder* fairHolder, BSONObjBuilder* b) {
+    if (fairHolder) {
+        const int used = fairHolder->used();
+        const int outof = fairHolder->outof();
+        b->append("out", used);
+        b->append("available", std::max(0, outof - used));
+        b->append("totalTickets", outof);
+    } else {
+        b->append("out", holder->used());
+        b->append("available", holder->available());
+        b->append("totalTickets", holder->outof());
+    }
+}
+
 }  // namespace
 
 WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
@@ -198,6 +318,10 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
     std::stringstream ss;
     ss << "create,";
     ss << "cache_size=" << cacheSizeGB << "G,";
+    if (_ephemeral) {
+        // Nothing is ever written to disk, the cache holds all data and is a hard limit.
+        ss << "in_memory=true,";
+    }
     ss << "session_max=20000,";
     ss << "eviction=(threads_max=4),";
     ss << "config_base=false,";
@@ -217,7 +341,7 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
         // If we started without the journal, but previously used the journal then open with the
         // WT log enabled to perform any unclean shutdown recovery and then close and reopen in
         // the normal path without the journal.
-        if (boost::filesystem::exists(journalPath)) {
+        if (!_ephemeral && boost::filesystem::exists(journalPath)) {
             string config = ss.str();
             log() << "Detected WT journal files.  Running recovery from last checkpoint.";
             log() << "journal to nojournal transition config: " << config;
@@ -263,7 +387,19 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
         _sizeStorer->fillCache();
     }
 
-    Locker::setGlobalThrottling(&openReadTransaction, &openWriteTransaction);
+    if (wiredTigerAdmissionControl) {
+        TickSource* tickSource = SystemTickSource::get();
+        const int maxWrite = openWriteTransaction.outof();
+        const int maxRead = openReadTransaction.outof();
+        fairWriteTransaction.reset(new FairTicketHolder(
+            tickSource, std::min(kMinAdmissionTickets, maxWrite), maxWrite));
+        fairReadTransaction.reset(new FairTicketHolder(
+            tickSource, std::min(kMinAdmissionTickets, maxRead), maxRead));
+        fassertNoTrace(40001, admissionWeightsParam.apply());
+        Locker::setGlobalAdmissionControl(fairReadTransaction.get(), fairWriteTransaction.get());
+    } else {
+        Locker::setGlobalThrottling(&openReadTransaction, &openWriteTransaction);
+    }
 }
 
 
@@ -279,19 +415,30 @@ void WiredTigerKVEngine::appendGlobalStats(BSONObjBuilder& b) {
     BSONObjBuilder bb(b.subobjStart("concurrentTransactions"));
     {
         BSONObjBuilder bbb(bb.subobjStart("write"));
-        bbb.append("out", openWriteTransaction.used());
-        bbb.append("available", openWriteTransaction.available());
-        bbb.append("totalTickets", openWriteTransaction.outof());
+        appendTicketStats(&openWriteTransaction, fairWriteTransaction.get(), &bbb);
         bbb.done();
     }
     {
         BSONObjBuilder bbb(bb.subobjStart("read"));
-        bbb.append("out", openReadTransaction.used());
-        bbb.append("available", openReadTransaction.available());
-        bbb.append("totalTickets", openReadTransaction.outof());
+        appendTicketStats(&openReadTransaction, fairReadTransaction.get(), &bbb);
         bbb.done();
     }
     bb.done();
+
+    if (fairWriteTransaction && fairReadTransaction) {
+        BSONObjBuilder admission(b.subobjStart("admissionControl"));
+        {
+            BSONObjBuilder write(admission.subobjStart("write"));
+            fairWriteTransaction->appendStats(&write);
+            write.done();
+        }
+        {
+            BSONObjBuilder read(admission.subobjStart("read"));
+            fairReadTransaction->appendStats(&read);
+            read.done();
+        }
+        admission.done();
+    }
 }
 
 void WiredTigerKVEngine::cleanShutdown() {
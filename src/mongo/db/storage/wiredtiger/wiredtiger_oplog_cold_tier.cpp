@@ -0,0 +1,696 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_oplog_cold_tier.h"
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <iomanip>
+#include <snappy.h>
+#include <sstream>
+
+#include "mongo/base/data_view.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+const size_t WiredTigerOplogColdTier::kBlockSize;
+
+namespace {
+
+const uint64_t kSegmentMagic = 0x444c4f434c504f4dULL;  // "MOPLCOLD"
+const uint32_t kSegmentVersion = 1;
+
+const char kSegmentSuffix[] = ".seg";
+const char kTmpSuffix[] = ".tmp";
+
+// magic, index offset, number of blocks, version, number of records, data bytes.
+const size_t kFooterSize = 8 + 8 + 4 + 4 + 8 + 8;
+
+// first, last, offset, compressed size.
+const size_t kIndexEntrySize = 8 + 8 + 8 + 4;
+
+// uncompressed size, compressed size.
+const size_t kBlockHeaderSize = 4 + 4;
+
+// id, size.
+const size_t kEntryHeaderSize = 8 + 4;
+
+// Segments are named after both their first and last record, so that a segment which is
+// rewritten by truncateAfter() never reuses the file of the one it replaces.
+std::string segmentPath(const std::string& directory, const RecordId& first, const RecordId& last) {
+    std::stringstream ss;
+    ss << std::setw(20) << std::setfill('0') << first.repr() << '-' << std::setw(20)
+       << std::setfill('0') << last.repr() << kSegmentSuffix;
+    return (boost::filesystem::path(directory) / ss.str()).string();
+}
+
+void removeFile(const std::string& path) {
+    boost::system::error_code ec;
+    boost::filesystem::remove(path, ec);
+    if (ec) {
+        warning() << "failed to remove oplog cold tier file " << path << ": " << ec.message();
+    }
+}
+
+StatusWith<std::shared_ptr<WiredTigerOplogColdTier::Segment>> loadSegment(
+    const std::string& path) {
+    File file;
+    file.open(path.c_str(), /*readOnly=*/true);
+    const fileofs length = file.is_open() ? file.len() : 0;
+    if (file.bad() || length < kFooterSize) {
+        return Status(ErrorCodes::FileStreamFailed,
+                      str::stream() << "cannot read oplog cold tier segment " << path);
+    }
+
+    char footer[kFooterSize];
+    file.read(length - kFooterSize, footer, kFooterSize);
+    ConstDataView footerView(footer);
+    const uint64_t magic = footerView.read<LittleEndian<uint64_t>>();
+    const uint64_t indexOffset = footerView.read<LittleEndian<uint64_t>>(8);
+    const uint32_t numBlocks = footerView.read<LittleEndian<uint32_t>>(16);
+    const uint32_t version = footerView.read<LittleEndian<uint32_t>>(20);
+    if (file.bad() || magic != kSegmentMagic || version != kSegmentVersion ||
+        indexOffset + numBlocks * kIndexEntrySize + kFooterSize != length) {
+        return Status(ErrorCodes::FileStreamFailed,
+                      str::stream() << "invalid oplog cold tier segment " << path);
+    }
+
+    auto segment = std::make_shared<WiredTigerOplogColdTier::Segment>();
+    segment->path = path;
+    segment->numRecords = footerView.read<LittleEndian<int64_t>>(24);
+    segment->dataBytes = footerView.read<LittleEndian<int64_t>>(32);
+    segment->fileBytes = length;
+
+    std::string index(numBlocks * kIndexEntrySize, '\0');
+    file.read(indexOffset, &index[0], index.size());
+    if (file.bad() || numBlocks == 0) {
+        return Status(ErrorCodes::FileStreamFailed,
+                      str::stream() << "invalid index in oplog cold tier segment " << path);
+    }
+    for (uint32_t i = 0; i < numBlocks; i++) {
+        ConstDataView entry(index.data() + i * kIndexEntrySize);
+        WiredTigerOplogColdTier::BlockInfo block;
+        block.first = RecordId(entry.read<LittleEndian<int64_t>>());
+        block.last = RecordId(entry.read<LittleEndian<int64_t>>(8));
+        block.offset = entry.read<LittleEndian<uint64_t>>(16);
+        block.compressedSize = entry.read<LittleEndian<uint32_t>>(24);
+        segment->blocks.push_back(block);
+    }
+    segment->first = segment->blocks.front().first;
+    segment->last = segment->blocks.back().last;
+    return {std::move(segment)};
+}
+
+}  // namespace
+
+WiredTigerOplogColdTier::Writer::Writer(WiredTigerOplogColdTier* tier, std::string tmpPath)
+    : _tier(tier), _tmpPath(std::move(tmpPath)) {
+    _file.open(_tmpPath.c_str());
+    _file.truncate(0);
+    _segment.numRecords = 0;
+    _segment.dataBytes = 0;
+    _segment.fileBytes = 0;
+}
+
+WiredTigerOplogColdTier::Writer::~Writer() {
+    if (!_finished) {
+        removeFile(_tmpPath);
+    }
+}
+
+void WiredTigerOplogColdTier::Writer::add(const RecordId& id, const char* data, int size) {
+    invariant(!_finished);
+    invariant(_segment.numRecords == 0 || id > _segment.last);
+
+    if (_block.empty()) {
+        _blockFirst = id;
+    }
+    char header[kEntryHeaderSize];
+    DataView(header).write<LittleEndian<int64_t>>(id.repr(), 0).write<LittleEndian<int32_t>>(
+        size, 8);
+    _block.append(header, kEntryHeaderSize);
+    _block.append(data, size);
+    _blockLast = id;
+
+    if (_segment.numRecords == 0) {
+        _segment.first = id;
+    }
+    _segment.last = id;
+    _segment.numRecords++;
+    _segment.dataBytes += size;
+
+    if (_block.size() >= kBlockSize) {
+        _flushBlock();
+    }
+}
+
+void WiredTigerOplogColdTier::Writer::_flushBlock() {
+    if (_block.empty())
+        return;
+
+    std::string compressed;
+    snappy::Compress(_block.data(), _block.size(), &compressed);
+
+    char header[kBlockHeaderSize];
+    DataView(header)
+        .write<LittleEndian<uint32_t>>(_block.size(), 0)
+        .write<LittleEndian<uint32_t>>(compressed.size(), 4);
+    _file.write(_segment.fileBytes, header, kBlockHeaderSize);
+    _file.write(_segment.fileBytes + kBlockHeaderSize, compressed.data(), compressed.size());
+
+    BlockInfo block = {_blockFirst, _blockLast, static_cast<uint64_t>(_segment.fileBytes),
+                       static_cast<uint32_t>(compressed.size())};
+    _segment.blocks.push_back(block);
+    _segment.fileBytes += kBlockHeaderSize + compressed.size();
+    _block.clear();
+}
+
+Status WiredTigerOplogColdTier::Writer::finish() {
+    auto segment = _write();
+    if (!segment.isOK())
+        return segment.getStatus();
+
+    if (segment.getValue()) {
+        _tier->_addSegment(std::move(segment.getValue()));
+    }
+    return Status::OK();
+}
+
+StatusWith<std::shared_ptr<const WiredTigerOplogColdTier::Segment>>
+WiredTigerOplogColdTier::Writer::_write() {
+    invariant(!_finished);
+    _finished = true;
+
+    if (_segment.numRecords == 0) {
+        removeFile(_tmpPath);
+        return {std::shared_ptr<const Segment>()};
+    }
+
+    _flushBlock();
+
+    const uint64_t indexOffset = _segment.fileBytes;
+    std::string index(_segment.blocks.size() * kIndexEntrySize, '\0');
+    for (size_t i = 0; i < _segment.blocks.size(); i++) {
+        const BlockInfo& block = _segment.blocks[i];
+        DataView(&index[i * kIndexEntrySize])
+            .write<LittleEndian<int64_t>>(block.first.repr(), 0)
+            .write<LittleEndian<int64_t>>(block.last.repr(), 8)
+            .write<LittleEndian<uint64_t>>(block.offset, 16)
+            .write<LittleEndian<uint32_t>>(block.compressedSize, 24);
+    }
+    _file.write(indexOffset, index.data(), index.size());
+
+    char footer[kFooterSize];
+    DataView(footer)
+        .write<LittleEndian<uint64_t>>(kSegmentMagic, 0)
+        .write<LittleEndian<uint64_t>>(indexOffset, 8)
+        .write<LittleEndian<uint32_t>>(_segment.blocks.size(), 16)
+        .write<LittleEndian<uint32_t>>(kSegmentVersion, 20)
+        .write<LittleEndian<int64_t>>(_segment.numRecords, 24)
+        .write<LittleEndian<int64_t>>(_segment.dataBytes, 32);
+    _file.write(indexOffset + index.size(), footer, kFooterSize);
+    _segment.fileBytes += index.size() + kFooterSize;
+
+    _file.fsync();
+    if (_file.bad()) {
+        removeFile(_tmpPath);
+        return Status(ErrorCodes::FileStreamFailed,
+                      str::stream() << "failed to write oplog cold tier segment " << _tmpPath);
+    }
+
+    _segment.path = segmentPath(_tier->_directory, _segment.first, _segment.last);
+    boost::system::error_code ec;
+    boost::filesystem::rename(_tmpPath, _segment.path, ec);
+    if (ec) {
+        removeFile(_tmpPath);
+        return Status(ErrorCodes::FileRenameFailed,
+                      str::stream() << "failed to rename oplog cold tier segment " << _tmpPath
+                                    << " to " << _segment.path << ": " << ec.message());
+    }
+
+    return {std::make_shared<const Segment>(std::move(_segment))};
+}
+
+WiredTigerOplogColdTier::Cursor::Cursor(Segments segments, bool forward)
+    : _segments(std::move(segments)), _forward(forward) {}
+
+boost::optional<Record> WiredTigerOplogColdTier::Cursor::next() {
+    if (_eof)
+        return {};
+
+    if (!_positioned) {
+        _positioned = true;
+        if (_segments.empty()) {
+            _eof = true;
+            return {};
+        }
+        _segment = _forward ? 0 : _segments.size() - 1;
+        _block = _forward ? 0 : _segments[_segment]->blocks.size() - 1;
+        if (!_load(_segment, _block)) {
+            _eof = true;
+            return {};
+        }
+        _entry = _forward ? 0 : _offsets.size() - 1;
+    } else {
+        _entry += _forward ? 1 : -1;
+        if (_entry < 0 || _entry >= static_cast<long long>(_offsets.size())) {
+            if (!_advanceBlock()) {
+                _eof = true;
+                return {};
+            }
+        }
+    }
+
+    return _recordAt(_entry);
+}
+
+boost::optional<Record> WiredTigerOplogColdTier::Cursor::seekExact(const RecordId& id) {
+    _positioned = true;
+    _eof = true;
+
+    auto segment = std::lower_bound(
+        _segments.begin(),
+        _segments.end(),
+        id,
+        [](const std::shared_ptr<const Segment>& s, const RecordId& id) { return s->last < id; });
+    if (segment == _segments.end() || id < (*segment)->first)
+        return {};
+
+    const std::vector<BlockInfo>& blocks = (*segment)->blocks;
+    auto block = std::lower_bound(
+        blocks.begin(), blocks.end(), id, [](const BlockInfo& b, const RecordId& id) {
+            return b.last < id;
+        });
+    invariant(block != blocks.end());
+    if (!_load(segment - _segments.begin(), block - blocks.begin()))
+        return {};
+
+    const long long entry = _lowerBound(id);
+    if (entry == static_cast<long long>(_offsets.size()) || _idAt(entry) != id)
+        return {};
+
+    _eof = false;
+    _entry = entry;
+    return _recordAt(_entry);
+}
+
+void WiredTigerOplogColdTier::Cursor::seekAfter(const RecordId& id) {
+    _positioned = true;
+    _eof = true;
+
+    size_t segment;
+    size_t block;
+    if (_forward) {
+        // The first segment and block with a record after 'id'.
+        auto s = std::upper_bound(_segments.begin(),
+                                  _segments.end(),
+                                  id,
+                                  [](const RecordId& id, const std::shared_ptr<const Segment>& s) {
+                                      return id < s->last;
+                                  });
+        if (s == _segments.end())
+            return;
+        const std::vector<BlockInfo>& blocks = (*s)->blocks;
+        auto b = std::upper_bound(
+            blocks.begin(), blocks.end(), id, [](const RecordId& id, const BlockInfo& b) {
+                return id < b.last;
+            });
+        segment = s - _segments.begin();
+        block = b - blocks.begin();
+    } else {
+        // The last segment and block with a record before 'id'.
+        auto s = std::lower_bound(_segments.begin(),
+                                  _segments.end(),
+                                  id,
+                                  [](const std::shared_ptr<const Segment>& s, const RecordId& id) {
+                                      return s->first < id;
+                                  });
+        if (s == _segments.begin())
+            return;
+        --s;
+        const std::vector<BlockInfo>& blocks = (*s)->blocks;
+        auto b = std::lower_bound(
+            blocks.begin(), blocks.end(), id, [](const BlockInfo& b, const RecordId& id) {
+                return b.first < id;
+            });
+        invariant(b != blocks.begin());
+        --b;
+        segment = s - _segments.begin();
+        block = b - blocks.begin();
+    }
+
+    if (!_load(segment, block))
+        return;
+
+    _eof = false;
+    if (_forward) {
+        // next() moves on to the first entry greater than 'id'.
+        _entry = _lowerBound(RecordId(id.repr() + 1)) - 1;
+    } else {
+        // next() moves back to the last entry less than 'id'.
+        _entry = _lowerBound(id);
+    }
+}
+
+bool WiredTigerOplogColdTier::Cursor::_advanceBlock() {
+    size_t segment = _segment;
+    size_t block = _block;
+    if (_forward) {
+        if (++block == _segments[segment]->blocks.size()) {
+            if (++segment == _segments.size())
+                return false;
+            block = 0;
+        }
+    } else {
+        if (block-- == 0) {
+            if (segment-- == 0)
+                return false;
+            block = _segments[segment]->blocks.size() - 1;
+        }
+    }
+
+    if (!_load(segment, block))
+        return false;
+    _entry = _forward ? 0 : _offsets.size() - 1;
+    return true;
+}
+
+bool WiredTigerOplogColdTier::Cursor::_load(size_t segment, size_t block) {
+    const Segment& s = *_segments[segment];
+    _lost = true;
+
+    if (!_file || _fileSegment != segment) {
+        _file.reset();
+
+        // The segment may have been dropped to stay within the size cap.
+        boost::system::error_code ec;
+        if (!boost::filesystem::exists(s.path, ec))
+            return false;
+
+        _file = stdx::make_unique<File>();
+        _file->open(s.path.c_str(), /*readOnly=*/true);
+        _fileSegment = segment;
+    }
+
+    const BlockInfo& info = s.blocks[block];
+    std::string compressed(kBlockHeaderSize + info.compressedSize, '\0');
+    _file->read(info.offset, &compressed[0], compressed.size());
+    if (_file->bad()) {
+        _file.reset();
+        return false;
+    }
+
+    if (!snappy::Uncompress(
+            compressed.data() + kBlockHeaderSize, info.compressedSize, &_buffer)) {
+        warning() << "corrupt block at offset " << info.offset << " in oplog cold tier segment "
+                  << s.path;
+        return false;
+    }
+
+    _offsets.clear();
+    for (size_t offset = 0; offset + kEntryHeaderSize <= _buffer.size();) {
+        _offsets.push_back(offset);
+        offset += kEntryHeaderSize +
+            ConstDataView(_buffer.data() + offset).read<LittleEndian<int32_t>>(8);
+    }
+
+    _segment = segment;
+    _block = block;
+    _lost = _offsets.empty();
+    return !_lost;
+}
+
+long long WiredTigerOplogColdTier::Cursor::_lowerBound(const RecordId& id) const {
+    long long low = 0;
+    long long high = _offsets.size();
+    while (low < high) {
+        const long long mid = low + (high - low) / 2;
+        if (_idAt(mid) < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+RecordId WiredTigerOplogColdTier::Cursor::_idAt(long long entry) const {
+    return RecordId(ConstDataView(_buffer.data() + _offsets[entry]).read<LittleEndian<int64_t>>());
+}
+
+Record WiredTigerOplogColdTier::Cursor::_recordAt(long long entry) const {
+    const char* start = _buffer.data() + _offsets[entry];
+    const int size = ConstDataView(start).read<LittleEndian<int32_t>>(8);
+    return {_idAt(entry), RecordData(start + kEntryHeaderSize, size)};
+}
+
+WiredTigerOplogColdTier::WiredTigerOplogColdTier(std::string directory, long long maxBytes)
+    : _directory(std::move(directory)), _maxBytes(maxBytes) {}
+
+Status WiredTigerOplogColdTier::open() {
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(_directory, ec);
+    if (ec) {
+        return Status(ErrorCodes::FileNotOpen,
+                      str::stream() << "cannot create oplog cold tier directory " << _directory
+                                    << ": " << ec.message());
+    }
+
+    Segments segments;
+    boost::filesystem::directory_iterator di(_directory, ec);
+    for (; !ec && di != boost::filesystem::directory_iterator(); di.increment(ec)) {
+        const boost::filesystem::path path = di->path();
+        const std::string extension = path.extension().string();
+        if (extension == kTmpSuffix) {
+            // Left behind by a crash while sealing.
+            removeFile(path.string());
+        } else if (extension == kSegmentSuffix) {
+            auto segment = loadSegment(path.string());
+            if (!segment.isOK()) {
+                warning() << "ignoring oplog cold tier segment: " << segment.getStatus();
+                continue;
+            }
+            segments.push_back(std::move(segment.getValue()));
+        }
+    }
+    if (ec) {
+        return Status(ErrorCodes::FileStreamFailed,
+                      str::stream() << "cannot list oplog cold tier directory " << _directory
+                                    << ": " << ec.message());
+    }
+
+    std::sort(segments.begin(),
+              segments.end(),
+              [](const std::shared_ptr<const Segment>& a, const std::shared_ptr<const Segment>& b) {
+                  return a->first < b->first || (a->first == b->first && a->last < b->last);
+              });
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        invariant(_segments.empty());
+    }
+    RecordId last;
+    for (auto&& segment : segments) {
+        // A crash during truncateAfter() can leave the segment it rewrote behind next to the
+        // shorter replacement, which sorts first.
+        if (!last.isNull() && segment->first <= last) {
+            LOG(1) << "Removing oplog cold tier segment " << segment->path
+                   << " which overlaps an earlier one";
+            removeFile(segment->path);
+            continue;
+        }
+        last = segment->last;
+        _addSegment(segment);
+    }
+    return Status::OK();
+}
+
+std::unique_ptr<WiredTigerOplogColdTier::Writer> WiredTigerOplogColdTier::makeWriter() {
+    const std::string tmpPath =
+        (boost::filesystem::path(_directory) / (std::string("sealing") + kTmpSuffix)).string();
+    return std::unique_ptr<Writer>(new Writer(this, tmpPath));
+}
+
+std::unique_ptr<WiredTigerOplogColdTier::Cursor> WiredTigerOplogColdTier::getCursor(
+    bool forward) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return stdx::make_unique<Cursor>(_segments, forward);
+}
+
+RecordId WiredTigerOplogColdTier::lastRecord() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _segments.empty() ? RecordId() : _segments.back()->last;
+}
+
+RecordId WiredTigerOplogColdTier::findAtOrBefore(const RecordId& id) const {
+    const RecordId last = lastRecord();
+    if (last.isNull() || id >= last)
+        return last;
+
+    auto cursor = getCursor(/*forward=*/false);
+    cursor->seekAfter(RecordId(id.repr() + 1));
+    auto record = cursor->next();
+    return record ? record->id : RecordId();
+}
+
+StatusWith<RecordId> WiredTigerOplogColdTier::truncateAfter(const RecordId& id, bool inclusive) {
+    const auto isRemoved = [&](const RecordId& record) {
+        return inclusive ? record >= id : record > id;
+    };
+
+    Segments segments;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        segments = _segments;
+    }
+
+    size_t kept = segments.size();
+    while (kept > 0 && isRemoved(segments[kept - 1]->first)) {
+        kept--;
+    }
+
+    // The segment holding 'id' keeps the records before it.
+    std::shared_ptr<const Segment> rewritten;
+    const bool rewrite = kept > 0 && isRemoved(segments[kept - 1]->last);
+    if (rewrite) {
+        Cursor cursor({segments[kept - 1]}, /*forward=*/true);
+        auto writer = makeWriter();
+        while (auto record = cursor.next()) {
+            if (isRemoved(record->id))
+                break;
+            writer->add(record->id, record->data.data(), record->data.size());
+        }
+        if (cursor.lostPosition()) {
+            return Status(ErrorCodes::FileStreamFailed,
+                          str::stream() << "cannot read oplog cold tier segment "
+                                        << segments[kept - 1]->path << " to truncate it");
+        }
+
+        auto segment = writer->_write();
+        if (!segment.isOK())
+            return segment.getStatus();
+        rewritten = std::move(segment.getValue());
+        invariant(rewritten);
+    }
+
+    Segments dropped;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        invariant(_segments == segments);
+        dropped.assign(_segments.begin() + kept, _segments.end());
+        _segments.resize(kept);
+        if (rewrite) {
+            dropped.push_back(_segments.back());
+            _segments.back() = rewritten;
+        }
+
+        _totalBytes = 0;
+        for (auto&& segment : _segments) {
+            _totalBytes += segment->fileBytes;
+        }
+    }
+
+    // Newest first, so that a crash in between leaves no gap in front of the remaining ones.
+    std::sort(dropped.begin(),
+              dropped.end(),
+              [](const std::shared_ptr<const Segment>& a, const std::shared_ptr<const Segment>& b) {
+                  return a->first > b->first;
+              });
+    for (auto&& segment : dropped) {
+        LOG(1) << "Removing oplog cold tier segment " << segment->path << " to truncate after "
+               << id;
+        removeFile(segment->path);
+    }
+    return {lastRecord()};
+}
+
+void WiredTigerOplogColdTier::clear() {
+    Segments segments;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        segments.swap(_segments);
+        _totalBytes = 0;
+    }
+    for (auto&& segment : segments) {
+        removeFile(segment->path);
+    }
+}
+
+void WiredTigerOplogColdTier::appendStats(BSONObjBuilder* b) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    long long numRecords = 0;
+    long long dataBytes = 0;
+    for (auto&& segment : _segments) {
+        numRecords += segment->numRecords;
+        dataBytes += segment->dataBytes;
+    }
+    b->append("segments", static_cast<long long>(_segments.size()));
+    b->append("records", numRecords);
+    b->append("dataSize", dataBytes);
+    b->append("storageSize", _totalBytes);
+    b->append("maxSize", _maxBytes);
+    b->append("segmentsDropped", _segmentsDropped);
+    if (!_segments.empty()) {
+        b->append("firstRecordId", static_cast<long long>(_segments.front()->first.repr()));
+        b->append("lastRecordId", static_cast<long long>(_segments.back()->last.repr()));
+    }
+}
+
+void WiredTigerOplogColdTier::_addSegment(std::shared_ptr<const Segment> segment) {
+    Segments dropped;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        invariant(_segments.empty() || _segments.back()->last < segment->first);
+        _totalBytes += segment->fileBytes;
+        _segments.push_back(std::move(segment));
+
+        while (_totalBytes > _maxBytes && !_segments.empty()) {
+            _totalBytes -= _segments.front()->fileBytes;
+            dropped.push_back(_segments.front());
+            _segments.erase(_segments.begin());
+            _segmentsDropped++;
+        }
+    }
+
+    for (auto&& segment : dropped) {
+        LOG(1) << "Dropping oplog cold tier segment " << segment->path << " with "
+               << segment->numRecords << " records";
+        removeFile(segment->path);
+    }
+}
+
+}  // namespace mongo
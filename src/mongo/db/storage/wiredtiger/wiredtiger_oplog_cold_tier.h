@@ -0,0 +1,246 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/base/status_with.h"
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/file.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * Keeps oplog entries which were truncated from the oplog table in compressed, append-only
+ * segment files, so that a long oplog window does not need as much disk space as the oplog
+ * itself.
+ *
+ * Each segment holds the entries of one or more oplog stones in ascending RecordId order. The
+ * entries are grouped in blocks of about kBlockSize bytes which are snappy compressed separately,
+ * followed by an index of the blocks and a fixed size footer. Segments are written to a temporary
+ * file, synced and then renamed, so a crash never leaves a partial segment behind.
+ *
+ * The total size of the segments is capped at 'maxBytes'. Sealing a new segment drops the oldest
+ * ones beyond it.
+ *
+ * Sealing and truncation are done by a single thread at a time. Reading is thread safe.
+ */
+class WiredTigerOplogColdTier {
+    MONGO_DISALLOW_COPYING(WiredTigerOplogColdTier);
+
+public:
+    // Uncompressed size at which a block is compressed and written out.
+    static const size_t kBlockSize = 1024 * 1024;
+
+    struct BlockInfo {
+        RecordId first;
+        RecordId last;
+        uint64_t offset;
+        uint32_t compressedSize;
+    };
+
+    /**
+     * An immutable segment file.
+     */
+    struct Segment {
+        std::string path;
+        RecordId first;
+        RecordId last;
+        long long numRecords;
+        long long dataBytes;  // Uncompressed size of the records.
+        long long fileBytes;
+        std::vector<BlockInfo> blocks;
+    };
+
+    using Segments = std::vector<std::shared_ptr<const Segment>>;
+
+    /**
+     * Writes one segment. Records must be added in ascending order of their ids.
+     */
+    class Writer {
+        MONGO_DISALLOW_COPYING(Writer);
+
+    public:
+        ~Writer();
+
+        void add(const RecordId& id, const char* data, int size);
+
+        /**
+         * Writes out the remaining records and the index, syncs the segment and makes it visible
+         * to readers. A segment without records is discarded.
+         */
+        Status finish();
+
+    private:
+        friend class WiredTigerOplogColdTier;
+
+        Writer(WiredTigerOplogColdTier* tier, std::string tmpPath);
+
+        void _flushBlock();
+
+        // Like finish(), but returns the segment instead of making it visible to readers. Returns
+        // a null segment if there were no records.
+        StatusWith<std::shared_ptr<const Segment>> _write();
+
+        WiredTigerOplogColdTier* const _tier;
+        const std::string _tmpPath;
+        File _file;
+        Segment _segment;
+        std::string _block;
+        RecordId _blockFirst;
+        RecordId _blockLast;
+        bool _finished = false;
+    };
+
+    /**
+     * Iterates over the records in the segments which existed when it was created. Returned
+     * record data stays valid until the next call on the cursor.
+     */
+    class Cursor {
+        MONGO_DISALLOW_COPYING(Cursor);
+
+    public:
+        Cursor(Segments segments, bool forward);
+
+        /**
+         * Returns the next record in the direction of the cursor. An unpositioned cursor starts
+         * at the first (or last) record. Returns boost::none at the end, or if the segment it
+         * was reading was dropped.
+         */
+        boost::optional<Record> next();
+
+        /**
+         * Returns the record with 'id' and positions the cursor on it.
+         */
+        boost::optional<Record> seekExact(const RecordId& id);
+
+        /**
+         * Positions the cursor so that next() returns the first record after 'id' in the
+         * direction of the cursor.
+         */
+        void seekAfter(const RecordId& id);
+
+        /**
+         * Returns true if the cursor stopped because a segment could not be read, most likely
+         * because it was dropped to stay within the size cap, rather than at the end.
+         */
+        bool lostPosition() const {
+            return _lost;
+        }
+
+    private:
+        // Loads block 'block' of segment 'segment'. Returns false if it could not be read.
+        bool _load(size_t segment, size_t block);
+
+        // Moves to the first or last entry of the next or previous block that exists.
+        bool _advanceBlock();
+
+        // Returns the index of the first entry of the loaded block with an id >= 'id'.
+        long long _lowerBound(const RecordId& id) const;
+
+        RecordId _idAt(long long entry) const;
+        Record _recordAt(long long entry) const;
+
+        const Segments _segments;
+        const bool _forward;
+
+        bool _positioned = false;
+        bool _eof = false;
+        bool _lost = false;
+        size_t _segment = 0;
+        size_t _block = 0;
+        long long _entry = -1;  // Index into _offsets.
+
+        std::unique_ptr<File> _file;
+        size_t _fileSegment = 0;
+        std::string _buffer;
+        std::vector<size_t> _offsets;  // Start of each entry in _buffer.
+    };
+
+    /**
+     * Segments are kept in 'directory', which is created if needed.
+     */
+    WiredTigerOplogColdTier(std::string directory, long long maxBytes);
+
+    /**
+     * Loads the segments which already exist in the directory.
+     */
+    Status open();
+
+    std::unique_ptr<Writer> makeWriter();
+
+    std::unique_ptr<Cursor> getCursor(bool forward) const;
+
+    /**
+     * Returns the highest record id in the tier, or a null id if it is empty.
+     */
+    RecordId lastRecord() const;
+
+    /**
+     * Returns the id of the latest record at or before 'id', or a null id if there is none.
+     */
+    RecordId findAtOrBefore(const RecordId& id) const;
+
+    /**
+     * Removes the records after 'id', or from 'id' on if 'inclusive' is true. Segments which only
+     * hold later records are dropped and the segment which holds 'id' is rewritten without them.
+     * Returns the id of the last record left in the tier, or a null id if none is.
+     */
+    StatusWith<RecordId> truncateAfter(const RecordId& id, bool inclusive);
+
+    /**
+     * Removes all segments.
+     */
+    void clear();
+
+    void appendStats(BSONObjBuilder* b) const;
+
+private:
+    // Publishes a finished segment and drops old segments beyond the size cap.
+    void _addSegment(std::shared_ptr<const Segment> segment);
+
+    const std::string _directory;
+    const long long _maxBytes;
+
+    mutable stdx::mutex _mutex;
+    Segments _segments;
+    long long _totalBytes = 0;
+    long long _segmentsDropped = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,272 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_oplog_cold_tier.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const long long kUnlimited = 1024 * 1024 * 1024;
+
+std::string payload(long long id) {
+    // Large enough for a segment to span several blocks.
+    return std::string(900 + id % 200, 'a' + id % 26);
+}
+
+/**
+ * Seals a segment with the records from 'first' to 'last', stepping by 'step'.
+ */
+void seal(WiredTigerOplogColdTier* tier, long long first, long long last, long long step = 1) {
+    auto writer = tier->makeWriter();
+    for (long long id = first; id <= last; id += step) {
+        const std::string data = payload(id);
+        writer->add(RecordId(id), data.data(), data.size());
+    }
+    ASSERT_OK(writer->finish());
+}
+
+std::vector<long long> scan(WiredTigerOplogColdTier::Cursor* cursor) {
+    std::vector<long long> ids;
+    while (auto record = cursor->next()) {
+        ASSERT_EQUALS(payload(record->id.repr()),
+                      std::string(record->data.data(), record->data.size()));
+        ids.push_back(record->id.repr());
+    }
+    return ids;
+}
+
+std::vector<long long> range(long long first, long long last, long long step = 1) {
+    std::vector<long long> ids;
+    for (long long id = first; id <= last; id += step) {
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+TEST(WiredTigerOplogColdTierTest, ScansForwardAndBackwardAcrossSegmentsAndBlocks) {
+    unittest::TempDir dir("oplog_cold_tier_scan");
+    WiredTigerOplogColdTier tier(dir.path(), kUnlimited);
+    ASSERT_OK(tier.open());
+
+    seal(&tier, 1, 3000);
+    seal(&tier, 3001, 3010);
+    seal(&tier, 3011, 6000);
+    ASSERT_EQUALS(RecordId(6000), tier.lastRecord());
+
+    ASSERT(range(1, 6000) == scan(tier.getCursor(true).get()));
+
+    std::vector<long long> reversed = range(1, 6000);
+    std::reverse(reversed.begin(), reversed.end());
+    ASSERT(reversed == scan(tier.getCursor(false).get()));
+}
+
+TEST(WiredTigerOplogColdTierTest, SeeksToRecords) {
+    unittest::TempDir dir("oplog_cold_tier_seek");
+    WiredTigerOplogColdTier tier(dir.path(), kUnlimited);
+    ASSERT_OK(tier.open());
+
+    // Only even ids, so that odd ones fall between records.
+    seal(&tier, 2, 4000, 2);
+    seal(&tier, 4002, 8000, 2);
+
+    auto cursor = tier.getCursor(true);
+    ASSERT_FALSE(cursor->seekExact(RecordId(1001)));
+    ASSERT_FALSE(cursor->next());
+
+    auto record = cursor->seekExact(RecordId(1000));
+    ASSERT(record);
+    ASSERT_EQUALS(RecordId(1000), record->id);
+    ASSERT_EQUALS(RecordId(1002), cursor->next()->id);
+
+    for (long long id : {0LL, 1LL, 2LL, 1001LL, 3999LL, 4000LL, 4001LL, 7999LL, 8000LL}) {
+        cursor->seekAfter(RecordId(id));
+        ASSERT(range(id / 2 * 2 + 2, 8000, 2) == scan(cursor.get()));
+    }
+
+    auto reverse = tier.getCursor(false);
+    for (long long id : {1LL, 2LL, 3LL, 1001LL, 4002LL, 4003LL, 8000LL, 8001LL, 9000LL}) {
+        reverse->seekAfter(RecordId(id));
+        std::vector<long long> expected = range(2, std::min(8000LL, (id - 1) / 2 * 2), 2);
+        std::reverse(expected.begin(), expected.end());
+        ASSERT(expected == scan(reverse.get()));
+    }
+
+    ASSERT_EQUALS(RecordId(), tier.findAtOrBefore(RecordId(1)));
+    ASSERT_EQUALS(RecordId(2), tier.findAtOrBefore(RecordId(3)));
+    ASSERT_EQUALS(RecordId(4000), tier.findAtOrBefore(RecordId(4001)));
+    ASSERT_EQUALS(RecordId(4002), tier.findAtOrBefore(RecordId(4002)));
+    ASSERT_EQUALS(RecordId(8000), tier.findAtOrBefore(RecordId(100000)));
+}
+
+TEST(WiredTigerOplogColdTierTest, DropsOldestSegmentsBeyondMaxSize) {
+    unittest::TempDir dir("oplog_cold_tier_drop");
+    long long segmentBytes;
+    {
+        WiredTigerOplogColdTier tier(dir.path(), kUnlimited);
+        ASSERT_OK(tier.open());
+        seal(&tier, 1, 100);
+        BSONObjBuilder b;
+        tier.appendStats(&b);
+        segmentBytes = b.obj()["storageSize"].numberLong();
+        tier.clear();
+    }
+
+    WiredTigerOplogColdTier tier(dir.path(), segmentBytes * 2 + segmentBytes / 2);
+    ASSERT_OK(tier.open());
+    seal(&tier, 1, 100);
+    seal(&tier, 101, 200);
+    seal(&tier, 201, 300);
+
+    // The segments for the first 100 records do not fit any more.
+    ASSERT(range(101, 300) == scan(tier.getCursor(true).get()));
+
+    BSONObjBuilder b;
+    tier.appendStats(&b);
+    BSONObj stats = b.obj();
+    ASSERT_EQUALS(2, stats["segments"].numberLong());
+    ASSERT_EQUALS(200, stats["records"].numberLong());
+    ASSERT_EQUALS(1, stats["segmentsDropped"].numberLong());
+    ASSERT_EQUALS(101, stats["firstRecordId"].numberLong());
+}
+
+TEST(WiredTigerOplogColdTierTest, CursorStopsAtDroppedSegment) {
+    unittest::TempDir dir("oplog_cold_tier_dropped_cursor");
+    WiredTigerOplogColdTier tier(dir.path(), kUnlimited);
+    ASSERT_OK(tier.open());
+    seal(&tier, 1, 10);
+
+    auto exhausted = tier.getCursor(true);
+    ASSERT_EQUALS(10U, scan(exhausted.get()).size());
+    ASSERT_FALSE(exhausted->lostPosition());
+
+    auto cursor = tier.getCursor(true);
+    tier.clear();
+    ASSERT_FALSE(cursor->next());
+    ASSERT_TRUE(cursor->lostPosition());
+}
+
+TEST(WiredTigerOplogColdTierTest, ReopensExistingSegments) {
+    unittest::TempDir dir("oplog_cold_tier_reopen");
+    {
+        WiredTigerOplogColdTier tier(dir.path(), kUnlimited);
+        ASSERT_OK(tier.open());
+        seal(&tier, 1, 500);
+        seal(&tier, 501, 1000);
+
+        // An empty segment is not kept, and an unfinished one is removed.
+        ASSERT_OK(tier.makeWriter()->finish());
+        auto unfinished = tier.makeWriter();
+        unfinished->add(RecordId(1001), "x", 1);
+    }
+
+    WiredTigerOplogColdTier tier(dir.path(), kUnlimited);
+    ASSERT_OK(tier.open());
+    ASSERT_EQUALS(RecordId(1000), tier.lastRecord());
+    ASSERT(range(1, 1000) == scan(tier.getCursor(true).get()));
+
+    size_t files = 0;
+    for (boost::filesystem::directory_iterator it(dir.path());
+         it != boost::filesystem::directory_iterator();
+         ++it) {
+        files++;
+    }
+    ASSERT_EQUALS(2U, files);
+}
+
+TEST(WiredTigerOplogColdTierTest, TruncatesAfterRecord) {
+    unittest::TempDir dir("oplog_cold_tier_truncate");
+    WiredTigerOplogColdTier tier(dir.path(), kUnlimited);
+    ASSERT_OK(tier.open());
+    seal(&tier, 1, 500);
+    seal(&tier, 501, 1000);
+    seal(&tier, 1001, 1500);
+
+    auto truncated = tier.truncateAfter(RecordId(700), false);
+    ASSERT_OK(truncated.getStatus());
+    ASSERT_EQUALS(RecordId(700), truncated.getValue());
+    ASSERT_EQUALS(RecordId(700), tier.lastRecord());
+    ASSERT(range(1, 700) == scan(tier.getCursor(true).get()));
+
+    // Truncating from the first record of a segment removes all of it.
+    truncated = tier.truncateAfter(RecordId(501), true);
+    ASSERT_OK(truncated.getStatus());
+    ASSERT_EQUALS(RecordId(500), truncated.getValue());
+
+    // Later records can be sealed again.
+    seal(&tier, 501, 800);
+    ASSERT(range(1, 800) == scan(tier.getCursor(true).get()));
+
+    truncated = tier.truncateAfter(RecordId(1), true);
+    ASSERT_OK(truncated.getStatus());
+    ASSERT_EQUALS(RecordId(), truncated.getValue());
+    ASSERT(scan(tier.getCursor(true).get()).empty());
+}
+
+TEST(WiredTigerOplogColdTierTest, ReopenRemovesSegmentsOfInterruptedTruncation) {
+    unittest::TempDir dir("oplog_cold_tier_interrupted_truncate");
+    std::vector<boost::filesystem::path> original;
+    {
+        WiredTigerOplogColdTier tier(dir.path(), kUnlimited);
+        ASSERT_OK(tier.open());
+        seal(&tier, 1, 500);
+        seal(&tier, 501, 1000);
+        for (boost::filesystem::directory_iterator it(dir.path());
+             it != boost::filesystem::directory_iterator();
+             ++it) {
+            boost::filesystem::path copy = it->path();
+            copy += ".orig";
+            boost::filesystem::copy_file(it->path(), copy);
+            original.push_back(it->path());
+        }
+        ASSERT_OK(tier.truncateAfter(RecordId(700), false).getStatus());
+    }
+
+    // Put back the segments as if the truncation stopped before the originals were removed.
+    for (auto&& path : original) {
+        boost::filesystem::path copy = path;
+        copy += ".orig";
+        boost::filesystem::rename(copy, path);
+    }
+
+    WiredTigerOplogColdTier tier(dir.path(), kUnlimited);
+    ASSERT_OK(tier.open());
+    ASSERT_EQUALS(RecordId(700), tier.lastRecord());
+    ASSERT(range(1, 700) == scan(tier.getCursor(true).get()));
+}
+
+}  // namespace
+}  // namespace mongo
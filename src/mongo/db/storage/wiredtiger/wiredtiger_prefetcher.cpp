@@ -0,0 +1,155 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_prefetcher.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+const size_t WiredTigerPrefetcher::kMaxQueuedKeys;
+
+WiredTigerPrefetcher::WiredTigerPrefetcher(WT_CONNECTION* conn, int numThreads)
+    : _conn(conn), _numThreads(numThreads) {}
+
+WiredTigerPrefetcher::~WiredTigerPrefetcher() {
+    shutdown();
+}
+
+size_t WiredTigerPrefetcher::prefetch(const std::string& uri, const std::vector<int64_t>& keys) {
+    if (keys.empty() || _numThreads <= 0)
+        return 0;
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_inShutdown || _queuedKeys + keys.size() > kMaxQueuedKeys) {
+        _keysDropped.addAndFetch(keys.size());
+        return 0;
+    }
+
+    if (_threads.empty()) {
+        for (int i = 0; i < _numThreads; i++) {
+            _threads.emplace_back([this, i] {
+                setThreadName(std::string(str::stream() << "WTPrefetcher-" << i));
+                _run();
+            });
+        }
+    }
+
+    // Give every thread a share so that the reads of one request happen in parallel.
+    const size_t perThread = (keys.size() + _numThreads - 1) / _numThreads;
+    for (size_t start = 0; start < keys.size(); start += perThread) {
+        const size_t end = std::min(keys.size(), start + perThread);
+        Request request;
+        request.uri = uri;
+        request.keys.assign(keys.begin() + start, keys.begin() + end);
+        _queue.push_back(std::move(request));
+        _cv.notify_one();
+    }
+
+    _queuedKeys += keys.size();
+    _keysQueued.addAndFetch(keys.size());
+    return keys.size();
+}
+
+void WiredTigerPrefetcher::shutdown() {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_inShutdown)
+            return;
+        _inShutdown = true;
+    }
+    _cv.notify_all();
+
+    for (auto&& thread : _threads) {
+        thread.join();
+    }
+    _threads.clear();
+    _queue.clear();
+    _queuedKeys = 0;
+}
+
+void WiredTigerPrefetcher::appendStats(BSONObjBuilder* builder) const {
+    builder->append("keysQueued", _keysQueued.load());
+    builder->append("keysDropped", _keysDropped.load());
+    builder->append("keysRead", _keysRead.load());
+    builder->append("requestsFailed", _requestsFailed.load());
+}
+
+void WiredTigerPrefetcher::_run() {
+    WT_SESSION* session;
+    invariantWTOK(_conn->open_session(_conn, nullptr, "isolation=read-uncommitted", &session));
+
+    while (true) {
+        Request request;
+        {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            _cv.wait(lk, [this] { return _inShutdown || !_queue.empty(); });
+            if (_inShutdown)
+                break;
+            request = std::move(_queue.front());
+            _queue.pop_front();
+            _queuedKeys -= request.keys.size();
+        }
+        _read(session, request);
+    }
+
+    invariantWTOK(session->close(session, nullptr));
+}
+
+void WiredTigerPrefetcher::_read(WT_SESSION* session, const Request& request) {
+    // Cursors are not cached, an open cursor would keep the table from being dropped.
+    WT_CURSOR* cursor;
+    int ret = session->open_cursor(session, request.uri.c_str(), nullptr, nullptr, &cursor);
+    if (ret != 0) {
+        LOG(2) << "prefetcher could not open a cursor on " << request.uri << ": "
+               << wiredtiger_strerror(ret);
+        _requestsFailed.addAndFetch(1);
+        return;
+    }
+
+    for (auto key : request.keys) {
+        // Only bringing the record into the cache matters, not whether it is still there.
+        cursor->set_key(cursor, key);
+        cursor->search(cursor);
+    }
+    _keysRead.addAndFetch(request.keys.size());
+
+    invariantWTOK(cursor->close(cursor));
+}
+
+}  // namespace mongo
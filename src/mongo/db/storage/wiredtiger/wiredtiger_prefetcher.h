@@ -0,0 +1,110 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <wiredtiger.h>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * Reads records on background threads so that they are in the WiredTiger cache by the time a
+ * query asks for them. A query fetching the documents it found through an index otherwise waits
+ * for one random read after the other; handing the upcoming ones to the prefetcher lets those
+ * reads overlap.
+ *
+ * Each thread has its own session, which reads without a snapshot and so never holds back
+ * eviction. Requests are best effort: they are dropped when too many are queued already, and
+ * reads from a table which is dropped in the meantime just fail. The threads are only started
+ * with the first request.
+ */
+class WiredTigerPrefetcher {
+    MONGO_DISALLOW_COPYING(WiredTigerPrefetcher);
+
+public:
+    /**
+     * Requests are dropped rather than queued beyond this many keys.
+     */
+    static const size_t kMaxQueuedKeys = 4096;
+
+    WiredTigerPrefetcher(WT_CONNECTION* conn, int numThreads);
+    ~WiredTigerPrefetcher();
+
+    /**
+     * Queues reads of the records with the given keys from the table 'uri', spread over the
+     * threads. Never blocks on I/O. Returns how many of the keys were queued.
+     */
+    size_t prefetch(const std::string& uri, const std::vector<int64_t>& keys);
+
+    /**
+     * Stops the threads and closes their sessions. Must be called before the connection is
+     * closed. Requests made afterwards are dropped.
+     */
+    void shutdown();
+
+    void appendStats(BSONObjBuilder* builder) const;
+
+private:
+    struct Request {
+        std::string uri;
+        std::vector<int64_t> keys;
+    };
+
+    void _run();
+
+    void _read(WT_SESSION* session, const Request& request);
+
+    WT_CONNECTION* const _conn;
+    const int _numThreads;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+    std::deque<Request> _queue;
+    size_t _queuedKeys = 0;
+    bool _inShutdown = false;
+    std::vector<stdx::thread> _threads;
+
+    AtomicInt64 _keysQueued;
+    AtomicInt64 _keysDropped;
+    AtomicInt64 _keysRead;
+    AtomicInt64 _requestsFailed;
+};
+
+}  // namespace mongo
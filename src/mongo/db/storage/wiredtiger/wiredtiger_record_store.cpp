@@ -43,11 +43,14 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/oplog_hack.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_customization_hooks.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_oplog_cold_tier.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store_oplog_stones.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
@@ -88,6 +91,15 @@ bool shouldUseOplogHack(OperationContext* opCtx, const std::string& uri) {
     return (appMetadata.getValue().getIntField("oplogKeyExtractionVersion") == 1);
 }
 
+// Disk space in megabytes for oplog entries which are sealed into the cold tier when they are
+// truncated from the oplog. 0 disables the cold tier.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerOplogColdTierSizeMB, int, 0);
+
+// getManyCursors() splits the RecordIds of a collection into at most this many ranges, each
+// spanning at least kMinRecordIdsPerRange ids, so that they can be read on separate threads.
+const int64_t kMaxManyCursorRanges = 32;
+const int64_t kMinRecordIdsPerRange = 4096;
+
 }  // namespace
 
 MONGO_FP_DECLARE(WTWriteConflictException);
@@ -431,21 +443,68 @@ void WiredTigerRecordStore::OplogStones::_pokeReclaimThreadIfNeeded() {
 
 class WiredTigerRecordStore::Cursor final : public SeekableRecordCursor {
 public:
-    Cursor(OperationContext* txn, const WiredTigerRecordStore& rs, bool forward = true)
+    /**
+     * If 'includeColdTier' is true and the oplog has a cold tier, the cursor also returns the
+     * records sealed into it, which are all older than the ones in the table.
+     */
+    Cursor(OperationContext* txn,
+           const WiredTigerRecordStore& rs,
+           bool forward = true,
+           bool includeColdTier = false)
         : _rs(rs),
           _txn(txn),
           _forward(forward),
-          _readUntilForOplog(WiredTigerRecoveryUnit::get(txn)->getOplogReadTill()) {
+          _readUntilForOplog(WiredTigerRecoveryUnit::get(txn)->getOplogReadTill()),
+          _coldTier(includeColdTier ? rs._coldTier : nullptr) {
         _cursor.emplace(rs.getURI(), rs.tableId(), true, txn);
     }
 
+    /**
+     * A forward cursor over the records whose ids are in ['rangeStart', 'rangeEnd'). A null bound
+     * leaves that side of the range open.
+     */
+    Cursor(OperationContext* txn,
+           const WiredTigerRecordStore& rs,
+           const RecordId& rangeStart,
+           const RecordId& rangeEnd)
+        : Cursor(txn, rs, /*forward=*/true) {
+        invariant(!rs._isCapped);
+        _rangeStart = rangeStart;
+        _rangeEnd = rangeEnd;
+    }
+
     boost::optional<Record> next() final {
         if (_eof)
             return {};
 
+        if (_coldTier && _forward && _lastReturnedId.isNull() && !_coldCursor) {
+            // The oldest records are in the cold tier.
+            _coldCursor = _coldTier->getCursor(_forward);
+            _inColdTier = true;
+        }
+
+        if (_inColdTier) {
+            auto record = _nextInColdTier();
+            if (record || _eof)
+                return record;
+        }
+
         WT_CURSOR* c = _cursor->get();
 
         bool mustAdvance = !_skipNextAdvance;
+        if (_lastReturnedId.isNull() && !_rangeStart.isNull()) {
+            // Position on the first record of the range.
+            c->set_key(c, _makeKey(_rangeStart));
+            int cmp;
+            int seekRet = WT_OP_CHECK(c->search_near(c, &cmp));
+            if (seekRet == WT_NOTFOUND) {
+                _eof = true;
+                return {};
+            }
+            invariantWTOK(seekRet);
+            mustAdvance = cmp < 0;
+        }
+
         if (_lastReturnedId.isNull() && !_forward && _rs._isCapped) {
             // In this case we need to seek to the highest visible record.
             const RecordId reverseCappedInitialSeekPoint =
@@ -475,6 +534,14 @@ public:
             // table when you call next/prev.
             int advanceRet = WT_OP_CHECK(_forward ? c->next(c) : c->prev(c));
             if (advanceRet == WT_NOTFOUND) {
+                if (_coldTier && !_forward) {
+                    // Continue with the records older than the table.
+                    _coldCursor = _coldTier->getCursor(_forward);
+                    if (!_lastReturnedId.isNull())
+                        _coldCursor->seekAfter(_lastReturnedId);
+                    _inColdTier = true;
+                    return _nextInColdTier();
+                }
                 _eof = true;
                 return {};
             }
@@ -502,6 +569,11 @@ public:
             throw WriteConflictException();
         }
 
+        if (!_rangeEnd.isNull() && id >= _rangeEnd) {
+            _eof = true;
+            return {};
+        }
+
         if (!isVisible(id)) {
             _eof = true;
             return {};
@@ -522,6 +594,17 @@ public:
         int seekRet = WT_OP_CHECK(c->search(c));
         if (seekRet == WT_NOTFOUND) {
             _eof = true;
+            if (_coldTier) {
+                // The record may have been truncated into the cold tier.
+                _coldCursor = _coldTier->getCursor(_forward);
+                auto record = _coldCursor->seekExact(id);
+                if (record) {
+                    _lastReturnedId = id;
+                    _eof = false;
+                    _inColdTier = true;
+                }
+                return record;
+            }
             return {};
         }
         invariantWTOK(seekRet);
@@ -531,6 +614,7 @@ public:
 
         _lastReturnedId = id;
         _eof = false;
+        _inColdTier = false;
         return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
     }
 
@@ -547,6 +631,8 @@ public:
     void saveUnpositioned() final {
         save();
         _lastReturnedId = RecordId();
+        _coldCursor.reset();
+        _inColdTier = false;
     }
 
     bool restore() final {
@@ -561,7 +647,8 @@ public:
         if (_eof)
             return true;
 
-        if (_lastReturnedId.isNull())
+        // Records in the cold tier never change, so its cursor stays positioned.
+        if (_lastReturnedId.isNull() || _inColdTier)
             return true;
 
         WT_CURSOR* c = _cursor->get();
@@ -570,6 +657,8 @@ public:
         int cmp;
         int ret = WT_OP_CHECK(c->search_near(c, &cmp));
         if (ret == WT_NOTFOUND) {
+            if (_restoreInColdTier())
+                return true;
             _eof = true;
             return !_rs._isCapped;
         }
@@ -578,6 +667,9 @@ public:
         if (cmp == 0)
             return true;  // Landed right where we left off.
 
+        if (_restoreInColdTier())
+            return true;  // The oplog was truncated past us, but the record was kept.
+
         if (_rs._isCapped) {
             // Doc was deleted either by cappedDeleteAsNeeded() or cappedTruncateAfter().
             // It is important that we error out in this case so that consumers don't
@@ -607,7 +699,64 @@ public:
         // _cursor recreated in restore() to avoid risk of WT_ROLLBACK issues.
     }
 
+    size_t prefetch(const std::vector<RecordId>& ids) final {
+        std::vector<int64_t> keys;
+        keys.reserve(ids.size());
+        for (auto&& id : ids) {
+            keys.push_back(_makeKey(id));
+        }
+        return WiredTigerRecoveryUnit::get(_txn)->getSessionCache()->prefetcher().prefetch(
+            _rs.getURI(), keys);
+    }
+
 private:
+    // Returns the next record from the cold tier. Once a forward cursor has read all of it, it
+    // switches over to the table, positioned after the last record it returned. A cursor which
+    // lost its position in the cold tier reaches EOF rather than skipping over records.
+    boost::optional<Record> _nextInColdTier() {
+        if (auto record = _coldCursor->next()) {
+            _lastReturnedId = record->id;
+            return record;
+        }
+
+        if (!_forward || _coldCursor->lostPosition()) {
+            _eof = true;
+            return {};
+        }
+
+        _inColdTier = false;
+        if (_lastReturnedId.isNull())
+            return {};
+
+        // The last records of the cold tier may still be in the table if the truncation after
+        // sealing them did not happen, so skip over anything not after the last record returned.
+        WT_CURSOR* c = _cursor->get();
+        c->set_key(c, _makeKey(_lastReturnedId));
+        int cmp;
+        int ret = WT_OP_CHECK(c->search_near(c, &cmp));
+        if (ret == WT_NOTFOUND) {
+            _eof = true;
+            return {};
+        }
+        invariantWTOK(ret);
+        _skipNextAdvance = cmp > 0;
+        return {};
+    }
+
+    // Moves the cursor over to the cold tier if the last record it returned was truncated from
+    // the table after being sealed into the cold tier.
+    bool _restoreInColdTier() {
+        if (!_coldTier)
+            return false;
+
+        _coldCursor = _coldTier->getCursor(_forward);
+        if (!_coldCursor->seekExact(_lastReturnedId))
+            return false;
+
+        _inColdTier = true;
+        return true;
+    }
+
     bool isVisible(const RecordId& id) {
         if (!_rs._isCapped)
             return true;
@@ -634,6 +783,14 @@ private:
     bool _eof = false;
     RecordId _lastReturnedId;  // If null, need to seek to first/last record.
     const RecordId _readUntilForOplog;
+
+    // Bounds of the range of a cursor from getManyCursors(). Null if the range is open.
+    RecordId _rangeStart;
+    RecordId _rangeEnd;
+
+    const std::shared_ptr<WiredTigerOplogColdTier> _coldTier;
+    std::unique_ptr<WiredTigerOplogColdTier::Cursor> _coldCursor;
+    bool _inColdTier = false;
 };
 
 StatusWith<std::string> WiredTigerRecordStore::parseOptionsField(const BSONObj options) {
@@ -859,6 +1016,7 @@ WiredTigerRecordStore::WiredTigerRecordStore(OperationContext* ctx,
 
     if (WiredTigerKVEngine::initRsOplogBackgroundThread(ns)) {
         _oplogStones = std::make_shared<OplogStones>(ctx, this);
+        _openColdTier(ctx);
     }
 }
 
@@ -1210,6 +1368,70 @@ bool WiredTigerRecordStore::yieldAndAwaitOplogDeletionRequest(OperationContext*
     return !oplogStones->isDead();
 }
 
+void WiredTigerRecordStore::_openColdTier(OperationContext* txn) {
+    if (wiredTigerOplogColdTierSizeMB <= 0 || _isEphemeral)
+        return;
+
+    auto coldTier = std::make_shared<WiredTigerOplogColdTier>(
+        storageGlobalParams.dbpath + "/oplogColdTier",
+        static_cast<long long>(wiredTigerOplogColdTierSizeMB) * 1024 * 1024);
+    Status status = coldTier->open();
+    if (!status.isOK()) {
+        warning() << "Failed to open the oplog cold tier, truncated oplog entries will not be "
+                     "kept: " << status;
+        return;
+    }
+
+    if (_oplog_highestSeen.isNull()) {
+        // A rollback to an entry in the cold tier truncates the whole table, leaving the cold tier
+        // with all that is left of the oplog.
+        _oplog_highestSeen = coldTier->lastRecord();
+    } else if (coldTier->lastRecord() > _oplog_highestSeen) {
+        // Sealed entries of an oplog which has since been recreated don't belong in front of it.
+        LOG(1) << "Clearing the oplog cold tier since it does not precede the oplog";
+        coldTier->clear();
+    }
+
+    _coldTier = std::move(coldTier);
+}
+
+void WiredTigerRecordStore::_sealIntoColdTier(OperationContext* txn, const RecordId& lastRecord) {
+    // Records up to the last one in the cold tier were already sealed by an earlier attempt.
+    const RecordId after = std::max(_oplogStones->firstRecord, _coldTier->lastRecord());
+    if (after >= lastRecord)
+        return;
+
+    auto writer = _coldTier->makeWriter();
+
+    WiredTigerCursor curwrap(_uri, _tableId, true, txn);
+    WT_CURSOR* c = curwrap.get();
+    c->set_key(c, _makeKey(after));
+    int cmp;
+    int ret = WT_OP_CHECK(c->search_near(c, &cmp));
+    if (ret == 0 && cmp <= 0)
+        ret = WT_OP_CHECK(c->next(c));
+
+    for (; ret == 0; ret = WT_OP_CHECK(c->next(c))) {
+        int64_t key;
+        invariantWTOK(c->get_key(c, &key));
+        const RecordId id = _fromKey(key);
+        if (id > lastRecord)
+            break;
+
+        WT_ITEM value;
+        invariantWTOK(c->get_value(c, &value));
+        writer->add(id, static_cast<const char*>(value.data), static_cast<int>(value.size));
+    }
+    if (ret != WT_NOTFOUND)
+        invariantWTOK(ret);
+
+    Status status = writer->finish();
+    if (!status.isOK()) {
+        warning() << "Failed to seal the oplog entries up to " << lastRecord
+                  << " into the cold tier, they will be discarded: " << status;
+    }
+}
+
 void WiredTigerRecordStore::reclaimOplog(OperationContext* txn) {
     while (auto stone = _oplogStones->peekOldestStoneIfNeeded()) {
         invariant(stone->lastRecord.isNormal());
@@ -1222,6 +1444,10 @@ void WiredTigerRecordStore::reclaimOplog(OperationContext* txn) {
         WT_SESSION* session = ru->getSession(txn)->getSession();
 
         try {
+            if (_coldTier) {
+                _sealIntoColdTier(txn, stone->lastRecord);
+            }
+
             WriteUnitOfWork wuow(txn);
 
             WiredTigerCursor startwrap(_uri, _tableId, true, txn);
@@ -1389,7 +1615,8 @@ StatusWith<RecordId> WiredTigerRecordStore::updateRecord(OperationContext* txn,
     WiredTigerItem value(data, len);
     c->set_value(c, value.Get());
     ret = WT_OP_CHECK(c->insert(c));
-    invariantWTOK(ret);
+    if (ret)
+        return wtRCToStatus(ret, "WiredTigerRecordStore::updateRecord");
 
     _increaseDataSize(txn, len - old_length);
     if (!_oplogStones) {
@@ -1431,7 +1658,7 @@ std::unique_ptr<SeekableRecordCursor> WiredTigerRecordStore::getCursor(Operation
         }
     }
 
-    return stdx::make_unique<Cursor>(txn, *this, forward);
+    return stdx::make_unique<Cursor>(txn, *this, forward, /*includeColdTier=*/true);
 }
 
 std::unique_ptr<RecordCursor> WiredTigerRecordStore::getRandomCursor(OperationContext* txn) const {
@@ -1446,8 +1673,41 @@ std::unique_ptr<RecordCursor> WiredTigerRecordStore::getRandomCursorWithOptions(
 
 std::vector<std::unique_ptr<RecordCursor>> WiredTigerRecordStore::getManyCursors(
     OperationContext* txn) const {
-    std::vector<std::unique_ptr<RecordCursor>> cursors(1);
-    cursors[0] = stdx::make_unique<Cursor>(txn, *this, /*forward=*/true);
+    std::vector<std::unique_ptr<RecordCursor>> cursors;
+
+    // Capped collections keep a single cursor, which takes care of their visibility rules.
+    if (_isCapped) {
+        cursors.push_back(stdx::make_unique<Cursor>(txn, *this, /*forward=*/true));
+        return cursors;
+    }
+
+    // Split the ids between the lowest and the highest one into ranges of equal width. The first
+    // and the last range are open, so that the ranges cover records inserted in the meantime.
+    int64_t lowest = 0;
+    int64_t highest = 0;
+    {
+        WiredTigerCursor curwrap(_uri, _tableId, true, txn);
+        WT_CURSOR* c = curwrap.get();
+        int ret = WT_OP_CHECK(c->next(c));
+        if (ret != WT_NOTFOUND) {
+            invariantWTOK(ret);
+            invariantWTOK(c->get_key(c, &lowest));
+            invariantWTOK(c->reset(c));
+            invariantWTOK(WT_OP_CHECK(c->prev(c)));
+            invariantWTOK(c->get_key(c, &highest));
+        }
+    }
+
+    const int64_t width = std::max(int64_t(1), highest - lowest);
+    const int64_t numRanges =
+        std::min(kMaxManyCursorRanges, std::max(int64_t(1), width / kMinRecordIdsPerRange));
+    const int64_t rangeWidth = width / numRanges;
+    for (int64_t i = 0; i < numRanges; i++) {
+        const RecordId start = i == 0 ? RecordId() : _fromKey(lowest + i * rangeWidth);
+        const RecordId end = i + 1 == numRanges ? RecordId()
+                                                : _fromKey(lowest + (i + 1) * rangeWidth);
+        cursors.push_back(stdx::make_unique<Cursor>(txn, *this, start, end));
+    }
     return cursors;
 }
 
@@ -1470,6 +1730,10 @@ Status WiredTigerRecordStore::truncate(OperationContext* txn) {
         _oplogStones->clearStonesOnCommit(txn);
     }
 
+    if (_coldTier) {
+        _coldTier->clear();
+    }
+
     return Status::OK();
 }
 
@@ -1560,6 +1824,10 @@ void WiredTigerRecordStore::appendCustomStats(OperationContext* txn,
         result->appendIntOrLL("sleepCount", _cappedSleep.load());
         result->appendIntOrLL("sleepMS", _cappedSleepMS.load());
     }
+    if (_coldTier) {
+        BSONObjBuilder coldTier(result->subobjStart("coldTier"));
+        _coldTier->appendStats(&coldTier);
+    }
     WiredTigerSession* session = WiredTigerRecoveryUnit::get(txn)->getSession(txn);
     WT_SESSION* s = session->getSession();
     BSONObjBuilder bob(result->subobjStart(_engineName));
@@ -1664,8 +1932,10 @@ boost::optional<RecordId> WiredTigerRecordStore::oplogStartHack(
     int ret = WT_OP_CHECK(c->search_near(c, &cmp));
     if (ret == 0 && cmp > 0)
         ret = c->prev(c);  // landed one higher than startingPosition
-    if (ret == WT_NOTFOUND)
-        return RecordId();  // nothing <= startingPosition
+    if (ret == WT_NOTFOUND) {
+        // nothing <= startingPosition, unless it has been truncated into the cold tier
+        return _coldTier ? _coldTier->findAtOrBefore(startingPosition) : RecordId();
+    }
     invariantWTOK(ret);
 
     int64_t key;
@@ -1751,56 +2021,80 @@ void WiredTigerRecordStore::temp_cappedTruncateAfter(OperationContext* txn,
                                                      RecordId end,
                                                      bool inclusive) {
     Cursor cursor(txn, *this);
-
-    auto record = cursor.seekExact(end);
-    massert(28807, str::stream() << "Failed to seek to the record located at " << end, record);
+    boost::optional<Record> record;
 
     int64_t recordsRemoved = 0;
     int64_t bytesRemoved = 0;
     RecordId lastKeptId;
     RecordId firstRemovedId;
 
-    if (inclusive) {
-        Cursor reverseCursor(txn, *this, false);
-        invariant(reverseCursor.seekExact(end));
-        auto prev = reverseCursor.next();
-        lastKeptId = prev ? prev->id : RecordId();
-        firstRemovedId = end;
-    } else {
-        // If not deleting the record located at 'end', then advance the cursor to the first record
-        // that is being deleted.
+    if (_coldTier && end <= _coldTier->lastRecord()) {
+        // The record located at 'end' was sealed into the cold tier, so every record in the table
+        // is removed along with the later records of the cold tier. The cold tier is truncated
+        // first so that a rollback interrupted before the table is truncated can run again.
+        massert(28807,
+                str::stream() << "Failed to seek to the record located at " << end,
+                _coldTier->findAtOrBefore(end) == end);
+
+        auto lastKept = _coldTier->truncateAfter(end, inclusive);
+        uassertStatusOK(lastKept.getStatus());
+        lastKeptId = lastKept.getValue();
+
         record = cursor.next();
-        if (!record) {
-            return;  // No records to delete.
+        if (record) {
+            firstRemovedId = record->id;
+        }
+    } else {
+        record = cursor.seekExact(end);
+        massert(
+            28807, str::stream() << "Failed to seek to the record located at " << end, record);
+
+        if (inclusive) {
+            // The record before 'end' may be the last one sealed into the cold tier.
+            Cursor reverseCursor(txn, *this, false, /*includeColdTier=*/true);
+            invariant(reverseCursor.seekExact(end));
+            auto prev = reverseCursor.next();
+            lastKeptId = prev ? prev->id : RecordId();
+            firstRemovedId = end;
+        } else {
+            // If not deleting the record located at 'end', then advance the cursor to the first
+            // record that is being deleted.
+            record = cursor.next();
+            if (!record) {
+                return;  // No records to delete.
+            }
+            lastKeptId = end;
+            firstRemovedId = record->id;
         }
-        lastKeptId = end;
-        firstRemovedId = record->id;
     }
 
-    // Compute the number and associated sizes of the records to delete.
-    do {
-        if (_cappedCallback) {
-            uassertStatusOK(_cappedCallback->aboutToDeleteCapped(txn, record->id, record->data));
-        }
-        recordsRemoved++;
-        bytesRemoved += record->data.size();
-    } while ((record = cursor.next()));
+    if (record) {
+        // Compute the number and associated sizes of the records to delete.
+        do {
+            if (_cappedCallback) {
+                uassertStatusOK(
+                    _cappedCallback->aboutToDeleteCapped(txn, record->id, record->data));
+            }
+            recordsRemoved++;
+            bytesRemoved += record->data.size();
+        } while ((record = cursor.next()));
 
-    // Truncate the collection starting from the record located at 'firstRemovedId' to the end of
-    // the collection.
-    WriteUnitOfWork wuow(txn);
+        // Truncate the collection starting from the record located at 'firstRemovedId' to the end
+        // of the collection.
+        WriteUnitOfWork wuow(txn);
 
-    WiredTigerCursor startwrap(_uri, _tableId, true, txn);
-    WT_CURSOR* start = startwrap.get();
-    start->set_key(start, _makeKey(firstRemovedId));
+        WiredTigerCursor startwrap(_uri, _tableId, true, txn);
+        WT_CURSOR* start = startwrap.get();
+        start->set_key(start, _makeKey(firstRemovedId));
 
-    WT_SESSION* session = WiredTigerRecoveryUnit::get(txn)->getSession(txn)->getSession();
-    invariantWTOK(session->truncate(session, nullptr, start, nullptr, nullptr));
+        WT_SESSION* session = WiredTigerRecoveryUnit::get(txn)->getSession(txn)->getSession();
+        invariantWTOK(session->truncate(session, nullptr, start, nullptr, nullptr));
 
-    _changeNumRecords(txn, -recordsRemoved);
-    _increaseDataSize(txn, -bytesRemoved);
+        _changeNumRecords(txn, -recordsRemoved);
+        _increaseDataSize(txn, -bytesRemoved);
 
-    wuow.commit();
+        wuow.commit();
+    }
 
     if (_useOplogHack) {
         // Forget that we've ever seen a higher timestamp than we now have.
@@ -1808,8 +2102,15 @@ void WiredTigerRecordStore::temp_cappedTruncateAfter(OperationContext* txn,
     }
 
     if (_oplogStones) {
-        _oplogStones->updateStonesAfterCappedTruncateAfter(
-            recordsRemoved, bytesRemoved, firstRemovedId);
+        if (recordsRemoved > 0) {
+            _oplogStones->updateStonesAfterCappedTruncateAfter(
+                recordsRemoved, bytesRemoved, firstRemovedId);
+        }
+
+        // Records inserted after the last one kept are sealed and truncated like any others.
+        if (_oplogStones->firstRecord > lastKeptId) {
+            _oplogStones->firstRecord = lastKeptId;
+        }
     }
 }
 
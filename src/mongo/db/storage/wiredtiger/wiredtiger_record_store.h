@@ -53,6 +53,7 @@ namespace mongo {
 
 class RecoveryUnit;
 class WiredTigerCursor;
+class WiredTigerOplogColdTier;
 class WiredTigerRecoveryUnit;
 class WiredTigerSizeStorer;
 
@@ -274,6 +275,8 @@ private:
     void _changeNumRecords(OperationContext* txn, int64_t diff);
     void _increaseDataSize(OperationContext* txn, int64_t amount);
     RecordData _getData(const WiredTigerCursor& cursor) const;
+    void _openColdTier(OperationContext* txn);
+    void _sealIntoColdTier(OperationContext* txn, const RecordId& lastRecord);
     void _oplogSetStartHack(WiredTigerRecoveryUnit* wru) const;
 
     const std::string _uri;
@@ -317,6 +320,9 @@ private:
 
     // Non-null if this record store is underlying the active oplog.
     std::shared_ptr<OplogStones> _oplogStones;
+
+    // Non-null if truncated oplog stones are sealed into a cold tier instead of being discarded.
+    std::shared_ptr<WiredTigerOplogColdTier> _coldTier;
 };
 
 // WT failpoint to throw write conflict exceptions randomly
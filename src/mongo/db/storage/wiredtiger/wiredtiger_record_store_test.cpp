@@ -39,7 +39,9 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/json.h"
 #include "mongo/db/operation_context_noop.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/record_store_test_harness.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store_oplog_stones.h"
@@ -48,6 +50,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -956,6 +959,54 @@ TEST(WiredTigerRecordStoreTest, CappedCursorYieldFirst) {
     ASSERT(!cursor->next());
 }
 
+// getManyCursors() splits a large collection into ranges of RecordIds, which return every record
+// once and in order when read one after the other, each on its own OperationContext.
+TEST(WiredTigerRecordStoreTest, ManyCursorsSplitIntoRanges) {
+    WiredTigerHarnessHelper harnessHelper;
+    unique_ptr<RecordStore> rs(harnessHelper.newNonCappedRecordStore("a.b"));
+
+    const int numRecords = 20000;
+    {
+        unique_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        for (int i = 0; i < numRecords; i++) {
+            ASSERT_OK(rs->insertRecord(opCtx.get(), "a", 2, false).getStatus());
+        }
+        uow.commit();
+    }
+
+    unique_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+    auto cursors = rs->getManyCursors(opCtx.get());
+    ASSERT_GT(cursors.size(), 1U);
+
+    RecordId last;
+    int numSeen = 0;
+    for (auto&& cursor : cursors) {
+        cursor->save();
+        cursor->detachFromOperationContext();
+
+        unique_ptr<OperationContext> readCtx(harnessHelper.newOperationContext());
+        cursor->reattachToOperationContext(readCtx.get());
+        ASSERT_TRUE(cursor->restore());
+        while (auto record = cursor->next()) {
+            ASSERT_GT(record->id, last);
+            last = record->id;
+            numSeen++;
+        }
+        cursor->save();
+        cursor->detachFromOperationContext();
+    }
+    ASSERT_EQUALS(numRecords, numSeen);
+}
+
+TEST(WiredTigerRecordStoreTest, ManyCursorsOfCappedCollection) {
+    WiredTigerHarnessHelper harnessHelper;
+    unique_ptr<RecordStore> rs(harnessHelper.newCappedRecordStore("a.b", 1024 * 1024, -1));
+
+    unique_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+    ASSERT_EQUALS(1U, rs->getManyCursors(opCtx.get()).size());
+}
+
 BSONObj makeBSONObjWithSize(const Timestamp& opTime, int size, char fill = 'x') {
     BSONObj objTemplate = BSON("ts" << opTime << "str"
                                     << "");
@@ -1352,6 +1403,107 @@ TEST(WiredTigerRecordStoreTest, OplogStones_ReclaimStones) {
     }
 }
 
+std::vector<RecordId> scanOplog(OperationContext* opCtx, RecordStore* rs, bool forward) {
+    std::vector<RecordId> ids;
+    auto cursor = rs->getCursor(opCtx, forward);
+    while (auto record = cursor->next()) {
+        ids.push_back(record->id);
+    }
+    return ids;
+}
+
+// Verify that truncating the oplog after a record which was sealed into the cold tier removes the
+// later records of the cold tier and all records of the table.
+TEST(WiredTigerRecordStoreTest, OplogStones_CappedTruncateAfterInColdTier) {
+    unittest::TempDir dbpath("wt_cold_tier_test");
+    storageGlobalParams.dbpath = dbpath.path();
+
+    ServerParameter* coldTierSizeMB =
+        ServerParameterSet::getGlobal()->getMap().find("wiredTigerOplogColdTierSizeMB")->second;
+    ASSERT_OK(coldTierSizeMB->setFromString("1"));
+    ON_BLOCK_EXIT([coldTierSizeMB] { coldTierSizeMB->setFromString("0"); });
+
+    WiredTigerHarnessHelper harnessHelper;
+
+    const int64_t cappedMaxSize = 10 * 1024;  // 10KB
+    unique_ptr<RecordStore> rs(
+        harnessHelper.newCappedRecordStore("local.oplog.stones", cappedMaxSize, -1));
+
+    WiredTigerRecordStore* wtrs = static_cast<WiredTigerRecordStore*>(rs.get());
+    WiredTigerRecordStore::OplogStones* oplogStones = wtrs->oplogStones();
+
+    oplogStones->setMinBytesPerStone(100);
+    oplogStones->setNumStonesToKeep(2U);
+
+    // Seal the first four records into the cold tier.
+    {
+        unique_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+
+        for (unsigned i = 1; i <= 6; i++) {
+            ASSERT_EQ(insertBSONWithSize(opCtx.get(), rs.get(), Timestamp(1, i), 100),
+                      RecordId(1, i));
+        }
+        wtrs->reclaimOplog(opCtx.get());
+
+        ASSERT_EQ(2, rs->numRecords(opCtx.get()));
+        ASSERT_EQ(2U, oplogStones->numStones());
+        ASSERT_EQ(6U, scanOplog(opCtx.get(), rs.get(), true).size());
+    }
+
+    // Truncate data using an inclusive RecordId whose preceding record is in the cold tier.
+    {
+        unique_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+
+        rs->temp_cappedTruncateAfter(opCtx.get(), RecordId(1, 5), true);
+
+        ASSERT_EQ(0, rs->numRecords(opCtx.get()));
+        ASSERT_EQ(0U, oplogStones->numStones());
+        ASSERT_EQ(4U, scanOplog(opCtx.get(), rs.get(), true).size());
+
+        ASSERT_EQ(insertBSONWithSize(opCtx.get(), rs.get(), Timestamp(1, 5), 100), RecordId(1, 5));
+        ASSERT_EQ(1, oplogStones->currentRecords());
+    }
+
+    // Truncate data using a non-inclusive RecordId inside the cold tier. The table is emptied.
+    {
+        unique_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+
+        rs->temp_cappedTruncateAfter(opCtx.get(), RecordId(1, 2), false);
+
+        ASSERT_EQ(0, rs->numRecords(opCtx.get()));
+        ASSERT_EQ(0, rs->dataSize(opCtx.get()));
+        ASSERT_EQ(0U, oplogStones->numStones());
+        ASSERT_EQ(0, oplogStones->currentRecords());
+        ASSERT_EQ(0, oplogStones->currentBytes());
+
+        std::vector<RecordId> expected = {RecordId(1, 1), RecordId(1, 2)};
+        ASSERT(expected == scanOplog(opCtx.get(), rs.get(), true));
+        std::reverse(expected.begin(), expected.end());
+        ASSERT(expected == scanOplog(opCtx.get(), rs.get(), false));
+    }
+
+    // Reopening the oplog with an empty table keeps the records of the cold tier.
+    rs.reset();
+    rs = harnessHelper.newCappedRecordStore("local.oplog.stones", cappedMaxSize, -1);
+    {
+        unique_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+
+        ASSERT_EQ(0, rs->numRecords(opCtx.get()));
+        std::vector<RecordId> expected = {RecordId(1, 1), RecordId(1, 2)};
+        ASSERT(expected == scanOplog(opCtx.get(), rs.get(), true));
+    }
+
+    // Records inserted after the truncation follow the cold tier.
+    {
+        unique_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+
+        ASSERT_EQ(insertBSONWithSize(opCtx.get(), rs.get(), Timestamp(1, 3), 100), RecordId(1, 3));
+
+        std::vector<RecordId> expected = {RecordId(1, 1), RecordId(1, 2), RecordId(1, 3)};
+        ASSERT(expected == scanOplog(opCtx.get(), rs.get(), true));
+    }
+}
+
 // Verify that oplog stones are not reclaimed even if the size of the record store exceeds
 // 'cappedMaxSize'.
 TEST(WiredTigerRecordStoreTest, OplogStones_ExceedCappedMaxSize) {
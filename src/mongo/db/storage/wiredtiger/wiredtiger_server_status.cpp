@@ -76,6 +76,20 @@ BSONObj WiredTigerServerStatusSection::generateSection(OperationContext* txn,
 
     WiredTigerKVEngine::appendGlobalStats(bob);
 
+    WiredTigerSessionCache* sessionCache = WiredTigerRecoveryUnit::get(txn)->getSessionCache();
+
+    BSONObjBuilder sessionCacheStats(bob.subobjStart("sessionCache"));
+    sessionCache->appendStats(&sessionCacheStats);
+    sessionCacheStats.done();
+
+    BSONObjBuilder prefetch(bob.subobjStart("prefetch"));
+    sessionCache->prefetcher().appendStats(&prefetch);
+    prefetch.done();
+
+    BSONObjBuilder groupCommit(bob.subobjStart("groupCommit"));
+    sessionCache->groupCommit().appendStats(&groupCommit);
+    groupCommit.done();
+
     return bob.obj();
 }
 
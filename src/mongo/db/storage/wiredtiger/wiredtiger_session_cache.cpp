@@ -33,18 +33,34 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 
+#include <algorithm>
+#include <functional>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 #include "mongo/base/error_codes.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
 WiredTigerSession::WiredTigerSession(WT_CONNECTION* conn, int epoch)
-    : _epoch(epoch), _session(NULL), _cursorGen(0), _cursorsCached(0), _cursorsOut(0) {
+    : _epoch(epoch),
+      _session(NULL),
+      _cursorGen(0),
+      _cursorsCached(0),
+      _cursorsOut(0),
+      _cursorCacheHits(0),
+      _cursorCacheMisses(0) {
     invariantWTOK(conn->open_session(conn, NULL, "isolation=snapshot", &_session));
 }
 
@@ -55,17 +71,21 @@ WiredTigerSession::~WiredTigerSession() {
 }
 
 WT_CURSOR* WiredTigerSession::getCursor(const std::string& uri, uint64_t id, bool forRecordStore) {
-    // Find the most recently used cursor
-    for (CursorCache::iterator i = _cursors.begin(); i != _cursors.end(); ++i) {
-        if (i->_id == id) {
-            WT_CURSOR* c = i->_cursor;
-            _cursors.erase(i);
-            _cursorsOut++;
-            _cursorsCached--;
-            return c;
-        }
+    // Find the most recently used cursor. Emptied index entries are kept, as the cursor is
+    // usually released again right away.
+    CursorIndex::iterator entry = _cursorIndex.find(id);
+    if (entry != _cursorIndex.end() && !entry->second.empty()) {
+        CursorCache::iterator i = entry->second.back();
+        entry->second.pop_back();
+        WT_CURSOR* c = i->_cursor;
+        _cursors.erase(i);
+        _cursorsOut++;
+        _cursorsCached--;
+        _cursorCacheHits++;
+        return c;
     }
 
+    _cursorCacheMisses++;
     WT_CURSOR* c = NULL;
     int ret = _session->open_cursor(
         _session, uri.c_str(), NULL, forRecordStore ? "" : "overwrite=false", &c);
@@ -85,6 +105,7 @@ void WiredTigerSession::releaseCursor(uint64_t id, WT_CURSOR* cursor) {
 
     // Cursors are pushed to the front of the list and removed from the back
     _cursors.push_front(WiredTigerCachedCursor(id, _cursorGen++, cursor));
+    _cursorIndex[id].push_back(_cursors.begin());
     _cursorsCached++;
 
     // "Old" is defined as not used in the last N**2 operations, if we have N cursors cached.
@@ -94,6 +115,14 @@ void WiredTigerSession::releaseCursor(uint64_t id, WT_CURSOR* cursor) {
     // in between use.
     while (_cursorGen - _cursors.back()._gen > 10000) {
         cursor = _cursors.back()._cursor;
+
+        // The oldest cursor in the cache is also the oldest one of its table.
+        CursorIndex::iterator entry = _cursorIndex.find(_cursors.back()._id);
+        invariant(entry != _cursorIndex.end() && entry->second.front() == --_cursors.end());
+        entry->second.erase(entry->second.begin());
+        if (entry->second.empty())
+            _cursorIndex.erase(entry);
+
         _cursors.pop_back();
         _cursorsCached--;
         invariantWTOK(cursor->close(cursor));
@@ -109,10 +138,31 @@ void WiredTigerSession::closeAllCursors() {
         }
     }
     _cursors.clear();
+    _cursorIndex.clear();
 }
 
 namespace {
 AtomicUInt64 nextTableId(1);
+
+// Number of threads reading ahead for queries, see WiredTigerPrefetcher. 0 disables read-ahead.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerPrefetchThreads, int, 4);
+
+// Upper bound on how long a group commit leader waits for more writers to join its batch.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerGroupCommitMaxWindowMicros, int, 1000);
+
+// Number of partitions of the session cache. 0 means one per core.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerSessionCachePartitions, int, 0);
+
+const int kMaxSessionCachePartitions = 1024;
+
+size_t numSessionCachePartitions() {
+    int partitions = wiredTigerSessionCachePartitions;
+    if (partitions <= 0) {
+        ProcessInfo p;
+        partitions = p.getNumCores();
+    }
+    return std::max(1, std::min(partitions, kMaxSessionCachePartitions));
+}
 }
 // static
 uint64_t WiredTigerSession::genTableId() {
@@ -122,10 +172,28 @@ uint64_t WiredTigerSession::genTableId() {
 // -----------------------
 
 WiredTigerSessionCache::WiredTigerSessionCache(WiredTigerKVEngine* engine)
-    : _engine(engine), _conn(engine->getConnection()), _snapshotManager(_conn), _shuttingDown(0) {}
+    : _engine(engine),
+      _conn(engine->getConnection()),
+      _snapshotManager(_conn),
+      _prefetcher(_conn, engine->isEphemeral() ? 0 : wiredTigerPrefetchThreads),
+      _shuttingDown(0),
+      _groupCommit([this] { _flush(); }, Microseconds(wiredTigerGroupCommitMaxWindowMicros)) {
+    for (size_t i = 0; i < numSessionCachePartitions(); i++) {
+        _partitions.push_back(stdx::make_unique<Partition>());
+    }
+}
 
 WiredTigerSessionCache::WiredTigerSessionCache(WT_CONNECTION* conn)
-    : _engine(NULL), _conn(conn), _snapshotManager(_conn), _shuttingDown(0) {}
+    : _engine(NULL),
+      _conn(conn),
+      _snapshotManager(_conn),
+      _prefetcher(_conn, wiredTigerPrefetchThreads),
+      _shuttingDown(0),
+      _groupCommit([this] { _flush(); }, Microseconds(wiredTigerGroupCommitMaxWindowMicros)) {
+    for (size_t i = 0; i < numSessionCachePartitions(); i++) {
+        _partitions.push_back(stdx::make_unique<Partition>());
+    }
+}
 
 WiredTigerSessionCache::~WiredTigerSessionCache() {
     shuttingDown();
@@ -148,11 +216,17 @@ void WiredTigerSessionCache::shuttingDown() {
         sleepmillis(1);
     }
 
+    _prefetcher.shutdown();
     closeAll();
     _snapshotManager.shutdown();
 }
 
 void WiredTigerSessionCache::waitUntilDurable(bool forceCheckpoint) {
+    // Data kept in memory only is as durable as it is ever going to be.
+    if (isEphemeral()) {
+        return;
+    }
+
     const int shuttingDown = _shuttingDown.fetchAndAdd(1);
     ON_BLOCK_EXIT([this] { _shuttingDown.fetchAndSubtract(1); });
 
@@ -171,18 +245,10 @@ void WiredTigerSessionCache::waitUntilDurable(bool forceCheckpoint) {
         return;
     }
 
-    uint32_t start = _lastSyncTime.load();
-    // Do the remainder in a critical section that ensures only a single thread at a time
-    // will attempt to synchronize.
-    stdx::unique_lock<stdx::mutex> lk(_lastSyncMutex);
-    uint32_t current = _lastSyncTime.loadRelaxed();  // synchronized with writes through mutex
-    if (current != start) {
-        // Someone else synced already since we read lastSyncTime, so we're done!
-        return;
-    }
-    _lastSyncTime.store(current + 1);
+    _groupCommit.waitForFlush();
+}
 
-    // Nobody has synched yet, so we have to sync ourselves.
+void WiredTigerSessionCache::_flush() {
     WiredTigerSession* session = getSession();
     ON_BLOCK_EXIT([this, session] { releaseSession(session); });
     WT_SESSION* s = session->getSession();
@@ -198,13 +264,17 @@ void WiredTigerSessionCache::waitUntilDurable(bool forceCheckpoint) {
 }
 
 void WiredTigerSessionCache::closeAll() {
-    // Increment the epoch as we are now closing all sessions with this epoch
-    SessionCache swap;
+    // Increment the epoch as we are now closing all sessions with this epoch. Sessions released
+    // after this point see the new epoch and are not cached. Those cached before are collected
+    // below, as the partitions are only locked after the increment.
+    _epoch.fetchAndAdd(1);
 
-    {
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        _epoch.fetchAndAdd(1);
-        _sessions.swap(swap);
+    SessionCache swap;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<SpinLock> lock(partition->lock);
+        swap.insert(swap.end(), partition->sessions.begin(), partition->sessions.end());
+        partition->sessions.clear();
+        partition->size.store(0);
     }
 
     for (SessionCache::iterator i = swap.begin(); i != swap.end(); i++) {
@@ -221,18 +291,39 @@ WiredTigerSession* WiredTigerSessionCache::getSession() {
     // operations should be allowed to start.
     invariant(!(_shuttingDown.loadRelaxed() & kShuttingDownMask));
 
+    Partition& home = _homePartition();
     {
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        if (!_sessions.empty()) {
+        _lockPartition(home);
+        stdx::lock_guard<SpinLock> lock(home.lock, stdx::adopt_lock);
+        if (!home.sessions.empty()) {
             // Get the most recently used session so that if we discard sessions, we're
             // discarding older ones
-            WiredTigerSession* cachedSession = _sessions.back();
-            _sessions.pop_back();
+            WiredTigerSession* cachedSession = home.sessions.back();
+            home.sessions.pop_back();
+            home.size.store(home.sessions.size());
+            home.sessionsReused++;
+            return cachedSession;
+        }
+    }
+
+    // Take a session cached by a thread which ran on another core, rather than opening one.
+    for (auto&& partition : _partitions) {
+        if (partition.get() == &home || partition->size.loadRelaxed() == 0)
+            continue;
+
+        _lockPartition(*partition);
+        stdx::lock_guard<SpinLock> lock(partition->lock, stdx::adopt_lock);
+        if (!partition->sessions.empty()) {
+            WiredTigerSession* cachedSession = partition->sessions.back();
+            partition->sessions.pop_back();
+            partition->size.store(partition->sessions.size());
+            partition->sessionsStolen++;
             return cachedSession;
         }
     }
 
     // Outside of the cache partition lock, but on release will be put back on the cache
+    _sessionsCreated.fetchAndAdd(1);
     return new WiredTigerSession(_conn, _epoch.load());
 }
 
@@ -264,11 +355,19 @@ void WiredTigerSessionCache::releaseSession(WiredTigerSession* session) {
     uint64_t currentEpoch = _epoch.load();
 
     if (session->_getEpoch() == currentEpoch) {  // check outside of lock to reduce contention
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
+        Partition& home = _homePartition();
+        _lockPartition(home);
+        stdx::lock_guard<SpinLock> lock(home.lock, stdx::adopt_lock);
         if (session->_getEpoch() == _epoch.load()) {  // recheck inside the lock for correctness
             returnedToCache = true;
-            _sessions.push_back(session);
+            home.sessions.push_back(session);
+            home.size.store(home.sessions.size());
         }
+
+        home.cursorCacheHits += session->_cursorCacheHits;
+        home.cursorCacheMisses += session->_cursorCacheMisses;
+        session->_cursorCacheHits = 0;
+        session->_cursorCacheMisses = 0;
     } else
         invariant(session->_getEpoch() < currentEpoch);
 
@@ -278,4 +377,52 @@ void WiredTigerSessionCache::releaseSession(WiredTigerSession* session) {
     if (_engine && _engine->haveDropsQueued())
         _engine->dropAllQueued();
 }
+
+void WiredTigerSessionCache::appendStats(BSONObjBuilder* b) const {
+    long long sessionsCached = 0;
+    long long sessionsReused = 0;
+    long long sessionsStolen = 0;
+    long long lockContended = 0;
+    long long cursorCacheHits = 0;
+    long long cursorCacheMisses = 0;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<SpinLock> lock(partition->lock);
+        sessionsCached += partition->sessions.size();
+        sessionsReused += partition->sessionsReused;
+        sessionsStolen += partition->sessionsStolen;
+        lockContended += partition->lockContended;
+        cursorCacheHits += partition->cursorCacheHits;
+        cursorCacheMisses += partition->cursorCacheMisses;
+    }
+
+    b->append("partitions", static_cast<int>(_partitions.size()));
+    b->append("sessionsCached", sessionsCached);
+    b->append("sessionsCreated", static_cast<long long>(_sessionsCreated.load()));
+    b->append("sessionsReused", sessionsReused);
+    b->append("sessionsStolen", sessionsStolen);
+    b->append("lockContended", lockContended);
+    b->append("cursorCacheHits", cursorCacheHits);
+    b->append("cursorCacheMisses", cursorCacheMisses);
+}
+
+WiredTigerSessionCache::Partition& WiredTigerSessionCache::_homePartition() {
+    size_t slot;
+#ifdef __linux__
+    const int cpu = sched_getcpu();
+    if (cpu >= 0) {
+        slot = cpu;
+    } else
+#endif
+    {
+        slot = std::hash<stdx::thread::id>()(stdx::this_thread::get_id());
+    }
+    return *_partitions[slot % _partitions.size()];
+}
+
+void WiredTigerSessionCache::_lockPartition(Partition& partition) {
+    if (partition.lock.try_lock())
+        return;
+    partition.lock.lock();
+    partition.lockContended++;
+}
 }
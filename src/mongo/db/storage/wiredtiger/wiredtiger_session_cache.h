@@ -32,11 +32,16 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <boost/thread/shared_mutex.hpp>
 #include <wiredtiger.h>
 
+#include "mongo/db/storage/wiredtiger/wiredtiger_group_commit.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_prefetcher.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_snapshot_manager.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/mutex.h"
@@ -44,6 +49,7 @@
 
 namespace mongo {
 
+class BSONObjBuilder;
 class WiredTigerKVEngine;
 
 class WiredTigerCachedCursor {
@@ -57,7 +63,7 @@ public:
 };
 
 /**
- * This is a structure that caches 1 cursor for each uri.
+ * This is a structure that caches cursors for each uri, looked up by their table id.
  * The idea is that there is a pool of these somewhere.
  * NOT THREADSAFE
  */
@@ -101,8 +107,10 @@ public:
 private:
     friend class WiredTigerSessionCache;
 
-    // The cursor cache is a list of pairs that contain an ID and cursor
+    // The cursor cache is a list of pairs that contain an ID and cursor, most recently released
+    // first. The index maps each ID to its cached cursors, oldest first.
     typedef std::list<WiredTigerCachedCursor> CursorCache;
+    typedef std::unordered_map<uint64_t, std::vector<CursorCache::iterator>> CursorIndex;
 
     // Used internally by WiredTigerSessionCache
     uint64_t _getEpoch() const {
@@ -112,13 +120,23 @@ private:
     const uint64_t _epoch;
     WT_SESSION* _session;  // owned
     CursorCache _cursors;  // owned
+    CursorIndex _cursorIndex;
     uint64_t _cursorGen;
     int _cursorsCached, _cursorsOut;
+
+    // Cursor cache lookups since the session was last returned to the WiredTigerSessionCache,
+    // which adds them to its statistics.
+    long long _cursorCacheHits, _cursorCacheMisses;
 };
 
 /**
  *  This cache implements a shared pool of WiredTiger sessions with the goal to amortize the
  *  cost of session creation and destruction over multiple uses.
+ *
+ *  The pool is split into partitions, one per core by default, each protected by its own spin
+ *  lock. Threads return sessions to and take them from the partition of the core they run on,
+ *  and only look at the other partitions when their own is empty, so that threads on different
+ *  cores rarely touch the same lock.
  */
 class WiredTigerSessionCache {
 public:
@@ -157,6 +175,8 @@ public:
      * Waits until all commits that happened before this call are durable, either by flushing
      * the log or forcing a checkpoint if forceCheckpoint is true or the journal is disabled.
      * Uses a temporary session. Safe to call without any locks, even during shutdown.
+     *
+     * Concurrent callers share log flushes, see WiredTigerGroupCommit.
      */
     void waitUntilDurable(bool forceCheckpoint);
 
@@ -171,10 +191,49 @@ public:
         return _snapshotManager;
     }
 
+    WiredTigerPrefetcher& prefetcher() {
+        return _prefetcher;
+    }
+
+    const WiredTigerGroupCommit& groupCommit() const {
+        return _groupCommit;
+    }
+
+    /**
+     * Appends the number of cached sessions, how they were obtained, how often a partition lock
+     * was contended and the cursor cache hit rate.
+     */
+    void appendStats(BSONObjBuilder* b) const;
+
 private:
+    struct Partition {
+        SpinLock lock;
+        std::vector<WiredTigerSession*> sessions;
+
+        // Number of cached sessions, for other threads to check without taking the lock.
+        AtomicUInt32 size;
+
+        // Statistics, protected by 'lock'.
+        long long sessionsReused = 0;
+        long long sessionsStolen = 0;
+        long long lockContended = 0;
+        long long cursorCacheHits = 0;
+        long long cursorCacheMisses = 0;
+    };
+
+    // Returns the partition of the core the calling thread runs on.
+    Partition& _homePartition();
+
+    // Locks 'partition', counting the acquisition as contended if the lock was held.
+    static void _lockPartition(Partition& partition);
+
+    // Makes all commits so far durable, through the journal if there is one.
+    void _flush();
+
     WiredTigerKVEngine* _engine;  // not owned, might be NULL
     WT_CONNECTION* _conn;         // not owned
     WiredTigerSnapshotManager _snapshotManager;
+    WiredTigerPrefetcher _prefetcher;
 
     // Used as follows:
     //   The low 31 bits are a count of active calls to releaseSession.
@@ -182,15 +241,15 @@ private:
     AtomicUInt32 _shuttingDown;
     static const uint32_t kShuttingDownMask = 1 << 31;
 
-    stdx::mutex _cacheLock;
     typedef std::vector<WiredTigerSession*> SessionCache;
-    SessionCache _sessions;
+    std::vector<std::unique_ptr<Partition>> _partitions;
+
+    AtomicUInt64 _sessionsCreated;
 
     // Bumped when all open sessions need to be closed
     AtomicUInt64 _epoch;  // atomic so we can check it outside of the lock
 
-    // Counter and critical section mutex for waitUntilDurable
-    AtomicUInt32 _lastSyncTime;
-    stdx::mutex _lastSyncMutex;
+    // Batches the log flushes of waitUntilDurable.
+    WiredTigerGroupCommit _groupCommit;
 };
 }  // namespace
@@ -0,0 +1,131 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <wiredtiger.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+class WiredTigerSessionCacheTest : public unittest::Test {
+public:
+    WiredTigerSessionCacheTest() : _dbpath("wt_session_cache_test") {
+        invariantWTOK(wiredtiger_open(_dbpath.path().c_str(), NULL, "create", &_conn));
+        _sessionCache.reset(new WiredTigerSessionCache(_conn));
+    }
+
+    ~WiredTigerSessionCacheTest() {
+        _sessionCache.reset();
+        _conn->close(_conn, NULL);
+    }
+
+protected:
+    BSONObj stats() const {
+        BSONObjBuilder b;
+        _sessionCache->appendStats(&b);
+        return b.obj();
+    }
+
+    void createTable(const char* uri) {
+        WiredTigerSession* session = _sessionCache->getSession();
+        WT_SESSION* s = session->getSession();
+        invariantWTOK(s->create(s, uri, "key_format=q,value_format=u"));
+        _sessionCache->releaseSession(session);
+    }
+
+    unittest::TempDir _dbpath;
+    WT_CONNECTION* _conn;
+    std::unique_ptr<WiredTigerSessionCache> _sessionCache;
+};
+
+TEST_F(WiredTigerSessionCacheTest, ReusesReleasedSessions) {
+    WiredTigerSession* session = _sessionCache->getSession();
+    _sessionCache->releaseSession(session);
+    ASSERT_EQUALS(1, stats()["sessionsCached"].numberLong());
+
+    // The session is found whether or not the thread moved to another core in between.
+    ASSERT_EQUALS(session, _sessionCache->getSession());
+    _sessionCache->releaseSession(session);
+
+    BSONObj obj = stats();
+    ASSERT_EQUALS(1, obj["sessionsCreated"].numberLong());
+    ASSERT_EQUALS(1, obj["sessionsReused"].numberLong() + obj["sessionsStolen"].numberLong());
+    ASSERT_GREATER_THAN_OR_EQUALS(obj["partitions"].numberInt(), 1);
+}
+
+TEST_F(WiredTigerSessionCacheTest, ClosesSessionsReleasedAfterCloseAll) {
+    WiredTigerSession* cached = _sessionCache->getSession();
+    WiredTigerSession* out = _sessionCache->getSession();
+    _sessionCache->releaseSession(cached);
+    ASSERT_EQUALS(1, stats()["sessionsCached"].numberLong());
+
+    _sessionCache->closeAll();
+    ASSERT_EQUALS(0, stats()["sessionsCached"].numberLong());
+
+    _sessionCache->releaseSession(out);
+    ASSERT_EQUALS(0, stats()["sessionsCached"].numberLong());
+}
+
+TEST_F(WiredTigerSessionCacheTest, CachesCursorsPerTable) {
+    createTable("table:a");
+    createTable("table:b");
+    const uint64_t idA = WiredTigerSession::genTableId();
+    const uint64_t idB = WiredTigerSession::genTableId();
+
+    WiredTigerSession* session = _sessionCache->getSession();
+    WT_CURSOR* a = session->getCursor("table:a", idA, true);
+    WT_CURSOR* b = session->getCursor("table:b", idB, true);
+    WT_CURSOR* a2 = session->getCursor("table:a", idA, true);
+    ASSERT_EQUALS(3, session->cursorsOut());
+    session->releaseCursor(idA, a);
+    session->releaseCursor(idB, b);
+    session->releaseCursor(idA, a2);
+
+    // The most recently released cursor of each table comes back first.
+    ASSERT_EQUALS(a2, session->getCursor("table:a", idA, true));
+    ASSERT_EQUALS(a, session->getCursor("table:a", idA, true));
+    ASSERT_EQUALS(b, session->getCursor("table:b", idB, true));
+    session->releaseCursor(idA, a);
+    session->releaseCursor(idA, a2);
+    session->releaseCursor(idB, b);
+    _sessionCache->releaseSession(session);
+
+    BSONObj obj = stats();
+    ASSERT_EQUALS(3, obj["cursorCacheHits"].numberLong());
+    ASSERT_EQUALS(3, obj["cursorCacheMisses"].numberLong());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -70,6 +70,11 @@ Status wtRCToStatus_slow(int retCode, const char* prefix) {
         return Status(ErrorCodes::BadValue, s);
     }
 
+    // Only returned when running in memory, where nothing can be evicted to make room.
+    if (retCode == WT_CACHE_FULL) {
+        return Status(ErrorCodes::ExceededMemoryLimit, s);
+    }
+
     // TODO convert specific codes rather than just using UNKNOWN_ERROR for everything.
     return Status(ErrorCodes::UnknownError, s);
 }
@@ -30,8 +30,11 @@
 
 #include "mongo/platform/basic.h"
 
+#include <unordered_map>
+
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/json.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/pipeline/dependencies.h"
 #include "mongo/db/pipeline/document_source.h"
@@ -236,6 +239,65 @@ public:
     }
 };
 
+/** Read a DocumentSourceCursor column by column. */
+class ColumnBatches : public Base {
+public:
+    void run() {
+        client.insert(nss.ns(), BSON("a" << 1 << "b" << 2));
+        client.insert(nss.ns(), BSON("b" << 3));
+        client.insert(nss.ns(), BSON("a" << 4 << "c" << 5));
+        createSource();
+
+        // A document loaded before switching to columns is not lost.
+        boost::optional<Document> next = source()->getNext();
+        ASSERT(bool(next));
+        ASSERT_EQUALS(Value(1), next->getField("a"));
+
+        ColumnBatch batch({"a"});
+        ASSERT(source()->getNextColumnBatch(&batch));
+        ASSERT_EQUALS(2U, batch.size());
+        ASSERT(batch.getColumn(0)[0].missing());
+        ASSERT_EQUALS(Value(4), batch.getColumn(0)[1]);
+
+        // Exhausting the source releases the read lock.
+        ASSERT(!source()->getNextColumnBatch(&batch));
+        ASSERT(batch.empty());
+        ASSERT(!_opCtx.lockState()->isReadLocked());
+    }
+};
+
+/** A $group on top-level fields, which reads its input from the cursor column by column. */
+class GroupFromColumns : public Base {
+public:
+    void run() {
+        for (int i = 0; i < 100; i++) {
+            client.insert(nss.ns(), BSON("a" << i % 3 << "b" << i << "c" << BSON("d" << i)));
+        }
+        client.insert(nss.ns(), BSON("b" << 1));
+        createSource();
+
+        BSONObj spec = fromjson("{$group: {_id: '$a', count: {$sum: 1}, total: {$sum: '$b'}}}");
+        intrusive_ptr<DocumentSource> group =
+            DocumentSourceGroup::createFromBson(spec.firstElement(), ctx());
+        group->setSource(source());
+
+        std::unordered_map<Value, Document, Value::Hash> results;
+        while (boost::optional<Document> next = group->getNext()) {
+            results[next->getField("_id")] = *next;
+        }
+
+        ASSERT_EQUALS(4U, results.size());
+        ASSERT_EQUALS(Document(BSON("_id" << 0 << "count" << 34 << "total" << 1683)),
+                      results[Value(0)]);
+        ASSERT_EQUALS(Document(BSON("_id" << 1 << "count" << 33 << "total" << 1617)),
+                      results[Value(1)]);
+        ASSERT_EQUALS(Document(BSON("_id" << 2 << "count" << 33 << "total" << 1650)),
+                      results[Value(2)]);
+        ASSERT_EQUALS(Document(BSON("_id" << BSONNULL << "count" << 1 << "total" << 1)),
+                      results[Value(BSONNULL)]);
+    }
+};
+
 }  // namespace DocumentSourceCursor
 
 class All : public Suite {
@@ -247,6 +309,8 @@ public:
         add<DocumentSourceCursor::Dispose>();
         add<DocumentSourceCursor::IterateDispose>();
         add<DocumentSourceCursor::LimitCoalesce>();
+        add<DocumentSourceCursor::ColumnBatches>();
+        add<DocumentSourceCursor::GroupFromColumns>();
     }
 };
 
@@ -470,6 +470,83 @@ public:
     }
 };
 
+/** Index creation generates keys on several threads and merges their sorted partitions. */
+template <bool unique>
+class InsertBuildParallelKeyGeneration : public IndexBuildBase {
+public:
+    InsertBuildParallelKeyGeneration() : _savedThreads(indexBuildKeyGenerationThreads.load()) {
+        indexBuildKeyGenerationThreads.store(4);
+    }
+
+    ~InsertBuildParallelKeyGeneration() {
+        indexBuildKeyGenerationThreads.store(_savedThreads);
+    }
+
+    void run() {
+        const int kDocs = 10 * 1000;
+
+        Database* db = _ctx.db();
+        Collection* coll;
+        {
+            WriteUnitOfWork wunit(&_txn);
+            db->dropCollection(&_txn, _ns);
+            coll = db->createCollection(&_txn, _ns);
+
+            for (int i = 0; i < kDocs - 1; i++) {
+                ASSERT_OK(coll->insertDocument(
+                    &_txn, BSON("_id" << i << "a" << i << "b" << BSON_ARRAY(i << -i)), true));
+            }
+            // Duplicates the only key of the first document, far apart from it in the scan.
+            ASSERT_OK(coll->insertDocument(
+                &_txn, BSON("_id" << kDocs << "a" << 0 << "b" << BSON_ARRAY(0)), true));
+            wunit.commit();
+        }
+
+        MultiIndexBlock indexer(&_txn, coll);
+        indexer.allowInterruption();
+
+        const BSONObj spec = BSON("name"
+                                  << "a_1_b_1"
+                                  << "ns" << coll->ns().ns() << "key" << BSON("a" << 1 << "b" << 1)
+                                  << "unique" << unique);
+        ASSERT_OK(indexer.init(spec));
+
+        std::set<RecordId> dups;
+        ASSERT_OK(indexer.insertAllDocumentsInCollection(&dups));
+        if (unique) {
+            // Only one of the two documents with the key {a: 0, b: 0} can be indexed.
+            ASSERT_EQUALS(1U, dups.size());
+            return;
+        }
+        ASSERT(dups.empty());
+
+        WriteUnitOfWork wunit(&_txn);
+        indexer.commit();
+        wunit.commit();
+
+        IndexDescriptor* desc = coll->getIndexCatalog()->findIndexByName(&_txn, "a_1_b_1");
+        ASSERT(desc);
+        ASSERT(coll->getIndexCatalog()->isMultikey(&_txn, desc));
+
+        // Every document but the two with a == 0 has two keys.
+        int64_t numKeys;
+        ASSERT_OK(coll->getIndexCatalog()->getIndex(desc)->validate(&_txn, false, &numKeys, NULL));
+        ASSERT_EQUALS(2 * kDocs - 2, numKeys);
+
+        std::unique_ptr<DBClientCursor> cursor =
+            _client.query(_ns, Query().hint(BSON("a" << 1 << "b" << 1)));
+        int count = 0;
+        while (cursor->more()) {
+            cursor->next();
+            count++;
+        }
+        ASSERT_EQUALS(kDocs, count);
+    }
+
+private:
+    const int _savedThreads;
+};
+
 /** Index creation is killed if mayInterrupt is true. */
 class InsertBuildIndexInterrupt : public IndexBuildBase {
 public:
@@ -901,6 +978,8 @@ public:
         add<InsertBuildEnforceUnique<false>>();
         add<InsertBuildFillDups<true>>();
         add<InsertBuildFillDups<false>>();
+        add<InsertBuildParallelKeyGeneration<false>>();
+        add<InsertBuildParallelKeyGeneration<true>>();
         add<InsertBuildIndexInterrupt>();
         add<InsertBuildIndexInterruptDisallowed>();
         add<InsertBuildIdIndexInterrupt>();
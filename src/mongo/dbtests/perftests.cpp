@@ -49,8 +49,13 @@
 #include "mongo/config.h"
 #include "mongo/db/client.h"
 #include "mongo/db/db.h"
+#include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/projection.h"
 #include "mongo/db/lasterror.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/extensions_callback_noop.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
 #include "mongo/db/storage/mmap_v1/mmap.h"
@@ -444,6 +449,89 @@ public:
     }
 };
 
+/**
+ * Scans a collection through a filter and a projection, pulling the results out of the plan
+ * either one at a time with work() or in batches with workBatch().
+ */
+class PlanScanBase : public B {
+public:
+    virtual int howLongMillis() {
+        return 2000;
+    }
+    virtual bool showDurStats() {
+        return false;
+    }
+    void prep() {
+        for (int i = 0; i < 10000; i++) {
+            insert(ns(), BSON("_id" << i << "x" << i % 100 << "y" << i << "s" << "payload"));
+        }
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(BSON("x" << BSON("$lt" << 50)));
+        verify(statusWithMatcher.isOK());
+        _filter = std::move(statusWithMatcher.getValue());
+    }
+    void timed() {
+        AutoGetCollectionForRead ctx(txn(), ns());
+
+        WorkingSet ws;
+        CollectionScanParams scanParams;
+        scanParams.collection = ctx.getCollection();
+        ExtensionsCallbackNoop extensionsCallback;
+        ProjectionStageParams projParams(extensionsCallback);
+        projParams.projObj = BSON("_id" << 0 << "y" << 1);
+        ProjectionStage plan(txn(),
+                             projParams,
+                             &ws,
+                             new CollectionScan(txn(), scanParams, &ws, _filter.get()));
+
+        long long count = 0;
+        vector<WorkingSetID> results;
+        while (!plan.isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            results.clear();
+            if (execBatchSize() > 1) {
+                plan.workBatch(execBatchSize(), &results, &id);
+            } else if (PlanStage::ADVANCED == plan.work(&id)) {
+                results.push_back(id);
+            }
+            for (auto result : results) {
+                ws.free(result);
+                count++;
+            }
+        }
+        verify(count == 5000);
+    }
+
+protected:
+    virtual size_t execBatchSize() = 0;
+
+private:
+    std::unique_ptr<MatchExpression> _filter;
+};
+
+class PlanScanTupleAtATime : public PlanScanBase {
+public:
+    string name() {
+        return "plan-scan-tuple-at-a-time";
+    }
+
+protected:
+    size_t execBatchSize() {
+        return 1;
+    }
+};
+
+class PlanScanBatched : public PlanScanBase {
+public:
+    string name() {
+        return "plan-scan-batched";
+    }
+
+protected:
+    size_t execBatchSize() {
+        return 128;
+    }
+};
 
 class All : public Suite {
 public:
@@ -457,6 +545,8 @@ public:
         add<boosttimed_mutexspeed>();
         add<stdmutexspeed>();
         add<stdtimed_mutexspeed>();
+        add<PlanScanTupleAtATime>();
+        add<PlanScanBatched>();
     }
 } myall;
 }
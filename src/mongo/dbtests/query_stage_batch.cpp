@@ -0,0 +1,326 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * This file tests PlanStage::workBatch() for the stages which implement it, and its use by
+ * PlanExecutor.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/fetch.h"
+#include "mongo/db/exec/index_scan.h"
+#include "mongo/db/exec/limit.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/projection.h"
+#include "mongo/db/exec/skip.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/extensions_callback_noop.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/dbtests/dbtests.h"
+#include "mongo/stdx/memory.h"
+
+namespace QueryStageBatch {
+
+using std::unique_ptr;
+using std::vector;
+using stdx::make_unique;
+
+class QueryStageBatchBase {
+public:
+    QueryStageBatchBase() : _client(&_txn) {
+        OldClientWriteContext ctx(&_txn, ns());
+        _client.ensureIndex(ns(), BSON("foo" << 1));
+        for (int i = 0; i < numObj(); ++i) {
+            _client.insert(ns(), BSON("foo" << i << "bar" << i * 2));
+        }
+    }
+
+    virtual ~QueryStageBatchBase() {
+        OldClientWriteContext ctx(&_txn, ns());
+        _client.dropCollection(ns());
+    }
+
+    static int numObj() {
+        return 100;
+    }
+
+    static const char* ns() {
+        return "unittests.QueryStageBatch";
+    }
+
+protected:
+    unique_ptr<MatchExpression> parseFilter(const BSONObj& filterObj) {
+        StatusWithMatchExpression statusWithMatcher = MatchExpressionParser::parse(filterObj);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        return std::move(statusWithMatcher.getValue());
+    }
+
+    CollectionScan* makeCollScan(Collection* coll, const MatchExpression* filter) {
+        CollectionScanParams params;
+        params.collection = coll;
+        params.direction = CollectionScanParams::FORWARD;
+        return new CollectionScan(&_txn, params, &_ws, filter);
+    }
+
+    IndexScan* makeIndexScan(Collection* coll) {
+        IndexScanParams params;
+        params.descriptor = coll->getIndexCatalog()->findIndexByKeyPattern(&_txn, BSON("foo" << 1));
+        ASSERT(params.descriptor);
+        params.bounds.isSimpleRange = true;
+        params.bounds.startKey = BSON("" << 10);
+        params.bounds.endKey = BSON("" << 90);
+        params.bounds.endKeyInclusive = true;
+        return new IndexScan(&_txn, params, &_ws, nullptr);
+    }
+
+    /**
+     * Returns owned copies of every object 'stage' produces when worked one result at a time.
+     */
+    vector<BSONObj> drain(PlanStage* stage) {
+        vector<BSONObj> out;
+        while (!stage->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = stage->work(&id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::DEAD, state);
+            if (PlanStage::ADVANCED == state) {
+                out.push_back(_ws.get(id)->obj.value().getOwned());
+                _ws.free(id);
+            }
+        }
+        return out;
+    }
+
+    /**
+     * Same as drain(), but pulls the results out of 'stage' in batches of 'batchSize'. The
+     * members are only looked at once the stage is exhausted, which also checks that results of
+     * earlier batches stay valid while the stage moves on.
+     */
+    vector<BSONObj> drainBatched(PlanStage* stage, size_t batchSize) {
+        vector<WorkingSetID> ids;
+        while (!stage->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            const size_t before = ids.size();
+            PlanStage::StageState state = stage->workBatch(batchSize, &ids, &id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::DEAD, state);
+            ASSERT_LESS_THAN_OR_EQUALS(ids.size() - before, batchSize);
+            if (PlanStage::IS_EOF == state) {
+                break;
+            }
+        }
+
+        vector<BSONObj> out;
+        for (auto id : ids) {
+            out.push_back(_ws.get(id)->obj.value().getOwned());
+            _ws.free(id);
+        }
+        return out;
+    }
+
+    void assertSameResults(const vector<BSONObj>& expected, const vector<BSONObj>& actual) {
+        ASSERT_EQUALS(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUALS(expected[i], actual[i]);
+        }
+    }
+
+    OperationContextImpl _txn;
+    WorkingSet _ws;
+
+private:
+    DBDirectClient _client;
+};
+
+class CollScanWithFilter : public QueryStageBatchBase {
+public:
+    void run() {
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        Collection* coll = ctx.getCollection();
+        unique_ptr<MatchExpression> filter = parseFilter(BSON("bar" << BSON("$gte" << 50)));
+
+        unique_ptr<PlanStage> scan(makeCollScan(coll, filter.get()));
+        vector<BSONObj> expected = drain(scan.get());
+        ASSERT_EQUALS(75U, expected.size());
+
+        for (size_t batchSize : {1, 7, 64, 1000}) {
+            unique_ptr<PlanStage> batched(makeCollScan(coll, filter.get()));
+            assertSameResults(expected, drainBatched(batched.get(), batchSize));
+        }
+    }
+};
+
+class FetchOverIndexScan : public QueryStageBatchBase {
+public:
+    void run() {
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        Collection* coll = ctx.getCollection();
+        unique_ptr<MatchExpression> filter = parseFilter(BSON("bar" << BSON("$lt" << 100)));
+
+        unique_ptr<PlanStage> fetch =
+            make_unique<FetchStage>(&_txn, &_ws, makeIndexScan(coll), filter.get(), coll);
+        vector<BSONObj> expected = drain(fetch.get());
+        ASSERT_EQUALS(40U, expected.size());
+
+        for (size_t batchSize : {1, 3, 16, 1000}) {
+            unique_ptr<PlanStage> batched =
+                make_unique<FetchStage>(&_txn, &_ws, makeIndexScan(coll), filter.get(), coll);
+            assertSameResults(expected, drainBatched(batched.get(), batchSize));
+        }
+    }
+};
+
+class ProjectionLimitSkip : public QueryStageBatchBase {
+public:
+    void run() {
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        Collection* coll = ctx.getCollection();
+
+        ExtensionsCallbackNoop extensionsCallback;
+        ProjectionStageParams params(extensionsCallback);
+        params.projObj = BSON("_id" << 0 << "foo" << 1);
+
+        auto makePlan = [&]() -> PlanStage* {
+            PlanStage* skip = new SkipStage(&_txn, 13, &_ws, makeCollScan(coll, nullptr));
+            PlanStage* limit = new LimitStage(&_txn, 50, &_ws, skip);
+            return new ProjectionStage(&_txn, params, &_ws, limit);
+        };
+
+        unique_ptr<PlanStage> plan(makePlan());
+        vector<BSONObj> expected = drain(plan.get());
+        ASSERT_EQUALS(50U, expected.size());
+        ASSERT_EQUALS(BSON("foo" << 13), expected.front());
+
+        for (size_t batchSize : {1, 5, 20, 1000}) {
+            unique_ptr<PlanStage> batched(makePlan());
+            assertSameResults(expected, drainBatched(batched.get(), batchSize));
+        }
+    }
+};
+
+/**
+ * A fetch stage reading ahead a window of documents returns the same results as one that
+ * fetches them one at a time.
+ */
+class FetchReadsAhead : public QueryStageBatchBase {
+public:
+    void run() {
+        const int oldWindow = internalQueryFetchReadAheadWindow.load();
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        Collection* coll = ctx.getCollection();
+
+        internalQueryFetchReadAheadWindow.store(0);
+        unique_ptr<FetchStage> fetch =
+            make_unique<FetchStage>(&_txn, &_ws, makeIndexScan(coll), nullptr, coll);
+        vector<BSONObj> expected = drain(fetch.get());
+        ASSERT_EQUALS(81U, expected.size());
+
+        for (int window : {2, 8, 1000}) {
+            internalQueryFetchReadAheadWindow.store(window);
+            unique_ptr<FetchStage> readAhead =
+                make_unique<FetchStage>(&_txn, &_ws, makeIndexScan(coll), nullptr, coll);
+            assertSameResults(expected, drain(readAhead.get()));
+
+            const FetchStats* stats =
+                static_cast<const FetchStats*>(readAhead->getSpecificStats());
+            ASSERT_EQUALS(81U, stats->docsExamined);
+            ASSERT_LESS_THAN_OR_EQUALS(stats->docsPrefetched, stats->docsExamined);
+        }
+        internalQueryFetchReadAheadWindow.store(oldWindow);
+    }
+};
+
+/**
+ * PlanExecutor returns the same results whether or not it pulls them through the plan in
+ * batches, including across saveState() / restoreState().
+ */
+class ExecutorUsesBatches : public QueryStageBatchBase {
+public:
+    void run() {
+        const int oldBatchSize = internalQueryExecBatchSize.load();
+        vector<BSONObj> expected = execute(1);
+        ASSERT_EQUALS(static_cast<size_t>(numObj()), expected.size());
+        assertSameResults(expected, execute(32));
+        internalQueryExecBatchSize.store(oldBatchSize);
+    }
+
+private:
+    vector<BSONObj> execute(int batchSize) {
+        internalQueryExecBatchSize.store(batchSize);
+
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        Collection* coll = ctx.getCollection();
+
+        CollectionScanParams params;
+        params.collection = coll;
+        params.direction = CollectionScanParams::FORWARD;
+
+        auto ws = make_unique<WorkingSet>();
+        unique_ptr<PlanStage> scan = make_unique<CollectionScan>(&_txn, params, ws.get(), nullptr);
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_txn, std::move(ws), std::move(scan), coll, PlanExecutor::YIELD_MANUAL);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        unique_ptr<PlanExecutor> exec = std::move(statusWithPlanExecutor.getValue());
+
+        vector<BSONObj> out;
+        for (BSONObj obj; PlanExecutor::ADVANCED == exec->getNext(&obj, NULL);) {
+            out.push_back(obj.getOwned());
+            if (out.size() % 10 == 0) {
+                exec->saveState();
+                ASSERT(exec->restoreState());
+            }
+        }
+        return out;
+    }
+};
+
+class All : public Suite {
+public:
+    All() : Suite("query_stage_batch") {}
+
+    void setupTests() {
+        add<CollScanWithFilter>();
+        add<FetchOverIndexScan>();
+        add<ProjectionLimitSkip>();
+        add<FetchReadsAhead>();
+        add<ExecutorUsesBatches>();
+    }
+};
+
+SuiteInstance<All> queryStageBatchAll;
+
+}  // namespace QueryStageBatch
@@ -131,8 +131,14 @@ public:
 
         // High enough so that we shouldn't trigger a replan based on works.
         const size_t decisionWorks = 50;
-        CachedPlanStage cachedPlanStage(
-            &_txn, collection, &_ws, cq.get(), plannerParams, decisionWorks, mockChild.release());
+        CachedPlanStage cachedPlanStage(&_txn,
+                                        collection,
+                                        &_ws,
+                                        cq.get(),
+                                        plannerParams,
+                                        decisionWorks,
+                                        nullptr,
+                                        mockChild.release());
 
         // This should succeed after triggering a replan.
         PlanYieldPolicy yieldPolicy(nullptr, PlanExecutor::YIELD_MANUAL);
@@ -199,8 +205,14 @@ public:
             mockChild->pushBack(PlanStage::NEED_TIME);
         }
 
-        CachedPlanStage cachedPlanStage(
-            &_txn, collection, &_ws, cq.get(), plannerParams, decisionWorks, mockChild.release());
+        CachedPlanStage cachedPlanStage(&_txn,
+                                        collection,
+                                        &_ws,
+                                        cq.get(),
+                                        plannerParams,
+                                        decisionWorks,
+                                        nullptr,
+                                        mockChild.release());
 
         // This should succeed after triggering a replan.
         PlanYieldPolicy yieldPolicy(nullptr, PlanExecutor::YIELD_MANUAL);
@@ -0,0 +1,220 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * This file tests db/exec/parallel_collection_scan.cpp.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/service_context.h"
+#include "mongo/dbtests/dbtests.h"
+#include "mongo/stdx/memory.h"
+
+namespace QueryStageParallelCollectionScan {
+
+using std::unique_ptr;
+using std::vector;
+using stdx::make_unique;
+
+class QueryStageParallelCollectionScanBase {
+public:
+    QueryStageParallelCollectionScanBase() : _client(&_txn) {
+        OldClientWriteContext ctx(&_txn, ns());
+        for (int i = 0; i < numObj(); ++i) {
+            _client.insert(ns(), BSON("foo" << i));
+        }
+    }
+
+    virtual ~QueryStageParallelCollectionScanBase() {
+        OldClientWriteContext ctx(&_txn, ns());
+        _client.dropCollection(ns());
+    }
+
+    // Enough records for a WiredTiger collection to be split into several partitions.
+    static int numObj() {
+        return 20000;
+    }
+
+    static const char* ns() {
+        return "unittests.QueryStageParallelCollectionScan";
+    }
+
+protected:
+    unique_ptr<MatchExpression> parseFilter(const BSONObj& filterObj) {
+        StatusWithMatchExpression statusWithMatcher = MatchExpressionParser::parse(filterObj);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        return std::move(statusWithMatcher.getValue());
+    }
+
+    /**
+     * Returns the value of 'foo' of every document 'stage' produces. Saves and restores the stage
+     * every 'yieldEvery' results if it isn't 0.
+     */
+    vector<int> drain(PlanStage* stage, WorkingSet* ws, int yieldEvery = 0) {
+        vector<int> out;
+        while (!stage->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = stage->work(&id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::DEAD, state);
+            if (PlanStage::ADVANCED != state) {
+                continue;
+            }
+
+            WorkingSetMember* member = ws->get(id);
+            ASSERT(member->hasLoc());
+            ASSERT(member->hasObj());
+            out.push_back(member->obj.value()["foo"].numberInt());
+            ws->free(id);
+
+            if (yieldEvery && 0 == out.size() % yieldEvery) {
+                stage->saveState();
+                stage->detachFromOperationContext();
+                stage->reattachToOperationContext(&_txn);
+                stage->restoreState();
+            }
+        }
+        return out;
+    }
+
+    vector<int> serialScan(Collection* coll, const MatchExpression* filter) {
+        CollectionScanParams params;
+        params.collection = coll;
+        params.direction = CollectionScanParams::FORWARD;
+        WorkingSet ws;
+        CollectionScan scan(&_txn, params, &ws, filter);
+        return drain(&scan, &ws);
+    }
+
+    OperationContextImpl _txn;
+
+private:
+    DBDirectClient _client;
+};
+
+// The partitions are returned one after another, in the order of a serial scan.
+class QueryStageParallelCollscanOrdered : public QueryStageParallelCollectionScanBase {
+public:
+    void run() {
+        // The partitions are read without the locks of the query.
+        if (!supportsDocLocking()) {
+            return;
+        }
+
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        Collection* coll = ctx.getCollection();
+        unique_ptr<MatchExpression> filter =
+            parseFilter(BSON("foo" << BSON("$mod" << BSON_ARRAY(3 << 0))));
+
+        WorkingSet ws;
+        ParallelCollectionScan scan(&_txn, coll, 3, true, &ws, filter.get());
+        vector<int> results = drain(&scan, &ws);
+        ASSERT(serialScan(coll, filter.get()) == results);
+        ASSERT_EQUALS(static_cast<size_t>(numObj() / 3 + 1), results.size());
+
+        const ParallelCollectionScanStats* stats =
+            static_cast<const ParallelCollectionScanStats*>(scan.getSpecificStats());
+        ASSERT_GREATER_THAN(stats->partitions, 1U);
+        ASSERT_EQUALS(static_cast<size_t>(numObj()), stats->docsTested);
+        ASSERT_TRUE(stats->ordered);
+    }
+};
+
+// Every document comes out exactly once, in whatever order the workers read them, even if the
+// stage gets saved and restored while the workers are reading.
+class QueryStageParallelCollscanUnorderedWithYields : public QueryStageParallelCollectionScanBase {
+public:
+    void run() {
+        if (!supportsDocLocking()) {
+            return;
+        }
+
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        Collection* coll = ctx.getCollection();
+
+        WorkingSet ws;
+        ParallelCollectionScan scan(&_txn, coll, 4, false, &ws, nullptr);
+        vector<int> results = drain(&scan, &ws, 1000);
+        std::sort(results.begin(), results.end());
+        ASSERT(serialScan(coll, nullptr) == results);
+    }
+};
+
+// workBatch() returns the same documents as work().
+class QueryStageParallelCollscanWorkBatch : public QueryStageParallelCollectionScanBase {
+public:
+    void run() {
+        if (!supportsDocLocking()) {
+            return;
+        }
+
+        AutoGetCollectionForRead ctx(&_txn, ns());
+        Collection* coll = ctx.getCollection();
+
+        WorkingSet ws;
+        ParallelCollectionScan scan(&_txn, coll, 2, true, &ws, nullptr);
+        vector<int> results;
+        while (!scan.isEOF()) {
+            vector<WorkingSetID> ids;
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan.workBatch(100, &ids, &id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_LESS_THAN_OR_EQUALS(ids.size(), 100U);
+            for (auto&& result : ids) {
+                results.push_back(ws.get(result)->obj.value()["foo"].numberInt());
+                ws.free(result);
+            }
+        }
+        ASSERT(serialScan(coll, nullptr) == results);
+    }
+};
+
+class All : public Suite {
+public:
+    All() : Suite("QueryStageParallelCollectionScan") {}
+
+    void setupTests() {
+        add<QueryStageParallelCollscanOrdered>();
+        add<QueryStageParallelCollscanUnorderedWithYields>();
+        add<QueryStageParallelCollscanWorkBatch>();
+    }
+};
+
+SuiteInstance<All> all;
+}
@@ -0,0 +1,94 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/rpc/legacy_reply_batch_builder.h"
+
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace rpc {
+
+namespace {
+
+// Size of each buffer which small documents are copied into.
+const int kChunkSize = 64 * 1024;
+
+}  // namespace
+
+LegacyReplyBatchBuilder::LegacyReplyBatchBuilder() : _chunk(new BufBuilder(kChunkSize)) {
+    _chunk->skip(sizeof(QueryResult::Value));
+}
+
+void LegacyReplyBatchBuilder::append(const BSONObj& doc) {
+    invariant(_chunk);
+
+    if (doc.isOwned() && doc.objsize() >= kMinPinnedDocumentSize) {
+        _flushChunk();
+        _message.appendPinned(doc.sharedBuffer(), doc.objdata(), doc.objsize());
+        _flushedLen += doc.objsize();
+    } else {
+        _chunk->appendBuf(doc.objdata(), doc.objsize());
+        if (_chunk->len() >= kChunkSize) {
+            _flushChunk();
+        }
+    }
+    _numDocs++;
+}
+
+void LegacyReplyBatchBuilder::_flushChunk() {
+    if (_chunk->len() == 0) {
+        return;
+    }
+    _flushedLen += _chunk->len();
+    _message.appendData(_chunk->buf(), _chunk->len());
+    _chunk->decouple();
+    _chunk.reset(new BufBuilder(kChunkSize));
+}
+
+Message LegacyReplyBatchBuilder::done(int resultFlags, long long cursorId, int startingFrom) {
+    invariant(_chunk);
+    _flushChunk();
+    _chunk.reset();
+
+    QueryResult::View qr = _message.header().view2ptr();
+    qr.msgdata().setOperation(opReply);
+    qr.setResultFlags(resultFlags);
+    qr.setCursorId(cursorId);
+    qr.setStartingFrom(startingFrom);
+    qr.setNReturned(_numDocs);
+    invariant(qr.msgdata().getLen() == _flushedLen);
+
+    return std::move(_message);
+}
+
+}  // namespace rpc
+}  // namespace mongo
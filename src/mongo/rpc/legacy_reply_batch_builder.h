@@ -0,0 +1,103 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/util/builder.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+class BSONObj;
+
+namespace rpc {
+
+/**
+ * Builds an OP_REPLY message carrying a batch of documents, as returned by legacy find and getMore.
+ *
+ * Instead of copying every document into one contiguous buffer, the reply is assembled as a list
+ * of segments which are written to the socket with a single scatter/gather send. Large documents
+ * which own their buffer (e.g. records fetched from the storage engine) are referenced in place
+ * and kept alive by the message. Small or unowned documents are copied into the current chunk,
+ * which is handed over to the message once it fills up to 64KB. The first chunk also holds the
+ * reply header.
+ */
+class LegacyReplyBatchBuilder {
+    MONGO_DISALLOW_COPYING(LegacyReplyBatchBuilder);
+
+public:
+    /**
+     * Owned documents at least this large are referenced rather than copied. Below this size the
+     * copy is cheaper than the extra iovec entry and reference count.
+     */
+    static const int kMinPinnedDocumentSize = 4 * 1024;
+
+    LegacyReplyBatchBuilder();
+
+    /**
+     * Adds 'doc' to the batch.
+     */
+    void append(const BSONObj& doc);
+
+    /**
+     * Number of documents appended so far.
+     */
+    int numDocs() const {
+        return _numDocs;
+    }
+
+    /**
+     * Size in bytes of the reply built so far, including the header.
+     */
+    int len() const {
+        return _flushedLen + _chunk->len();
+    }
+
+    /**
+     * Fills out the reply header and transfers ownership of the message to the caller. No further
+     * methods may be called afterwards.
+     */
+    Message done(int resultFlags, long long cursorId, int startingFrom);
+
+private:
+    // Moves the current chunk into the message and starts a new one.
+    void _flushChunk();
+
+    Message _message;
+    std::unique_ptr<BufBuilder> _chunk;
+
+    // Bytes already handed over to _message.
+    int _flushedLen = 0;
+    int _numDocs = 0;
+};
+
+}  // namespace rpc
+}  // namespace mongo
@@ -0,0 +1,194 @@
+/**
+ *    Copyright (C) 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/rpc/legacy_reply_batch_builder.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+using namespace mongo;
+
+BSONObj makeDoc(int i, size_t paddingBytes) {
+    return BSON("_id" << i << "padding" << std::string(paddingBytes, 'x'));
+}
+
+/**
+ * Concatenates the reply and returns the documents it carries.
+ */
+std::vector<BSONObj> readDocs(Message& reply) {
+    reply.concat();
+    QueryResult::View qr = reply.singleData().view2ptr();
+
+    std::vector<BSONObj> docs;
+    const char* data = qr.data();
+    const char* end = qr.view2ptr() + qr.msgdata().getLen();
+    while (data < end) {
+        BSONObj doc(data);
+        docs.push_back(doc.getOwned());
+        data += doc.objsize();
+    }
+    ASSERT(data == end);
+    return docs;
+}
+
+TEST(LegacyReplyBatchBuilder, EmptyBatch) {
+    rpc::LegacyReplyBatchBuilder batch;
+    ASSERT_EQUALS(0, batch.numDocs());
+    ASSERT_EQUALS(static_cast<int>(sizeof(QueryResult::Value)), batch.len());
+
+    Message reply = batch.done(ResultFlag_AwaitCapable, 0, 0);
+    ASSERT_EQUALS(1U, reply.numSegments());
+    ASSERT_EQUALS(opReply, reply.operation());
+
+    QueryResult::View qr = reply.header().view2ptr();
+    ASSERT_EQUALS(0, qr.getNReturned());
+    ASSERT_EQUALS(0, qr.getCursorId());
+    ASSERT_EQUALS(static_cast<int>(sizeof(QueryResult::Value)), qr.msgdata().getLen());
+}
+
+TEST(LegacyReplyBatchBuilder, SmallDocumentsAreCopiedIntoOneSegment) {
+    rpc::LegacyReplyBatchBuilder batch;
+    std::vector<BSONObj> input;
+    for (int i = 0; i < 10; i++) {
+        input.push_back(makeDoc(i, 10));
+        batch.append(input.back());
+    }
+
+    Message reply = batch.done(ResultFlag_AwaitCapable, 42, 5);
+    ASSERT_EQUALS(1U, reply.numSegments());
+
+    QueryResult::View qr = reply.header().view2ptr();
+    ASSERT_EQUALS(10, qr.getNReturned());
+    ASSERT_EQUALS(42, qr.getCursorId());
+    ASSERT_EQUALS(5, qr.getStartingFrom());
+
+    std::vector<BSONObj> output = readDocs(reply);
+    ASSERT_EQUALS(input.size(), output.size());
+    for (size_t i = 0; i < input.size(); i++) {
+        ASSERT_EQUALS(input[i], output[i]);
+    }
+}
+
+TEST(LegacyReplyBatchBuilder, SmallDocumentsAreSplitIntoChunks) {
+    rpc::LegacyReplyBatchBuilder batch;
+    std::vector<BSONObj> input;
+    int expectedLen = sizeof(QueryResult::Value);
+    for (int i = 0; expectedLen < 200 * 1024; i++) {
+        input.push_back(makeDoc(i, 1000));
+        batch.append(input.back());
+        expectedLen += input.back().objsize();
+    }
+    ASSERT_EQUALS(expectedLen, batch.len());
+
+    Message reply = batch.done(ResultFlag_AwaitCapable, 0, 0);
+
+    // Each 64KB chunk becomes a segment of its own.
+    ASSERT_EQUALS(4U, reply.numSegments());
+    ASSERT_EQUALS(expectedLen, reply.size());
+
+    QueryResult::View qr = reply.header().view2ptr();
+    ASSERT_EQUALS(static_cast<int>(input.size()), qr.getNReturned());
+
+    std::vector<BSONObj> output = readDocs(reply);
+    ASSERT_EQUALS(input.size(), output.size());
+    for (size_t i = 0; i < input.size(); i++) {
+        ASSERT_EQUALS(input[i], output[i]);
+    }
+}
+
+TEST(LegacyReplyBatchBuilder, LargeOwnedDocumentsArePinned) {
+    const size_t kLarge = rpc::LegacyReplyBatchBuilder::kMinPinnedDocumentSize;
+
+    rpc::LegacyReplyBatchBuilder batch;
+    std::vector<BSONObj> input{makeDoc(0, 10), makeDoc(1, kLarge), makeDoc(2, kLarge),
+                               makeDoc(3, 10)};
+    int expectedLen = sizeof(QueryResult::Value);
+    for (auto&& doc : input) {
+        ASSERT(doc.isOwned());
+        batch.append(doc);
+        expectedLen += doc.objsize();
+    }
+    ASSERT_EQUALS(expectedLen, batch.len());
+
+    Message reply = batch.done(ResultFlag_AwaitCapable, 0, 0);
+
+    // Header with the first document, each pinned document, then the trailing small document.
+    ASSERT_EQUALS(4U, reply.numSegments());
+    ASSERT_EQUALS(expectedLen, reply.size());
+    ASSERT_EQUALS(expectedLen, reply.header().getLen());
+
+    std::vector<BSONObj> output = readDocs(reply);
+    ASSERT_EQUALS(input.size(), output.size());
+    for (size_t i = 0; i < input.size(); i++) {
+        ASSERT_EQUALS(input[i], output[i]);
+    }
+}
+
+TEST(LegacyReplyBatchBuilder, PinnedDocumentsOutliveTheirSource) {
+    const size_t kLarge = rpc::LegacyReplyBatchBuilder::kMinPinnedDocumentSize;
+
+    rpc::LegacyReplyBatchBuilder batch;
+    BSONObj expected = makeDoc(7, kLarge).copy();
+    {
+        BSONObj doc = makeDoc(7, kLarge);
+        batch.append(doc);
+    }
+
+    Message reply = batch.done(ResultFlag_AwaitCapable, 0, 0);
+    ASSERT_EQUALS(2U, reply.numSegments());
+
+    std::vector<BSONObj> output = readDocs(reply);
+    ASSERT_EQUALS(1U, output.size());
+    ASSERT_EQUALS(expected, output[0]);
+}
+
+TEST(LegacyReplyBatchBuilder, UnownedDocumentsAreCopied) {
+    const size_t kLarge = rpc::LegacyReplyBatchBuilder::kMinPinnedDocumentSize;
+
+    rpc::LegacyReplyBatchBuilder batch;
+    BSONObj owner = BSON("sub" << makeDoc(0, kLarge));
+    BSONObj unowned = owner["sub"].Obj();
+    ASSERT_FALSE(unowned.isOwned());
+    batch.append(unowned);
+
+    Message reply = batch.done(ResultFlag_AwaitCapable, 0, 0);
+    ASSERT_EQUALS(1U, reply.numSegments());
+
+    std::vector<BSONObj> output = readDocs(reply);
+    ASSERT_EQUALS(1U, output.size());
+    ASSERT_EQUALS(unowned, output[0]);
+}
+
+}  // namespace
@@ -0,0 +1,290 @@
+/*    Copyright 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/fair_ticket_holder.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+const char FairTicketHolder::kInternalTenant[] = "_internal";
+const size_t FairTicketHolder::kMaxTenants;
+const double FairTicketHolder::kLatencyTolerance = 2.0;
+
+namespace {
+
+// An increase which lowers the throughput by more than this fraction is undone.
+const double kThroughputDropTolerance = 0.1;
+
+// Fraction of the tickets taken away when the latency exceeds the tolerance.
+const int kDecreaseDivisor = 10;
+
+// The baseline latency follows increases by 1/kBaselineDecay of the difference per interval, so
+// that it eventually catches up with a workload that has become inherently slower.
+const long long kBaselineDecay = 64;
+
+}  // namespace
+
+FairTicketHolder::FairTicketHolder(TickSource* tickSource,
+                                   int minTickets,
+                                   int maxTickets,
+                                   Milliseconds adjustInterval)
+    : _tickSource(tickSource),
+      _minTickets(minTickets),
+      _adjustIntervalTicks(adjustInterval.count() * tickSource->getTicksPerSecond() / 1000),
+      _maxTickets(maxTickets),
+      _capacity(maxTickets),
+      _intervalStart(tickSource->getTicks()) {
+    invariant(_minTickets > 0);
+    invariant(_maxTickets >= _minTickets);
+}
+
+FairTicketHolder::Ticket FairTicketHolder::waitForTicket(StringData tenantName) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    Tenant* const tenant = _getTenant_inlock(tenantName);
+
+    Ticket ticket;
+    ticket._tenant = tenant;
+
+    if (_waiters.empty() && _used < _capacity) {
+        _used++;
+        tenant->out++;
+        tenant->totalAdmitted++;
+        ticket._grantedAt = _tickSource->getTicks();
+        return ticket;
+    }
+
+    Waiter waiter;
+    waiter.tenant = tenant;
+    waiter.startTag = std::max(_virtualTime, tenant->lastFinishTag);
+    waiter.queuedAt = _tickSource->getTicks();
+    tenant->lastFinishTag = waiter.startTag + 1.0 / tenant->weight;
+    tenant->queued++;
+
+    const WaiterKey key(tenant->lastFinishTag, _nextSequence++);
+    _waiters[key] = &waiter;
+
+    waiter.cv.wait(lk, [&waiter] { return waiter.granted; });
+
+    // The granting thread has already moved the ticket over to the tenant.
+    ticket._grantedAt = _tickSource->getTicks();
+    return ticket;
+}
+
+void FairTicketHolder::release(Ticket* ticket) {
+    invariant(ticket->isValid());
+    const TickSource::Tick now = _tickSource->getTicks();
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    Tenant* const tenant = ticket->_tenant;
+    invariant(tenant->out > 0);
+    tenant->out--;
+    _used--;
+
+    _recordLatency_inlock(now, now - ticket->_grantedAt);
+    _grantWaiters_inlock(now);
+
+    ticket->_tenant = nullptr;
+}
+
+Status FairTicketHolder::setMaxTickets(int maxTickets) {
+    if (maxTickets < _minTickets) {
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "the maximum number of tickets has to be at least "
+                                    << _minTickets);
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _maxTickets = maxTickets;
+    _capacity = std::min(_capacity, _maxTickets);
+    return Status::OK();
+}
+
+Status FairTicketHolder::setWeights(const std::map<std::string, int>& weights) {
+    for (auto&& weight : weights) {
+        if (weight.second <= 0) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "weight for tenant '" << weight.first
+                                        << "' has to be > 0");
+        }
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _weights = weights;
+    for (auto&& tenant : _tenants) {
+        auto it = _weights.find(tenant.first);
+        tenant.second->weight = it == _weights.end() ? 1 : it->second;
+    }
+    return Status::OK();
+}
+
+int FairTicketHolder::used() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _used;
+}
+
+int FairTicketHolder::outof() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _capacity;
+}
+
+int FairTicketHolder::queued() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _waiters.size();
+}
+
+void FairTicketHolder::appendStats(BSONObjBuilder* b) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    b->append("out", _used);
+    b->append("queued", static_cast<int>(_waiters.size()));
+    b->append("totalTickets", _capacity);
+    b->append("minTickets", _minTickets);
+    b->append("maxTickets", _maxTickets);
+    b->append("latencyMicros", _lastLatencyMicros);
+    b->append("baselineLatencyMicros", _baselineLatencyMicros);
+    b->append("throughputPerSec", _lastThroughput);
+    b->append("totalIncreases", _totalIncreases);
+    b->append("totalDecreases", _totalDecreases);
+
+    BSONObjBuilder tenantsBuilder(b->subobjStart("tenants"));
+    for (auto&& entry : _tenants) {
+        const Tenant& tenant = *entry.second;
+        BSONObjBuilder tenantBuilder(tenantsBuilder.subobjStart(entry.first));
+        tenantBuilder.append("weight", tenant.weight);
+        tenantBuilder.append("out", tenant.out);
+        tenantBuilder.append("queued", tenant.queued);
+        tenantBuilder.append("totalAdmitted", tenant.totalAdmitted);
+        tenantBuilder.append("totalQueued", tenant.totalQueued);
+        tenantBuilder.append("totalQueuedMicros", tenant.totalQueuedMicros);
+        tenantBuilder.doneFast();
+    }
+    tenantsBuilder.doneFast();
+}
+
+FairTicketHolder::Tenant* FairTicketHolder::_getTenant_inlock(StringData name) {
+    if (name.empty())
+        name = kInternalTenant;
+
+    auto it = _tenants.find(name.toString());
+    if (it != _tenants.end())
+        return it->second.get();
+
+    if (_tenants.size() >= kMaxTenants) {
+        for (auto idle = _tenants.begin(); idle != _tenants.end();) {
+            if (idle->second->out == 0 && idle->second->queued == 0) {
+                idle = _tenants.erase(idle);
+            } else {
+                ++idle;
+            }
+        }
+    }
+
+    auto weight = _weights.find(name.toString());
+    auto& tenant = _tenants[name.toString()];
+    tenant.reset(new Tenant(weight == _weights.end() ? 1 : weight->second));
+    return tenant.get();
+}
+
+void FairTicketHolder::_grantWaiters_inlock(TickSource::Tick now) {
+    while (_used < _capacity && !_waiters.empty()) {
+        auto it = _waiters.begin();
+        Waiter* const waiter = it->second;
+        _waiters.erase(it);
+
+        _virtualTime = waiter->startTag;
+
+        Tenant* const tenant = waiter->tenant;
+        tenant->queued--;
+        tenant->out++;
+        tenant->totalAdmitted++;
+        tenant->totalQueued++;
+        tenant->totalQueuedMicros += _ticksToMicros(now - waiter->queuedAt);
+        _used++;
+
+        waiter->granted = true;
+        waiter->cv.notify_one();
+    }
+}
+
+void FairTicketHolder::_recordLatency_inlock(TickSource::Tick now, TickSource::Tick heldTicks) {
+    _intervalCompleted++;
+    _intervalHeldTicks += heldTicks;
+
+    const TickSource::Tick elapsed = now - _intervalStart;
+    if (elapsed < _adjustIntervalTicks)
+        return;
+
+    const long long latency = _ticksToMicros(_intervalHeldTicks) / _intervalCompleted;
+    const double throughput =
+        static_cast<double>(_intervalCompleted) * _tickSource->getTicksPerSecond() / elapsed;
+
+    if (_baselineLatencyMicros == 0 || latency < _baselineLatencyMicros) {
+        _baselineLatencyMicros = latency;
+    } else {
+        _baselineLatencyMicros += (latency - _baselineLatencyMicros) / kBaselineDecay;
+    }
+
+    // Only a saturated holder tells anything about the right number of tickets. Without queuing
+    // a lower throughput just means fewer requests arrived.
+    const bool saturated = !_waiters.empty();
+    const bool latencyTooHigh = latency > _baselineLatencyMicros * kLatencyTolerance;
+    const bool increaseBackfired = saturated && _lastAdjustmentWasIncrease &&
+        throughput < _lastThroughput * (1 - kThroughputDropTolerance);
+
+    _lastAdjustmentWasIncrease = false;
+    if (latencyTooHigh || increaseBackfired) {
+        const int decrease = latencyTooHigh ? std::max(1, _capacity / kDecreaseDivisor) : 1;
+        const int capacity = std::max(_minTickets, _capacity - decrease);
+        if (capacity < _capacity) {
+            _capacity = capacity;
+            _totalDecreases++;
+        }
+    } else if (saturated && _capacity < _maxTickets) {
+        _capacity++;
+        _totalIncreases++;
+        _lastAdjustmentWasIncrease = true;
+    }
+
+    _lastLatencyMicros = latency;
+    _lastThroughput = throughput;
+    _intervalStart = now;
+    _intervalCompleted = 0;
+    _intervalHeldTicks = 0;
+}
+
+long long FairTicketHolder::_ticksToMicros(TickSource::Tick ticks) const {
+    return static_cast<long long>(static_cast<double>(ticks) * 1000 * 1000 /
+                                  _tickSource->getTicksPerSecond());
+}
+
+}  // namespace mongo
@@ -0,0 +1,212 @@
+/*    Copyright 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/base/string_data.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/tick_source.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * Ticket based admission control which shares the tickets fairly between tenants.
+ *
+ * Every caller names the tenant it is acting for (a database, or the VIP a connection came in
+ * through). While tickets are available they are handed out first come, first served. Once they
+ * run out, callers queue and freed tickets go to waiters in start-time fair queuing order: each
+ * tenant is entitled to a share of the tickets proportional to its weight, so a single tenant
+ * issuing a flood of operations cannot starve the others.
+ *
+ * The number of tickets adapts to the observed latency, measured as the time a ticket is held.
+ * The holder keeps a baseline of the lowest recent latency. While callers are queuing and the
+ * latency stays within kLatencyTolerance of the baseline, one ticket is added per adjustment
+ * interval. When the latency exceeds it, or an increase made the throughput drop, tickets are
+ * taken away again. The count always stays within [minTickets, maxTickets].
+ */
+class FairTicketHolder {
+    MONGO_DISALLOW_COPYING(FairTicketHolder);
+
+    struct Tenant;
+
+public:
+    /**
+     * Tenant name used for callers which do not specify one, such as internal operations.
+     */
+    static const char kInternalTenant[];
+
+    /**
+     * Maximum number of tenants to track. Idle tenants are forgotten beyond this.
+     */
+    static const size_t kMaxTenants = 1024;
+
+    /**
+     * The latency may grow up to this factor over the baseline before tickets are taken away.
+     */
+    static const double kLatencyTolerance;
+
+    /**
+     * A granted ticket. Must be passed back to release().
+     */
+    class Ticket {
+    public:
+        bool isValid() const {
+            return _tenant != nullptr;
+        }
+
+    private:
+        friend class FairTicketHolder;
+
+        Tenant* _tenant = nullptr;
+        TickSource::Tick _grantedAt = 0;
+    };
+
+    /**
+     * 'tickSource' is not owned and must outlive the holder. The holder starts out with
+     * 'maxTickets' tickets.
+     */
+    FairTicketHolder(TickSource* tickSource,
+                     int minTickets,
+                     int maxTickets,
+                     Milliseconds adjustInterval = Milliseconds(100));
+
+    /**
+     * Blocks until a ticket is granted to 'tenant'. An empty name means kInternalTenant.
+     */
+    Ticket waitForTicket(StringData tenant);
+
+    /**
+     * Returns 'ticket' to the holder and invalidates it.
+     */
+    void release(Ticket* ticket);
+
+    /**
+     * Changes the upper bound on the number of tickets, which must be at least minTickets.
+     */
+    Status setMaxTickets(int maxTickets);
+
+    /**
+     * Replaces the weights of all tenants. Tenants not present in 'weights' get weight 1. Every
+     * weight must be positive.
+     */
+    Status setWeights(const std::map<std::string, int>& weights);
+
+    int used() const;
+
+    int outof() const;
+
+    int queued() const;
+
+    /**
+     * Appends the ticket counts, the adaptation state and per tenant queue statistics.
+     */
+    void appendStats(BSONObjBuilder* b) const;
+
+private:
+    struct Tenant {
+        explicit Tenant(int weight) : weight(weight) {}
+
+        int weight;
+
+        // Finish tag of the last request queued by this tenant.
+        double lastFinishTag = 0;
+
+        int out = 0;
+        int queued = 0;
+
+        long long totalAdmitted = 0;
+        long long totalQueued = 0;
+        long long totalQueuedMicros = 0;
+    };
+
+    struct Waiter {
+        Tenant* tenant;
+        double startTag;
+        TickSource::Tick queuedAt;
+        bool granted = false;
+        stdx::condition_variable cv;
+    };
+
+    // Waiters are served in order of their finish tag. The sequence number keeps requests with
+    // equal tags in arrival order.
+    using WaiterKey = std::pair<double, unsigned long long>;
+
+    Tenant* _getTenant_inlock(StringData name);
+
+    // Hands out tickets to waiters for as long as there are free tickets.
+    void _grantWaiters_inlock(TickSource::Tick now);
+
+    // Accounts for a ticket held for 'heldTicks' and adapts the ticket count when an interval
+    // has elapsed.
+    void _recordLatency_inlock(TickSource::Tick now, TickSource::Tick heldTicks);
+
+    long long _ticksToMicros(TickSource::Tick ticks) const;
+
+    TickSource* const _tickSource;
+    const int _minTickets;
+    const TickSource::Tick _adjustIntervalTicks;
+
+    mutable stdx::mutex _mutex;
+
+    int _maxTickets;
+    int _capacity;
+    int _used = 0;
+
+    // System virtual time: the start tag of the most recently granted queued request.
+    double _virtualTime = 0;
+    unsigned long long _nextSequence = 0;
+
+    std::map<WaiterKey, Waiter*> _waiters;
+    std::map<std::string, std::unique_ptr<Tenant>> _tenants;
+    std::map<std::string, int> _weights;
+
+    // Measurements for the current adjustment interval.
+    TickSource::Tick _intervalStart;
+    long long _intervalCompleted = 0;
+    TickSource::Tick _intervalHeldTicks = 0;
+
+    // State carried between adjustment intervals.
+    long long _lastLatencyMicros = 0;
+    long long _baselineLatencyMicros = 0;
+    double _lastThroughput = 0;
+    bool _lastAdjustmentWasIncrease = false;
+    long long _totalIncreases = 0;
+    long long _totalDecreases = 0;
+};
+
+}  // namespace mongo
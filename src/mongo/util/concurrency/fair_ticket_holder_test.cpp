@@ -0,0 +1,196 @@
+/*    Copyright 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/fair_ticket_holder.h"
+#include "mongo/util/tick_source_mock.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+void waitForQueued(const FairTicketHolder& holder, int expected) {
+    while (holder.queued() < expected) {
+        sleepmillis(1);
+    }
+}
+
+/**
+ * Queues one waiter per entry of 'tenants' behind a single held ticket, then releases it and
+ * returns the order in which the waiters were granted their tickets, separated by commas.
+ */
+std::string grantOrder(FairTicketHolder* holder, const std::vector<std::string>& tenants) {
+    stdx::mutex mutex;
+    std::string order;
+
+    FairTicketHolder::Ticket blocker = holder->waitForTicket("blocker");
+
+    std::vector<stdx::thread> threads;
+    for (size_t i = 0; i < tenants.size(); i++) {
+        const std::string tenant = tenants[i];
+        threads.emplace_back([holder, tenant, &mutex, &order] {
+            FairTicketHolder::Ticket ticket = holder->waitForTicket(tenant);
+            {
+                stdx::lock_guard<stdx::mutex> lk(mutex);
+                order += order.empty() ? tenant : "," + tenant;
+            }
+            holder->release(&ticket);
+        });
+        waitForQueued(*holder, i + 1);
+    }
+
+    holder->release(&blocker);
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+    return order;
+}
+
+TEST(FairTicketHolderTest, GrantsWithoutQueuingWhileTicketsAreAvailable) {
+    TickSourceMock tickSource;
+    FairTicketHolder holder(&tickSource, 1, 2);
+
+    FairTicketHolder::Ticket first = holder.waitForTicket("a");
+    FairTicketHolder::Ticket second = holder.waitForTicket("b");
+    ASSERT_TRUE(first.isValid());
+    ASSERT_TRUE(second.isValid());
+    ASSERT_EQUALS(2, holder.used());
+    ASSERT_EQUALS(0, holder.queued());
+
+    holder.release(&first);
+    holder.release(&second);
+    ASSERT_FALSE(first.isValid());
+    ASSERT_EQUALS(0, holder.used());
+}
+
+TEST(FairTicketHolderTest, InterleavesTenantsWithEqualWeights) {
+    TickSourceMock tickSource;
+    FairTicketHolder holder(&tickSource, 1, 1);
+
+    ASSERT_EQUALS("noisy,quiet,noisy,noisy",
+                  grantOrder(&holder, {"noisy", "noisy", "noisy", "quiet"}));
+}
+
+TEST(FairTicketHolderTest, SharesTicketsInProportionToWeights) {
+    TickSourceMock tickSource;
+    FairTicketHolder holder(&tickSource, 1, 1);
+    ASSERT_OK(holder.setWeights({{"heavy", 3}}));
+
+    ASSERT_EQUALS("heavy,heavy,heavy,light,heavy,light",
+                  grantOrder(&holder, {"heavy", "heavy", "heavy", "heavy", "light", "light"}));
+}
+
+TEST(FairTicketHolderTest, ShrinksWhenLatencyRises) {
+    TickSourceMock tickSource;
+    FairTicketHolder holder(&tickSource, 1, 4);
+
+    FairTicketHolder::Ticket ticket = holder.waitForTicket("a");
+    tickSource.advance(Milliseconds(100));
+    holder.release(&ticket);
+    ASSERT_EQUALS(4, holder.outof());
+
+    ticket = holder.waitForTicket("a");
+    tickSource.advance(Milliseconds(300));
+    holder.release(&ticket);
+    ASSERT_EQUALS(3, holder.outof());
+}
+
+TEST(FairTicketHolderTest, GrowsWhileSaturatedAndLatencyIsStable) {
+    TickSourceMock tickSource;
+    FairTicketHolder holder(&tickSource, 1, 2);
+
+    // Establish the baseline and then get the holder down to a single ticket.
+    FairTicketHolder::Ticket ticket = holder.waitForTicket("a");
+    tickSource.advance(Milliseconds(100));
+    holder.release(&ticket);
+    ticket = holder.waitForTicket("a");
+    tickSource.advance(Milliseconds(300));
+    holder.release(&ticket);
+    ASSERT_EQUALS(1, holder.outof());
+
+    ticket = holder.waitForTicket("a");
+    stdx::thread waiter([&holder] {
+        FairTicketHolder::Ticket queued = holder.waitForTicket("b");
+        holder.release(&queued);
+    });
+    waitForQueued(holder, 1);
+
+    tickSource.advance(Milliseconds(100));
+    holder.release(&ticket);
+    waiter.join();
+    ASSERT_EQUALS(2, holder.outof());
+}
+
+TEST(FairTicketHolderTest, ReportsPerTenantStatistics) {
+    TickSourceMock tickSource;
+    FairTicketHolder holder(&tickSource, 1, 1);
+    grantOrder(&holder, {"db1", "db2"});
+
+    BSONObjBuilder b;
+    holder.appendStats(&b);
+    BSONObj stats = b.obj();
+    ASSERT_EQUALS(0, stats["out"].numberInt());
+    ASSERT_EQUALS(1, stats["totalTickets"].numberInt());
+
+    BSONObj db1 = stats["tenants"]["db1"].Obj();
+    ASSERT_EQUALS(1, db1["totalAdmitted"].numberLong());
+    ASSERT_EQUALS(1, db1["totalQueued"].numberLong());
+    ASSERT_EQUALS(0, db1["queued"].numberInt());
+    ASSERT_EQUALS(1, stats["tenants"]["blocker"]["totalAdmitted"].numberLong());
+}
+
+TEST(FairTicketHolderTest, EmptyTenantIsInternal) {
+    TickSourceMock tickSource;
+    FairTicketHolder holder(&tickSource, 1, 1);
+    FairTicketHolder::Ticket ticket = holder.waitForTicket("");
+    holder.release(&ticket);
+
+    BSONObjBuilder b;
+    holder.appendStats(&b);
+    ASSERT_TRUE(b.obj()["tenants"].Obj().hasField(FairTicketHolder::kInternalTenant));
+}
+
+TEST(FairTicketHolderTest, RejectsInvalidSettings) {
+    TickSourceMock tickSource;
+    FairTicketHolder holder(&tickSource, 2, 4);
+    ASSERT_NOT_OK(holder.setMaxTickets(1));
+    ASSERT_NOT_OK(holder.setWeights({{"a", 0}}));
+
+    ASSERT_OK(holder.setMaxTickets(3));
+    ASSERT_EQUALS(3, holder.outof());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -63,6 +63,10 @@ public:
         LeaveCriticalSection(&_cs);
     }
 
+    bool try_lock() {
+        return TryEnterCriticalSection(&_cs);
+    }
+
 private:
     CRITICAL_SECTION _cs;
 };
@@ -85,6 +89,10 @@ public:
         _lockSlowPath();
     }
 
+    bool try_lock() {
+        return _tryLock();
+    }
+
 private:
     bool _tryLock() {
         bool wasLocked = _locked.test_and_set(std::memory_order_acquire);
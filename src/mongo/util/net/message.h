@@ -42,6 +42,7 @@
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/net/sock.h"
 #include "mongo/util/print.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 
@@ -411,7 +412,8 @@ public:
 
     Message(void* data, bool freeIt) : _buf(reinterpret_cast<char*>(data)), _freeIt(freeIt) {}
 
-    Message(Message&& r) : _buf(r._buf), _data(std::move(r._data)), _freeIt(r._freeIt) {
+    Message(Message&& r)
+        : _buf(r._buf), _data(std::move(r._data)), _pins(std::move(r._pins)), _freeIt(r._freeIt) {
         r._buf = nullptr;
         r._freeIt = false;
     }
@@ -493,6 +495,7 @@ public:
 
         _buf = r._buf;
         _data = std::move(r._data);
+        _pins = std::move(r._pins);
         _freeIt = r._freeIt;
 
         r._buf = nullptr;
@@ -505,14 +508,16 @@ public:
             if (_buf) {
                 std::free(_buf);
             }
-            for (std::vector<std::pair<char*, int>>::const_iterator i = _data.begin();
-                 i != _data.end();
-                 ++i) {
-                std::free(i->first);
+            for (size_t i = 0; i < _data.size(); ++i) {
+                // Pinned segments are released along with _pins below.
+                if (!_pins[i].get()) {
+                    std::free(_data[i].first);
+                }
             }
         }
         _buf = nullptr;
         _data.clear();
+        _pins.clear();
         _freeIt = false;
     }
 
@@ -528,15 +533,41 @@ public:
             _setData(md.view2ptr(), true);
             return;
         }
-        verify(_freeIt);
-        if (_buf) {
-            _data.push_back(std::make_pair(_buf, MsgData::ConstView(_buf).getLen()));
-            _buf = 0;
-        }
+        _splitBuf();
         _data.push_back(std::make_pair(d, size));
+        _pins.push_back(SharedBuffer());
+        header().setLen(header().getLen() + size);
+    }
+
+    /**
+     * Appends 'size' bytes at 'data' as a separate segment of the message without copying them.
+     * The segment is sent with the rest of the message through a single scatter/gather write.
+     *
+     * 'data' must point into the memory owned by 'pin', which is kept alive until the message is
+     * reset. The message must already contain its header.
+     */
+    void appendPinned(SharedBuffer pin, const char* data, int size) {
+        invariant(pin.get());
+        if (size <= 0) {
+            return;
+        }
+        verify(!empty());
+        _splitBuf();
+        _data.push_back(std::make_pair(const_cast<char*>(data), size));
+        _pins.push_back(std::move(pin));
         header().setLen(header().getLen() + size);
     }
 
+    /**
+     * Returns the number of buffers the message is made of.
+     */
+    size_t numSegments() const {
+        if (_buf) {
+            return 1;
+        }
+        return _data.size();
+    }
+
     // use to set first buffer if empty
     void setData(char* d, bool freeIt) {
         verify(empty());
@@ -572,12 +603,26 @@ private:
         _freeIt = freeIt;
         _buf = d;
     }
+
+    // Moves the single buffer in _buf, if any, to the front of _data so that more segments can be
+    // appended after it.
+    void _splitBuf() {
+        verify(_freeIt);
+        if (_buf) {
+            _data.push_back(std::make_pair(_buf, MsgData::ConstView(_buf).getLen()));
+            _pins.push_back(SharedBuffer());
+            _buf = 0;
+        }
+    }
     // if just one buffer, keep it in _buf, otherwise keep a sequence of buffers in _data
     char* _buf{nullptr};
     // byte buffer(s) - the first must contain at least a full MsgData unless using _buf for storage
     // instead
     typedef std::vector<std::pair<char*, int>> MsgVec;
     MsgVec _data{};
+    // Parallel to _data. A non-null entry keeps alive the memory of a segment appended through
+    // appendPinned(); such segments are not freed by reset().
+    std::vector<SharedBuffer> _pins{};
     bool _freeIt{false};
 };
 
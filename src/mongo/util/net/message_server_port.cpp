@@ -31,15 +31,18 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <memory>
 #include <system_error>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/config.h"
+#include "mongo/db/client.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/stdx/functional.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/concurrency/synchronization.h"
 #include "mongo/util/concurrency/thread_name.h"
@@ -53,8 +56,13 @@
 #include "mongo/util/net/message_port.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/scopeguard.h"
 
+#ifdef __linux__
+#include "mongo/util/net/service_executor_epoll.h"
+#endif
+
 #ifdef __linux__  // TODO: consider making this ifndef _WIN32
 #include <sys/resource.h>
 #endif
@@ -90,6 +98,117 @@ private:
     MessageHandler* const _handler;
 };
 
+/**
+ * Returns the connection ticket acquired in PortMessageServer::accepted().
+ */
+void releaseConnectionTicket(MessagingPortWithHandler* port) {
+    if (!port->isVipMode() || port->inAdminWhiteList()) {
+        Listener::internalTicketHolder.release();
+    } else {
+        Listener::globalTicketHolder.release();
+    }
+}
+
+void logEndConnection(MessagingPortWithHandler* port) {
+    if (!serverGlobalParams.quiet) {
+        int conns =
+            Listener::globalTicketHolder.used() + Listener::internalTicketHolder.used() - 1;
+        const char* word = (conns == 1 ? " connection" : " connections");
+        log() << "end connection " << port->psock->remoteString() << " (" << conns << word
+              << " now open)" << endl;
+    }
+}
+
+#ifdef __linux__
+/**
+ * A client connection serviced by the epoll service executor. Each readable event handles
+ * exactly one request; between requests the connection's Client is detached from the worker
+ * thread and parked here.
+ */
+class EpollSession : public ServiceExecutorEpoll::Session {
+    MONGO_DISALLOW_COPYING(EpollSession);
+
+public:
+    explicit EpollSession(std::unique_ptr<MessagingPortWithHandler> port)
+        : _port(std::move(port)) {}
+
+    int fd() const override {
+        return _port->psock->rawFD();
+    }
+
+    bool onReadable() override {
+        MessageHandler* const handler = _port->getHandler();
+
+        if (!_connected) {
+            _port->psock->setLogLevel(logger::LogSeverity::Debug(1));
+            handler->connected(_port.get());
+            _connected = true;
+        } else {
+            Client::setCurrent(std::move(_client));
+        }
+
+        ON_BLOCK_EXIT([this] {
+            if (haveClient())
+                _client = Client::releaseCurrent();
+        });
+
+        try {
+            if (inShutdown())
+                return false;
+
+            Message m;
+            _port->psock->clearCounters();
+
+            if (!_port->recv(m)) {
+                logEndConnection(_port.get());
+                return false;
+            }
+
+            handler->process(m, _port.get());
+            networkCounter.hit(_port->psock->getBytesIn(), _port->psock->getBytesOut());
+
+            // Occasionally we want to see if we're using too much memory.
+            if ((_requests++ & 0xf) == 0) {
+                markThreadIdle();
+            }
+            return true;
+        } catch (AssertionException& e) {
+            log() << "AssertionException handling request, closing client connection: " << e;
+        } catch (SocketException& e) {
+            log() << "SocketException handling request, closing client connection: " << e;
+        } catch (const DBException& e) {
+            log() << "DBException handling request, closing client connection: " << e;
+        } catch (std::exception& e) {
+            error() << "Uncaught std::exception: " << e.what() << ", terminating";
+            dbexit(EXIT_UNCAUGHT);
+        }
+        return false;
+    }
+
+    void onEnd() override {
+        if (_client) {
+            // The handler destroys the Client, which must be attached to this thread for that.
+            Client::setCurrent(std::move(_client));
+            _port->getHandler()->close();
+        }
+        _port->shutdown();
+        releaseConnectionTicket(_port.get());
+    }
+
+private:
+    const std::unique_ptr<MessagingPortWithHandler> _port;
+
+    // Whether the handler has been told about the connection. Happens on the first request, so
+    // that the Client is created on a worker thread.
+    bool _connected = false;
+
+    // The connection's Client while no request is being processed.
+    ServiceContext::UniqueClient _client;
+
+    int64_t _requests = 0;
+};
+#endif  // __linux__
+
 }  // namespace
 
 class PortMessageServer : public MessageServer, public Listener {
@@ -102,7 +221,27 @@ public:
      *     and should make sure that it lives longer than this server.
      */
     PortMessageServer(const MessageServer::Options& opts, MessageHandler* handler)
-        : Listener("", opts.ipList, opts.port), _handler(handler) {}
+        : Listener("", opts.ipList, opts.port), _handler(handler) {
+#ifdef __linux__
+        if (serverGlobalParams.serviceExecutor == "epoll") {
+#ifdef MONGO_CONFIG_SSL
+            if (getSSLManager()) {
+                // SSL buffers decrypted bytes in user space, so socket readiness does not tell
+                // whether a request is pending.
+                warning() << "the epoll service executor does not support SSL, "
+                          << "using a thread per connection instead";
+                return;
+            }
+#endif
+            size_t numThreads = serverGlobalParams.serviceExecutorThreads;
+            if (numThreads == 0) {
+                ProcessInfo p;
+                numThreads = 2 * std::max(1u, p.getNumCores());
+            }
+            _executor.reset(new ServiceExecutorEpoll(numThreads, &serviceExecutorCounter));
+        }
+#endif
+    }
 
     virtual void accepted(std::shared_ptr<Socket> psocket, long long connectionId) {
         ScopeGuard sleepAfterClosingPort = MakeGuard(sleepmillis, 2);
@@ -142,6 +281,21 @@ public:
             }
         }
 
+#ifdef __linux__
+        if (_executor) {
+            // The executor releases the ticket when it ends the session, including on failure.
+            Status status = _executor->add(stdx::make_unique<EpollSession>(
+                std::unique_ptr<MessagingPortWithHandler>(portWithHandler.release())));
+            if (!status.isOK()) {
+                log() << "failed to register new connection with the service executor, "
+                      << "closing connection: " << status;
+                return;
+            }
+            sleepAfterClosingPort.Dismiss();
+            return;
+        }
+#endif
+
         try {
 #ifndef __linux__  // TODO: consider making this ifdef _WIN32
             {
@@ -186,11 +340,7 @@ public:
             portWithHandler.release();
             sleepAfterClosingPort.Dismiss();
         } catch (...) {
-            if (!portWithHandler->isVipMode() || portWithHandler->inAdminWhiteList()) {
-                Listener::internalTicketHolder.release();
-            } else {
-                Listener::globalTicketHolder.release();
-            }
+            releaseConnectionTicket(portWithHandler.get());
             log() << "failed to create thread after accepting new connection, closing connection";
         }
     }
@@ -204,6 +354,17 @@ public:
     }
 
     void run() {
+#ifdef __linux__
+        if (_executor) {
+            Status status = _executor->start();
+            if (!status.isOK()) {
+                error() << "failed to start the epoll service executor: " << status;
+                return;
+            }
+            log() << "servicing connections with " << _executor->numWorkers()
+                  << " epoll service executor threads";
+        }
+#endif
         initAndListen();
     }
 
@@ -214,6 +375,11 @@ public:
 private:
     MessageHandler* _handler;
 
+#ifdef __linux__
+    // Set when connections are multiplexed over a worker pool instead of a thread each.
+    std::unique_ptr<ServiceExecutorEpoll> _executor;
+#endif
+
     /**
      * Handles incoming messages from a given socket.
      *
@@ -246,12 +412,7 @@ private:
                 portWithHandler->psock->clearCounters();
 
                 if (!portWithHandler->recv(m)) {
-                    if (!serverGlobalParams.quiet) {
-                        int conns = Listener::globalTicketHolder.used() + Listener::internalTicketHolder.used() - 1;
-                        const char* word = (conns == 1 ? " connection" : " connections");
-                        log() << "end connection " << portWithHandler->psock->remoteString() << " ("
-                              << conns << word << " now open)" << endl;
-                    }
+                    logEndConnection(portWithHandler.get());
                     break;
                 }
 
@@ -285,11 +446,7 @@ private:
             manager->cleanupThreadLocals();
 #endif
 
-        if (!portWithHandler->isVipMode() || portWithHandler->inAdminWhiteList()) {
-            Listener::internalTicketHolder.release();
-        } else {
-            Listener::globalTicketHolder.release();
-        }
+        releaseConnectionTicket(portWithHandler.get());
 
         return NULL;
     }
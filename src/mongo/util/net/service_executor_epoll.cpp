@@ -0,0 +1,251 @@
+/*    Copyright 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/service_executor_epoll.h"
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "mongo/db/stats/counters.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+namespace {
+
+const uint32_t kSessionEvents = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+const int kMaxEventsPerWait = 64;
+
+}  // namespace
+
+ServiceExecutorEpoll::ServiceExecutorEpoll(size_t numWorkers, ServiceExecutorCounter* counter)
+    : _numWorkers(numWorkers), _counter(counter) {
+    invariant(_numWorkers > 0);
+    invariant(_counter);
+}
+
+ServiceExecutorEpoll::~ServiceExecutorEpoll() {
+    shutdown();
+}
+
+Status ServiceExecutorEpoll::start() {
+    invariant(_epollFd == -1);
+
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epollFd < 0) {
+        return Status(ErrorCodes::InternalError,
+                      str::stream() << "epoll_create1 failed: " << errnoWithDescription());
+    }
+
+    _wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_wakeupFd < 0) {
+        return Status(ErrorCodes::InternalError,
+                      str::stream() << "eventfd failed: " << errnoWithDescription());
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeupFd, &ev) != 0) {
+        return Status(ErrorCodes::InternalError,
+                      str::stream() << "epoll_ctl failed: " << errnoWithDescription());
+    }
+
+    _poller = stdx::thread([this] { _pollerThread(); });
+    for (size_t i = 0; i < _numWorkers; i++) {
+        _workers.emplace_back([this, i] {
+            setThreadName(std::string(str::stream() << "serviceExecutor" << i));
+            _workerThread();
+        });
+    }
+
+    return Status::OK();
+}
+
+Status ServiceExecutorEpoll::add(std::unique_ptr<Session> session) {
+    Session* const raw = session.release();
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_inShutdown || _epollFd < 0) {
+            raw->onEnd();
+            delete raw;
+            return Status(ErrorCodes::ShutdownInProgress, "service executor is not running");
+        }
+        _sessions.insert(raw);
+    }
+    _counter->sessionAdded();
+
+    struct epoll_event ev;
+    ev.events = kSessionEvents;
+    ev.data.ptr = raw;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, raw->fd(), &ev) != 0) {
+        const std::string err = errnoWithDescription();
+        _end(raw);
+        return Status(ErrorCodes::InternalError, str::stream() << "epoll_ctl failed: " << err);
+    }
+
+    return Status::OK();
+}
+
+void ServiceExecutorEpoll::shutdown() {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_inShutdown)
+            return;
+        _inShutdown = true;
+    }
+    _readyCV.notify_all();
+
+    if (_wakeupFd >= 0) {
+        uint64_t one = 1;
+        if (write(_wakeupFd, &one, sizeof(one)) != sizeof(one)) {
+            warning() << "failed to wake up service executor poller: " << errnoWithDescription();
+        }
+    }
+
+    if (_poller.joinable())
+        _poller.join();
+    for (auto&& worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+
+    // No threads are left running, so every remaining session can be ended from here.
+    std::set<Session*> remaining;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _ready.clear();
+        remaining.swap(_sessions);
+    }
+    for (auto session : remaining) {
+        session->onEnd();
+        delete session;
+        _counter->sessionEnded();
+    }
+
+    if (_epollFd >= 0)
+        close(_epollFd);
+    if (_wakeupFd >= 0)
+        close(_wakeupFd);
+    _epollFd = -1;
+    _wakeupFd = -1;
+}
+
+void ServiceExecutorEpoll::_pollerThread() {
+    setThreadName("serviceExecutorPoller");
+
+    struct epoll_event events[kMaxEventsPerWait];
+    while (true) {
+        int n = epoll_wait(_epollFd, events, kMaxEventsPerWait, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            severe() << "epoll_wait failed: " << errnoWithDescription();
+            fassertFailed(40000);
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_inShutdown)
+            return;
+
+        const long long now = curTimeMicros64();
+        for (int i = 0; i < n; i++) {
+            Session* session = static_cast<Session*>(events[i].data.ptr);
+            if (!session)
+                continue;  // Spurious wakeup through the eventfd.
+            _ready.push_back(ReadySession{session, now});
+            _counter->enqueued();
+            _readyCV.notify_one();
+        }
+    }
+}
+
+void ServiceExecutorEpoll::_workerThread() {
+    while (true) {
+        ReadySession ready;
+        {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            _readyCV.wait(lk, [this] { return _inShutdown || !_ready.empty(); });
+            if (_inShutdown)
+                return;
+            ready = _ready.front();
+            _ready.pop_front();
+        }
+
+        _counter->started(curTimeMicros64() - ready.enqueuedMicros);
+
+        bool keepOpen = false;
+        try {
+            keepOpen = ready.session->onReadable();
+        } catch (const std::exception& e) {
+            error() << "Uncaught exception in service executor session, closing connection: "
+                    << e.what();
+        }
+
+        _counter->finished();
+        _rearmOrEnd(ready.session, keepOpen);
+    }
+}
+
+void ServiceExecutorEpoll::_rearmOrEnd(Session* session, bool keepOpen) {
+    if (keepOpen) {
+        struct epoll_event ev;
+        ev.events = kSessionEvents;
+        ev.data.ptr = session;
+        if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, session->fd(), &ev) == 0)
+            return;
+        warning() << "failed to re-arm connection with service executor, closing it: "
+                  << errnoWithDescription();
+    }
+
+    // Removal fails harmlessly if the session already closed its socket.
+    epoll_ctl(_epollFd, EPOLL_CTL_DEL, session->fd(), nullptr);
+    _end(session);
+}
+
+void ServiceExecutorEpoll::_end(Session* session) {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_sessions.erase(session) == 0)
+            return;  // Already ended by shutdown().
+    }
+    session->onEnd();
+    delete session;
+    _counter->sessionEnded();
+}
+
+}  // namespace mongo
@@ -0,0 +1,151 @@
+/*    Copyright 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+
+namespace mongo {
+
+class ServiceExecutorCounter;
+
+/**
+ * Multiplexes many client connections over a fixed pool of worker threads.
+ *
+ * A single poller thread waits on an epoll set containing the socket of every registered session.
+ * When a socket becomes readable the session is queued and the next free worker runs its
+ * onReadable() handler, which is expected to read and process exactly one request. Sockets are
+ * registered with EPOLLONESHOT, so a session is never handled by two workers at once; it is
+ * re-armed once its handler returns.
+ *
+ * Because a worker only picks up a session once bytes are pending, idle connections cost no
+ * thread. A handler is still allowed to block (e.g. to read the remainder of a partially received
+ * message, or to stream an exhaust cursor), which ties up one worker for that duration.
+ *
+ * Only available on Linux.
+ */
+class ServiceExecutorEpoll {
+    MONGO_DISALLOW_COPYING(ServiceExecutorEpoll);
+
+public:
+    /**
+     * A connection registered with the executor.
+     */
+    class Session {
+    public:
+        virtual ~Session() = default;
+
+        /**
+         * The socket to watch for readability.
+         */
+        virtual int fd() const = 0;
+
+        /**
+         * Called on a worker thread when the socket has data pending (or was closed by the peer).
+         * Returns false if the session should be ended.
+         */
+        virtual bool onReadable() = 0;
+
+        /**
+         * Called exactly once, on a worker thread or from shutdown(), when the session is being
+         * ended. The session object is destroyed right after this returns.
+         */
+        virtual void onEnd() = 0;
+    };
+
+    /**
+     * 'counter' is not owned and must outlive the executor.
+     */
+    ServiceExecutorEpoll(size_t numWorkers, ServiceExecutorCounter* counter);
+    ~ServiceExecutorEpoll();
+
+    /**
+     * Creates the epoll set and spawns the poller and worker threads.
+     */
+    Status start();
+
+    /**
+     * Registers a session. Ownership is transferred to the executor. If the session cannot be
+     * registered, its onEnd() is invoked immediately and an error is returned.
+     */
+    Status add(std::unique_ptr<Session> session);
+
+    /**
+     * Stops all threads and ends every session which is still registered. Safe to call more than
+     * once.
+     */
+    void shutdown();
+
+    size_t numWorkers() const {
+        return _numWorkers;
+    }
+
+private:
+    struct ReadySession {
+        Session* session;
+        long long enqueuedMicros;
+    };
+
+    void _pollerThread();
+    void _workerThread();
+
+    // Re-arms 'session' for the next readable event, or ends it if 'keepOpen' is false.
+    void _rearmOrEnd(Session* session, bool keepOpen);
+    void _end(Session* session);
+
+    const size_t _numWorkers;
+    ServiceExecutorCounter* const _counter;
+
+    int _epollFd = -1;
+
+    // Written to by shutdown() to wake the poller out of epoll_wait.
+    int _wakeupFd = -1;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _readyCV;
+    bool _inShutdown = false;
+
+    // Sessions whose sockets are readable, waiting for a worker. Guarded by _mutex.
+    std::deque<ReadySession> _ready;
+
+    // Every session currently owned by the executor. Guarded by _mutex.
+    std::set<Session*> _sessions;
+
+    stdx::thread _poller;
+    std::vector<stdx::thread> _workers;
+};
+
+}  // namespace mongo
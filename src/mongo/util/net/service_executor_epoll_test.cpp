@@ -0,0 +1,176 @@
+/*    Copyright 2016 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "mongo/db/stats/counters.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/service_executor_epoll.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Shared between the test and its sessions: counts bytes read and sessions ended.
+ */
+struct Tally {
+    void byteRead() {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        bytes++;
+        cv.notify_all();
+    }
+
+    void ended() {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        ends++;
+        cv.notify_all();
+    }
+
+    void waitFor(int expectedBytes, int expectedEnds) {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        cv.wait(lk, [&] { return bytes >= expectedBytes && ends >= expectedEnds; });
+    }
+
+    stdx::mutex mutex;
+    stdx::condition_variable cv;
+    int bytes = 0;
+    int ends = 0;
+};
+
+/**
+ * Reads one byte per readable event and ends when the peer closes its end of the socket pair.
+ */
+class ByteSession : public ServiceExecutorEpoll::Session {
+public:
+    ByteSession(int fd, Tally* tally) : _fd(fd), _tally(tally) {}
+
+    int fd() const override {
+        return _fd;
+    }
+
+    bool onReadable() override {
+        char c;
+        if (read(_fd, &c, 1) != 1)
+            return false;
+        _tally->byteRead();
+        return true;
+    }
+
+    void onEnd() override {
+        close(_fd);
+        _tally->ended();
+    }
+
+private:
+    const int _fd;
+    Tally* const _tally;
+};
+
+void writeByte(int fd) {
+    char c = 'x';
+    ASSERT_EQUALS(1, write(fd, &c, 1));
+}
+
+TEST(ServiceExecutorEpollTest, HandlesRequestsFromManySessions) {
+    const int kSessions = 20;
+    const int kBytesPerSession = 5;
+
+    ServiceExecutorCounter counter;
+    Tally tally;
+    ServiceExecutorEpoll executor(4, &counter);
+    ASSERT_OK(executor.start());
+
+    std::vector<int> clientEnds;
+    for (int i = 0; i < kSessions; i++) {
+        int fds[2];
+        ASSERT_EQUALS(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        ASSERT_OK(executor.add(stdx::make_unique<ByteSession>(fds[0], &tally)));
+        clientEnds.push_back(fds[1]);
+    }
+
+    for (int i = 0; i < kBytesPerSession; i++) {
+        for (int fd : clientEnds) {
+            writeByte(fd);
+        }
+    }
+    tally.waitFor(kSessions * kBytesPerSession, 0);
+
+    for (int fd : clientEnds) {
+        close(fd);
+    }
+    tally.waitFor(kSessions * kBytesPerSession, kSessions);
+
+    executor.shutdown();
+
+    BSONObjBuilder b;
+    counter.append(b);
+    BSONObj stats = b.obj();
+    ASSERT_EQUALS(0, stats["sessions"].numberLong());
+    ASSERT_EQUALS(0, stats["queued"].numberLong());
+    ASSERT_EQUALS(0, stats["inFlight"].numberLong());
+    ASSERT_GREATER_THAN_OR_EQUALS(stats["totalScheduled"].numberLong(),
+                                  kSessions * kBytesPerSession);
+}
+
+TEST(ServiceExecutorEpollTest, ShutdownEndsIdleSessions) {
+    ServiceExecutorCounter counter;
+    Tally tally;
+    ServiceExecutorEpoll executor(2, &counter);
+    ASSERT_OK(executor.start());
+
+    int fds[2];
+    ASSERT_EQUALS(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT_OK(executor.add(stdx::make_unique<ByteSession>(fds[0], &tally)));
+
+    executor.shutdown();
+    ASSERT_EQUALS(1, tally.ends);
+    close(fds[1]);
+}
+
+TEST(ServiceExecutorEpollTest, AddAfterShutdownFails) {
+    ServiceExecutorCounter counter;
+    Tally tally;
+    ServiceExecutorEpoll executor(1, &counter);
+    ASSERT_OK(executor.start());
+    executor.shutdown();
+
+    int fds[2];
+    ASSERT_EQUALS(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT_EQUALS(ErrorCodes::ShutdownInProgress,
+                  executor.add(stdx::make_unique<ByteSession>(fds[0], &tally)));
+    ASSERT_EQUALS(1, tally.ends);
+    close(fds[1]);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -42,6 +42,7 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <netdb.h>
+#include <limits.h>
 #if defined(__OpenBSD__)
 #include <sys/uio.h>
 #endif
@@ -690,21 +691,29 @@ void Socket::send(const vector<pair<char*, int>>& data, const char* context) {
     _send(data, context);
 #else
     vector<struct iovec> d(data.size());
-    int i = 0;
+    size_t numIovecs = 0;
     for (vector<pair<char*, int>>::const_iterator j = data.begin(); j != data.end(); ++j) {
         if (j->second > 0) {
-            d[i].iov_base = j->first;
-            d[i].iov_len = j->second;
-            ++i;
+            d[numIovecs].iov_base = j->first;
+            d[numIovecs].iov_len = j->second;
+            ++numIovecs;
             _bytesOut += j->second;
         }
     }
+
+    // A scatter/gather reply may reference more buffers than a single sendmsg() accepts, so the
+    // iovec array is handed to the kernel in windows of at most IOV_MAX entries.
+    const size_t maxIovecsPerCall = IOV_MAX;
+    struct iovec* next = d.data();
+    size_t remaining = numIovecs;
+
     struct msghdr meta;
     memset(&meta, 0, sizeof(meta));
-    meta.msg_iov = &d[0];
-    meta.msg_iovlen = d.size();
 
-    while (meta.msg_iovlen > 0) {
+    while (remaining > 0) {
+        meta.msg_iov = next;
+        meta.msg_iovlen = std::min(remaining, maxIovecsPerCall);
+
         int ret = -1;
         if (MONGO_FAIL_POINT(throwSockExcep)) {
 #if defined(_WIN32)
@@ -727,16 +736,15 @@ void Socket::send(const vector<pair<char*, int>>& data, const char* context) {
                 throw SocketException(SocketException::SEND_TIMEOUT, remoteString());
             }
         } else {
-            struct iovec*& i = meta.msg_iov;
             while (ret > 0) {
-                if (i->iov_len > unsigned(ret)) {
-                    i->iov_len -= ret;
-                    i->iov_base = (char*)(i->iov_base) + ret;
+                if (next->iov_len > unsigned(ret)) {
+                    next->iov_len -= ret;
+                    next->iov_base = (char*)(next->iov_base) + ret;
                     ret = 0;
                 } else {
-                    ret -= i->iov_len;
-                    ++i;
-                    --(meta.msg_iovlen);
+                    ret -= next->iov_len;
+                    ++next;
+                    --remaining;
                 }
             }
         }